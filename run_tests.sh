@@ -18,6 +18,7 @@ print_red() {
 }
 
 export TECKYL="$PWD/bin/teckyl"
+export TECKYL_RUN="$PWD/bin/teckyl-run"
 export LLC="$PWD/llvm-project/llvm/bin/llc"
 export MLIR_OPT="$PWD/llvm-project/llvm/bin/mlir-opt"
 export MLIR_TRANSLATE="$PWD/llvm-project/llvm/bin/mlir-translate"
@@ -37,16 +38,26 @@ for MODE in good bad
 do
     TEST_DIR="$BASE_DIR/tests/inputs/$MODE"
 
-    for BODY_OP in "linalg.generic" "scf.for"
+    for FLAGS in "-body-op=linalg.generic" \
+		 "-body-op=linalg.generic -specialize-linalg-ops" \
+		 "-body-op=scf.for" \
+		 "-body-op=scf.for -accumulation-type=f32" \
+		 "-body-op=scf.for -assume-noalias -assume-aligned=64" \
+		 "-body-op=linalg.generic -nontemporal-threshold=1" \
+		 "-body-op=scf.for -prefetch-distance=16" \
+		 "-body-op=linalg.generic -instrument" \
+		 "-body-op=linalg.generic -specialize-linalg-ops -dynamic-strides" \
+		 "-body-op=linalg.generic -batch" \
+		 "-body-op=scf.for -accumulation-type=i32 -requantize-scale=scale -requantize-zero-point=zero_point"
     do
 	find "$TEST_DIR" -type f -name "*.tc" -print0 | sort | \
 	    while IFS= read -r -d '' SRC_FILE
 	    do
-		printf '%s' "Running teckyl [$BODY_OP] on $SRC_FILE... "
+		printf '%s' "Running teckyl [$FLAGS] on $SRC_FILE... "
 
 		# Suppress error messages from the shell
 		exec 2> /dev/null
-		"$TECKYL" -emit=mlir -body-op=$BODY_OP "$SRC_FILE" > "$TMP_LOGFILE" 2>&1
+		"$TECKYL" -emit=mlir $FLAGS "$SRC_FILE" > "$TMP_LOGFILE" 2>&1
 		RETVAL=$?
 		exec 2> /dev/tty
 
@@ -78,6 +89,39 @@ do
     done
 done
 
+# The lowering to the LLVM dialect used by teckyl-genobject and
+# teckyl-run, applied to shifted, strided and specialized accesses
+for FLAGS in "-body-op=linalg.generic -specialize-linalg-ops" \
+	     "-body-op=scf.for -nontemporal-threshold=1" \
+	     "-lower-tc=linalg"
+do
+    find "$BASE_DIR/tests/inputs/good/affine" \
+	 "$BASE_DIR/tests/inputs/good/specializations" \
+	 -type f -name "*.tc" -print0 | sort -z | \
+	while IFS= read -r -d '' SRC_FILE
+	do
+	    printf '%s' "Running teckyl -emit=llvm-mlir [$FLAGS] on $SRC_FILE... "
+
+	    # Suppress error messages from the shell
+	    exec 2> /dev/null
+	    "$TECKYL" -emit=llvm-mlir $FLAGS "$SRC_FILE" > "$TMP_LOGFILE" 2>&1
+	    RETVAL=$?
+	    exec 2> /dev/tty
+
+	    if [ $RETVAL -ne 0 ]
+	    then
+		print_red "failed"
+		echo
+		cat "$TMP_LOGFILE" >&2
+		exit 1
+	    else
+		print_green "success"
+	    fi
+	done
+
+    [ $? -eq 0 ] || exit 1
+done
+
 if [ -x "$MLIR_OPT" -a -x "$MLIR_TRANSLATE" ]
 then
     for TEST_DIR in "$BASE_DIR"/tests/exec/*
@@ -146,6 +190,30 @@ then
 		print_green "success"
 	    fi
 	done
+
+    find "$BASE_DIR/tests/tuning" -type f -name "*.tc" -print0 | sort | \
+	while IFS= read -r -d '' SRC_FILE
+	do
+	    printf '%s' "Running tuning space test on $SRC_FILE... "
+
+	    # Suppress error messages from the shell
+	    exec 2> /dev/null
+	    ("$TECKYL" -emit=tuning-space -tuning-shape=M=6,N=12,K=9 \
+		       -tuning-cpu=testcpu -tuning-max-loop-orders=3 \
+		       "$SRC_FILE" | "$FILECHECK" "$SRC_FILE") > "$TMP_LOGFILE" 2>&1
+	    RETVAL=$?
+	    exec 2> /dev/tty
+
+	    if [ $RETVAL -ne 0 ]
+	    then
+		print_red "failed"
+		echo
+		cat "$TMP_LOGFILE" >&2
+		exit 1
+	    else
+		print_green "success"
+	    fi
+	done
     
     if [ -x "$TRANSFORM" ]
     then
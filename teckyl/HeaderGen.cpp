@@ -1,18 +1,26 @@
 #include "HeaderGen.h"
+#include "teckyl/lang_extras.h"
+#include "teckyl/lang_layout.h"
 
+#include <algorithm>
 #include <sstream>
+#include <string>
 #include <unordered_set>
 
 namespace teckyl {
 
 // Returns a string describing the C data type for a given scalar lang
-// data kind. For integers with less than 8 bits, "void" is
-// returned. For unsupported scalar types, the function aborts.
+// data kind. Integers with less than 8 bits are packed into bytes and
+// represented by one of the packed types declared by
+// genPackedTypes(). 16-bit floats have no portable C type and are
+// represented by their bit patterns as uint16_t. For unsupported
+// scalar types, the function aborts.
 static const char *getCType(int kind) {
   switch (kind) {
   case lang::TK_UINT2:
+    return "teckyl_uint2x4_t";
   case lang::TK_UINT4:
-    return "void";
+    return "teckyl_uint4x2_t";
   case lang::TK_UINT8:
     return "uint8_t";
   case lang::TK_UINT16:
@@ -23,8 +31,9 @@ static const char *getCType(int kind) {
     return "uint64_t";
 
   case lang::TK_INT2:
+    return "teckyl_int2x4_t";
   case lang::TK_INT4:
-    return "void";
+    return "teckyl_int4x2_t";
   case lang::TK_INT8:
     return "int8_t";
   case lang::TK_INT16:
@@ -37,6 +46,9 @@ static const char *getCType(int kind) {
   case lang::TK_SIZET:
     return "size_t";
 
+  case lang::TK_FLOAT16:
+  case lang::TK_BFLOAT16:
+    return "uint16_t";
   case lang::TK_FLOAT:
   case lang::TK_FLOAT32:
     return "float";
@@ -47,52 +59,462 @@ static const char *getCType(int kind) {
   llvm_unreachable("Unsupported scalar type");
 }
 
-// Generate a function signature for a tensor function using
-// "flattened" memrefs as parameters (i.e., for a 2d memref "A",
+// Generates the declarations of the types used for buffers of packed
+// integers with less than 8 bits. Each byte holds 8 / bits
+// consecutive elements of the innermost dimension of a tensor, with
+// the element with the lowest index in the least significant bits
+// (e.g., elements 0 and 1 of an int4 tensor are stored in bits 0-3
+// and 4-7 of the first byte). Rows are padded to entire bytes.
+//
+// The declarations are guarded, such that multiple generated headers
+// can be included in the same translation unit.
+static void genPackedTypes(std::stringstream &ss) {
+  ss << "#ifndef TECKYL_PACKED_TYPES" << std::endl
+     << "#define TECKYL_PACKED_TYPES" << std::endl
+     << "typedef uint8_t teckyl_int2x4_t;" << std::endl
+     << "typedef uint8_t teckyl_uint2x4_t;" << std::endl
+     << "typedef uint8_t teckyl_int4x2_t;" << std::endl
+     << "typedef uint8_t teckyl_uint4x2_t;" << std::endl
+     << "#endif" << std::endl;
+}
+
+// Generates the declaration of the macro TECKYL_ASSUME_ALIGNED(p, n),
+// which informs the compiler that the pointer `p` is aligned to `n`
+// bytes if the compiler supports such hints and evaluates to `p`
+// otherwise. The hint is cast back to the type of `p`, since C++ does
+// not convert the void pointer implicitly.
+static void genAssumeAlignedMacro(std::stringstream &ss) {
+  ss << "#ifndef TECKYL_ASSUME_ALIGNED" << std::endl
+     << "#if defined(__GNUC__)" << std::endl
+     << "#define TECKYL_ASSUME_ALIGNED(p, n) "
+        "((__typeof__(p))__builtin_assume_aligned((p), (n)))"
+     << std::endl
+     << "#else" << std::endl
+     << "#define TECKYL_ASSUME_ALIGNED(p, n) (p)" << std::endl
+     << "#endif" << std::endl
+     << "#endif" << std::endl;
+}
+
+// Generates the declaration of the macro TECKYL_RESTRICT, which
+// expands to the restrict qualifier of C99 or to the __restrict
+// extension in C++, which has no restrict qualifier.
+static void genRestrictMacro(std::stringstream &ss) {
+  ss << "#ifndef TECKYL_RESTRICT" << std::endl
+     << "#if defined(__cplusplus)" << std::endl
+     << "#define TECKYL_RESTRICT __restrict" << std::endl
+     << "#else" << std::endl
+     << "#define TECKYL_RESTRICT restrict" << std::endl
+     << "#endif" << std::endl
+     << "#endif" << std::endl;
+}
+
+// Returns the names of the size parameters of `def` in order of their
+// first appearance in the signature from left to right
+static std::vector<std::string> getSizeParamsInOrder(lang::Def def) {
+  std::unordered_set<std::string> sizeParams;
+  std::vector<std::string> sizeParamsSeq;
+
+  auto collectFromParam = [&](lang::Param param) {
+    for (const lang::TreeRef &dim : param.tensorType().dims()) {
+      if (dim->kind() == lang::TK_IDENT) {
+        lang::Ident ident(dim);
+
+        if (sizeParams.insert(ident.name()).second)
+          sizeParamsSeq.push_back(ident.name());
+      }
+    }
+  };
+
+  for (lang::Param inParam : def.params())
+    collectFromParam(inParam);
+
+  for (lang::Param outParam : def.returns())
+    collectFromParam(outParam);
+
+  return sizeParamsSeq;
+}
+
+// Generates the size of a tensor dimension `dim`, i.e., either the
+// name of a size parameter or a constant
+static void genDim(std::stringstream &ss, const lang::TreeRef &dim) {
+  if (dim->kind() == lang::TK_IDENT) {
+    lang::Ident ident(dim);
+    ss << ident.name();
+  } else if (dim->kind() == lang::TK_CONST) {
+    lang::Const cst(dim);
+    ss << cst.value();
+  }
+}
+
+// Generates the number of elements of the physical dimension `pdim`
+// in memory for a tensor of type `type`. For the innermost dimension
+// of a tensor with packed elements, this is the number of bytes.
+static void genExtent(std::stringstream &ss, lang::TensorType type,
+                      const layout::PhysicalDim &pdim, bool innermost) {
+  lang::ListView<lang::TreeRef> dims = type.dims();
+  int kind = type.scalarType();
+
+  switch (pdim.kind) {
+  case layout::PhysicalDim::Kind::Full:
+    // Number of bytes per row of packed elements
+    if (innermost && isPackedIntType(kind)) {
+      unsigned int elementsPerByte = 8 / getIntBits(kind);
+
+      ss << "((";
+      genDim(ss, dims[pdim.dim]);
+      ss << "+" << elementsPerByte - 1 << ")/" << elementsPerByte << ")";
+    } else {
+      genDim(ss, dims[pdim.dim]);
+    }
+    break;
+  case layout::PhysicalDim::Kind::Outer:
+    ss << "((";
+    genDim(ss, dims[pdim.dim]);
+    ss << "+" << pdim.blockSize - 1 << ")/" << pdim.blockSize << ")";
+    break;
+  case layout::PhysicalDim::Kind::Inner:
+    ss << pdim.blockSize;
+    break;
+  }
+}
+
+// Returns the types and names of the parameters of a tensor function
+// using "flattened" memrefs as parameters (i.e., for a 2d memref "A",
 // parameters A_allocatedPtr, A_alignedPtr, A_offset, A_size0,
 // A_size1, A_stride0, A_stride1 would be added).
 //
 // The parameters are listed in order of the tensor function
 // definition from left to right with input parameters befoe output
 // parameters.
-void genMemrefSignature(std::stringstream &ss, lang::Def def) {
-  ss << "void " << def.name().name() << "(";
+//
+// For tensors with packed elements (see genPackedTypes()), the sizes
+// are given in elements and the strides in bytes. For tensors with a
+// blocked layout, there is one size and one stride per physical
+// dimension (see layout::getMemRefSizeDim()).
+//
+// If `options.instrument` is set, the parameters for the table of
+// profiling counters (see genProfileTable()) are added last.
+static std::vector<std::pair<std::string, std::string>>
+getMemrefParams(lang::Def def, const HeaderGenOptions &options) {
+  std::vector<std::pair<std::string, std::string>> params;
+
+  auto addParams = [&](lang::Param &param, bool isInput) {
+    const std::string &name = param.ident().name();
+    std::string ptrType = std::string(isInput ? "const " : "") +
+                          getCType(param.tensorType().scalarType()) + "*";
+
+    params.emplace_back(ptrType, name + "_allocatedPtr");
+    params.emplace_back(ptrType, name + "_alignedPtr");
+    params.emplace_back("int64_t", name + "_offset");
+
+    // Tensors with blocked layouts have one memref dimension per
+    // physical dimension
+    size_t rank = layout::getLayout(param.tensorType()).size();
+
+    for (size_t i = 0; i < rank; i++)
+      params.emplace_back("int64_t", name + "_size" + std::to_string(i));
+
+    for (size_t i = 0; i < rank; i++)
+      params.emplace_back("int64_t", name + "_stride" + std::to_string(i));
+  };
+
+  for (lang::Param inParam : def.params())
+    addParams(inParam, true);
+
+  for (lang::Param outParam : def.returns())
+    addParams(outParam, false);
+
+  if (options.instrument) {
+    params.emplace_back("int64_t*", "teckyl_profile_allocatedPtr");
+    params.emplace_back("int64_t*", "teckyl_profile_alignedPtr");
+    params.emplace_back("int64_t", "teckyl_profile_offset");
+    params.emplace_back("int64_t", "teckyl_profile_size0");
+    params.emplace_back("int64_t", "teckyl_profile_size1");
+    params.emplace_back("int64_t", "teckyl_profile_stride0");
+    params.emplace_back("int64_t", "teckyl_profile_stride1");
+  }
 
+  return params;
+}
+
+// Generates the comma-separated list of the parameters returned by
+// getMemrefParams(), either with their types for a declaration or
+// without for a call
+static void genMemrefParamList(std::stringstream &ss, lang::Def def,
+                               const HeaderGenOptions &options,
+                               bool withTypes) {
   bool isFirstParam = true;
 
-  auto genParam = [&](lang::Param &param, bool isInput) {
+  for (const auto &param : getMemrefParams(def, options)) {
     if (isFirstParam)
       isFirstParam = false;
     else
       ss << ", ";
 
-    if (isInput)
-      ss << "const ";
+    if (withTypes)
+      ss << param.first << " ";
 
-    ss << getCType(param.tensorType().scalarType()) << "* "
-       << param.ident().name() << "_allocatedPtr, ";
+    ss << param.second;
+  }
+}
 
-    if (isInput)
-      ss << "const ";
+// Generate a function signature for a tensor function using
+// "flattened" memrefs as parameters (see getMemrefParams()). The name
+// of the function is the name of the definition followed by `suffix`.
+void genMemrefSignature(std::stringstream &ss, lang::Def def,
+                        const HeaderGenOptions &options,
+                        const std::string &suffix = "") {
+  ss << "void " << def.name().name() << suffix << "(";
+  genMemrefParamList(ss, def, options, true);
+  ss << ");" << std::endl;
+}
 
-    ss << getCType(param.tensorType().scalarType()) << "* "
-       << param.ident().name() << "_alignedPtr, "
-       << "int64_t " << param.ident().name() << "_offset";
+// Returns the suffix of the names of the variants of functions
+// compiled for the instruction set `isa`
+static const char *getISASuffix(HeaderGenOptions::ISA isa) {
+  switch (isa) {
+  case HeaderGenOptions::ISA::SSE42:
+    return "_sse42";
+  case HeaderGenOptions::ISA::AVX2:
+    return "_avx2";
+  case HeaderGenOptions::ISA::AVX512:
+    return "_avx512";
+  }
 
-    for (int i = 0; i < param.tensorType().dims().size(); i++)
-      ss << ", int64_t " << param.ident().name() << "_size" << i;
+  llvm_unreachable("Unknown instruction set");
+}
+
+// Returns the CPU features as understood by __builtin_cpu_supports()
+// that must be present for the variant for the instruction set
+// `isa`. These are the features teckyl-genobject passes to llc for
+// the variant.
+static std::vector<const char *> getISAFeatures(HeaderGenOptions::ISA isa) {
+  switch (isa) {
+  case HeaderGenOptions::ISA::SSE42:
+    return {"sse4.2", "popcnt"};
+  case HeaderGenOptions::ISA::AVX2:
+    return {"avx2", "fma"};
+  case HeaderGenOptions::ISA::AVX512:
+    return {"avx512f", "avx512bw", "avx512dq", "avx512vl", "avx2", "fma"};
+  }
+
+  llvm_unreachable("Unknown instruction set");
+}
+
+// Generates the declarations of the variants of the tensor function
+// for `def` compiled for the instruction sets from
+// `options.isa_variants` and for the baseline of the target (with the
+// suffix "_generic"), as well as a dispatcher with the name of the
+// definition and the memref signature (see genMemrefSignature()).
+//
+// Upon its first invocation, the dispatcher selects the variant for
+// the most recent instruction set supported by the host CPU and
+// caches a pointer to the variant, such that subsequent invocations
+// only add an indirect call. The cache is static, i.e., each
+// translation unit including the header selects the variant once.
+// Threads calling the dispatcher concurrently may all select the
+// variant, but always store the same pointer; the cache is accessed
+// with relaxed atomic operations, such that these stores do not race
+// with the loads.
+static void genDispatcher(std::stringstream &ss, lang::Def def,
+                          const HeaderGenOptions &options) {
+  const std::string &name = def.name().name();
+  std::vector<HeaderGenOptions::ISA> isas = options.isa_variants;
+
+  // Most recent instruction set first
+  std::sort(isas.begin(), isas.end(),
+            [](HeaderGenOptions::ISA a, HeaderGenOptions::ISA b) {
+              return static_cast<int>(a) > static_cast<int>(b);
+            });
+  isas.erase(std::unique(isas.begin(), isas.end()), isas.end());
+
+  genMemrefSignature(ss, def, options, "_generic");
+
+  for (HeaderGenOptions::ISA isa : isas)
+    genMemrefSignature(ss, def, options, getISASuffix(isa));
+
+  ss << std::endl << "typedef void (*" << name << "_variant_t)(";
+  genMemrefParamList(ss, def, options, true);
+  ss << ");" << std::endl
+     << std::endl
+     << "static inline " << name << "_variant_t " << name
+     << "_select_variant(void) {" << std::endl
+     << "#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))"
+     << std::endl
+     << "\t__builtin_cpu_init();" << std::endl;
+
+  for (HeaderGenOptions::ISA isa : isas) {
+    bool isFirstFeature = true;
+
+    ss << std::endl << "\tif(";
+
+    for (const char *feature : getISAFeatures(isa)) {
+      if (isFirstFeature)
+        isFirstFeature = false;
+      else
+        ss << " &&" << std::endl << "\t   ";
+
+      ss << "__builtin_cpu_supports(\"" << feature << "\")";
+    }
 
-    for (int i = 0; i < param.tensorType().dims().size(); i++)
-      ss << ", int64_t " << param.ident().name() << "_stride" << i;
+    ss << ")" << std::endl
+       << "\t\treturn " << name << getISASuffix(isa) << ";" << std::endl;
+  }
+
+  ss << "#endif" << std::endl
+     << "\treturn " << name << "_generic;" << std::endl
+     << "}" << std::endl
+     << std::endl
+     << "static inline void " << name << "(";
+  genMemrefParamList(ss, def, options, true);
+  ss << ") {" << std::endl
+     << "\tstatic " << name << "_variant_t variant;" << std::endl
+     << "\t" << name << "_variant_t v;" << std::endl
+     << std::endl
+     << "#if defined(__GNUC__)" << std::endl
+     << "\tv = __atomic_load_n(&variant, __ATOMIC_RELAXED);" << std::endl
+     << "#else" << std::endl
+     << "\tv = variant;" << std::endl
+     << "#endif" << std::endl
+     << std::endl
+     << "\tif(!v) {" << std::endl
+     << "\t\tv = " << name << "_select_variant();" << std::endl
+     << "#if defined(__GNUC__)" << std::endl
+     << "\t\t__atomic_store_n(&variant, v, __ATOMIC_RELAXED);" << std::endl
+     << "#else" << std::endl
+     << "\t\tvariant = v;" << std::endl
+     << "#endif" << std::endl
+     << "\t}" << std::endl
+     << std::endl
+     << "\tv(";
+  genMemrefParamList(ss, def, options, false);
+  ss << ");" << std::endl << "}" << std::endl;
+}
+
+// Generates the declarations of the variants of the tensor function
+// for `def` for contiguous and for arbitrarily strided tensors (see
+// HeaderGenOptions::stride_versioning), as well as a dispatcher with
+// the name of the definition and the memref signature (see
+// genMemrefSignature()).
+//
+// The dispatcher calls the contiguous variant if the offset of each
+// tensor is 0 and the stride of its innermost physical dimension
+// is 1. The remaining strides are passed to both variants and thus
+// need not describe a dense tensor.
+static void genStrideDispatcher(std::stringstream &ss, lang::Def def,
+                                const HeaderGenOptions &options) {
+  const std::string &name = def.name().name();
+  bool isFirstCond = true;
+
+  genMemrefSignature(ss, def, options, "_contiguous");
+  genMemrefSignature(ss, def, options, "_strided");
+
+  ss << std::endl << "static inline void " << name << "(";
+  genMemrefParamList(ss, def, options, true);
+  ss << ") {" << std::endl << "\tif(";
+
+  auto genCond = [&](const lang::Param &param) {
+    const std::string &paramName = param.ident().name();
+    layout::Layout layout = layout::getLayout(param.tensorType());
+
+    // Outputs with 0 dimensions have no strides
+    if (layout.empty())
+      return;
+
+    // Tensors with blocked layouts have one memref dimension per
+    // physical dimension
+    size_t innermost =
+        layout::isBlocked(layout) ? layout.size() - 1 : layout.back().dim;
+
+    if (isFirstCond)
+      isFirstCond = false;
+    else
+      ss << " &&" << std::endl << "\t   ";
+
+    ss << paramName << "_offset == 0 && " << paramName << "_stride"
+       << innermost << " == 1";
   };
 
-  for (lang::Param inParam : def.params())
-    genParam(inParam, true);
+  for (const lang::Param &inParam : def.params())
+    genCond(inParam);
 
-  for (lang::Param outParam : def.returns())
-    genParam(outParam, false);
+  for (const lang::Param &outParam : def.returns())
+    genCond(outParam);
 
-  ss << ");" << std::endl;
+  if (isFirstCond)
+    ss << "1";
+
+  ss << ")" << std::endl << "\t\t" << name << "_contiguous(";
+  genMemrefParamList(ss, def, options, false);
+  ss << ");" << std::endl
+     << "\telse" << std::endl
+     << "\t\t" << name << "_strided(";
+  genMemrefParamList(ss, def, options, false);
+  ss << ");" << std::endl << "}" << std::endl;
+}
+
+// Returns the number of rows of the table of profiling counters for
+// `def`, i.e., one row per comprehension, but at least one row
+static size_t getProfileTableRows(lang::Def def) {
+  return std::max<size_t>(def.statements().size(), 1);
+}
+
+// Returns `str` as a C string literal
+static std::string getCStringLiteral(const std::string &str) {
+  std::string res = "\"";
+
+  for (char c : str) {
+    if (c == '"' || c == '\\')
+      res += '\\';
+
+    res += c;
+  }
+
+  return res + "\"";
+}
+
+// Generates the table of profiling counters for functions generated
+// with MLIRGenOptions::instrument, which is passed to the function by
+// the wrapper function (see genParamWrapper()), as well as the
+// functions <name>_profile_dump() and <name>_profile_reset(). The
+// table has one row per comprehension with the accumulated cycles in
+// the first and the number of executions in the second column. The
+// dump function prints the counters of each comprehension along with
+// its location in the TC source.
+//
+// The table is static, i.e., each translation unit including the
+// header has its own table.
+static void genProfileTable(std::stringstream &ss, lang::Def def) {
+  const std::string &name = def.name().name();
+  size_t rows = getProfileTableRows(def);
+  size_t row = 0;
+
+  ss << "static int64_t " << name << "_profile[" << rows << "][2];"
+     << std::endl
+     << std::endl
+     << "static inline void " << name << "_profile_dump(FILE* f) {"
+     << std::endl;
+
+  for (const lang::Comprehension &c : def.statements()) {
+    std::stringstream loc;
+
+    loc << c.range().filename() << ":" << c.range().startLine();
+
+    ss << "\tfprintf(f, \"%s: %\" PRId64 \" cycles, %\" PRId64 \" calls\\n\", "
+       << getCStringLiteral(loc.str()) << ", " << name << "_profile[" << row
+       << "][0], " << name << "_profile[" << row << "][1]);" << std::endl;
+
+    row++;
+  }
+
+  ss << "}" << std::endl
+     << std::endl
+     << "static inline void " << name << "_profile_reset(void) {" << std::endl
+     << "\tfor(size_t i = 0; i < " << rows << "; i++)" << std::endl
+     << "\t\t" << name << "_profile[i][0] = " << name
+     << "_profile[i][1] = 0;" << std::endl
+     << "}" << std::endl
+     << std::endl;
 }
 
 // Generates wrapper function for a tensor function using only bare
@@ -100,7 +522,20 @@ void genMemrefSignature(std::stringstream &ss, lang::Def def) {
 // dimensions. The generated function calls the original function with
 // appropriate memref parameters for offsets (always 0), sizes
 // (derived from size parameters or constants if defined statically),
-// and strides in row-major format.
+// and strides according to the layout of the tensor (row-major by
+// default). Strides of tensors with packed elements account for the
+// padding of the innermost dimension to entire bytes and strides of
+// blocked layouts for the padding of blocked dimensions to entire
+// blocks.
+//
+// If `options.assume_noalias` is set, the pointers are declared as
+// restrict pointers (see genRestrictMacro()). The memref signature
+// cannot use restrict, since the allocated and the aligned pointer of
+// each tensor are the same pointer. If `options.assume_aligned` is
+// non-zero, the pointers are passed to the original function through
+// TECKYL_ASSUME_ALIGNED (see genAssumeAlignedMacro()). If
+// `options.instrument` is set, the table of profiling counters (see
+// genProfileTable()) is passed last.
 //
 // The name of the generated function is the original name with the
 // suffix "_wrap". The parameters are listed in order of the tensor
@@ -119,10 +554,8 @@ void genMemrefSignature(std::stringstream &ss, lang::Def def) {
 //           float* C,
 //           uint64_t M, uint64_t N)
 //
-void genParamWrapper(std::stringstream &ss, lang::Def def) {
-  std::unordered_set<std::string> sizeParams;
-  std::vector<std::string> sizeParamsSeq;
-
+void genParamWrapper(std::stringstream &ss, lang::Def def,
+                     const HeaderGenOptions &options) {
   ss << "static inline void " << def.name().name() << "_wrap(";
 
   bool isFirstParam = true;
@@ -137,15 +570,8 @@ void genParamWrapper(std::stringstream &ss, lang::Def def) {
       ss << "const ";
 
     ss << getCType(param.tensorType().scalarType()) << "* "
+       << (options.assume_noalias ? "TECKYL_RESTRICT " : "")
        << param.ident().name();
-    for (const lang::TreeRef &dim : param.tensorType().dims()) {
-      if (dim->kind() == lang::TK_IDENT) {
-        lang::Ident ident(dim);
-
-        if (sizeParams.insert(ident.name()).second)
-          sizeParamsSeq.push_back(ident.name());
-      }
-    }
   };
 
   for (lang::Param inParam : def.params())
@@ -154,7 +580,7 @@ void genParamWrapper(std::stringstream &ss, lang::Def def) {
   for (lang::Param outParam : def.returns())
     genParam(outParam, false);
 
-  for (const std::string &sizeParamName : sizeParamsSeq)
+  for (const std::string &sizeParamName : getSizeParamsInOrder(def))
     ss << ", uint64_t " << sizeParamName;
 
   ss << ") {" << std::endl;
@@ -167,43 +593,68 @@ void genParamWrapper(std::stringstream &ss, lang::Def def) {
     else
       ss << ", ";
 
-    ss << param.ident().name() << ", " << param.ident().name() << ", "
-       << "0";
+    // Pointer to the data, annotated with the assumed alignment
+    auto genPtr = [&]() {
+      if (options.assume_aligned) {
+        ss << "TECKYL_ASSUME_ALIGNED(" << param.ident().name() << ", "
+           << options.assume_aligned << ")";
+      } else {
+        ss << param.ident().name();
+      }
+    };
+
+    genPtr();
+    ss << ", ";
+    genPtr();
+    ss << ", 0";
 
     lang::ListView<lang::TreeRef> dims = param.tensorType().dims();
+    layout::Layout layout = layout::getLayout(param.tensorType());
 
-    // Sizes
-    for (const lang::TreeRef &dim : dims) {
-      ss << ", ";
+    // Generates the stride of the physical dimension with the index
+    // `i`
+    auto genStride = [&](size_t i) {
+      if (i == layout.size() - 1)
+        ss << "1";
 
-      if (dim->kind() == lang::TK_IDENT) {
-        lang::Ident ident(dim);
-        ss << ident.name();
-      } else if (dim->kind() == lang::TK_CONST) {
-        lang::Const cst(dim);
-        ss << cst.value();
+      for (size_t j = i + 1; j < layout.size(); j++) {
+        if (j > i + 1)
+          ss << "*";
+
+        genExtent(ss, param.tensorType(), layout[j], j == layout.size() - 1);
       }
-    }
+    };
 
-    // Strides
-    for (size_t i = 0; i < dims.size(); i++) {
-      if (i == dims.size() - 1)
-        ss << ", 1";
-      else
+    if (layout::isBlocked(layout)) {
+      // One memref dimension per physical dimension (see
+      // layout::getMemRefSizeDim())
+      for (const layout::PhysicalDim &pdim : layout) {
         ss << ", ";
 
-      for (size_t j = i + 1; j < dims.size(); j++) {
-        lang::TreeRef dim = dims[j];
+        if (pdim.kind == layout::PhysicalDim::Kind::Inner)
+          ss << pdim.blockSize;
+        else
+          genDim(ss, dims[pdim.dim]);
+      }
 
-        if (j > i + 1)
-          ss << "*";
+      for (size_t i = 0; i < layout.size(); i++) {
+        ss << ", ";
+        genStride(i);
+      }
+    } else {
+      // Sizes
+      for (const lang::TreeRef &dim : dims) {
+        ss << ", ";
+        genDim(ss, dim);
+      }
 
-        if (dim->kind() == lang::TK_IDENT) {
-          lang::Ident ident(dim);
-          ss << ident.name();
-        } else if (dim->kind() == lang::TK_CONST) {
-          lang::Const cst(dim);
-          ss << cst.value();
+      // Strides
+      for (size_t dim = 0; dim < dims.size(); dim++) {
+        for (size_t i = 0; i < layout.size(); i++) {
+          if (layout[i].dim == dim) {
+            ss << ", ";
+            genStride(i);
+          }
         }
       }
     }
@@ -217,6 +668,13 @@ void genParamWrapper(std::stringstream &ss, lang::Def def) {
   for (const lang::Param &outParam : def.returns())
     genMemrefArgs(outParam);
 
+  if (options.instrument) {
+    const std::string &name = def.name().name();
+
+    ss << ", &" << name << "_profile[0][0], &" << name << "_profile[0][0], 0, "
+       << getProfileTableRows(def) << ", 2, 2, 1";
+  }
+
   ss << ");" << std::endl << "}" << std::endl;
 }
 
@@ -224,20 +682,50 @@ void genParamWrapper(std::stringstream &ss, lang::Def def) {
 // given in tcs. The parameter includeGuard is the preprocessor symbol
 // used to protect the generated header file against double inclusion.
 std::string genHeader(const std::map<std::string, lang::Def> &tcs,
-                      const std::string &includeGuard) {
+                      const std::string &includeGuard,
+                      const HeaderGenOptions &options) {
   std::stringstream ss;
 
   ss << "#ifndef " << includeGuard << std::endl
      << "#define " << includeGuard << std::endl
      << std::endl
      << "#include <stdint.h>" << std::endl
-     << "#include <stdlib.h>" << std::endl
-     << std::endl;
+     << "#include <stdlib.h>" << std::endl;
+
+  if (options.instrument) {
+    ss << "#include <inttypes.h>" << std::endl
+       << "#include <stdio.h>" << std::endl;
+  }
+
+  ss << std::endl;
+
+  genPackedTypes(ss);
+  ss << std::endl;
+
+  if (options.assume_noalias) {
+    genRestrictMacro(ss);
+    ss << std::endl;
+  }
+
+  if (options.assume_aligned) {
+    genAssumeAlignedMacro(ss);
+    ss << std::endl;
+  }
 
   for (const std::pair<std::string, lang::Def> &def : tcs) {
-    genMemrefSignature(ss, def.second);
+    if (options.stride_versioning)
+      genStrideDispatcher(ss, def.second, options);
+    else if (options.isa_variants.empty())
+      genMemrefSignature(ss, def.second, options);
+    else
+      genDispatcher(ss, def.second, options);
+
     ss << std::endl;
-    genParamWrapper(ss, def.second);
+
+    if (options.instrument)
+      genProfileTable(ss, def.second);
+
+    genParamWrapper(ss, def.second, options);
   }
 
   ss << std::endl;
@@ -245,4 +733,164 @@ std::string genHeader(const std::map<std::string, lang::Def> &tcs,
 
   return ss.str();
 }
+
+// Returns a C literal for the value 1 of the scalar type `kind`. For
+// types represented by bit patterns or bytes of packed elements, the
+// literal is the bit pattern of 1 for each element.
+static const char *getOneLiteral(int kind) {
+  switch (kind) {
+  case lang::TK_INT2:
+  case lang::TK_UINT2:
+    return "0x55";
+  case lang::TK_INT4:
+  case lang::TK_UINT4:
+    return "0x11";
+  case lang::TK_FLOAT16:
+    return "0x3C00";
+  case lang::TK_BFLOAT16:
+    return "0x3F80";
+  case lang::TK_FLOAT:
+  case lang::TK_FLOAT32:
+    return "1.0f";
+  case lang::TK_FLOAT64:
+    return "1.0";
+  }
+
+  return "1";
+}
+
+// Generates a C99 program that measures the execution time of the
+// kernel `kernelName` from `tcs`, which must have been compiled into
+// an object file linked with the program. The sizes of the tensors
+// are taken from `shape`, which must provide a value for each size
+// parameter of the kernel. All elements of all tensors are
+// initialized with 1, such that integer divisions do not trap and
+// floating point operations do not produce denormals for typical
+// kernels.
+//
+// The program invokes the kernel `repetitions` times through its
+// wrapper function (see genParamWrapper()) and prints the minimum
+// execution time in nanoseconds to stdout.
+std::string genBenchmark(const std::map<std::string, lang::Def> &tcs,
+                         const std::string &kernelName,
+                         const std::map<std::string, uint64_t> &shape,
+                         unsigned int repetitions,
+                         const HeaderGenOptions &options) {
+  std::map<std::string, lang::Def> kernel;
+  std::stringstream ss;
+
+  kernel.emplace(kernelName, tcs.at(kernelName));
+  lang::Def def = kernel.at(kernelName);
+
+  // The buffers are allocated with posix_memalign(), such that the
+  // alignment assumed by the kernel holds
+  unsigned int alignment = std::max(options.assume_aligned, 64u);
+
+  ss << "#define _POSIX_C_SOURCE 200112L" << std::endl
+     << std::endl
+     << "#include <inttypes.h>" << std::endl
+     << "#include <stdio.h>" << std::endl
+     << "#include <time.h>" << std::endl
+     << std::endl
+     << genHeader(kernel, "TECKYL_BENCHMARK_H", options) << std::endl
+     << "static uint64_t teckyl_benchmark_now(void) {" << std::endl
+     << "\tstruct timespec ts;" << std::endl
+     << "\tclock_gettime(CLOCK_MONOTONIC, &ts);" << std::endl
+     << "\treturn (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;" << std::endl
+     << "}" << std::endl
+     << std::endl
+     << "int main(void) {" << std::endl;
+
+  for (const std::string &sizeParam : getSizeParamsInOrder(def)) {
+    ss << "\tconst uint64_t " << sizeParam << " = " << shape.at(sizeParam)
+       << ";" << std::endl;
+  }
+
+  auto genAllocation = [&](lang::Param param) {
+    lang::TensorType type = param.tensorType();
+    layout::Layout layout = layout::getLayout(type);
+    const std::string &name = param.ident().name();
+    const char *ctype = getCType(type.scalarType());
+
+    ss << "\tconst size_t " << name << "_count = ";
+
+    if (layout.empty())
+      ss << "1";
+
+    for (size_t i = 0; i < layout.size(); i++) {
+      if (i > 0)
+        ss << "*";
+
+      genExtent(ss, type, layout[i], i == layout.size() - 1);
+    }
+
+    ss << ";" << std::endl
+       << "\t" << ctype << "* " << name << ";" << std::endl
+       << std::endl
+       << "\tif(posix_memalign((void**)&" << name << ", " << alignment << ", "
+       << name << "_count * sizeof(" << ctype << "))) {" << std::endl
+       << "\t\tfputs(\"Could not allocate " << name << "\\n\", stderr);"
+       << std::endl
+       << "\t\treturn 1;" << std::endl
+       << "\t}" << std::endl
+       << std::endl
+       << "\tfor(size_t i = 0; i < " << name << "_count; i++)" << std::endl
+       << "\t\t" << name << "[i] = " << getOneLiteral(type.scalarType()) << ";"
+       << std::endl
+       << std::endl;
+  };
+
+  for (lang::Param inParam : def.params())
+    genAllocation(inParam);
+
+  for (lang::Param outParam : def.returns())
+    genAllocation(outParam);
+
+  ss << "\tuint64_t best = UINT64_MAX;" << std::endl
+     << std::endl
+     << "\tfor(unsigned int rep = 0; rep < " << repetitions << "; rep++) {"
+     << std::endl
+     << "\t\tuint64_t start = teckyl_benchmark_now();" << std::endl
+     << "\t\t" << kernelName << "_wrap(";
+
+  bool isFirstArg = true;
+
+  auto genArg = [&](const std::string &arg) {
+    if (isFirstArg)
+      isFirstArg = false;
+    else
+      ss << ", ";
+
+    ss << arg;
+  };
+
+  for (lang::Param inParam : def.params())
+    genArg(inParam.ident().name());
+
+  for (lang::Param outParam : def.returns())
+    genArg(outParam.ident().name());
+
+  for (const std::string &sizeParam : getSizeParamsInOrder(def))
+    genArg(sizeParam);
+
+  ss << ");" << std::endl
+     << "\t\tuint64_t elapsed = teckyl_benchmark_now() - start;" << std::endl
+     << std::endl
+     << "\t\tif(elapsed < best)" << std::endl
+     << "\t\t\tbest = elapsed;" << std::endl
+     << "\t}" << std::endl
+     << std::endl
+     << "\tprintf(\"%\" PRIu64 \"\\n\", best);" << std::endl
+     << std::endl;
+
+  for (lang::Param inParam : def.params())
+    ss << "\tfree(" << inParam.ident().name() << ");" << std::endl;
+
+  for (lang::Param outParam : def.returns())
+    ss << "\tfree(" << outParam.ident().name() << ");" << std::endl;
+
+  ss << std::endl << "\treturn 0;" << std::endl << "}" << std::endl;
+
+  return ss.str();
+}
 } // namespace teckyl
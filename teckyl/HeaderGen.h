@@ -1,14 +1,56 @@
 #ifndef TECKYL_HEADER_GEN_H
 #define TECKYL_HEADER_GEN_H
 
+#include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "teckyl/tc/lang/tree_views.h"
 
 namespace teckyl {
+class HeaderGenOptions {
+public:
+  // Declares the pointers to the data of tensors as restrict pointers
+  bool assume_noalias;
+
+  // Alignment in bytes assumed for the data of all tensors; 0 if no
+  // alignment is assumed
+  unsigned int assume_aligned;
+
+  // Declares the table of profiling counters passed to functions
+  // generated with MLIRGenOptions::instrument and generates functions
+  // to dump and reset the counters
+  bool instrument;
+
+  // Instruction sets for which variants of functions can be compiled,
+  // in ascending order of preference
+  enum class ISA { SSE42, AVX2, AVX512 };
+
+  // Declares the variants of each function for these instruction sets
+  // in addition to a variant for the baseline of the target and
+  // generates a dispatcher selecting the variant at runtime. No
+  // variants are declared if empty.
+  std::vector<ISA> isa_variants;
+
+  // Declares a variant of each function for tensors with a unit
+  // innermost stride and a zero offset (with the suffix
+  // "_contiguous") and a variant for arbitrary strides (with the
+  // suffix "_strided", compiled with MLIRGenOptions::dynamic_strides)
+  // and generates a dispatcher checking the strides at runtime. Cannot
+  // be combined with `isa_variants`.
+  bool stride_versioning;
+};
+
 std::string genHeader(const std::map<std::string, lang::Def> &tcs,
-                      const std::string &includeGuard);
+                      const std::string &includeGuard,
+                      const HeaderGenOptions &options = HeaderGenOptions{});
+
+std::string genBenchmark(const std::map<std::string, lang::Def> &tcs,
+                         const std::string &kernelName,
+                         const std::map<std::string, uint64_t> &shape,
+                         unsigned int repetitions,
+                         const HeaderGenOptions &options = HeaderGenOptions{});
 }
 
 #endif
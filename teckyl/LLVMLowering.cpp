@@ -0,0 +1,88 @@
+#include "teckyl/LLVMLowering.h"
+
+#include <mlir/Conversion/AffineToStandard/AffineToStandard.h>
+#include <mlir/Conversion/SCFToStandard/SCFToStandard.h>
+#include <mlir/Conversion/StandardToLLVM/ConvertStandardToLLVM.h>
+#include <mlir/Conversion/StandardToLLVM/ConvertStandardToLLVMPass.h>
+#include <mlir/Dialect/LLVMIR/LLVMDialect.h>
+#include <mlir/Dialect/Linalg/Passes.h>
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/IR/Function.h>
+#include <mlir/IR/Module.h>
+#include <mlir/Transforms/DialectConversion.h>
+
+namespace teckyl {
+
+namespace {
+
+// Lowers a std.store operation with the attribute "nontemporal" set
+// to true to an llvm.store operation with the unit attribute
+// "nontemporal". The benefit is higher than the one of the pattern
+// for std.store from populateStdToLLVMConversionPatterns(), which
+// lowers all other stores.
+struct NonTemporalStoreOpLowering : public mlir::ConvertToLLVMPattern {
+  NonTemporalStoreOpLowering(mlir::MLIRContext *context,
+                             mlir::LLVMTypeConverter &typeConverter)
+      : mlir::ConvertToLLVMPattern(mlir::StoreOp::getOperationName(),
+                                   context, typeConverter, 2) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::Operation *op, llvm::ArrayRef<mlir::Value> operands,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    mlir::StoreOp store = mlir::cast<mlir::StoreOp>(op);
+    mlir::BoolAttr nontemporal =
+        store.getAttrOfType<mlir::BoolAttr>("nontemporal");
+
+    if (!nontemporal || !nontemporal.getValue())
+      return mlir::failure();
+
+    mlir::StoreOp::Adaptor transformed(operands);
+    mlir::Value dataPtr =
+        getDataPtr(op->getLoc(), store.getMemRefType(), transformed.memref(),
+                   transformed.indices(), rewriter, getModule());
+
+    mlir::LLVM::StoreOp llvmStore =
+        rewriter.replaceOpWithNewOp<mlir::LLVM::StoreOp>(
+            op, transformed.value(), dataPtr);
+
+    llvmStore.setAttr("nontemporal", rewriter.getUnitAttr());
+
+    return mlir::success();
+  }
+};
+
+struct LowerToLLVMPass
+    : public mlir::PassWrapper<LowerToLLVMPass,
+                               mlir::OperationPass<mlir::ModuleOp>> {
+  void runOnOperation() override {
+    mlir::ModuleOp module = getOperation();
+    mlir::LLVMTypeConverter typeConverter(&getContext());
+    mlir::OwningRewritePatternList patterns;
+
+    mlir::populateStdToLLVMConversionPatterns(typeConverter, patterns);
+    patterns.insert<NonTemporalStoreOpLowering>(&getContext(), typeConverter);
+
+    mlir::LLVMConversionTarget target(getContext());
+
+    if (mlir::failed(mlir::applyPartialConversion(module, target, patterns,
+                                                  &typeConverter)))
+      signalPassFailure();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<mlir::Pass> createLowerToLLVMPass() {
+  return std::make_unique<LowerToLLVMPass>();
+}
+
+void addLowerToLLVMPasses(mlir::PassManager &pm) {
+  // The loops generated for linalg operations compute indexes with
+  // affine.apply operations, which must be lowered afterwards
+  pm.nest<mlir::FuncOp>().addPass(mlir::createConvertLinalgToLoopsPass());
+  pm.addPass(mlir::createLowerAffinePass());
+  pm.addPass(mlir::createLowerToCFGPass());
+  pm.addPass(createLowerToLLVMPass());
+}
+
+} // namespace teckyl
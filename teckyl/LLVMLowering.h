@@ -0,0 +1,26 @@
+#ifndef TECKYL_LLVMLOWERING_H
+#define TECKYL_LLVMLOWERING_H
+
+#include <mlir/Pass/Pass.h>
+#include <mlir/Pass/PassManager.h>
+
+#include <memory>
+
+namespace teckyl {
+
+// Creates a pass lowering the standard dialect to the LLVM dialect
+// like -convert-std-to-llvm, except for std.store operations carrying
+// the "nontemporal" attribute set by MLIRGen (see
+// MLIRGenOptions::nontemporal_threshold). These are lowered to
+// llvm.store operations with the nontemporal attribute, which are
+// translated to stores with !nontemporal metadata.
+std::unique_ptr<mlir::Pass> createLowerToLLVMPass();
+
+// Adds the passes lowering the code generated by MLIRGen and by the
+// lowering of the tc dialect (with linalg, scf and affine operations)
+// to the LLVM dialect to `pm`
+void addLowerToLLVMPasses(mlir::PassManager &pm);
+
+} // namespace teckyl
+
+#endif
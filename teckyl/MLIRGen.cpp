@@ -1,12 +1,17 @@
 #include "teckyl/MLIRGen.h"
 #include "teckyl/MLIRAffineExprGen.h"
+#include "teckyl/TcDialect.h"
 #include "teckyl/lang_affine.h"
+#include "teckyl/lang_analysis.h"
 #include "teckyl/lang_extras.h"
+#include "teckyl/lang_layout.h"
 #include "teckyl/patterns.h"
 
 #include "teckyl/tc/lang/sema.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/ScopedHashTable.h>
 #include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/raw_ostream.h>
 #include <mlir/Dialect/Affine/IR/AffineOps.h>
 #include <mlir/Dialect/Linalg/EDSC/Builders.h>
 #include <mlir/Dialect/Linalg/EDSC/Intrinsics.h>
@@ -17,15 +22,29 @@
 #include <mlir/IR/Function.h>
 #include <mlir/IR/StandardTypes.h>
 
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace teckyl {
 
-static const char *getTypeAsString(mlir::Type t) {
+// Returns the name of the type `t` used in error messages
+static std::string getTypeAsString(mlir::Type t) {
   if (t.isF16())
     return "f16";
+  else if (t.isBF16())
+    return "bf16";
   else if (t.isF32())
     return "f32";
   else if (t.isF64())
     return "f64";
+  else if (t.isInteger(1))
+    return "i1";
+  else if (t.isInteger(2))
+    return "i2";
+  else if (t.isInteger(4))
+    return "i4";
   else if (t.isInteger(8))
     return "i8";
   else if (t.isInteger(16))
@@ -36,17 +55,24 @@ static const char *getTypeAsString(mlir::Type t) {
     return "i64";
   else if (t.isIndex())
     return "index";
-  llvm_unreachable("Cannot determine name for type");
+
+  // Any other type is printed in MLIR syntax
+  std::string str;
+  llvm::raw_string_ostream os(str);
+
+  t.print(os);
+
+  return os.str();
 }
 
 static inline bool isMLIRFloatType(mlir::Type t) {
-  return t.isF16() || t.isF32() || t.isF64();
+  return t.isF16() || t.isBF16() || t.isF32() || t.isF64();
 }
 
 // Returns the total size in bits of the float type `t`. Throws an
 // exception if `t` is not a float type.
 static inline unsigned int getMLIRFloatTypeBits(mlir::Type &t) {
-  if (t.isF16())
+  if (t.isF16() || t.isBF16())
     return 16;
   if (t.isF32())
     return 32;
@@ -60,6 +86,8 @@ static inline unsigned int getMLIRFloatTypeBits(mlir::Type &t) {
 static inline unsigned int getMLIRFloatTypeMantissaBits(mlir::Type &t) {
   if (t.isF16())
     return 10;
+  if (t.isBF16())
+    return 7;
   if (t.isF32())
     return 23;
   if (t.isF64())
@@ -85,39 +113,28 @@ static inline bool isMLIRIntType(mlir::Type t) {
 using IteratorBoundsMap =
     std::map<std::string, std::pair<mlir::Value, mlir::Value>>;
 
-// Kinds of tensor expression iterators
-enum IteratorKind {
-  // Iterator appears on the left hand side (and may also appear at
-  // the right hand side)
-  LHS,
-
-  // Iterator appears only on the right hand side
-  RHSOnly
+// Storage of a tensor whose elements cannot be addressed with the
+// tensor indexes as memref indexes. Loads and stores of elements of
+// such tensors translate the indexes and unpack or pack the elements
+// (see MLIRValueExprGen::buildTensorLoad()).
+struct TensorStorage {
+  // Logical element type (e.g., i4) of tensors with an integer
+  // element type of less than 8 bits, otherwise null. The elements of
+  // such tensors are packed into a memref of i8 values: each byte of
+  // the innermost dimension holds 8 / bits consecutive elements, with
+  // the element with the lowest index in the least significant
+  // bits. The sizes of the memref are the logical sizes of the tensor,
+  // while all strides are given in bytes.
+  mlir::IntegerType packedType;
+
+  // Physical dimensions of tensors with a blocked layout, otherwise
+  // empty. The memref has one dimension per physical dimension (see
+  // layout::getMemRefSizeDim()).
+  layout::Layout blockedLayout;
 };
 
-// Collects the set of iterators of a comprehensions by listing all
-// identifiers and retaining only those that are not in the symbol
-// table `symTab`.
-static std::map<std::string, IteratorKind> collectIterators(
-    const lang::Comprehension &comprehension,
-    const llvm::ScopedHashTable<llvm::StringRef, mlir::Value> &symTab) {
-  std::map<std::string, IteratorKind> iterators;
-
-  for (const lang::Ident &lhsIndex : comprehension.indices())
-    iterators.emplace(lhsIndex.name(), IteratorKind::LHS);
-
-  mapRecursive(comprehension.rhs(), [&](const lang::TreeRef &t) {
-    if (t->kind() == lang::TK_IDENT) {
-      std::string name = lang::Ident(t).name();
-
-      if (iterators.find(name) == iterators.end() && symTab.count(name) == 0) {
-        iterators.emplace(name, IteratorKind::RHSOnly);
-      }
-    }
-  });
-
-  return iterators;
-}
+// Maps memrefs to the storage of the tensors they hold
+using TensorStorageMap = llvm::DenseMap<mlir::Value, TensorStorage>;
 
 class MLIRGenBase {
 public:
@@ -142,6 +159,8 @@ protected:
       return builder.getF32Type();
     case lang::TK_FLOAT16:
       return builder.getF16Type();
+    case lang::TK_BFLOAT16:
+      return builder.getBF16Type();
     case lang::TK_FLOAT32:
       return builder.getF32Type();
     case lang::TK_FLOAT64:
@@ -156,20 +175,30 @@ protected:
     case lang::TK_DOUBLE:
     case lang::TK_FLOAT:
     case lang::TK_FLOAT16:
+    case lang::TK_BFLOAT16:
     case lang::TK_FLOAT32:
     case lang::TK_FLOAT64:
       return getFloatType(kind);
+    // Integer types are signless in MLIR; the signedness of unsigned
+    // tensors is only taken into account when their elements are
+    // widened (see MLIRMappedValueExprGen::setAccessWidening)
     case lang::TK_INT2:
+    case lang::TK_UINT2:
       return builder.getIntegerType(2);
     case lang::TK_INT4:
+    case lang::TK_UINT4:
       return builder.getIntegerType(4);
     case lang::TK_INT8:
+    case lang::TK_UINT8:
       return builder.getIntegerType(8);
     case lang::TK_INT16:
+    case lang::TK_UINT16:
       return builder.getIntegerType(16);
     case lang::TK_INT32:
+    case lang::TK_UINT32:
       return builder.getIntegerType(32);
     case lang::TK_INT64:
+    case lang::TK_UINT64:
       return builder.getIntegerType(64);
     case lang::TK_SIZET:
       return builder.getIndexType();
@@ -200,19 +229,52 @@ protected:
       llvm_unreachable("Can only determine rank for MemRef");
   }
 
+  // Returns the element type of memrefs holding tensors with the
+  // scalar type `kind`. Integers with less than 8 bits are packed into
+  // bytes (see TensorStorage).
+  mlir::Type getMemRefElementType(int kind) {
+    if (isPackedIntType(kind))
+      return builder.getIntegerType(8);
+
+    return getScalarType(kind);
+  }
+
   // Translates a TC tensor type into an MLIR tensor type. If the
   // original type is a scalar type, a scalar MLIR type is returned.
+  //
+  // Tensors with a layout other than row-major are represented by
+  // memrefs with a strided layout, in which only the stride of the
+  // innermost physical dimension is static. Memrefs for blocked
+  // layouts have one dimension per physical dimension.
   mlir::Type getTensorType(const lang::TensorType &tensorType) {
-    mlir::Type scalarType = getScalarType(tensorType.scalarType());
     size_t ndims = tensorType.dims().size();
+    mlir::Type elementType = getMemRefElementType(tensorType.scalarType());
 
-    if (ndims > 0) {
-      // Build a MemRef type with the correct number of dimensions,
-      // but leave size of dimensions undefined return
-      return mlir::MemRefType::get(std::vector<int64_t>(ndims, -1), scalarType);
-    } else {
-      return scalarType;
-    }
+    if (ndims == 0)
+      return getScalarType(tensorType.scalarType());
+
+    layout::Layout layout = layout::getLayout(tensorType);
+
+    // Build a MemRef type with the correct number of dimensions,
+    // but leave size of dimensions undefined return
+    if (layout::isRowMajor(layout))
+      return mlir::MemRefType::get(std::vector<int64_t>(ndims, -1),
+                                   elementType);
+
+    int64_t dynStride = mlir::MemRefType::getDynamicStrideOrOffset();
+    size_t rank = layout::isBlocked(layout) ? layout.size() : ndims;
+    std::vector<int64_t> strides(rank, dynStride);
+
+    if (layout::isBlocked(layout))
+      strides.back() = 1;
+    else
+      strides[layout.back().dim] = 1;
+
+    mlir::AffineMap map =
+        mlir::makeStridedLinearLayoutMap(strides, 0, builder.getContext());
+
+    return mlir::MemRefType::get(std::vector<int64_t>(rank, -1), elementType,
+                                 map);
   }
 
   // Translates a TC source location to an MLIR source location
@@ -258,6 +320,18 @@ static bool convertValue(mlir::OpBuilder &builder, mlir::Value &v, mlir::Type t,
   return false;
 }
 
+// Extends the integer value `v` to the wider integer type `t`. The
+// value is zero-extended if `isUnsigned` is true and sign-extended
+// otherwise.
+static mlir::Value extendInteger(mlir::OpBuilder &builder, mlir::Value v,
+                                 mlir::Type t, bool isUnsigned,
+                                 mlir::Location location) {
+  if (isUnsigned)
+    return builder.create<mlir::ZeroExtendIOp>(location, v, t);
+  else
+    return builder.create<mlir::SignExtendIOp>(location, v, t);
+}
+
 // Checks if a value of type `t` can be converted to `targetType`
 // losslessly. Returns true if this is possible, otherwise false.
 static bool typeLosslesslyConvertible(mlir::Type t, mlir::Type targetType) {
@@ -265,7 +339,16 @@ static bool typeLosslesslyConvertible(mlir::Type t, mlir::Type targetType) {
     return true;
 
   if (isMLIRFloatType(t) && isMLIRFloatType(targetType)) {
-    if (getMLIRFloatTypeBits(t) <= getMLIRFloatTypeBits(targetType))
+    // Both the mantissa and the exponent must fit (e.g., neither f16
+    // nor bf16 can represent all values of the other type)
+    unsigned int mantissaBits = getMLIRFloatTypeMantissaBits(t);
+    unsigned int targetMantissaBits = getMLIRFloatTypeMantissaBits(targetType);
+    unsigned int exponentBits = getMLIRFloatTypeBits(t) - mantissaBits - 1;
+    unsigned int targetExponentBits =
+        getMLIRFloatTypeBits(targetType) - targetMantissaBits - 1;
+
+    if (mantissaBits <= targetMantissaBits &&
+        exponentBits <= targetExponentBits)
       return true;
   } else if (isMLIRIntType(t) && isMLIRIntType(targetType)) {
     if (getMLIRIntTypeBits(t) <= getMLIRIntTypeBits(targetType))
@@ -301,8 +384,16 @@ static bool alignTypes(mlir::OpBuilder &builder, mlir::Value &a, mlir::Value &b,
     return convertValue(builder, a, tB, location);
   else if (typeLosslesslyConvertible(tB, tA))
     return convertValue(builder, b, tA, location);
-  else
-    return false;
+
+  // f16 and bf16 cannot represent each other's values; promote both
+  // to f32 like the semantic analysis does
+  if (isMLIRFloatType(tA) && isMLIRFloatType(tB)) {
+    mlir::Type f32 = builder.getF32Type();
+    return convertValue(builder, a, f32, location) &&
+           convertValue(builder, b, f32, location);
+  }
+
+  return false;
 }
 
 // Builds a binary operation from `lhs` and `rhs` associated to the
@@ -338,6 +429,51 @@ mlir::Value buildBinaryExprFromValues(mlir::OpBuilder &builder, mlir::Value lhs,
   }
 }
 
+// Builds the maximum (if `max` is true) or the minimum of `lhs` and
+// `rhs` from a comparison and a select. Integers are compared as
+// unsigned values if `isUnsigned` is true and as signed values
+// otherwise. Floats are compared with ordered predicates, i.e., `rhs`
+// is selected if either value is NaN.
+static mlir::Value buildMinMaxFromValues(mlir::OpBuilder &builder, bool max,
+                                         mlir::Value lhs, mlir::Value rhs,
+                                         bool isUnsigned,
+                                         mlir::FileLineColLoc location) {
+  if (!alignTypes(builder, lhs, rhs, location)) {
+    std::stringstream ss;
+
+    ss << "Operands for binary expression have different types: "
+       << getTypeAsString(lhs.getType()) << " and "
+       << getTypeAsString(rhs.getType());
+
+    mlirgen::SourceException err(location, ss.str());
+    THROW_OR_ASSERT(err);
+  }
+
+  mlir::Type resType = lhs.getType();
+  mlir::Value cond;
+
+  if (isMLIRFloatType(resType)) {
+    cond = builder.create<mlir::CmpFOp>(
+        location, max ? mlir::CmpFPredicate::OGT : mlir::CmpFPredicate::OLT,
+        lhs, rhs);
+  } else if (isMLIRIntType(resType)) {
+    mlir::CmpIPredicate pred;
+
+    if (isUnsigned)
+      pred = max ? mlir::CmpIPredicate::ugt : mlir::CmpIPredicate::ult;
+    else
+      pred = max ? mlir::CmpIPredicate::sgt : mlir::CmpIPredicate::slt;
+
+    cond = builder.create<mlir::CmpIOp>(location, pred, lhs, rhs);
+  } else {
+    mlirgen::SourceException err(
+        location, "Cannot create binary operation: Unsupported operand type");
+    THROW_OR_ASSERT(err);
+  }
+
+  return builder.create<mlir::SelectOp>(location, cond, lhs, rhs);
+}
+
 // Builds MLIR expressions without control flow from tensor
 // expressions
 class MLIRValueExprGen : public MLIRGenBase {
@@ -378,6 +514,9 @@ public:
       if (floatType.isF16()) {
         return builder.create<mlir::ConstantFloatOp>(
             location, llvm::APFloat(llvm::APFloat::IEEEhalf(), cst), floatType);
+      } else if (floatType.isBF16()) {
+        return builder.create<mlir::ConstantFloatOp>(
+            location, llvm::APFloat(llvm::APFloat::BFloat(), cst), floatType);
       } else if (floatType.isF32()) {
         return builder.create<mlir::ConstantFloatOp>(
             location, llvm::APFloat(llvm::APFloat::IEEEsingle(), cst),
@@ -433,10 +572,96 @@ public:
     return symTab.lookup(i.name());
   }
 
+  // Sets the map describing the tensors whose elements cannot be
+  // addressed directly with the tensor indexes (see
+  // TensorStorage). Loads and stores of elements of these tensors
+  // translate the indexes for blocked layouts and unpack and pack
+  // packed elements with shift and mask operations.
+  void setTensorStorage(const TensorStorageMap *tensorStorage) {
+    this->tensorStorage = tensorStorage;
+  }
+
+  // Returns the storage of `tensor` or NULL if the elements of the
+  // tensor are addressed directly with the tensor indexes.
+  const TensorStorage *lookupTensorStorage(mlir::Value tensor) {
+    if (!tensorStorage)
+      return nullptr;
+
+    auto it = tensorStorage->find(tensor);
+
+    if (it == tensorStorage->end())
+      return nullptr;
+
+    return &it->second;
+  }
+
+  // Returns the logical element type of `tensor` if its elements are
+  // packed into bytes, otherwise a null type.
+  mlir::IntegerType getPackedElementType(mlir::Value tensor) {
+    const TensorStorage *storage = lookupTensorStorage(tensor);
+
+    return storage ? storage->packedType : mlir::IntegerType();
+  }
+
+  // Builds a load of the element of `tensor` at the position
+  // `indexes`, unpacking the element if the tensor is packed.
+  mlir::Value buildTensorLoad(mlir::Location location, mlir::Value tensor,
+                              std::vector<mlir::Value> indexes) {
+    buildBlockedIndexes(location, tensor, indexes);
+
+    mlir::IntegerType packedType = getPackedElementType(tensor);
+
+    if (!packedType)
+      return builder.create<mlir::LoadOp>(location, tensor, indexes);
+
+    mlir::Value shift = buildPackedByteIndex(location, packedType, indexes);
+    mlir::Value byte = builder.create<mlir::LoadOp>(location, tensor, indexes);
+    mlir::Value shifted =
+        builder.create<mlir::UnsignedShiftRightOp>(location, byte, shift);
+
+    return builder.create<mlir::TruncateIOp>(location, shifted, packedType);
+  }
+
+  // Builds a store of `value` to the element of `tensor` at the
+  // position `indexes`. Elements of packed tensors are inserted into
+  // the byte holding the element, leaving all other elements of the
+  // byte untouched.
+  mlir::StoreOp buildTensorStore(mlir::Location location, mlir::Value value,
+                                 mlir::Value tensor,
+                                 std::vector<mlir::Value> indexes) {
+    buildBlockedIndexes(location, tensor, indexes);
+
+    mlir::IntegerType packedType = getPackedElementType(tensor);
+
+    if (!packedType)
+      return builder.create<mlir::StoreOp>(location, value, tensor, indexes);
+
+    mlir::Type byteType = builder.getIntegerType(8);
+    mlir::Value shift = buildPackedByteIndex(location, packedType, indexes);
+    mlir::Value byte = builder.create<mlir::LoadOp>(location, tensor, indexes);
+
+    mlir::Value elementMask = builder.create<mlir::ConstantIntOp>(
+        location, (1 << packedType.getWidth()) - 1, byteType);
+    mlir::Value allOnes =
+        builder.create<mlir::ConstantIntOp>(location, -1, byteType);
+    mlir::Value mask =
+        builder.create<mlir::ShiftLeftOp>(location, elementMask, shift);
+    mlir::Value keepMask = builder.create<mlir::XOrOp>(location, mask, allOnes);
+
+    mlir::Value extended =
+        builder.create<mlir::ZeroExtendIOp>(location, value, byteType);
+    mlir::Value shifted =
+        builder.create<mlir::ShiftLeftOp>(location, extended, shift);
+    mlir::Value kept = builder.create<mlir::AndOp>(location, byte, keepMask);
+    mlir::Value merged = builder.create<mlir::OrOp>(location, kept, shifted);
+
+    return builder.create<mlir::StoreOp>(location, merged, tensor, indexes);
+  }
+
   // Builds an MLIR load operation indexing the tensor that
   // corresponds to `ident` using the symbols corresponding to the
   // identifiers from `indices`.
-  virtual mlir::LoadOp
+  virtual mlir::Value
   buildIndexLoadExpr(const lang::Ident &ident,
                      const lang::ListView<lang::Ident> &indices) {
     std::vector<mlir::Value> argVals;
@@ -448,12 +673,12 @@ public:
 
     mlir::Value tensor = symTab.lookup(ident.name());
 
-    return builder.create<mlir::LoadOp>(loc(ident.range()), tensor, argVals);
+    return buildTensorLoad(loc(ident.range()), tensor, argVals);
   }
 
   // Builds an MLIR load operation indexing the tensor that
   // corresponds to `ident` using the expressions passed in `indices`.
-  virtual mlir::LoadOp
+  virtual mlir::Value
   buildIndexLoadExpr(const lang::Ident &ident,
                      const lang::ListView<lang::TreeRef> &indices) {
     std::vector<mlir::Value> argVals;
@@ -465,11 +690,11 @@ public:
 
     mlir::Value tensor = symTab.lookup(ident.name());
 
-    return builder.create<mlir::LoadOp>(loc(ident.range()), tensor, argVals);
+    return buildTensorLoad(loc(ident.range()), tensor, argVals);
   }
 
   // Translates a TC access expression into an MLIR load operation.
-  virtual mlir::LoadOp buildIndexLoadExpr(const lang::Access &a) {
+  virtual mlir::Value buildIndexLoadExpr(const lang::Access &a) {
     return buildIndexLoadExpr(a.name(), a.arguments());
   }
 
@@ -490,10 +715,13 @@ public:
     }
 
     mlir::StoreOp ret =
-        builder.create<mlir::StoreOp>(location, valueToStore, tensor, argVals);
+        buildTensorStore(location, valueToStore, tensor, argVals);
 
     mlir::Type elementType = ret.getMemRefType().getElementType();
 
+    if (mlir::IntegerType packedType = getPackedElementType(tensor))
+      elementType = packedType;
+
     if (elementType != valueToStore.getType()) {
       std::stringstream ss;
 
@@ -660,6 +888,69 @@ public:
 
 protected:
   llvm::ScopedHashTable<llvm::StringRef, mlir::Value> &symTab;
+  const TensorStorageMap *tensorStorage = nullptr;
+
+  // Replaces the logical indexes `indexes` of an element of `tensor`
+  // with the indexes of the physical dimensions if the tensor has a
+  // blocked layout
+  void buildBlockedIndexes(mlir::Location location, mlir::Value tensor,
+                           std::vector<mlir::Value> &indexes) {
+    const TensorStorage *storage = lookupTensorStorage(tensor);
+
+    if (!storage || storage->blockedLayout.empty())
+      return;
+
+    std::vector<mlir::Value> physicalIndexes;
+
+    for (const layout::PhysicalDim &pdim : storage->blockedLayout) {
+      mlir::Value idx = indexes[pdim.dim];
+
+      if (pdim.kind == layout::PhysicalDim::Kind::Full) {
+        physicalIndexes.push_back(idx);
+        continue;
+      }
+
+      mlir::Value blockSize =
+          builder.create<mlir::ConstantIndexOp>(location, pdim.blockSize);
+
+      if (pdim.kind == layout::PhysicalDim::Kind::Outer) {
+        physicalIndexes.push_back(
+            builder.create<mlir::UnsignedDivIOp>(location, idx, blockSize));
+      } else {
+        physicalIndexes.push_back(
+            builder.create<mlir::UnsignedRemIOp>(location, idx, blockSize));
+      }
+    }
+
+    indexes = physicalIndexes;
+  }
+
+  // Replaces the innermost index of `indexes` for an element of a
+  // packed tensor with the logical element type `packedType` by the
+  // index of the byte holding the element and returns the position of
+  // the element within the byte in bits as an i8 value.
+  mlir::Value buildPackedByteIndex(mlir::Location location,
+                                   mlir::IntegerType packedType,
+                                   std::vector<mlir::Value> &indexes) {
+    unsigned int bits = packedType.getWidth();
+    mlir::Value elementsPerByte =
+        builder.create<mlir::ConstantIndexOp>(location, 8 / bits);
+    mlir::Value bitsCst =
+        builder.create<mlir::ConstantIndexOp>(location, bits);
+    mlir::Value idx = indexes.back();
+
+    // Indexes are never negative, so the divisions by powers of two
+    // end up as shifts and masks
+    indexes.back() =
+        builder.create<mlir::UnsignedDivIOp>(location, idx, elementsPerByte);
+
+    mlir::Value pos =
+        builder.create<mlir::UnsignedRemIOp>(location, idx, elementsPerByte);
+    mlir::Value shift = builder.create<mlir::MulIOp>(location, pos, bitsCst);
+
+    return builder.create<mlir::IndexCastOp>(
+        location, builder.getIntegerType(8), shift);
+  }
 };
 
 // Builds MLIR expressions without control flow from tensor
@@ -677,22 +968,108 @@ public:
       : MLIRValueExprGen(_builder, symTab, filename), valMap(valMap) {}
 
   virtual mlir::Value buildExpr(const lang::TreeRef &t) override {
+    mlir::Value val;
     auto idxIt = valMap.find(t->id());
+
     if (idxIt != valMap.end())
-      return idxIt->second;
+      val = idxIt->second;
     else
-      return MLIRValueExprGen::buildExpr(t);
+      val = MLIRValueExprGen::buildExpr(t);
+
+    if (widenedType && t->kind() == lang::TK_ACCESS)
+      val = widenAccess(lang::Access(t), val);
+
+    return val;
+  }
+
+  // Causes all integer tensor elements read by the generated code to
+  // be widened to the integer type `type` before they are used (e.g.,
+  // to multiply int8 values with 32 bits in reductions into int32
+  // tensors). Elements of the tensors listed in `unsignedTensors` are
+  // zero-extended, all others sign-extended.
+  void setAccessWidening(mlir::Type type,
+                         const std::set<std::string> &unsignedTensors) {
+    widenedType = type;
+    this->unsignedTensors = unsignedTensors;
   }
 
 protected:
   const std::map<lang::TreeId, mlir::Value> &valMap;
+  mlir::Type widenedType;
+  std::set<std::string> unsignedTensors;
+
+  mlir::Value widenAccess(const lang::Access &a, mlir::Value val) {
+    mlir::Type t = val.getType();
+
+    if (!isMLIRIntType(t) ||
+        getMLIRIntTypeBits(t) >= getMLIRIntTypeBits(widenedType)) {
+      return val;
+    }
+
+    bool isUnsigned = unsignedTensors.count(a.name().name()) > 0;
+
+    return extendInteger(builder, val, widenedType, isUnsigned,
+                         loc(a.range()));
+  }
+};
+
+// Builds MLIR expressions without control flow from tensor
+// expressions like MLIRMappedValueExprGen, but only generates code
+// once for each set of structurally identical sub-expressions (e.g.,
+// for repeated reads of the same tensor element or for repeated uses
+// of a let binding). Later occurrences reuse the value generated for
+// the first occurrence.
+//
+// The generator must only be used to generate code for a single
+// block or for blocks dominated by the blocks code has previously
+// been generated for.
+class MLIRCSEValueExprGen : public MLIRMappedValueExprGen {
+public:
+  MLIRCSEValueExprGen(
+      mlir::OpBuilder &_builder,
+      const std::map<lang::TreeId, mlir::Value> &valMap,
+      llvm::ScopedHashTable<llvm::StringRef, mlir::Value> &symTab,
+      const std::string &filename = "unknown filename")
+      : MLIRMappedValueExprGen(_builder, valMap, symTab, filename) {}
+
+  virtual mlir::Value buildExpr(const lang::TreeRef &t) override {
+    auto it = known.find(t);
+    if (it != known.end())
+      return it->second;
+
+    mlir::Value val = MLIRMappedValueExprGen::buildExpr(t);
+    known.insert({t, val});
+
+    return val;
+  }
+
+protected:
+  std::unordered_map<lang::TreeRef, mlir::Value, TreeStructuralHash,
+                     TreeStructuralEqual>
+      known;
 };
 
 class MLIRGenImpl : protected MLIRGenBase {
 public:
-  MLIRGenImpl(mlir::MLIRContext *context, const MLIRGenOptions &options,
+  MLIRGenImpl(mlir::MLIRContext *context, mlir::ModuleOp module,
+              const MLIRGenOptions &options,
               const std::string &filename = "unknown file")
-      : MLIRGenBase(context, filename), options(options) {}
+      : MLIRGenBase(context, filename), module(module), options(options) {}
+
+  // Returns the type of the argument of generated functions for a
+  // tensor of type `tensorType`, i.e., the type returned by
+  // getTensorType() or, with `options.dynamic_strides`, a memref type
+  // of the same rank with dynamic strides and offset
+  mlir::Type getArgTensorType(const lang::TensorType &tensorType) {
+    mlir::Type type = getTensorType(tensorType);
+    mlir::MemRefType memrefType = type.dyn_cast<mlir::MemRefType>();
+
+    if (!options.dynamic_strides || !memrefType)
+      return type;
+
+    return getFullyDynamicMemRefType(memrefType.getRank(),
+                                     memrefType.getElementType());
+  }
 
   // Builds a FuncOp for a definition `def`
   mlir::FuncOp buildFunction(const std::string &name, const lang::Def &def) {
@@ -705,7 +1082,7 @@ public:
     // Add tensor parameters
     for (lang::Param param : def.params()) {
       lang::TensorType tensorType = param.tensorType();
-      mlir::Type mlirTensorType = getTensorType(tensorType);
+      mlir::Type mlirTensorType = getArgTensorType(tensorType);
       argTypes.push_back(mlirTensorType);
     }
 
@@ -741,13 +1118,19 @@ public:
         }
       }
 
-      mlir::Type mlirTensorType =
-          mlir::MemRefType::get(std::vector<int64_t>(outputRanks[name], -1),
-                                getScalarType(tcTensorType.scalarType()));
-
-      argTypes.push_back(mlirTensorType);
+      // Scalar outputs are returned through memrefs with 0 dimensions
+      if (tcTensorType.dims().size() == 0) {
+        argTypes.push_back(mlir::MemRefType::get(
+            {}, getMemRefElementType(tcTensorType.scalarType())));
+      } else {
+        argTypes.push_back(getArgTensorType(tcTensorType));
+      }
     }
 
+    // Add table of profiling counters
+    if (options.instrument)
+      argTypes.push_back(getProfileTableType());
+
     mlir::FunctionType func_type =
         builder.getFunctionType(argTypes, llvm::None);
 
@@ -771,6 +1154,7 @@ public:
       // tensor as the defining representative.
       auto checkOrDefineSizeSymbol = [&](const lang::Param &param,
                                          mlir::BlockArgument &arg) {
+        layout::Layout layout = layout::getLayout(param.tensorType());
         size_t dimIdx = 0;
         for (const lang::TreeRef &dim : param.tensorType().dims()) {
           if (dim->kind() == lang::TK_IDENT) {
@@ -778,8 +1162,9 @@ public:
 
             if (symTab.count(ident.name()) == 0) {
               // Use this as a repesentative for the size dimension
-              mlir::Value sizeParamVal =
-                  builder.create<mlir::DimOp>(loc(def.range()), arg, dimIdx);
+              mlir::Value sizeParamVal = builder.create<mlir::DimOp>(
+                  loc(def.range()), arg,
+                  layout::getMemRefSizeDim(layout, dimIdx));
               symTab.insert(ident.name(), sizeParamVal);
             }
           }
@@ -794,25 +1179,99 @@ public:
         paramSpecs.insert({param.ident().name(), param.tensorType()});
       };
 
+      // Registers tensors with packed sub-byte elements or a blocked
+      // layout in `tensorStorage`
+      auto checkStorage = [&](const lang::Param &param,
+                              mlir::BlockArgument &arg) {
+        int kind = param.tensorType().scalarType();
+        layout::Layout layout = layout::getLayout(param.tensorType());
+        TensorStorage storage;
+
+        if (!arg.getType().isa<mlir::MemRefType>())
+          return;
+
+        if (isPackedIntType(kind)) {
+          if (!layout::isRowMajor(layout)) {
+            mlirgen::SourceException err(
+                loc(param.range()),
+                "Tensors with sub-byte elements must be row-major");
+            THROW_OR_ASSERT(err);
+          }
+
+          storage.packedType = getScalarType(kind).cast<mlir::IntegerType>();
+        }
+
+        if (layout::isBlocked(layout))
+          storage.blockedLayout = layout;
+
+        if (storage.packedType || !storage.blockedLayout.empty())
+          tensorStorage.insert({arg, storage});
+      };
+
+      // Attaches the assumptions requested by the options on aliasing
+      // and alignment to the tensor argument `arg` with the index
+      // `argIdx`. The `llvm.noalias` attribute is propagated to the
+      // pointers of the memref descriptor by the conversion to the LLVM
+      // dialect, while the alignment is asserted with an
+      // assume_alignment operation at the beginning of the function.
+      auto addArgAssumptions = [&](const lang::Param &param,
+                                   mlir::BlockArgument &arg, size_t argIdx) {
+        if (!arg.getType().isa<mlir::MemRefType>())
+          return;
+
+        if (options.assume_noalias)
+          funcOp.setArgAttr(argIdx, "llvm.noalias", builder.getBoolAttr(true));
+
+        if (options.assume_aligned) {
+          builder.create<mlir::AssumeAlignmentOp>(
+              loc(param.range()), arg,
+              builder.getI32IntegerAttr(options.assume_aligned));
+        }
+      };
+
       // Process inputs
       for (lang::Param param : def.params()) {
-        mlir::BlockArgument arg = funcOp.getArgument(i++);
+        mlir::BlockArgument arg = funcOp.getArgument(i);
         symTab.insert(param.ident().name(), arg);
         checkOrDefineSizeSymbol(param, arg);
         addParamSpec(param);
+        checkStorage(param, arg);
+        addArgAssumptions(param, arg, i++);
       }
 
       // Process outputs
       for (lang::Param param : def.returns()) {
-        mlir::BlockArgument arg = funcOp.getArgument(i++);
+        mlir::BlockArgument arg = funcOp.getArgument(i);
         symTab.insert(param.ident().name(), arg);
         checkOrDefineSizeSymbol(param, arg);
         addParamSpec(param);
+        checkStorage(param, arg);
+        addArgAssumptions(param, arg, i++);
       }
     }
 
-    for (const lang::Comprehension &comprehension : def.statements())
-      buildComprehension(comprehension);
+    // Analyze all comprehensions once; iterators are all identifiers
+    // that are not in the symbol table at the function scope
+    comprehensionInfos.clear();
+
+    for (const lang::Comprehension &comprehension : def.statements()) {
+      comprehensionInfos.push_back(analyzeComprehension(
+          comprehension,
+          [&](const std::string &name) { return symTab.count(name) != 0; }));
+    }
+
+    if (options.nontemporal_threshold > 0)
+      nonTemporalOutputs = collectNonTemporalOutputs(def);
+
+    if (options.instrument) {
+      mlir::Value profile = funcOp.getArguments().back();
+
+      for (size_t idx = 0; idx < comprehensionInfos.size(); idx++)
+        buildProfiledComprehension(comprehensionInfos[idx], profile, idx);
+    } else {
+      for (size_t idx = 0; idx < comprehensionInfos.size(); idx++)
+        buildComprehension(comprehensionInfos[idx], idx);
+    }
 
     builder.create<mlir::ReturnOp>(loc(def.range()));
 
@@ -822,10 +1281,121 @@ public:
 private:
   llvm::ScopedHashTable<llvm::StringRef, mlir::Value> symTab;
   std::map<const std::string, lang::TensorType> paramSpecs;
+  TensorStorageMap tensorStorage;
+  std::set<std::string> nonTemporalOutputs;
+
+  // Properties of the comprehensions of the current definition, in
+  // the order of the comprehensions
+  std::vector<ComprehensionInfo> comprehensionInfos;
+
+  mlir::ModuleOp module;
   const MLIRGenOptions options;
 
-  // Used for tensor initialization
-  enum NeutralElement { Zero = 0, One = 1 };
+  // Returns the logical element type of the tensor `v` (e.g., i4 for
+  // packed tensors, see TensorStorage). If `v` is not a MemRef value,
+  // the function returns the type of `v`.
+  mlir::Type getElementType(const mlir::Value &v) {
+    auto it = tensorStorage.find(v);
+
+    if (it != tensorStorage.end() && it->second.packedType)
+      return it->second.packedType;
+
+    return MLIRGenBase::getElementType(v);
+  }
+
+  // Checks if the comprehension analyzed in `info` reads or writes
+  // any tensor whose elements cannot be addressed directly with the
+  // tensor indexes (see TensorStorage)
+  bool accessesTensorStorage(const ComprehensionInfo &info) {
+    if (tensorStorage.count(symTab.lookup(info.comprehension.ident().name())))
+      return true;
+
+    for (const lang::Access &a : info.accesses) {
+      if (tensorStorage.count(symTab.lookup(a.name().name())))
+        return true;
+    }
+
+    return false;
+  }
+
+  // Used for tensor initialization. Lowest and Highest are the lowest
+  // and highest values of the element type (-inf and inf for floats).
+  enum NeutralElement { Zero = 0, One = 1, Lowest, Highest };
+
+  // Returns the neutral element of the reduction operator `kind`
+  static NeutralElement getNeutralElement(int kind) {
+    switch (kind) {
+    case lang::TK_PLUS_EQ:
+    case lang::TK_PLUS_EQ_B:
+      return NeutralElement::Zero;
+    case lang::TK_TIMES_EQ:
+    case lang::TK_TIMES_EQ_B:
+      return NeutralElement::One;
+    case lang::TK_MAX_EQ:
+    case lang::TK_MAX_EQ_B:
+      return NeutralElement::Lowest;
+    case lang::TK_MIN_EQ:
+    case lang::TK_MIN_EQ_B:
+      return NeutralElement::Highest;
+    default:
+      llvm_unreachable("Unsupported reduction");
+    }
+  }
+
+  // Returns the constant of type `type` for the neutral element
+  // `value`. The lowest and highest integer values are taken from the
+  // range of unsigned integers if `isUnsigned` is true.
+  mlir::Attribute getNeutralElementAttr(NeutralElement value, mlir::Type type,
+                                        bool isUnsigned) {
+    bool lowest = (value == NeutralElement::Lowest);
+
+    if (mlir::FloatType floatType = type.dyn_cast<mlir::FloatType>()) {
+      switch (value) {
+      case NeutralElement::Zero:
+        return builder.getFloatAttr(type, 0.0);
+      case NeutralElement::One:
+        return builder.getFloatAttr(type, 1.0);
+      case NeutralElement::Lowest:
+      case NeutralElement::Highest:
+        break;
+      }
+
+      return builder.getFloatAttr(
+          type, llvm::APFloat::getInf(floatType.getFloatSemantics(), lowest));
+    }
+
+    unsigned int bits = getMLIRIntTypeBits(type);
+    llvm::APInt cst;
+
+    switch (value) {
+    case NeutralElement::Zero:
+      return builder.getIntegerAttr(type, llvm::APInt(bits, 0));
+    case NeutralElement::One:
+      return builder.getIntegerAttr(type, llvm::APInt(bits, 1));
+    case NeutralElement::Lowest:
+    case NeutralElement::Highest:
+      break;
+    }
+
+    if (isUnsigned) {
+      cst = lowest ? llvm::APInt::getMinValue(bits)
+                   : llvm::APInt::getMaxValue(bits);
+    } else {
+      cst = lowest ? llvm::APInt::getSignedMinValue(bits)
+                   : llvm::APInt::getSignedMaxValue(bits);
+    }
+
+    return builder.getIntegerAttr(type, cst);
+  }
+
+  // Builds a constant of type `type` for the neutral element `value`
+  // (see getNeutralElementAttr())
+  mlir::Value buildNeutralElement(MLIRValueExprGen &exprGen,
+                                  NeutralElement value, mlir::Type type,
+                                  bool isUnsigned, mlir::Location location) {
+    return exprGen.getBuilder().create<mlir::ConstantOp>(
+        location, getNeutralElementAttr(value, type, isUnsigned));
+  }
 
   // Builds a loop nest with one loop per iterator from `iterators`
   // using the bounds from `mlirIteratorBounds`.
@@ -861,7 +1431,88 @@ private:
     return outermost;
   }
 
-  // Builds a linalg.generic operation that initializes the specified
+  // Returns a view of the tensor `tensorVal` named `tensorName`
+  // indexed by the expressions `args`, in which each dimension
+  // directly indexed by an iterator whose domain from `langItBounds`
+  // does not match the size of the dimension is restricted to the
+  // domain of the iterator. That is, the view starts at the lower
+  // bound of the iterator and its size is the number of iterations of
+  // the iterator. All other dimensions are left unchanged.
+  //
+  // If no dimension needs to be restricted, `tensorVal` itself is
+  // returned.
+  mlir::Value buildIteratorDomainSubView(const std::string &tensorName,
+                                         mlir::Value tensorVal,
+                                         const std::vector<lang::TreeRef> &args,
+                                         const IteratorRangeMap &langItBounds,
+                                         mlir::Location location) {
+    MLIRValueExprGen exprGen(builder, symTab, filename);
+    std::vector<mlir::Value> offsets;
+    std::vector<mlir::Value> sizes;
+    bool restricted = false;
+
+    for (size_t dim = 0; dim < args.size(); dim++) {
+      const lang::TreeRef &arg = args[dim];
+
+      if (arg->kind() != lang::TK_IDENT ||
+          langItBounds.count(lang::Ident(arg).name()) == 0 ||
+          iteratorDomainMatchesTensorDimension(paramSpecs, langItBounds,
+                                               lang::Ident(arg).name(),
+                                               tensorName, dim)) {
+        offsets.push_back(builder.create<mlir::ConstantIndexOp>(location, 0));
+        sizes.push_back(builder.create<mlir::DimOp>(location, tensorVal, dim));
+        continue;
+      }
+
+      const lang::RangeConstraint &range =
+          langItBounds.at(lang::Ident(arg).name());
+      mlir::Value lb = exprGen.buildExpr(range.start());
+      mlir::Value ub = exprGen.buildExpr(range.end());
+
+      // Force conversion to index type (the constants above might
+      // well be integers if they are constants)
+      if (!lb.getType().isIndex()) {
+        lb = builder.create<mlir::IndexCastOp>(location, builder.getIndexType(),
+                                               lb);
+      }
+
+      if (!ub.getType().isIndex()) {
+        ub = builder.create<mlir::IndexCastOp>(location, builder.getIndexType(),
+                                               ub);
+      }
+
+      offsets.push_back(lb);
+
+      // lb and ub are of type index; convert to integer, subtract and
+      // convert back to index
+      //
+      // FIXME: Size of Index is platform-dependent, so this might be
+      // a lossy conversion
+      mlir::Value lbInt = builder.create<mlir::IndexCastOp>(
+          location, builder.getIntegerType(64), lb);
+      mlir::Value ubInt = builder.create<mlir::IndexCastOp>(
+          location, builder.getIntegerType(64), ub);
+
+      mlir::Value sizeInt =
+          builder.create<mlir::SubIOp>(location, ubInt, lbInt);
+      mlir::Value size = builder.create<mlir::IndexCastOp>(
+          location, builder.getIndexType(), sizeInt);
+
+      sizes.push_back(size);
+      restricted = true;
+    }
+
+    if (!restricted)
+      return tensorVal;
+
+    std::vector<mlir::Value> strides{
+        args.size(), builder.create<mlir::ConstantIndexOp>(location, 1)};
+
+    return builder.create<mlir::SubViewOp>(location, tensorVal, offsets, sizes,
+                                           strides);
+  }
+
+  // Builds a linalg.fill operation that initializes the specified
   // tensor with the specified value.
   void buildTensorInitialization(const std::string &tensorName,
                                  mlir::Value tensorVal,
@@ -870,110 +1521,83 @@ private:
                                  const IteratorRangeMap &langItBounds) {
     MLIRValueExprGen exprGen(builder, symTab, filename);
     mlir::Type elementType = getElementType(tensorVal);
-    size_t rank = getRank(tensorVal);
-    std::vector<mlir::IteratorType> iteratorTypes(rank,
-                                                  mlir::IteratorType::Parallel);
-    mlir::Value output;
+    std::vector<lang::TreeRef> args;
+
+    for (const lang::Ident &index : indexes)
+      args.push_back(index.tree());
 
-    // Check if the bounds for the iterators used to index the output
-    // tensor are equal to the size of the indexed dimensions.
-    //
-    // If this is the case, just use the output tensor as the output
-    // memref for the linalg.generic operation.
-    //
     // If the iterator ranges do not match the output tensor
-    // dimensions, create a view with a one-to-one mapping from the
+    // dimensions, fill a view with a one-to-one mapping from the
     // iteration domain to the tensor elements.
-    if (comprehensionLHSIteratorDomainsMatchTensorDimensions(
-            paramSpecs, langItBounds, tensorName, indexes)) {
-      output = tensorVal;
-    } else {
-      std::vector<mlir::Value> offsets;
-      std::vector<mlir::Value> sizes;
-      std::vector<mlir::Value> strides{
-          rank, exprGen.buildConstant("1", builder.getIndexType(), location)};
-
-      for (const lang::Ident &index : indexes) {
-        mlir::Value lb =
-            exprGen.buildExpr(langItBounds.at(index.name()).start());
-        mlir::Value ub = exprGen.buildExpr(langItBounds.at(index.name()).end());
-
-        // Force conversion to index type (the constants above might
-        // well be integers if they are constants)
-        if (!lb.getType().isIndex()) {
-          lb = builder.create<mlir::IndexCastOp>(location,
-                                                 builder.getIndexType(), lb);
-        }
-
-        if (!ub.getType().isIndex()) {
-          ub = builder.create<mlir::IndexCastOp>(location,
-                                                 builder.getIndexType(), ub);
-        }
+    mlir::Value output = buildIteratorDomainSubView(
+        tensorName, tensorVal, args, langItBounds, location);
 
-        offsets.push_back(lb);
+    mlir::Value cstVal = buildNeutralElement(
+        exprGen, value, elementType, isUnsignedTensor(tensorName), location);
 
-        // lb and ub are of type index; convert to integer, subtract and
-        // convert back to index
-        //
-        // FIXME: Size of Index is platform-dependent, so this might be
-        // a lossy conversion
-        mlir::Value lbInt = builder.create<mlir::IndexCastOp>(
-            location, builder.getIntegerType(64), lb);
-        mlir::Value ubInt = builder.create<mlir::IndexCastOp>(
-            location, builder.getIntegerType(64), ub);
+    builder.create<mlir::linalg::FillOp>(location, output, cstVal);
+  }
 
-        mlir::Value sizeInt =
-            builder.create<mlir::SubIOp>(location, ubInt, lbInt);
-        mlir::Value size = builder.create<mlir::IndexCastOp>(
-            location, builder.getIndexType(), sizeInt);
+  // Initializes the elements of the tensor `ident` indexed by
+  // `indexes` like buildTensorInitialization, but with a loop nest
+  // storing one element after another. This is used for tensors with
+  // packed elements or blocked layouts, whose elements cannot be
+  // addressed by linalg.fill.
+  void buildElementwiseTensorInitialization(
+      const lang::Ident &ident, const lang::ListView<lang::Ident> &indexes,
+      mlir::Location location, NeutralElement value,
+      const IteratorRangeMap &langItBounds) {
+    llvm::ScopedHashTableScope<llvm::StringRef, mlir::Value> var_scope(symTab);
+    MLIRValueExprGen exprGen(builder, symTab, filename);
+    std::vector<std::string> iterators;
 
-        sizes.push_back(size);
-      }
+    exprGen.setTensorStorage(&tensorStorage);
 
-      output = builder.create<mlir::SubViewOp>(location, tensorVal, offsets,
-                                               sizes, strides);
-    }
+    for (const lang::Ident &index : indexes)
+      iterators.push_back(index.name());
 
-    mlir::Value cstVal;
+    IteratorBoundsMap mlirItBounds =
+        exprGen.translateIteratorBounds(langItBounds);
 
-    switch (value) {
-    case NeutralElement::Zero:
-      cstVal = exprGen.buildConstant("0", elementType, location);
-      break;
-    case NeutralElement::One:
-      cstVal = exprGen.buildConstant("1", elementType, location);
-      break;
-    }
+    mlir::Block *currBlock = builder.getInsertionBlock();
 
-    builder.create<mlir::linalg::FillOp>(location, output, cstVal);
-  }
+    buildLoopNest(iterators, mlirItBounds, location);
+    exprGen.getBuilder().setInsertionPoint(builder.getInsertionBlock(),
+                                           builder.getInsertionPoint());
 
-  // Collects all access expressions that are descendants of t in an
-  // arbitrary order
-  std::vector<lang::Access> collectTensorAccessesSeq(const lang::TreeRef &t) {
-    std::vector<lang::Access> res;
+    mlir::Type elementType = getElementType(symTab.lookup(ident.name()));
+    mlir::Value cstVal = buildNeutralElement(
+        exprGen, value, elementType, isUnsignedTensor(ident.name()), location);
 
-    // Collect all tensor accesses in subexpressions
-    mapRecursive(t, [&](const lang::TreeRef &e) {
-      if (e->kind() == lang::TK_ACCESS)
-        res.push_back(lang::Access(e));
-    });
+    exprGen.buildIndexStoreExpr(cstVal, ident, indexes);
 
-    return res;
+    // Restore insertion point to point after the outermost loop
+    builder.setInsertionPointToEnd(currBlock);
   }
 
   // Builds the core of a comprehension (e.g., just the actual
   // compitation without the initialization broadcasting the neutral
   // element for default-initialized reductions). This is the fallback
   // routine for comprehensions with possibly non-affine accesses.
-  void buildLoopReductionCore(const lang::Comprehension &c, mlir::Value tensor,
+  void buildLoopReductionCore(const ComprehensionInfo &info,
+                              mlir::Value tensor,
                               const std::vector<std::string> &iteratorsSeq,
-                              const IteratorRangeMap &langItBounds,
                               mlir::Location location) {
-    MLIRValueExprGen exprGen(builder, symTab, filename);
+    const lang::Comprehension &c = info.comprehension;
+
+    // Structurally identical sub-expressions (e.g., repeated reads
+    // of the same tensor element) are only evaluated once per
+    // iteration
+    std::map<lang::TreeId, mlir::Value> noMappings;
+    MLIRCSEValueExprGen exprGen(builder, noMappings, symTab, filename);
+
+    exprGen.setTensorStorage(&tensorStorage);
+
+    if (mlir::Type t = getOperandWideningType(c, tensor, mlir::Type()))
+      exprGen.setAccessWidening(t, collectUnsignedTensors());
 
     IteratorBoundsMap mlirItBounds =
-        exprGen.translateIteratorBounds(langItBounds);
+        exprGen.translateIteratorBounds(info.bounds);
 
     mlir::Block *currBlock = builder.getInsertionBlock();
 
@@ -982,29 +1606,21 @@ private:
 
     exprGen.getBuilder().setInsertionPointToStart(innermost.getBody());
 
+    if (options.prefetch_distance > 0)
+      buildPrefetches(info, iteratorsSeq, innermost);
+
     // Build expression for RHS of assignment
     mlir::Value rhsVal = exprGen.buildExpr(c.rhs());
     mlir::Value accu;
     mlir::Value assignmentVal;
 
-    switch (c.assignment()->kind()) {
-    case lang::TK_PLUS_EQ:
-    case lang::TK_PLUS_EQ_B:
+    if (c.assignment()->kind() == '=') {
+      assignmentVal = rhsVal;
+    } else {
       accu = exprGen.buildIndexLoadExpr(c.ident(), c.indices());
-      assignmentVal = buildBinaryExprFromValues<mlir::AddFOp, mlir::AddIOp>(
-          exprGen.getBuilder(), rhsVal, accu, loc(c.range()));
-      break;
-    case lang::TK_TIMES_EQ:
-    case lang::TK_TIMES_EQ_B:
-      accu = exprGen.buildIndexLoadExpr(c.ident(), c.indices());
-      assignmentVal = buildBinaryExprFromValues<mlir::MulFOp, mlir::MulIOp>(
-          exprGen.getBuilder(), rhsVal, accu, loc(c.range()));
-      break;
-    case '=':
-      assignmentVal = rhsVal;
-      break;
-    default:
-      llvm_unreachable("Unsupported operator");
+      assignmentVal = buildReductionStep(
+          exprGen.getBuilder(), c.assignment()->kind(), rhsVal, accu,
+          isUnsignedTensor(c.ident().name()), loc(c.range()));
     }
 
     mlir::Type elementType = getElementType(symTab.lookup(c.ident().name()));
@@ -1022,45 +1638,814 @@ private:
       THROW_OR_ASSERT(err);
     }
 
-    exprGen.buildIndexStoreExpr(assignmentVal, c.ident(), c.indices());
+    mlir::StoreOp store =
+        exprGen.buildIndexStoreExpr(assignmentVal, c.ident(), c.indices());
+
+    // Stores to write-once outputs bypass the cache (see
+    // collectNonTemporalOutputs())
+    if (nonTemporalOutputs.count(c.ident().name()))
+      store.setAttr("nontemporal", builder.getBoolAttr(true));
 
     // Restore insertion point to point after the outermost loop
     builder.setInsertionPointToEnd(currBlock);
   }
 
-  // Creates an instance of OP_T from c if CHECK_FUNC returns
-  // true. The order of the input operands to OP_T is the canonical
-  // order provided by CHECK_FUNC and the order of output operands is
-  // the same as in outputs.
-  template <typename OP_T, int num_inputs,
-            bool (*CHECK_FUNC)(const lang::Comprehension &c,
-                               size_t (*canonical_order)[num_inputs])>
-  bool tryBuildSpecializedLinalgOp(
-      const lang::Comprehension &c,
-      llvm::ArrayRef<mlir::edsc::StructuredIndexed> inputs,
-      llvm::ArrayRef<mlir::edsc::StructuredIndexed> outputs) {
+  // Returns the type of the table of profiling counters passed to
+  // instrumented functions (see MLIRGenOptions::instrument)
+  mlir::MemRefType getProfileTableType() {
+    return mlir::MemRefType::get({-1, 2}, builder.getIntegerType(64));
+  }
 
-    llvm::SmallVector<mlir::Value, 4> rearranged;
-    size_t canon[num_inputs];
+  // Builds the code for the comprehension analyzed in `info` with the
+  // index `idx` enclosed by reads of the cycle counter and adds the
+  // elapsed cycles and one execution to the row `idx` of the table of
+  // profiling counters `profile`
+  void buildProfiledComprehension(const ComprehensionInfo &info,
+                                  mlir::Value profile, size_t idx) {
+    mlir::Location location = loc(info.comprehension.range());
+    mlir::Type i64 = builder.getIntegerType(64);
+    mlir::FuncOp cycles = getOrDeclareExternalFunction("_teckyl_prof_cycles",
+                                                       {}, location, {i64});
+
+    mlir::Value start =
+        builder.create<mlir::CallOp>(location, cycles).getResult(0);
+
+    buildComprehension(info, idx);
+
+    mlir::Value end =
+        builder.create<mlir::CallOp>(location, cycles).getResult(0);
+    mlir::Value elapsed = builder.create<mlir::SubIOp>(location, end, start);
+    mlir::Value one = builder.create<mlir::ConstantOp>(
+        location, builder.getI64IntegerAttr(1));
+
+    // Adds `v` to the counter in column `col` of the row
+    auto addToCounter = [&](int64_t col, mlir::Value v) {
+      std::vector<mlir::Value> indexes{
+          builder.create<mlir::ConstantIndexOp>(location, idx),
+          builder.create<mlir::ConstantIndexOp>(location, col)};
+      mlir::Value counter =
+          builder.create<mlir::LoadOp>(location, profile, indexes);
+      mlir::Value sum = builder.create<mlir::AddIOp>(location, counter, v);
+
+      builder.create<mlir::StoreOp>(location, sum, profile, indexes);
+    };
+
+    addToCounter(0, elapsed);
+    addToCounter(1, one);
+  }
+
+  // Builds prefetch operations at the current insertion point for the
+  // gathers and strided reads of the comprehension analyzed in `info`
+  // (see isPrefetchCandidate()) within the loop nest for the iterators
+  // `iteratorsSeq`, whose innermost loop is `innermost`. The elements
+  // read `options.prefetch_distance` iterations of the innermost loop
+  // ahead are prefetched. The position ahead is clamped to the last
+  // iteration, such that indexes of gathers are never loaded out of
+  // bounds.
+  void buildPrefetches(const ComprehensionInfo &info,
+                       const std::vector<std::string> &iteratorsSeq,
+                       mlir::scf::ForOp innermost) {
+    const std::string &innermostIt = iteratorsSeq.back();
+    std::set<std::string> iteratorSet(iteratorsSeq.begin(),
+                                      iteratorsSeq.end());
+    std::vector<lang::Access> candidates;
+    std::unordered_set<lang::TreeRef, TreeStructuralHash, TreeStructuralEqual>
+        distinctAccesses;
+
+    for (const lang::Access &a : info.accesses) {
+      // Accesses to tensors with packed elements or blocked layouts
+      // are not prefetched
+      if (tensorStorage.count(symTab.lookup(a.name().name())))
+        continue;
+
+      if (isPrefetchCandidate(a, innermostIt, iteratorSet) &&
+          distinctAccesses.insert(a.tree()).second) {
+        candidates.push_back(a);
+      }
+    }
 
-    // Check if c is of correct type and determine canonical order for
-    // input operands
-    if (CHECK_FUNC(c, &canon)) {
-      for (int i = 0; i < num_inputs; i++)
-        rearranged.push_back(inputs[canon[i]]);
+    if (candidates.empty())
+      return;
+
+    mlir::Location location = loc(info.comprehension.range());
+    mlir::Value distance = builder.create<mlir::ConstantIndexOp>(
+        location, options.prefetch_distance);
+    mlir::Value one = builder.create<mlir::ConstantIndexOp>(location, 1);
+    mlir::Value ahead = builder.create<mlir::AddIOp>(
+        location, innermost.getInductionVar(), distance);
+    mlir::Value last =
+        builder.create<mlir::SubIOp>(location, innermost.upperBound(), one);
+    mlir::Value inBounds = builder.create<mlir::CmpIOp>(
+        location, mlir::CmpIPredicate::slt, ahead, last);
+    mlir::Value clamped =
+        builder.create<mlir::SelectOp>(location, inBounds, ahead, last);
+
+    // Evaluate the indexes with the innermost iterator mapped to the
+    // position ahead
+    llvm::ScopedHashTableScope<llvm::StringRef, mlir::Value> aheadScope(
+        symTab);
+    symTab.insert(innermostIt, clamped);
 
-      for (mlir::edsc::StructuredIndexed o : outputs)
-        rearranged.push_back(o);
+    MLIRValueExprGen exprGen(builder, symTab, filename);
+
+    for (const lang::Access &a : candidates) {
+      std::vector<mlir::Value> indexes;
+
+      for (const lang::TreeRef &arg : a.arguments()) {
+        mlir::Value idx = exprGen.buildExpr(arg);
 
-      mlir::ValueRange operands(
-          mlir::ArrayRef<mlir::Value>{rearranged.begin(), rearranged.end()});
+        if (!idx.getType().isIndex()) {
+          idx = builder.create<mlir::IndexCastOp>(location,
+                                                  builder.getIndexType(), idx);
+        }
 
-      builder.create<OP_T>(loc(c.range()), mlir::TypeRange{}, operands);
+        indexes.push_back(idx);
+      }
 
+      builder.create<mlir::PrefetchOp>(location,
+                                       symTab.lookup(a.name().name()), indexes,
+                                       /*isWrite=*/false,
+                                       /*localityHint=*/3,
+                                       /*isDataCache=*/true);
+    }
+  }
+
+  // Checks if `kind` is one of the reduction operators supported for
+  // widened accumulation
+  static bool isSumOrProductReduction(int kind) {
+    switch (kind) {
+    case lang::TK_PLUS_EQ:
+    case lang::TK_PLUS_EQ_B:
+    case lang::TK_TIMES_EQ:
+    case lang::TK_TIMES_EQ_B:
       return true;
+    default:
+      return false;
     }
+  }
 
-    return false;
+  // Builds one step of the reduction operator `kind`, combining the
+  // value `rhsVal` with the accumulator `accu`. Integer maxima and
+  // minima compare unsigned values if `isUnsigned` is true.
+  static mlir::Value buildReductionStep(mlir::OpBuilder &b, int kind,
+                                        mlir::Value rhsVal, mlir::Value accu,
+                                        bool isUnsigned,
+                                        mlir::FileLineColLoc location) {
+    switch (kind) {
+    case lang::TK_PLUS_EQ:
+    case lang::TK_PLUS_EQ_B:
+      return buildBinaryExprFromValues<mlir::AddFOp, mlir::AddIOp>(
+          b, rhsVal, accu, location);
+    case lang::TK_TIMES_EQ:
+    case lang::TK_TIMES_EQ_B:
+      return buildBinaryExprFromValues<mlir::MulFOp, mlir::MulIOp>(
+          b, rhsVal, accu, location);
+    case lang::TK_MAX_EQ:
+    case lang::TK_MAX_EQ_B:
+      return buildMinMaxFromValues(b, true, rhsVal, accu, isUnsigned,
+                                   location);
+    case lang::TK_MIN_EQ:
+    case lang::TK_MIN_EQ_B:
+      return buildMinMaxFromValues(b, false, rhsVal, accu, isUnsigned,
+                                   location);
+    default:
+      llvm_unreachable("Unsupported operator");
+    }
+  }
+
+  // Returns true if the tensor `name` has been declared with an
+  // unsigned integer element type
+  bool isUnsignedTensor(const std::string &name) {
+    auto it = paramSpecs.find(name);
+
+    return it != paramSpecs.end() &&
+           isUnsignedIntType(it->second.scalarType());
+  }
+
+  // Returns the names of all tensors declared with an unsigned
+  // integer element type
+  std::set<std::string> collectUnsignedTensors() {
+    std::set<std::string> res;
+
+    for (const auto &spec : paramSpecs) {
+      if (isUnsignedIntType(spec.second.scalarType()))
+        res.insert(spec.first);
+    }
+
+    return res;
+  }
+
+  // Returns the type in which the reduction of the comprehension
+  // analyzed in `info` into `tensor` should be accumulated if it
+  // differs from the element type of the tensor, i.e., if a wider
+  // accumulation type has been requested for a sum or product of the
+  // same kind (float or integer) as the tensor. Otherwise, a null
+  // type is returned.
+  mlir::Type getWideningAccumulationType(const ComprehensionInfo &info,
+                                         mlir::Value tensor) {
+    mlir::Type elementType = getElementType(tensor);
+    mlir::Type accuType;
+
+    if (!isSumOrProductReduction(info.comprehension.assignment()->kind()))
+      return mlir::Type();
+
+    switch (options.accumulation_type) {
+    case MLIRGenOptions::AccumulationType::Output:
+      return mlir::Type();
+    case MLIRGenOptions::AccumulationType::F32:
+      accuType = builder.getF32Type();
+      break;
+    case MLIRGenOptions::AccumulationType::F64:
+      accuType = builder.getF64Type();
+      break;
+    case MLIRGenOptions::AccumulationType::I32:
+      accuType = builder.getIntegerType(32);
+      break;
+    }
+
+    if (isMLIRFloatType(elementType) && isMLIRFloatType(accuType) &&
+        getMLIRFloatTypeBits(elementType) < getMLIRFloatTypeBits(accuType)) {
+      return accuType;
+    }
+
+    // Integer reductions are only widened if all operands fit into the
+    // output type, such that the narrowing after the reduction never
+    // hides a lossy conversion of an operand
+    if (isMLIRIntType(elementType) && isMLIRIntType(accuType) &&
+        getMLIRIntTypeBits(elementType) < getMLIRIntTypeBits(accuType) &&
+        integerOperandsFitType(info, elementType)) {
+      return accuType;
+    }
+
+    return mlir::Type();
+  }
+
+  // Checks if all integer tensor elements and integer constants
+  // referenced by the right hand side of the comprehension analyzed in
+  // `info` have at most as many bits as the integer type `type`
+  bool integerOperandsFitType(const ComprehensionInfo &info, mlir::Type type) {
+    auto fits = [&](mlir::Type operandType) {
+      return !isMLIRIntType(operandType) ||
+             getMLIRIntTypeBits(operandType) <= getMLIRIntTypeBits(type);
+    };
+
+    for (const lang::Access &a : info.accesses)
+      if (!fits(getElementType(symTab.lookup(a.name().name()))))
+        return false;
+
+    for (const lang::Const &cst : info.constants)
+      if (!fits(getScalarType(cst.type()->kind())))
+        return false;
+
+    return true;
+  }
+
+  // Returns the integer type to which tensor elements read by the
+  // sum or product `c` into `tensor` must be widened before they are
+  // combined, such that no intermediate result (e.g., the product of
+  // two int8 values) is computed with fewer bits than the
+  // accumulator. `accuType` is the accumulation type or a null type
+  // if the reduction accumulates in the element type of
+  // `tensor`. Returns a null type if no widening is necessary.
+  mlir::Type getOperandWideningType(const lang::Comprehension &c,
+                                    mlir::Value tensor, mlir::Type accuType) {
+    mlir::Type t = accuType ? accuType : getElementType(tensor);
+
+    if (!isSumOrProductReduction(c.assignment()->kind()) ||
+        !isMLIRIntType(t)) {
+      return mlir::Type();
+    }
+
+    return t;
+  }
+
+  // Returns the value of the scalar parameter `name` or of the first
+  // element of the tensor parameter `name`. Returns a null value if
+  // the definition has no such parameter.
+  mlir::Value buildParameterScalarRead(mlir::OpBuilder &b,
+                                       const std::string &name,
+                                       mlir::Location location) {
+    if (name.empty() || symTab.count(name) == 0)
+      return mlir::Value();
+
+    mlir::Value param = symTab.lookup(name);
+
+    if (!param.getType().isa<mlir::MemRefType>())
+      return param;
+
+    mlir::Value zero = b.create<mlir::ConstantIndexOp>(location, 0);
+    std::vector<mlir::Value> indexes(getRank(param), zero);
+
+    return b.create<mlir::LoadOp>(location, param, indexes);
+  }
+
+  // Converts the integer accumulator `accu` into the narrower integer
+  // type `outType` of the output tensor `outTensorName`.
+  //
+  // If `scale` is non-null, the accumulator is requantized first,
+  // i.e., multiplied with the floating point value `scale`, rounded
+  // half away from zero and offset by `zeroPoint` (if non-null). The
+  // result is saturated to the range of `outType`.
+  mlir::Value buildIntegerNarrowing(mlir::OpBuilder &b, mlir::Value accu,
+                                    mlir::Type outType,
+                                    const std::string &outTensorName,
+                                    mlir::Value scale, mlir::Value zeroPoint,
+                                    mlir::Location location) {
+    mlir::Type accuType = accu.getType();
+    unsigned int accuBits = getMLIRIntTypeBits(accuType);
+    unsigned int outBits = getMLIRIntTypeBits(outType);
+
+    if (scale) {
+      mlir::Type floatType = scale.getType();
+      mlir::Value x = b.create<mlir::SIToFPOp>(location, accu, floatType);
+      mlir::Value half =
+          b.create<mlir::ConstantOp>(location, b.getFloatAttr(floatType, 0.5));
+      mlir::Value fzero =
+          b.create<mlir::ConstantOp>(location, b.getFloatAttr(floatType, 0.0));
+
+      x = b.create<mlir::MulFOp>(location, x, scale);
+
+      mlir::Value isNegative = b.create<mlir::CmpFOp>(
+          location, mlir::CmpFPredicate::OLT, x, fzero);
+
+      x = b.create<mlir::SelectOp>(location, isNegative,
+                                   b.create<mlir::SubFOp>(location, x, half),
+                                   b.create<mlir::AddFOp>(location, x, half));
+      accu = b.create<mlir::FPToSIOp>(location, x, accuType);
+
+      if (zeroPoint) {
+        mlir::Type zeroPointType = zeroPoint.getType();
+
+        if (getMLIRIntTypeBits(zeroPointType) < accuBits) {
+          zeroPoint = extendInteger(b, zeroPoint, accuType, false, location);
+        } else if (getMLIRIntTypeBits(zeroPointType) > accuBits) {
+          zeroPoint =
+              b.create<mlir::TruncateIOp>(location, zeroPoint, accuType);
+        }
+
+        accu = b.create<mlir::AddIOp>(location, accu, zeroPoint);
+      }
+    }
+
+    // Saturate to the range of the output type
+    llvm::APInt minVal, maxVal;
+
+    if (isUnsignedTensor(outTensorName)) {
+      minVal = llvm::APInt::getMinValue(outBits).zext(accuBits);
+      maxVal = llvm::APInt::getMaxValue(outBits).zext(accuBits);
+    } else {
+      minVal = llvm::APInt::getSignedMinValue(outBits).sext(accuBits);
+      maxVal = llvm::APInt::getSignedMaxValue(outBits).sext(accuBits);
+    }
+
+    mlir::Value minCst = b.create<mlir::ConstantOp>(
+        location, b.getIntegerAttr(accuType, minVal));
+    mlir::Value maxCst = b.create<mlir::ConstantOp>(
+        location, b.getIntegerAttr(accuType, maxVal));
+
+    mlir::Value belowMin = b.create<mlir::CmpIOp>(
+        location, mlir::CmpIPredicate::slt, accu, minCst);
+    accu = b.create<mlir::SelectOp>(location, belowMin, minCst, accu);
+
+    mlir::Value aboveMax = b.create<mlir::CmpIOp>(
+        location, mlir::CmpIPredicate::sgt, accu, maxCst);
+    accu = b.create<mlir::SelectOp>(location, aboveMax, maxCst, accu);
+
+    return b.create<mlir::TruncateIOp>(location, accu, outType);
+  }
+
+  // Builds the core of a reduction like buildLoopReductionCore, but
+  // keeps the accumulator in a value of type `accuType` carried by
+  // the loops over the reduction iterators instead of reading and
+  // writing the output tensor in every iteration. The loops over the
+  // iterators indexing the output tensor enclose the reduction loops.
+  //
+  // Default-initialized reductions start from the neutral element
+  // and do not require a prior initialization of the output tensor;
+  // other reductions load and widen each element of the output
+  // tensor once before the reduction loops. The result is narrowed
+  // (and requantized for integers, see buildIntegerNarrowing) and
+  // stored once after the reduction loops.
+  void buildAccumulatingLoopReductionCore(const ComprehensionInfo &info,
+                                          mlir::Value tensor,
+                                          mlir::Type accuType,
+                                          mlir::Location location) {
+    const lang::Comprehension &c = info.comprehension;
+    std::map<lang::TreeId, mlir::Value> noMappings;
+    MLIRCSEValueExprGen exprGen(builder, noMappings, symTab, filename);
+    mlir::OpBuilder &b = exprGen.getBuilder();
+    mlir::Type elementType = getElementType(tensor);
+    const std::string &outTensorName = c.ident().name();
+    bool isInteger = isMLIRIntType(accuType);
+
+    exprGen.setTensorStorage(&tensorStorage);
+
+    if (isInteger)
+      exprGen.setAccessWidening(accuType, collectUnsignedTensors());
+
+    IteratorBoundsMap mlirItBounds =
+        exprGen.translateIteratorBounds(info.bounds);
+
+    // Requantization parameters are loop-invariant
+    mlir::Value scale, zeroPoint;
+
+    if (isInteger) {
+      scale = buildParameterScalarRead(b, options.requantize_scale, location);
+      zeroPoint =
+          buildParameterScalarRead(b, options.requantize_zero_point, location);
+
+      if (scale && !isMLIRFloatType(scale.getType())) {
+        mlirgen::SourceException err(
+            location,
+            "The requantization scale must be a floating point value");
+        THROW_OR_ASSERT(err);
+      }
+
+      if (zeroPoint && !isMLIRIntType(zeroPoint.getType())) {
+        mlirgen::SourceException err(
+            location, "The requantization zero point must be an integer value");
+        THROW_OR_ASSERT(err);
+      }
+
+      if (scale && (c.assignment()->kind() == lang::TK_PLUS_EQ ||
+                    c.assignment()->kind() == lang::TK_TIMES_EQ)) {
+        mlirgen::SourceException err(
+            location, "Requantized reductions must be default-initialized");
+        THROW_OR_ASSERT(err);
+      }
+    }
+
+    std::vector<std::string> lhsIterators;
+    std::vector<std::string> reductionIterators(info.reductionIterators.begin(),
+                                                info.reductionIterators.end());
+
+    for (const lang::Ident &index : c.indices())
+      lhsIterators.push_back(index.name());
+
+    mlir::Block *currBlock = builder.getInsertionBlock();
+    mlir::scf::ForOp innermost;
+
+    if (!lhsIterators.empty()) {
+      buildLoopNest(lhsIterators, mlirItBounds, location, &innermost);
+      b.setInsertionPointToStart(innermost.getBody());
+    }
+
+    mlir::Value accu;
+
+    switch (c.assignment()->kind()) {
+    case lang::TK_PLUS_EQ_B:
+      accu = exprGen.buildConstant("0", accuType, location);
+      break;
+    case lang::TK_TIMES_EQ_B:
+      accu = exprGen.buildConstant("1", accuType, location);
+      break;
+    default:
+      accu = exprGen.buildIndexLoadExpr(c.ident(), c.indices());
+
+      if (isInteger) {
+        accu = extendInteger(b, accu, accuType,
+                             isUnsignedTensor(outTensorName), location);
+      } else {
+        convertValue(b, accu, accuType, location);
+      }
+    }
+
+    // Build the reduction loops, each carrying the accumulator
+    mlir::Value step = b.create<mlir::ConstantIndexOp>(location, 1);
+    std::vector<mlir::scf::ForOp> reductionLoops;
+
+    for (const std::string &it : reductionIterators) {
+      mlir::scf::ForOp loop = b.create<mlir::scf::ForOp>(
+          location, mlirItBounds.at(it).first, mlirItBounds.at(it).second,
+          step, mlir::ValueRange{accu});
+
+      symTab.insert(it, loop.getInductionVar());
+      accu = loop.getRegionIterArgs().front();
+      reductionLoops.push_back(loop);
+
+      b.setInsertionPointToStart(loop.getBody());
+    }
+
+    mlir::Value rhsVal = exprGen.buildExpr(c.rhs());
+
+    if (!convertValue(b, rhsVal, accuType, loc(c.range()))) {
+      std::stringstream ss;
+
+      ss << "Operand for assignment cannot be converted to the "
+            "accumulation type: "
+         << "cannot convert " << getTypeAsString(rhsVal.getType()) << " to "
+         << getTypeAsString(accuType);
+
+      mlirgen::SourceException err(loc(c.range()), ss.str());
+      THROW_OR_ASSERT(err);
+    }
+
+    accu = buildReductionStep(b, c.assignment()->kind(), rhsVal, accu,
+                              isUnsignedTensor(outTensorName), loc(c.range()));
+
+    // Yield the accumulator from the innermost to the outermost
+    // reduction loop
+    for (auto it = reductionLoops.rbegin(); it != reductionLoops.rend();
+         ++it) {
+      b.create<mlir::scf::YieldOp>(location, mlir::ValueRange{accu});
+      accu = it->getResult(0);
+      b.setInsertionPointAfter(*it);
+    }
+
+    mlir::Value narrowed;
+
+    if (isInteger) {
+      narrowed = buildIntegerNarrowing(b, accu, elementType, outTensorName,
+                                       scale, zeroPoint, location);
+    } else {
+      narrowed = b.create<mlir::FPTruncOp>(location, accu, elementType);
+    }
+
+    exprGen.buildIndexStoreExpr(narrowed, c.ident(), c.indices());
+
+    // Restore insertion point to point after the outermost loop
+    builder.setInsertionPointToEnd(currBlock);
+  }
+
+  // Creates an instance of OP_T from c. The order of the input
+  // operands to OP_T is the canonical order `canon` of the pattern
+  // matched by c (see pattern::classifyComprehension()) and the order
+  // of output operands is the same as in outputs.
+  template <typename OP_T>
+  bool
+  buildNamedLinalgOp(const lang::Comprehension &c, const size_t (&canon)[2],
+                     llvm::ArrayRef<mlir::edsc::StructuredIndexed> inputs,
+                     llvm::ArrayRef<mlir::edsc::StructuredIndexed> outputs) {
+    llvm::SmallVector<mlir::Value, 4> rearranged;
+
+    for (int i = 0; i < 2; i++)
+      rearranged.push_back(inputs[canon[i]]);
+
+    for (mlir::edsc::StructuredIndexed o : outputs)
+      rearranged.push_back(o);
+
+    // Named contractions do not perform any implicit conversions;
+    // leave mixed-type comprehensions to linalg.generic
+    if (!haveUniformFloatElementType(rearranged))
+      return false;
+
+    mlir::ValueRange operands(
+        mlir::ArrayRef<mlir::Value>{rearranged.begin(), rearranged.end()});
+
+    builder.create<OP_T>(loc(c.range()), mlir::TypeRange{}, operands);
+
+    return true;
+  }
+
+  // Checks if all memref values share the same floating point
+  // element type
+  bool haveUniformFloatElementType(llvm::ArrayRef<mlir::Value> values) {
+    mlir::Type elementType = getElementType(values.front());
+
+    if (!elementType.isa<mlir::FloatType>())
+      return false;
+
+    return llvm::all_of(values, [&](mlir::Value v) {
+      return getElementType(v) == elementType;
+    });
+  }
+
+  // Creates a linalg.copy operation from c, which must be a copy of a
+  // tensor with the dimensions permuted by `permutation` (e.g., a
+  // transposition).
+  bool tryBuildCopyOp(const lang::Comprehension &c,
+                      const std::vector<unsigned> &permutation,
+                      llvm::ArrayRef<mlir::edsc::StructuredIndexed> inputs,
+                      llvm::ArrayRef<mlir::edsc::StructuredIndexed> outputs) {
+    mlir::Value input = inputs[0];
+    mlir::Value output = outputs[0];
+
+    // Copies do not perform any conversion of the elements
+    if (getElementType(input) != getElementType(output))
+      return false;
+
+    mlir::AffineMap perm =
+        mlir::AffineMap::getPermutationMap(permutation, builder.getContext());
+    mlir::AffineMapAttr inputPerm;
+
+    if (!perm.isIdentity())
+      inputPerm = mlir::AffineMapAttr::get(perm);
+
+    builder.create<mlir::linalg::CopyOp>(loc(c.range()), input, output,
+                                         inputPerm, mlir::AffineMapAttr());
+
+    return true;
+  }
+
+  // Tries to build a linalg.pooling_sum operation from the
+  // comprehension analyzed in `info`. Since the iterators for the
+  // window dimensions do not index any tensor dimension directly, the
+  // window sizes are taken from their explicit ranges, which must
+  // start at zero and end at a numeric constant. The domains of the
+  // iterators for the output tensor must match its dimensions.
+  bool tryBuildPoolingOp(const ComprehensionInfo &info, mlir::Value outTensor,
+                         mlir::Location location) {
+    const lang::Comprehension &c = info.comprehension;
+    const IteratorRangeMap &langItBounds = info.bounds;
+
+    if (info.pattern.kind != pattern::Kind::SumPooling)
+      return false;
+
+    for (const lang::Ident &idx : c.indices()) {
+      if (langItBounds.find(idx.name()) == langItBounds.end())
+        return false;
+    }
+
+    if (!comprehensionLHSIteratorDomainsMatchTensorDimensions(
+            paramSpecs, langItBounds, c.ident().name(), c.indices())) {
+      return false;
+    }
+
+    llvm::SmallVector<int64_t, 4> windowShape;
+
+    for (const std::string &it : info.pattern.windowIterators) {
+      auto bound = langItBounds.find(it);
+
+      if (bound == langItBounds.end() ||
+          !isZeroExpr(bound->second.start()) ||
+          bound->second.end()->kind() != lang::TK_CONST) {
+        return false;
+      }
+
+      lang::Const end(bound->second.end());
+
+      if (!isIntType(end.type()->kind()))
+        return false;
+
+      windowShape.push_back(end.value<int64_t>());
+    }
+
+    mlir::Value inTensor = symTab.lookup(lang::Access(c.rhs()).name().name());
+    mlir::Type elementType = getElementType(outTensor);
+
+    if (getElementType(inTensor) != elementType)
+      return false;
+
+    // Only the shape of the window operand is relevant
+    mlir::MemRefType windowType =
+        mlir::MemRefType::get(windowShape, elementType);
+    mlir::Value window = builder.create<mlir::AllocaOp>(location, windowType);
+
+    llvm::SmallVector<mlir::Value, 3> operands = {inTensor, window, outTensor};
+
+    builder.create<mlir::linalg::PoolingSumOp>(
+        location, mlir::TypeRange{},
+        mlir::ValueRange(mlir::ArrayRef<mlir::Value>{operands.begin(),
+                                                     operands.end()}));
+
+    return true;
+  }
+
+  // Returns a memref type with dynamic sizes, strides and offset for
+  // the given rank and element type, to which any memref of the same
+  // rank and element type can be cast.
+  mlir::MemRefType getFullyDynamicMemRefType(unsigned rank,
+                                             mlir::Type elementType) {
+    int64_t dynStride = mlir::MemRefType::getDynamicStrideOrOffset();
+    llvm::SmallVector<int64_t, 4> shape(rank, -1);
+    llvm::SmallVector<int64_t, 4> strides(rank, dynStride);
+    mlir::AffineMap layout = mlir::makeStridedLinearLayoutMap(
+        strides, dynStride, builder.getContext());
+
+    return mlir::MemRefType::get(shape, elementType, layout);
+  }
+
+  // Returns the declaration of the external function `name`. If the
+  // function has not been declared yet, a declaration with the
+  // argument types `argTypes` and the result types `resultTypes` is
+  // added to the module.
+  mlir::FuncOp getOrDeclareExternalFunction(
+      const std::string &name, llvm::ArrayRef<mlir::Type> argTypes,
+      mlir::Location location,
+      llvm::ArrayRef<mlir::Type> resultTypes = llvm::None) {
+    mlir::FuncOp f = module.lookupSymbol<mlir::FuncOp>(name);
+
+    if (!f) {
+      f = mlir::FuncOp::create(location, name,
+                               builder.getFunctionType(argTypes, resultTypes));
+      module.push_back(f);
+    }
+
+    return f;
+  }
+
+  // Tries to lower a matrix multiplication or a matrix-vector product
+  // to a call to a runtime library routine named
+  // <prefix><type><routine>, where <type> is "s", "d" or "i8" and
+  // <routine> is "gemm" or "gemv" (e.g., _teckyl_cblas_sgemm for the
+  // CBLAS wrappers from runtime/teckyl_cblas.c). The operands are
+  // passed as memrefs with a fully dynamic strided layout;
+  // transposition flags and leading dimensions are derived from the
+  // strides at runtime.
+  //
+  // Default initialization of the output tensor is folded into the
+  // call by passing zero for beta, such that no separate
+  // initialization is needed. Products of int8 tensors are only
+  // lowered if `allowInt8` is set and require an int32 output tensor.
+  //
+  // Returns true if the call has been built, otherwise false.
+  bool tryBuildLibraryCall(const ComprehensionInfo &info,
+                           mlir::Value outTensor, const std::string &prefix,
+                           bool allowInt8, mlir::Location location) {
+    const lang::Comprehension &c = info.comprehension;
+    const size_t(&canon)[2] = info.pattern.canonicalOrder;
+    bool definit = info.pattern.definit;
+    std::string routine;
+
+    if (info.pattern.kind == pattern::Kind::Matmul)
+      routine = "gemm";
+    else if (info.pattern.kind == pattern::Kind::Matvec)
+      routine = "gemv";
+    else
+      return false;
+
+    // The library calls always operate on entire tensors; make sure
+    // that the iteration domains match the tensor dimensions
+    for (const std::string &it : info.allIterators) {
+      if (info.bounds.find(it) == info.bounds.end())
+        return false;
+    }
+
+    if (!directIteratorDomainsMatchTensorDimensions(info, paramSpecs))
+      return false;
+
+    llvm::SmallVector<mlir::Value, 3> operands;
+
+    for (size_t i = 0; i < 2; i++) {
+      lang::Access access(c.rhs()->tree(canon[i]));
+      operands.push_back(symTab.lookup(access.name().name()));
+    }
+
+    operands.push_back(outTensor);
+
+    mlir::Type elementType = getElementType(outTensor);
+    mlir::Type inputElementType = elementType;
+    std::string typePrefix;
+
+    if (elementType.isF32()) {
+      typePrefix = "s";
+    } else if (elementType.isF64()) {
+      typePrefix = "d";
+    } else if (allowInt8 && elementType.isInteger(32) &&
+               getElementType(operands[0]).isInteger(8)) {
+      typePrefix = "i8";
+      inputElementType = getElementType(operands[0]);
+    } else {
+      return false;
+    }
+
+    for (size_t i = 0; i < 2; i++) {
+      if (getElementType(operands[i]) != inputElementType)
+        return false;
+    }
+
+    // The library routines only handle signed integers
+    for (size_t i = 0; i < 2; i++) {
+      lang::Access access(c.rhs()->tree(canon[i]));
+
+      if (isUnsignedTensor(access.name().name()))
+        return false;
+    }
+
+    if (isUnsignedTensor(c.ident().name()))
+      return false;
+
+    llvm::SmallVector<mlir::Type, 4> argTypes;
+    llvm::SmallVector<mlir::Value, 4> args;
+
+    for (mlir::Value operand : operands) {
+      mlir::MemRefType argType = getFullyDynamicMemRefType(
+          operand.getType().cast<mlir::MemRefType>().getRank(),
+          getElementType(operand));
+
+      argTypes.push_back(argType);
+      args.push_back(
+          builder.create<mlir::MemRefCastOp>(location, operand, argType));
+    }
+
+    mlir::Attribute betaAttr;
+
+    if (elementType.isa<mlir::FloatType>())
+      betaAttr = builder.getFloatAttr(elementType, definit ? 0.0 : 1.0);
+    else
+      betaAttr = builder.getIntegerAttr(elementType, definit ? 0 : 1);
+
+    mlir::Value beta = builder.create<mlir::ConstantOp>(location, betaAttr);
+
+    argTypes.push_back(elementType);
+    args.push_back(beta);
+
+    mlir::FuncOp callee = getOrDeclareExternalFunction(
+        prefix + typePrefix + routine, argTypes, location);
+
+    builder.create<mlir::CallOp>(location, callee, args);
+
+    return true;
   }
 
   // Builds a linalg.fill operation initializing the memref value
@@ -1090,30 +2475,43 @@ private:
     builder.create<mlir::linalg::FillOp>(loc(lcst.range()), outTensor, cst);
   }
 
-  // Tries to build a linalg structured operations from c and the
+  // Tries to build a linalg structured operation for the operation
+  // recognized for the comprehension analyzed in `info` from the
   // provided inputs / outputs.
   bool tryBuildSpecializedLinalgOp(
-      const lang::Comprehension &c,
+      const ComprehensionInfo &info,
       llvm::ArrayRef<mlir::edsc::StructuredIndexed> inputs,
       llvm::ArrayRef<mlir::edsc::StructuredIndexed> outputs) {
+    const lang::Comprehension &c = info.comprehension;
+    const size_t(&canon)[2] = info.pattern.canonicalOrder;
 
-    if (pattern::isConstantInitialization(c)) {
+    switch (info.pattern.kind) {
+    case pattern::Kind::ConstantInitialization:
       buildFillOp(lang::Const(c.rhs()), outputs[0]);
       return true;
+    case pattern::Kind::Matmul:
+      return buildNamedLinalgOp<mlir::linalg::MatmulOp>(c, canon, inputs,
+                                                        outputs);
+    case pattern::Kind::Matvec:
+      return buildNamedLinalgOp<mlir::linalg::MatvecOp>(c, canon, inputs,
+                                                        outputs);
+    case pattern::Kind::Dot:
+      return buildNamedLinalgOp<mlir::linalg::DotOp>(c, canon, inputs,
+                                                     outputs);
+    case pattern::Kind::BatchMatmul:
+      return buildNamedLinalgOp<mlir::linalg::BatchMatmulOp>(c, canon, inputs,
+                                                             outputs);
+    case pattern::Kind::Conv1D:
+      return buildNamedLinalgOp<mlir::linalg::ConvWOp>(c, canon, inputs,
+                                                       outputs);
+    case pattern::Kind::Conv2D:
+      return buildNamedLinalgOp<mlir::linalg::ConvHWOp>(c, canon, inputs,
+                                                        outputs);
+    case pattern::Kind::PermutedCopy:
+      return tryBuildCopyOp(c, info.pattern.permutation, inputs, outputs);
+    default:
+      return false;
     }
-
-    return tryBuildSpecializedLinalgOp<mlir::linalg::MatmulOp, 2,
-                                       pattern::isMatmulComprehension>(
-               c, inputs, outputs) ||
-           tryBuildSpecializedLinalgOp<mlir::linalg::MatmulOp, 2,
-                                       pattern::isDefinitMatmulComprehension>(
-               c, inputs, outputs) ||
-           tryBuildSpecializedLinalgOp<mlir::linalg::MatvecOp, 2,
-                                       pattern::isMatvecComprehension>(
-               c, inputs, outputs) ||
-           tryBuildSpecializedLinalgOp<mlir::linalg::MatvecOp, 2,
-                                       pattern::isDefinitMatvecComprehension>(
-               c, inputs, outputs);
   }
 
   // Builds the core of a comprehension (e.g., just the actual
@@ -1121,17 +2519,30 @@ private:
   // element for default-initialized reductions) with affine
   // accesses. The check for affine accesses must be performed prior
   // to the call.
-  void
-  buildLinalgReductionCore(const lang::Comprehension &c, mlir::Value tensor,
-                           const std::map<std::string, IteratorKind> &iterators,
-                           const std::vector<std::string> &iteratorsSeq,
-                           mlir::Location location) {
-    std::vector<lang::Access> tensorAccesses =
-        collectTensorAccessesSeq(c.rhs());
+  //
+  // Tensors indexed directly by iterators whose domains from
+  // `info.bounds` do not match the indexed dimensions are passed as
+  // subviews restricted to the domains (see
+  // buildIteratorDomainSubView()), such that the iteration domain of
+  // the linalg operation derived from the operands is the domain of
+  // the comprehension. Iterators whose domains do not start at zero
+  // must thus only be used for direct indexing (see
+  // ComprehensionInfo::offsetIteratorsOnlyIndexDirectly).
+  void buildLinalgReductionCore(const ComprehensionInfo &info,
+                                mlir::Value tensor,
+                                const std::vector<std::string> &iteratorsSeq,
+                                mlir::Location location) {
+    const lang::Comprehension &c = info.comprehension;
+    const std::vector<lang::Access> &tensorAccesses = info.accesses;
+    const IteratorRangeMap &langItBounds = info.bounds;
     std::vector<mlir::edsc::StructuredIndexed> inputs;
+    std::vector<mlir::edsc::StructuredIndexed> accessOperands;
     std::vector<mlir::Value> inputTensorValues;
     std::set<std::string> accessedTensors;
     std::map<lang::TreeId, unsigned int> argIndexes;
+    std::unordered_map<lang::TreeRef, unsigned int, TreeStructuralHash,
+                       TreeStructuralEqual>
+        distinctAccesses;
 
     // Extract names of all tensors that are indexed on the rhs
     for (const lang::Access &access : tensorAccesses)
@@ -1155,15 +2566,37 @@ private:
     // Create one AffineExpr per access dimension of each tensor
     // access; keep a mapping between access expressions and the index
     // within the lists of input block arguments for the generated
-    // linalg operation
+    // linalg operation.
+    //
+    // Structurally identical accesses (e.g., the three occurrences of
+    // A(i) in C(i) = A(i)*A(i) + A(i)) are mapped to the same input
+    // operand, such that each distinct element is only read once per
+    // iteration.
     for (const lang::Access &a : tensorAccesses) {
       std::vector<mlir::AffineExpr> aff = affGen.buildAffineExpressions(a);
+      auto known = distinctAccesses.find(a.tree());
 
-      mlir::Value tensorValue = symTab.lookup(a.name().name());
-      inputTensorValues.push_back(tensorValue);
+      if (known != distinctAccesses.end()) {
+        accessOperands.push_back(inputs[known->second]);
+        argIndexes.insert({a.id(), known->second});
+        continue;
+      }
+
+      std::vector<lang::TreeRef> args;
+
+      for (const lang::TreeRef &arg : a.arguments())
+        args.push_back(arg);
+
+      mlir::Value tensorValue =
+          buildIteratorDomainSubView(a.name().name(),
+                                     symTab.lookup(a.name().name()), args,
+                                     langItBounds, location);
       mlir::edsc::StructuredIndexed tensorBase(tensorValue);
       mlir::edsc::StructuredIndexed tensorIndexed = tensorBase(aff);
 
+      accessOperands.push_back(tensorIndexed);
+      inputTensorValues.push_back(tensorValue);
+      distinctAccesses.insert({a.tree(), inputs.size()});
       argIndexes.insert({a.id(), inputs.size()});
       inputs.push_back(tensorIndexed);
     }
@@ -1174,7 +2607,13 @@ private:
     {
       std::vector<mlir::AffineExpr> aff =
           affGen.buildAffineExpressions(c.indices());
-      mlir::edsc::StructuredIndexed tensorHandle(tensor);
+      std::vector<lang::TreeRef> args;
+
+      for (const lang::Ident &index : c.indices())
+        args.push_back(index.tree());
+
+      mlir::edsc::StructuredIndexed tensorHandle(buildIteratorDomainSubView(
+          c.ident().name(), tensor, args, langItBounds, location));
       mlir::edsc::StructuredIndexed tensorIndexed(tensorHandle(aff));
       outputs.push_back(tensorIndexed);
     }
@@ -1183,7 +2622,7 @@ private:
     std::vector<mlir::IteratorType> iteratorTypes;
 
     for (const std::string &it : iteratorsSeq) {
-      if (iterators.at(it) == IteratorKind::LHS)
+      if (info.iterators.at(it) == IteratorKind::LHS)
         iteratorTypes.push_back(mlir::IteratorType::Parallel);
       else
         iteratorTypes.push_back(mlir::IteratorType::Reduction);
@@ -1191,6 +2630,11 @@ private:
 
     mlir::edsc::ScopedContext sc(builder, location);
 
+    mlir::Type operandWideningType =
+        getOperandWideningType(c, tensor, mlir::Type());
+    std::set<std::string> unsignedTensors = collectUnsignedTensors();
+    bool isUnsignedOutput = isUnsignedTensor(c.ident().name());
+
     // Region builder for the body of the linalg.generic
     // operation. The block arguments are the tensor elements from the
     // access expressions and the value at the current position in the
@@ -1207,8 +2651,12 @@ private:
       for (auto it : argIndexes)
         valMap.insert({it.first, blockArgs[it.second]});
 
-      MLIRMappedValueExprGen gen(mlir::edsc::ScopedContext::getBuilderRef(),
-                                 valMap, symTab, filename);
+      MLIRCSEValueExprGen gen(mlir::edsc::ScopedContext::getBuilderRef(),
+                              valMap, symTab, filename);
+
+      if (operandWideningType)
+        gen.setAccessWidening(operandWideningType, unsignedTensors);
+
       mlir::Value rhsVal = gen.buildExpr(c.rhs());
 
       // Accumulator for output tensor is always the last argument
@@ -1217,22 +2665,12 @@ private:
 
       // Build the operator for the reduction and store final value
       // for the reduction step in res
-      switch (c.assignment()->kind()) {
-      case lang::TK_PLUS_EQ:
-      case lang::TK_PLUS_EQ_B:
-        res = buildBinaryExprFromValues<mlir::AddFOp, mlir::AddIOp>(
-            gen.getBuilder(), rhsVal, accu, loc(c.range()));
-        break;
-      case lang::TK_TIMES_EQ:
-      case lang::TK_TIMES_EQ_B:
-        res = buildBinaryExprFromValues<mlir::MulFOp, mlir::MulIOp>(
-            gen.getBuilder(), rhsVal, accu, loc(c.range()));
-        break;
-      case '=':
+      if (c.assignment()->kind() == '=') {
         res = rhsVal;
-        break;
-      default:
-        llvm_unreachable("Unsupported operator");
+      } else {
+        res = buildReductionStep(gen.getBuilder(), c.assignment()->kind(),
+                                 rhsVal, accu, isUnsignedOutput,
+                                 loc(c.range()));
       }
 
       mlir::Type elementType = getElementType(tensor);
@@ -1255,97 +2693,360 @@ private:
     bool buildGeneric = true;
 
     if (options.specialize_linalg_ops) {
-      if (tryBuildSpecializedLinalgOp(c, inputs, outputs))
+      if (tryBuildSpecializedLinalgOp(info, accessOperands, outputs))
         buildGeneric = false;
     }
 
     if (buildGeneric) {
+      // Iterators that never index a tensor dimension directly (e.g.,
+      // k in B(k+5)) get an additional input operand indexed directly
+      // by the iterator, whose only purpose is to define the range of
+      // the iterator. The block arguments for these operands follow
+      // the arguments for the tensor accesses and are never used.
+      std::set<std::string> directIterators;
+
+      for (const lang::Ident &index : c.indices())
+        directIterators.insert(index.name());
+
+      for (const DirectIndex &di : info.directIndexes)
+        directIterators.insert(di.iterator);
+
+      for (const std::string &it : iteratorsSeq) {
+        if (directIterators.count(it))
+          continue;
+
+        std::vector<mlir::AffineExpr> aff{
+            mlir::getAffineDimExpr(iteratorDims.at(it), builder.getContext())};
+        mlir::edsc::StructuredIndexed domainHandle(
+            buildIteratorDomainOperand(langItBounds.at(it), location));
+        inputs.push_back(domainHandle(aff));
+      }
+
       mlir::edsc::makeGenericLinalgOp(iteratorTypes, inputs, outputs,
                                       regionBuilder);
     }
   }
 
-  // Builds the MLIR representation of a single comprehension
-  void buildComprehension(const lang::Comprehension &c) {
-    mlir::Location startLoc = loc(c.range());
-
-    // New scope for iterators
-    llvm::ScopedHashTableScope<llvm::StringRef, mlir::Value> var_scope(symTab);
+  // Returns a one-dimensional view with as many elements as there are
+  // iterations in the range `range`, which must start at zero. All
+  // elements of the view alias the same, uninitialized byte on the
+  // stack (i.e., the view has a stride of zero), such that the view
+  // can define the range of a loop of a linalg operation without
+  // occupying memory proportional to the range.
+  mlir::Value buildIteratorDomainOperand(const lang::RangeConstraint &range,
+                                         mlir::Location location) {
+    MLIRValueExprGen exprGen(builder, symTab, filename);
+    mlir::Value size = exprGen.buildExpr(range.end());
 
-    std::map<std::string, IteratorKind> iterators = collectIterators(c, symTab);
-    std::set<std::string> iteratorSet;
-    std::set<std::string> iteratorSetReduction;
-    IteratorRangeMap langItBounds = collectExplicitIteratorBounds(c);
+    if (!size.getType().isIndex()) {
+      size = builder.create<mlir::IndexCastOp>(location, builder.getIndexType(),
+                                               size);
+    }
 
-    for (const std::pair<std::string, IteratorKind> &it : iterators) {
-      iteratorSet.insert(it.first);
+    mlir::Value elem = builder.create<mlir::AllocaOp>(
+        location, mlir::MemRefType::get({1}, builder.getIntegerType(8)));
+    mlir::Value zero = builder.create<mlir::ConstantIndexOp>(location, 0);
 
-      if (it.second == IteratorKind::RHSOnly)
-        iteratorSetReduction.insert(it.first);
-    }
+    return builder.create<mlir::SubViewOp>(location, elem,
+                                           mlir::ValueRange{zero},
+                                           mlir::ValueRange{size},
+                                           mlir::ValueRange{zero});
+  }
 
+  // Returns the order of the iterators of the comprehension analyzed
+  // in `info` with the index `idx` from the outermost to the innermost
+  // loop
+  std::vector<std::string> getIteratorOrder(const ComprehensionInfo &info,
+                                            size_t idx) {
     // Decide on an (arbitrary) order for the iterators for the loop
     // nest
     std::vector<std::string> iteratorsSeq;
 
-    for (std::pair<std::string, IteratorKind> it : iterators)
+    for (const std::pair<std::string, IteratorKind> &it : info.iterators)
       iteratorsSeq.push_back(it.first);
 
+    // Use the order given in the options instead if it is a
+    // permutation of the iterators
+    auto orderIt = options.loop_orders.find(idx);
+
+    if (orderIt != options.loop_orders.end() &&
+        std::is_permutation(iteratorsSeq.begin(), iteratorsSeq.end(),
+                            orderIt->second.begin(), orderIt->second.end())) {
+      iteratorsSeq = orderIt->second;
+    }
+
+    return iteratorsSeq;
+  }
+
+  // Builds a tc.comprehension operation (see TcDialect.h) for the
+  // comprehension analyzed in `info` with the index `idx`. Accesses
+  // whose index expressions are affine in the iterators become
+  // tc.access operations; all other accesses are loaded with the
+  // values of the iterators passed to the body.
+  void buildTcComprehension(const ComprehensionInfo &info, size_t idx) {
+    const lang::Comprehension &c = info.comprehension;
+    mlir::Location location = loc(c.range());
     const std::string &outTensorName = c.ident().name();
     mlir::Value outTensorVal = symTab.lookup(outTensorName);
+    mlir::Type elementType = getElementType(outTensorVal);
+    bool isUnsigned = isUnsignedTensor(outTensorName);
+    int kind = c.assignment()->kind();
+
+    if (accessesTensorStorage(info) ||
+        (getWideningAccumulationType(info, outTensorVal) &&
+         !info.reductionIterators.empty())) {
+      mlirgen::SourceException err(
+          location, "Comprehensions with packed or blocked tensors or with "
+                    "widened accumulation cannot be represented in the tc "
+                    "dialect");
+      THROW_OR_ASSERT(err);
+    }
+
+    std::vector<std::string> iteratorsSeq = getIteratorOrder(info, idx);
+    std::map<std::string, unsigned int> iteratorDims;
+    std::vector<llvm::StringRef> iteratorTypes;
+    std::vector<unsigned> outputIndices;
+    std::vector<mlir::Value> lowerBounds;
+    std::vector<mlir::Value> upperBounds;
+
+    MLIRValueExprGen boundsGen(builder, symTab, filename);
+    IteratorBoundsMap mlirItBounds =
+        boundsGen.translateIteratorBounds(info.bounds);
+
+    for (const std::string &it : iteratorsSeq) {
+      iteratorDims.emplace(it, iteratorDims.size());
+      iteratorTypes.push_back(info.reductionIterators.count(it)
+                                  ? mlir::getReductionIteratorTypeName()
+                                  : mlir::getParallelIteratorTypeName());
+      lowerBounds.push_back(mlirItBounds.at(it).first);
+      upperBounds.push_back(mlirItBounds.at(it).second);
+    }
+
+    for (const lang::Ident &index : c.indices())
+      outputIndices.push_back(iteratorDims.at(index.name()));
+
+    mlir::Attribute init;
+
+    if (kind == lang::TK_PLUS_EQ_B || kind == lang::TK_TIMES_EQ_B ||
+        kind == lang::TK_MAX_EQ_B || kind == lang::TK_MIN_EQ_B) {
+      init = getNeutralElementAttr(getNeutralElement(kind), elementType,
+                                   isUnsigned);
+    }
+
+    dialect::ComprehensionOp op = builder.create<dialect::ComprehensionOp>(
+        location, outTensorVal, lowerBounds, upperBounds, iteratorsSeq,
+        iteratorTypes, outputIndices, lang::kindToToken(kind), init);
+
+    mlir::OpBuilder::InsertionGuard guard(builder);
+    mlir::Block &body = op.getBody();
+
+    builder.setInsertionPointToStart(&body);
+
+    // Iterators used in non-affine index expressions refer to the
+    // block arguments
+    llvm::ScopedHashTableScope<llvm::StringRef, mlir::Value> var_scope(symTab);
+
+    for (const std::string &it : iteratorsSeq)
+      symTab.insert(it, body.getArgument(iteratorDims.at(it)));
+
+    // One tc.access operation per set of structurally identical
+    // affine accesses
+    MLIRAffineExprGen affGen(builder.getContext(), iteratorDims);
+    std::map<lang::TreeId, mlir::Value> valMap;
+    std::unordered_map<lang::TreeRef, mlir::Value, TreeStructuralHash,
+                       TreeStructuralEqual>
+        distinctAccesses;
+
+    for (const lang::Access &a : info.accesses) {
+      bool iteratorAffine = true;
+
+      for (const lang::TreeRef &arg : a.arguments()) {
+        std::set<std::string> idents = collectIdentNames(arg);
+
+        if (!isAffine(arg, info.allIterators) ||
+            !std::includes(info.allIterators.begin(), info.allIterators.end(),
+                           idents.begin(), idents.end())) {
+          iteratorAffine = false;
+        }
+      }
+
+      if (!iteratorAffine)
+        continue;
+
+      auto known = distinctAccesses.find(a.tree());
+
+      if (known == distinctAccesses.end()) {
+        std::vector<mlir::AffineExpr> aff = affGen.buildAffineExpressions(a);
+        mlir::AffineMap map = mlir::AffineMap::get(
+            iteratorsSeq.size(), 0, aff, builder.getContext());
+        mlir::Value val = builder.create<dialect::AccessOp>(
+            loc(a.range()), symTab.lookup(a.name().name()), map);
+
+        known = distinctAccesses.insert({a.tree(), val}).first;
+      }
+
+      valMap.insert({a.id(), known->second});
+    }
+
+    MLIRCSEValueExprGen exprGen(builder, valMap, symTab, filename);
+
+    if (mlir::Type t = getOperandWideningType(c, outTensorVal, mlir::Type()))
+      exprGen.setAccessWidening(t, collectUnsignedTensors());
+
+    mlir::Value res = exprGen.buildExpr(c.rhs());
+
+    if (kind != '=') {
+      res = buildReductionStep(builder, kind, res, op.getAccumulator(),
+                               isUnsigned, location);
+    }
+
+    if (!convertValue(builder, res, elementType, location)) {
+      std::stringstream ss;
+
+      ss << "Operand for assignment cannot be converted to element type of the "
+            "target tensor: "
+         << "cannot convert " << getTypeAsString(res.getType()) << " to "
+         << getTypeAsString(elementType);
+
+      mlirgen::SourceException err(location, ss.str());
+      THROW_OR_ASSERT(err);
+    }
+
+    builder.create<dialect::YieldOp>(location, res);
+  }
+
+  // Builds the MLIR representation of the comprehension analyzed in
+  // `info`, which is the comprehension with the index `idx` within its
+  // definition
+  void buildComprehension(const ComprehensionInfo &info, size_t idx) {
+    // Let bindings have been inlined into the right hand side by
+    // analyzeComprehension(); code for each binding is only generated
+    // once per iteration, since identical sub-expressions are shared
+    const lang::Comprehension &c = info.comprehension;
+    mlir::Location startLoc = loc(c.range());
+
+    // Comprehensions are kept as a whole in the tc dialect
+    if (options.emit_tc_dialect) {
+      buildTcComprehension(info, idx);
+      return;
+    }
+
+    // New scope for iterators
+    llvm::ScopedHashTableScope<llvm::StringRef, mlir::Value> var_scope(symTab);
+
+    std::vector<std::string> iteratorsSeq = getIteratorOrder(info, idx);
+
+    const std::string &outTensorName = c.ident().name();
+    mlir::Value outTensorVal = symTab.lookup(outTensorName);
+
+    // Reductions accumulated in a wider type than the element type of
+    // the output tensor carry the accumulator through scf.for loops
+    // and are never specialized or lowered to library calls
+    mlir::Type accuType = getWideningAccumulationType(info, outTensorVal);
+    bool widenAccumulation = accuType && !info.reductionIterators.empty();
+
+    // Packed sub-byte elements and elements of tensors with blocked
+    // layouts can only be addressed by the loads and stores generated
+    // for scf.for loop nests
+    bool elementwise = accessesTensorStorage(info);
+
+    // Non-temporal stores are attached to the stores of scf.for loop
+    // nests, since linalg operations do not carry such hints
+    bool nontemporal = nonTemporalOutputs.count(outTensorName);
+
+    // Recognized contractions may be lowered to library calls, which
+    // also take care of the initialization of the output tensor
+    if (!widenAccumulation && !elementwise &&
+        options.contraction_backend ==
+            MLIRGenOptions::ContractionBackend::CBLAS &&
+        tryBuildLibraryCall(info, outTensorVal, "_teckyl_cblas_", false,
+                            startLoc)) {
+      return;
+    }
+
+    if (!widenAccumulation && !elementwise &&
+        options.contraction_backend ==
+            MLIRGenOptions::ContractionBackend::TeckylRT &&
+        tryBuildLibraryCall(info, outTensorVal, "_teckyl_rt_", true,
+                            startLoc)) {
+      return;
+    }
+
+    // Reductions with widened accumulation start from the neutral
+    // element and write every element of the output tensor once
+    if (widenAccumulation) {
+      buildAccumulatingLoopReductionCore(info, outTensorVal, accuType,
+                                         startLoc);
+      return;
+    }
 
     // Initialize output tensor for default-initialized reductions
-    if (c.assignment()->kind() == lang::TK_PLUS_EQ_B) {
-      buildTensorInitialization(outTensorName, outTensorVal, c.indices(),
-                                startLoc, NeutralElement::Zero, langItBounds);
-    } else if (c.assignment()->kind() == lang::TK_TIMES_EQ_B) {
-      buildTensorInitialization(outTensorName, outTensorVal, c.indices(),
-                                startLoc, NeutralElement::One, langItBounds);
-    } else if (c.assignment()->kind() == lang::TK_MAX_EQ_B ||
-               c.assignment()->kind() == lang::TK_MIN_EQ_B) {
-      // TODO: Support max and min
-      llvm_unreachable("Unsupported reduction");
+    if (c.assignment()->kind() == lang::TK_PLUS_EQ_B ||
+        c.assignment()->kind() == lang::TK_TIMES_EQ_B ||
+        c.assignment()->kind() == lang::TK_MAX_EQ_B ||
+        c.assignment()->kind() == lang::TK_MIN_EQ_B) {
+      NeutralElement neutral = getNeutralElement(c.assignment()->kind());
+
+      if (tensorStorage.count(outTensorVal)) {
+        buildElementwiseTensorInitialization(c.ident(), c.indices(), startLoc,
+                                             neutral, info.bounds);
+      } else {
+        buildTensorInitialization(outTensorName, outTensorVal, c.indices(),
+                                  startLoc, neutral, info.bounds);
+      }
+    }
+
+    // Pooling windows are not directly derived from tensor
+    // dimensions and would thus never reach linalg.generic; check for
+    // them separately
+    if (options.specialize_linalg_ops && !elementwise && !nontemporal &&
+        tryBuildPoolingOp(info, outTensorVal, startLoc)) {
+      return;
     }
 
     // Build code for the actual computation
     //
     // Check if the reduction of the comprehension is eligible for a
-    // linalg.generic operation. The requirements are:
+    // linalg.generic operation. The requirements, which are
+    // determined by analyzeComprehension(), are:
     //
     // 1. All tensor indexing must be affine.
     //
-    // 2. The existence of a direct mapping between iteration
-    //    dimensions and tensor accesses. This requires that each
-    //    iterator of the comprehension is referenced at least once
-    //    for direct indexing. For example, this is the case for:
-    //
-    //      C(i, j) = A(i) + A(i / 2) + B(k)
-    //
-    //    since i, j, and k are all used for direct indexing at least
-    //    once, while:
+    // 2. Each reduction iterator of the comprehension is referenced
+    //    at least once in the index expressions of a tensor access,
+    //    such that the access maps of the linalg operation cover all
+    //    iteration dimensions. For example, this is the case for:
     //
     //      C(i, j) = A(i) + A(i / 2) + B(k+5)
     //
-    //    would not meet the condition above, since k is never
-    //    directly used index a tensor dimension.
+    //    Iterators that are never used for direct indexing (e.g., k
+    //    above) are given an operand defining their range (see
+    //    buildIteratorDomainOperand()).
     //
     // 3. Since the iteration domains are directly derived from the
-    //    tensors dimensions, the bounds for the comprehension for
-    //    iterators with direct indexing must match the size of the
-    //    respective tensor dimension.
+    //    tensors dimensions, tensors directly indexed by iterators
+    //    whose bounds do not match the size of the indexed dimension
+    //    are restricted to the bounds with subviews. The subviews
+    //    shift the origin of iterators whose domain does not start at
+    //    zero, hence such iterators must only be used for direct
+    //    indexing. For example, this is the case for:
+    //
+    //      C(i) = A(i) + B(i) where i in 1:N
     //
-    // Conditions 2 and 3 might be relaxed in the future in cases,
-    // where it is possible to create subviews which restore the
-    // conditions.
-    if (options.body_op == MLIRGenOptions::BodyOp::ScfFor ||
-        hasNonAffineIndexing(c.rhs(), iteratorSet) ||
-        !allIteratorsIndexTensorDimension(iteratorSetReduction, c.rhs()) ||
-        !directIteratorDomainsMatchTensorDimensions(c, paramSpecs)) {
-      buildLoopReductionCore(c, outTensorVal, iteratorsSeq, langItBounds,
-                             startLoc);
+    //    while:
+    //
+    //      C(i) = A(i) + A(i-1) where i in 1:N
+    //
+    //    would not meet the condition, since the subview of A for the
+    //    direct access does not apply to A(i-1).
+    //
+    if (options.body_op == MLIRGenOptions::BodyOp::ScfFor || elementwise ||
+        nontemporal || !info.affineIndexing ||
+        !info.reductionIteratorsIndexTensors ||
+        !info.offsetIteratorsOnlyIndexDirectly) {
+      buildLoopReductionCore(info, outTensorVal, iteratorsSeq, startLoc);
     } else {
-      buildLinalgReductionCore(c, outTensorVal, iterators, iteratorsSeq,
-                               startLoc);
+      buildLinalgReductionCore(info, outTensorVal, iteratorsSeq, startLoc);
     }
   }
 
@@ -1381,14 +3082,69 @@ private:
 
     return ranks;
   }
+
+  // Returns the names of the output tensors of `def` whose stores
+  // should bypass the cache. These are the output tensors that are
+  // written by exactly one comprehension with a plain assignment,
+  // that are not read by any comprehension and whose size is at least
+  // `options.nontemporal_threshold` bytes. Tensors with packed
+  // sub-byte elements are excluded, since each store of an element
+  // reads the enclosing byte.
+  //
+  // Outputs initialized for reductions are never included, since the
+  // initialized elements are read again right away.
+  std::set<std::string> collectNonTemporalOutputs(const lang::Def &def) {
+    std::map<std::string, unsigned int> writes;
+    std::set<std::string> reads;
+    std::set<std::string> res;
+
+    for (const ComprehensionInfo &info : comprehensionInfos) {
+      const lang::Comprehension &c = info.comprehension;
+      int kind = c.assignment()->kind();
+
+      // Count other assignments twice to exclude their targets
+      writes[c.ident().name()] += (kind == '=') ? 1 : 2;
+
+      for (const lang::Access &a : info.accesses)
+        reads.insert(a.name().name());
+    }
+
+    for (const lang::Param &param : def.returns()) {
+      const std::string &name = param.ident().name();
+      lang::TensorType tt = param.tensorType();
+
+      if (writes[name] != 1 || reads.count(name) ||
+          isPackedIntType(tt.scalarType()) || tt.dims().size() == 0) {
+        continue;
+      }
+
+      // Size in bytes; symbolic sizes are assumed to be large
+      int64_t size =
+          getMemRefElementType(tt.scalarType()).getIntOrFloatBitWidth() / 8;
+      bool isStatic = true;
+
+      for (const lang::TreeRef &dim : tt.dims()) {
+        if (dim->kind() == lang::TK_CONST)
+          size *= lang::Const(dim).value<int64_t>();
+        else
+          isStatic = false;
+      }
+
+      if (!isStatic || size >= options.nontemporal_threshold)
+        res.insert(name);
+    }
+
+    return res;
+  }
 };
 
 // Builds an MLIR function with the name `name` from the TC definition
 // `def`.
 mlir::FuncOp buildMLIRFunction(mlir::MLIRContext &context,
-                               const std::string &name, const lang::Def &tc,
+                               mlir::ModuleOp module, const std::string &name,
+                               const lang::Def &tc,
                                const MLIRGenOptions &options) {
-  MLIRGenImpl generator(&context, options);
+  MLIRGenImpl generator(&context, module, options);
   return generator.buildFunction(name, tc);
 }
 } // namespace teckyl
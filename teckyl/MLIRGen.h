@@ -5,8 +5,11 @@
 
 #include "teckyl/tc/lang/tree_views.h"
 #include <mlir/IR/Function.h>
+#include <mlir/IR/Module.h>
 
+#include <map>
 #include <sstream>
+#include <vector>
 
 namespace teckyl {
 namespace mlirgen {
@@ -38,14 +41,79 @@ private:
 class MLIRGenOptions {
 public:
   enum class BodyOp { LinalgGeneric, ScfFor };
+  enum class ContractionBackend { Linalg, CBLAS, TeckylRT };
+
+  // Type used to accumulate reductions; `Output` accumulates in the
+  // element type of the output tensor
+  enum class AccumulationType { Output, F32, F64, I32 };
 
   BodyOp body_op;
   bool specialize_linalg_ops;
+  ContractionBackend contraction_backend;
+  AccumulationType accumulation_type;
+
+  // Names of the parameters holding the scale and the zero point for
+  // the requantization of integer reductions accumulated in a wider
+  // type than their output tensor. Definitions without these
+  // parameters saturate the accumulator to the range of the output
+  // type instead.
+  std::string requantize_scale;
+  std::string requantize_zero_point;
+
+  // Marks all tensor arguments of generated functions as not aliasing
+  // any other argument
+  bool assume_noalias;
+
+  // Alignment in bytes assumed for the data of all tensor arguments
+  // of generated functions; 0 if no alignment is assumed
+  unsigned int assume_aligned;
+
+  // Minimum size in bytes of output tensors written exactly once by a
+  // plain assignment and never read, for which non-temporal stores
+  // are generated. Tensors with symbolic sizes are assumed to exceed
+  // the threshold. 0 disables non-temporal stores.
+  int64_t nontemporal_threshold;
+
+  // Number of iterations of the innermost loop of scf.for loop nests
+  // by which gathers and strided reads are prefetched; 0 disables
+  // software prefetching
+  int64_t prefetch_distance;
+
+  // Passes all tensors as memrefs with dynamic strides and offsets,
+  // such that generated functions accept tensors with arbitrary
+  // strides (e.g., views with a non-unit innermost stride). By
+  // default, the innermost stride is assumed to be 1 and the offset
+  // to be 0, which allows for more efficient address computations.
+  bool dynamic_strides;
+
+  // Adds a table of profiling counters with one row per comprehension
+  // as the last argument of generated functions. The execution of
+  // each comprehension adds the elapsed cycles (as reported by
+  // _teckyl_prof_cycles() from the teckyl-prof runtime library) to
+  // the first and the number of executions to the second column of
+  // its row.
+  bool instrument;
+
+  // Represents each comprehension as a single tc.comprehension
+  // operation (see TcDialect.h) instead of lowering it directly. The
+  // options selecting the lowering of comprehensions (e.g., body_op)
+  // then have no effect.
+  bool emit_tc_dialect;
+
+  // Order of the iterators from the outermost to the innermost loop
+  // for comprehensions given by their index within the definition
+  // (e.g., as recorded in a tuning database). Comprehensions without
+  // an entry or with an order that is not a permutation of their
+  // iterators use the default order.
+  std::map<size_t, std::vector<std::string>> loop_orders;
 };
 
+// Builds an MLIR function for the TC definition `tc`. Declarations of
+// external functions called by the generated code (e.g., for
+// contractions lowered to library calls) are added to `module`.
 mlir::FuncOp
-buildMLIRFunction(mlir::MLIRContext &context, const std::string &name,
-                  const lang::Def &tc,
+buildMLIRFunction(mlir::MLIRContext &context, mlir::ModuleOp module,
+                  const std::string &name, const lang::Def &tc,
                   const MLIRGenOptions &options = MLIRGenOptions{});
 
 } // namespace teckyl
@@ -0,0 +1,225 @@
+#include "teckyl/TcDialect.h"
+
+#include <mlir/Dialect/Utils/StructuredOpsUtils.h>
+
+namespace teckyl {
+namespace dialect {
+
+TcDialect::TcDialect(mlir::MLIRContext *context)
+    : mlir::Dialect(getDialectNamespace(), context) {
+  addOperations<ComprehensionOp, AccessOp, YieldOp>();
+}
+
+void ComprehensionOp::build(mlir::OpBuilder &builder,
+                            mlir::OperationState &state, mlir::Value output,
+                            mlir::ValueRange lowerBounds,
+                            mlir::ValueRange upperBounds,
+                            llvm::ArrayRef<std::string> iterators,
+                            llvm::ArrayRef<llvm::StringRef> iteratorTypes,
+                            llvm::ArrayRef<unsigned> outputIndices,
+                            llvm::StringRef reduction, mlir::Attribute init) {
+  llvm::SmallVector<mlir::Attribute, 4> names;
+  llvm::SmallVector<int64_t, 4> indices(outputIndices.begin(),
+                                        outputIndices.end());
+
+  for (const std::string &it : iterators)
+    names.push_back(builder.getStringAttr(it));
+
+  state.addOperands(output);
+  state.addOperands(lowerBounds);
+  state.addOperands(upperBounds);
+
+  state.addAttribute(getIteratorsAttrName(), builder.getArrayAttr(names));
+  state.addAttribute(getIteratorTypesAttrName(),
+                     builder.getStrArrayAttr(iteratorTypes));
+  state.addAttribute(getOutputIndicesAttrName(),
+                     builder.getI64ArrayAttr(indices));
+  state.addAttribute(getReductionAttrName(), builder.getStringAttr(reduction));
+
+  if (init)
+    state.addAttribute(getInitAttrName(), init);
+
+  // The body takes the iterators and the current value of the output
+  // element
+  mlir::Region *body = state.addRegion();
+  mlir::Block *block = new mlir::Block();
+
+  for (size_t i = 0; i < iterators.size(); i++)
+    block->addArgument(builder.getIndexType());
+
+  block->addArgument(
+      output.getType().cast<mlir::MemRefType>().getElementType());
+
+  body->push_back(block);
+}
+
+mlir::LogicalResult ComprehensionOp::verify() {
+  if (getOperation()->getNumOperands() % 2 != 1)
+    return emitOpError("expects an output and two bounds per iterator");
+
+  if (!getOutput().getType().isa<mlir::MemRefType>())
+    return emitOpError("expects a memref as the output");
+
+  unsigned n = getNumIterators();
+
+  for (mlir::Value bound : getOperation()->getOperands().drop_front()) {
+    if (!bound.getType().isIndex())
+      return emitOpError("expects bounds of index type");
+  }
+
+  auto iterators = getAttrOfType<mlir::ArrayAttr>(getIteratorsAttrName());
+  auto iteratorTypes =
+      getAttrOfType<mlir::ArrayAttr>(getIteratorTypesAttrName());
+  auto outputIndices =
+      getAttrOfType<mlir::ArrayAttr>(getOutputIndicesAttrName());
+
+  if (!iterators || iterators.size() != n || !iteratorTypes ||
+      iteratorTypes.size() != n) {
+    return emitOpError("expects a name and a type for each iterator");
+  }
+
+  for (unsigned i = 0; i < n; i++) {
+    auto type = iteratorTypes[i].dyn_cast<mlir::StringAttr>();
+
+    if (!type || (type.getValue() != mlir::getParallelIteratorTypeName() &&
+                  type.getValue() != mlir::getReductionIteratorTypeName())) {
+      return emitOpError("expects iterator types to be \"")
+             << mlir::getParallelIteratorTypeName() << "\" or \""
+             << mlir::getReductionIteratorTypeName() << "\"";
+    }
+  }
+
+  if (!outputIndices ||
+      outputIndices.size() != (size_t)getOutputType().getRank()) {
+    return emitOpError("expects one output index per dimension of the output");
+  }
+
+  for (mlir::Attribute attr : outputIndices) {
+    auto idx = attr.dyn_cast<mlir::IntegerAttr>();
+
+    if (!idx || idx.getInt() < 0 || idx.getInt() >= n ||
+        isReductionIterator(idx.getInt())) {
+      return emitOpError("expects output indices to be parallel iterators");
+    }
+  }
+
+  if (!getAttrOfType<mlir::StringAttr>(getReductionAttrName()))
+    return emitOpError("expects a reduction operator");
+
+  mlir::Type elementType = getOutputType().getElementType();
+
+  if (mlir::Attribute init = getInit()) {
+    if (init.getType() != elementType)
+      return emitOpError("expects the initial value to be of the element "
+                         "type of the output");
+  }
+
+  mlir::Region &region = getOperation()->getRegion(0);
+
+  if (region.getBlocks().size() != 1)
+    return emitOpError("expects a body with a single block");
+
+  mlir::Block &body = getBody();
+
+  if (body.getNumArguments() != n + 1)
+    return emitOpError("expects one body argument per iterator and one for "
+                       "the output element");
+
+  for (unsigned i = 0; i < n; i++) {
+    if (!body.getArgument(i).getType().isIndex())
+      return emitOpError("expects body arguments of index type for the "
+                         "iterators");
+  }
+
+  if (getAccumulator().getType() != elementType ||
+      body.empty() || !llvm::isa<YieldOp>(body.back()) ||
+      getYieldedValue().getType() != elementType) {
+    return emitOpError("expects the body to take and to yield a value of "
+                       "the element type of the output");
+  }
+
+  return mlir::success();
+}
+
+std::vector<std::string> ComprehensionOp::getIteratorNames() {
+  std::vector<std::string> res;
+
+  for (mlir::Attribute name :
+       getAttrOfType<mlir::ArrayAttr>(getIteratorsAttrName())) {
+    res.push_back(name.cast<mlir::StringAttr>().getValue().str());
+  }
+
+  return res;
+}
+
+bool ComprehensionOp::isReductionIterator(unsigned idx) {
+  mlir::ArrayAttr types =
+      getAttrOfType<mlir::ArrayAttr>(getIteratorTypesAttrName());
+
+  return types[idx].cast<mlir::StringAttr>().getValue() ==
+         mlir::getReductionIteratorTypeName();
+}
+
+std::vector<unsigned> ComprehensionOp::getOutputIndices() {
+  std::vector<unsigned> res;
+
+  for (mlir::Attribute idx :
+       getAttrOfType<mlir::ArrayAttr>(getOutputIndicesAttrName())) {
+    res.push_back(idx.cast<mlir::IntegerAttr>().getInt());
+  }
+
+  return res;
+}
+
+llvm::SmallVector<mlir::AffineExpr, 4> ComprehensionOp::getOutputIndexExprs() {
+  llvm::SmallVector<mlir::AffineExpr, 4> res;
+
+  for (unsigned idx : getOutputIndices())
+    res.push_back(mlir::getAffineDimExpr(idx, getContext()));
+
+  return res;
+}
+
+void AccessOp::build(mlir::OpBuilder &builder, mlir::OperationState &state,
+                     mlir::Value tensor, mlir::AffineMap map) {
+  state.addOperands(tensor);
+  state.addAttribute(getMapAttrName(), mlir::AffineMapAttr::get(map));
+  state.addTypes(tensor.getType().cast<mlir::MemRefType>().getElementType());
+}
+
+mlir::LogicalResult AccessOp::verify() {
+  mlir::MemRefType type = getTensor().getType().dyn_cast<mlir::MemRefType>();
+  auto mapAttr = getAttrOfType<mlir::AffineMapAttr>(getMapAttrName());
+  ComprehensionOp parent =
+      getOperation()->getParentOfType<ComprehensionOp>();
+
+  if (!parent)
+    return emitOpError("expects to be nested in a tc.comprehension");
+
+  if (!type)
+    return emitOpError("expects a memref");
+
+  if (!mapAttr)
+    return emitOpError("expects an affine map");
+
+  mlir::AffineMap map = mapAttr.getValue();
+
+  if (map.getNumDims() != parent.getNumIterators() || map.getNumSymbols() != 0)
+    return emitOpError("expects one map dimension per iterator");
+
+  if (map.getNumResults() != (unsigned)type.getRank())
+    return emitOpError("expects one map result per dimension of the memref");
+
+  if (getOperation()->getResult(0).getType() != type.getElementType())
+    return emitOpError("expects the element type of the memref as the result");
+
+  return mlir::success();
+}
+
+void YieldOp::build(mlir::OpBuilder &builder, mlir::OperationState &state,
+                    mlir::Value value) {
+  state.addOperands(value);
+}
+
+} // namespace dialect
+} // namespace teckyl
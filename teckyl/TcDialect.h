@@ -0,0 +1,193 @@
+#ifndef TECKYL_TCDIALECT_H
+#define TECKYL_TCDIALECT_H
+
+#include <mlir/IR/AffineMap.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/Dialect.h>
+#include <mlir/IR/OpDefinition.h>
+#include <mlir/IR/StandardTypes.h>
+
+#include <string>
+#include <vector>
+
+namespace teckyl {
+namespace dialect {
+
+// The tc dialect represents tensor comprehensions with their
+// high-level structure (iterators and their kinds, iterator ranges,
+// reduction operator and statement order), such that transformations
+// across comprehensions can be implemented as MLIR passes before the
+// comprehensions are lowered to linalg, scf or affine operations (see
+// TcLowering.h).
+class TcDialect : public mlir::Dialect {
+public:
+  explicit TcDialect(mlir::MLIRContext *context);
+
+  static llvm::StringRef getDialectNamespace() { return "tc"; }
+};
+
+// A comprehension writing the elements of the memref `output`. The
+// operands are the output followed by the lower bounds and the upper
+// bounds (exclusive) of the iterators.
+//
+// The attributes describe the iterators, which are listed in the
+// order of the loops from the outermost to the innermost loop:
+//
+//   iterators:      names of the iterators
+//   iterator_types: "parallel" for iterators indexing the output and
+//                   "reduction" for all other iterators
+//   output_indices: index of the iterator for each dimension of the
+//                   output
+//   reduction:      assignment operator of the comprehension (e.g.,
+//                   "=", "+=" or "+=!")
+//   init:           neutral element of default-initialized reductions,
+//                   to which the output elements are set before the
+//                   reduction; absent for all other comprehensions
+//
+// The single block of the body takes the values of the iterators
+// followed by the current value of the output element and yields the
+// new value of the element (see YieldOp). Affine reads of tensor
+// elements are represented by AccessOp.
+//
+// Example:
+//
+//   C(i, j) +=! A(i, k) * B(k, j)
+//
+// is represented as
+//
+//   "tc.comprehension"(%C, %lb_i, %lb_j, %lb_k, %ub_i, %ub_j, %ub_k) ({
+//   ^bb0(%i: index, %j: index, %k: index, %accu: f32):
+//     %0 = "tc.access"(%A) {map = affine_map<(d0, d1, d2) -> (d0, d2)>}
+//     %1 = "tc.access"(%B) {map = affine_map<(d0, d1, d2) -> (d2, d1)>}
+//     %2 = mulf %0, %1 : f32
+//     %3 = addf %2, %accu : f32
+//     "tc.yield"(%3) : (f32) -> ()
+//   }) {init = 0.0 : f32, iterators = ["i", "j", "k"],
+//       iterator_types = ["parallel", "parallel", "reduction"],
+//       output_indices = [0, 1], reduction = "+=!"}
+class ComprehensionOp
+    : public mlir::Op<ComprehensionOp, mlir::OpTrait::ZeroResult,
+                      mlir::OpTrait::VariadicOperands,
+                      mlir::OpTrait::OneRegion> {
+public:
+  using Op::Op;
+
+  static llvm::StringRef getOperationName() { return "tc.comprehension"; }
+
+  static llvm::StringRef getIteratorsAttrName() { return "iterators"; }
+  static llvm::StringRef getIteratorTypesAttrName() { return "iterator_types"; }
+  static llvm::StringRef getOutputIndicesAttrName() { return "output_indices"; }
+  static llvm::StringRef getReductionAttrName() { return "reduction"; }
+  static llvm::StringRef getInitAttrName() { return "init"; }
+
+  // Builds a comprehension with an empty body block. `init` may be a
+  // null attribute for comprehensions that are not
+  // default-initialized reductions.
+  static void build(mlir::OpBuilder &builder, mlir::OperationState &state,
+                    mlir::Value output, mlir::ValueRange lowerBounds,
+                    mlir::ValueRange upperBounds,
+                    llvm::ArrayRef<std::string> iterators,
+                    llvm::ArrayRef<llvm::StringRef> iteratorTypes,
+                    llvm::ArrayRef<unsigned> outputIndices,
+                    llvm::StringRef reduction, mlir::Attribute init);
+
+  mlir::LogicalResult verify();
+
+  mlir::Value getOutput() { return getOperation()->getOperand(0); }
+
+  mlir::MemRefType getOutputType() {
+    return getOutput().getType().cast<mlir::MemRefType>();
+  }
+
+  unsigned getNumIterators() {
+    return (getOperation()->getNumOperands() - 1) / 2;
+  }
+
+  mlir::Operation::operand_range getLowerBounds() {
+    return getOperation()->getOperands().slice(1, getNumIterators());
+  }
+
+  mlir::Operation::operand_range getUpperBounds() {
+    return getOperation()->getOperands().slice(1 + getNumIterators(),
+                                               getNumIterators());
+  }
+
+  std::vector<std::string> getIteratorNames();
+
+  // Checks if the iterator with the index `idx` is a reduction
+  // iterator
+  bool isReductionIterator(unsigned idx);
+
+  std::vector<unsigned> getOutputIndices();
+
+  // Returns the indexes of the output as expressions of the
+  // iterators
+  llvm::SmallVector<mlir::AffineExpr, 4> getOutputIndexExprs();
+
+  llvm::StringRef getReduction() {
+    return getAttrOfType<mlir::StringAttr>(getReductionAttrName()).getValue();
+  }
+
+  // Returns the neutral element of default-initialized reductions or
+  // a null attribute
+  mlir::Attribute getInit() { return getAttr(getInitAttrName()); }
+
+  mlir::Block &getBody() { return getOperation()->getRegion(0).front(); }
+
+  // Returns the block argument for the current value of the output
+  // element
+  mlir::BlockArgument getAccumulator() {
+    return getBody().getArgument(getNumIterators());
+  }
+
+  // Returns the value yielded for the output element
+  mlir::Value getYieldedValue() {
+    return getBody().getTerminator()->getOperand(0);
+  }
+};
+
+// An affine read of an element of the memref `tensor` within the body
+// of a ComprehensionOp. The dimensions of the affine map `map` are
+// the iterators of the enclosing comprehension; its results are the
+// indexes of the element.
+class AccessOp
+    : public mlir::Op<AccessOp, mlir::OpTrait::OneResult,
+                      mlir::OpTrait::OneOperand> {
+public:
+  using Op::Op;
+
+  static llvm::StringRef getOperationName() { return "tc.access"; }
+
+  static llvm::StringRef getMapAttrName() { return "map"; }
+
+  static void build(mlir::OpBuilder &builder, mlir::OperationState &state,
+                    mlir::Value tensor, mlir::AffineMap map);
+
+  mlir::LogicalResult verify();
+
+  mlir::Value getTensor() { return getOperation()->getOperand(0); }
+
+  mlir::AffineMap getMap() {
+    return getAttrOfType<mlir::AffineMapAttr>(getMapAttrName()).getValue();
+  }
+};
+
+// Terminates the body of a ComprehensionOp, yielding the new value of
+// the output element
+class YieldOp
+    : public mlir::Op<YieldOp, mlir::OpTrait::ZeroResult,
+                      mlir::OpTrait::OneOperand, mlir::OpTrait::IsTerminator,
+                      mlir::OpTrait::HasParent<ComprehensionOp>::Impl> {
+public:
+  using Op::Op;
+
+  static llvm::StringRef getOperationName() { return "tc.yield"; }
+
+  static void build(mlir::OpBuilder &builder, mlir::OperationState &state,
+                    mlir::Value value);
+};
+
+} // namespace dialect
+} // namespace teckyl
+
+#endif
@@ -0,0 +1,403 @@
+#include "teckyl/TcLowering.h"
+#include "teckyl/TcDialect.h"
+
+#include <mlir/Dialect/Affine/IR/AffineOps.h>
+#include <mlir/Dialect/Linalg/EDSC/Builders.h>
+#include <mlir/Dialect/Linalg/EDSC/Intrinsics.h>
+#include <mlir/Dialect/SCF/SCF.h>
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/IR/BlockAndValueMapping.h>
+#include <mlir/IR/Function.h>
+#include <mlir/IR/Matchers.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace teckyl {
+namespace dialect {
+
+namespace {
+
+// Kinds of loops generated for comprehensions
+enum class LoopKind { SCF, Affine };
+
+// Builds a nest of loops of the kind `kind` for the iterators of `op`
+// with the indexes `iterators` (from the outermost to the innermost
+// loop) at the insertion point of `builder`. The induction variable
+// of each loop is stored in `ivs` at the index of its iterator. The
+// insertion point is moved to the start of the innermost loop.
+void buildLoopNest(mlir::OpBuilder &builder, ComprehensionOp op,
+                   llvm::ArrayRef<unsigned> iterators, LoopKind kind,
+                   llvm::SmallVectorImpl<mlir::Value> &ivs) {
+  mlir::Location location = op.getLoc();
+  mlir::Operation::operand_range lbs = op.getLowerBounds();
+  mlir::Operation::operand_range ubs = op.getUpperBounds();
+  mlir::AffineMap symbolMap = mlir::AffineMap::get(
+      0, 1, mlir::getAffineSymbolExpr(0, builder.getContext()));
+  mlir::Value step;
+
+  if (kind == LoopKind::SCF)
+    step = builder.create<mlir::ConstantIndexOp>(location, 1);
+
+  ivs.resize(op.getNumIterators());
+
+  for (unsigned it : iterators) {
+    if (kind == LoopKind::SCF) {
+      mlir::scf::ForOp loop =
+          builder.create<mlir::scf::ForOp>(location, lbs[it], ubs[it], step);
+
+      ivs[it] = loop.getInductionVar();
+      builder.setInsertionPointToStart(loop.getBody());
+    } else {
+      mlir::AffineForOp loop = builder.create<mlir::AffineForOp>(
+          location, mlir::ValueRange{lbs[it]}, symbolMap,
+          mlir::ValueRange{ubs[it]}, symbolMap);
+
+      ivs[it] = loop.getInductionVar();
+      builder.setInsertionPointToStart(loop.getBody());
+    }
+  }
+}
+
+// Returns the indexes of the output element of `op` for the iterator
+// values `ivs`
+llvm::SmallVector<mlir::Value, 4>
+getOutputIndexes(ComprehensionOp op, llvm::ArrayRef<mlir::Value> ivs) {
+  llvm::SmallVector<mlir::Value, 4> indexes;
+
+  for (unsigned idx : op.getOutputIndices())
+    indexes.push_back(ivs[idx]);
+
+  return indexes;
+}
+
+// Builds a load of the output element of `op` for the iterator
+// values `ivs`
+mlir::Value buildOutputLoad(mlir::OpBuilder &builder, ComprehensionOp op,
+                            llvm::ArrayRef<mlir::Value> ivs, LoopKind kind) {
+  llvm::SmallVector<mlir::Value, 4> indexes = getOutputIndexes(op, ivs);
+
+  if (kind == LoopKind::Affine) {
+    return builder.create<mlir::AffineLoadOp>(op.getLoc(), op.getOutput(),
+                                              indexes);
+  }
+
+  return builder.create<mlir::LoadOp>(op.getLoc(), op.getOutput(), indexes);
+}
+
+// Builds a store of `value` to the output element of `op` for the
+// iterator values `ivs`
+void buildOutputStore(mlir::OpBuilder &builder, ComprehensionOp op,
+                      mlir::Value value, llvm::ArrayRef<mlir::Value> ivs,
+                      LoopKind kind) {
+  llvm::SmallVector<mlir::Value, 4> indexes = getOutputIndexes(op, ivs);
+
+  if (kind == LoopKind::Affine) {
+    builder.create<mlir::AffineStoreOp>(op.getLoc(), value, op.getOutput(),
+                                        indexes);
+  } else {
+    builder.create<mlir::StoreOp>(op.getLoc(), value, op.getOutput(), indexes);
+  }
+}
+
+// Builds a load for the access `access` with the iterator values
+// `ivs`. For scf.for loops, index expressions other than plain
+// iterators are computed with affine.apply operations.
+mlir::Value buildAccessLoad(mlir::OpBuilder &builder, AccessOp access,
+                            llvm::ArrayRef<mlir::Value> ivs, LoopKind kind) {
+  mlir::AffineMap map = access.getMap();
+
+  if (kind == LoopKind::Affine) {
+    return builder.create<mlir::AffineLoadOp>(access.getLoc(),
+                                              access.getTensor(), map, ivs);
+  }
+
+  llvm::SmallVector<mlir::Value, 4> indexes;
+
+  for (unsigned i = 0; i < map.getNumResults(); i++) {
+    mlir::AffineExpr expr = map.getResult(i);
+
+    if (mlir::AffineDimExpr dim = expr.dyn_cast<mlir::AffineDimExpr>()) {
+      indexes.push_back(ivs[dim.getPosition()]);
+    } else {
+      indexes.push_back(builder.create<mlir::AffineApplyOp>(
+          access.getLoc(), map.getSubMap({i}), ivs));
+    }
+  }
+
+  return builder.create<mlir::LoadOp>(access.getLoc(), access.getTensor(),
+                                      indexes);
+}
+
+// Clones the body of `op` without its terminator to the insertion
+// point of `builder` and returns the value yielded for the output
+// element. The iterators are replaced with `ivs` (unless `ivs` is
+// empty), the current value of the output element with `accu` and
+// each access with the value returned by `buildAccess`.
+mlir::Value
+cloneBody(mlir::OpBuilder &builder, ComprehensionOp op,
+          llvm::ArrayRef<mlir::Value> ivs, mlir::Value accu,
+          llvm::function_ref<mlir::Value(AccessOp)> buildAccess) {
+  mlir::BlockAndValueMapping mapping;
+  mlir::Block &body = op.getBody();
+
+  for (size_t i = 0; i < ivs.size(); i++)
+    mapping.map(body.getArgument(i), ivs[i]);
+
+  if (accu)
+    mapping.map(op.getAccumulator(), accu);
+
+  for (mlir::Operation &nested : body.without_terminator()) {
+    if (AccessOp access = llvm::dyn_cast<AccessOp>(&nested))
+      mapping.map(access.getResult(), buildAccess(access));
+    else
+      builder.clone(nested, mapping);
+  }
+
+  return mapping.lookupOrDefault(op.getYieldedValue());
+}
+
+// Replaces `op` with a loop nest of the kind `kind`, preceded by a
+// second loop nest initializing the output for default-initialized
+// reductions
+void lowerToLoops(ComprehensionOp op, LoopKind kind) {
+  mlir::OpBuilder builder(op);
+  std::vector<unsigned> iterators(op.getNumIterators());
+
+  std::iota(iterators.begin(), iterators.end(), 0);
+
+  if (mlir::Attribute init = op.getInit()) {
+    mlir::OpBuilder::InsertionGuard guard(builder);
+    mlir::Value initVal = builder.create<mlir::ConstantOp>(op.getLoc(), init);
+    llvm::SmallVector<mlir::Value, 4> ivs;
+
+    buildLoopNest(builder, op, op.getOutputIndices(), kind, ivs);
+    buildOutputStore(builder, op, initVal, ivs, kind);
+  }
+
+  llvm::SmallVector<mlir::Value, 4> ivs;
+  mlir::Value accu;
+
+  buildLoopNest(builder, op, iterators, kind, ivs);
+
+  // Plain assignments do not read the output element
+  if (!op.getAccumulator().use_empty())
+    accu = buildOutputLoad(builder, op, ivs, kind);
+
+  mlir::Value res = cloneBody(builder, op, ivs, accu, [&](AccessOp access) {
+    return buildAccessLoad(builder, access, ivs, kind);
+  });
+
+  buildOutputStore(builder, op, res, ivs, kind);
+  op.erase();
+}
+
+// Checks if `v` is the constant zero, possibly converted to an index
+bool isConstantZero(mlir::Value v) {
+  if (mlir::IndexCastOp cast =
+          llvm::dyn_cast_or_null<mlir::IndexCastOp>(v.getDefiningOp())) {
+    v = cast.getOperand();
+  }
+
+  return mlir::matchPattern(v, mlir::m_Zero());
+}
+
+// Returns a one-dimensional view with `size` elements, which all
+// alias the same, uninitialized byte on the stack. The view defines
+// the range of a loop of a linalg operation without occupying memory
+// proportional to the range.
+mlir::Value buildDomainOperand(mlir::OpBuilder &builder, mlir::Value size,
+                               mlir::Location location) {
+  mlir::Value elem = builder.create<mlir::AllocaOp>(
+      location, mlir::MemRefType::get({1}, builder.getIntegerType(8)));
+  mlir::Value zero = builder.create<mlir::ConstantIndexOp>(location, 0);
+
+  return builder.create<mlir::SubViewOp>(location, elem, mlir::ValueRange{zero},
+                                         mlir::ValueRange{size},
+                                         mlir::ValueRange{zero});
+}
+
+// Checks if `op` can be lowered to linalg.generic operations. The
+// ranges of the loops of linalg operations start at zero and the
+// body of linalg.generic has no access to the values of the
+// iterators.
+bool isLinalgCompatible(ComprehensionOp op) {
+  for (mlir::Value lb : op.getLowerBounds()) {
+    if (!isConstantZero(lb))
+      return false;
+  }
+
+  for (unsigned i = 0; i < op.getNumIterators(); i++) {
+    if (!op.getBody().getArgument(i).use_empty())
+      return false;
+  }
+
+  return true;
+}
+
+// Replaces `op` with a linalg.generic operation, preceded by a second
+// linalg.generic operation initializing the output for
+// default-initialized reductions. The loop ranges are defined by one
+// domain operand per iterator (see buildDomainOperand()), which
+// precede all other operands, such that the ranges are never derived
+// from the sizes of the accessed tensors. Structurally identical
+// accesses are mapped to the same input operand.
+void lowerToLinalg(ComprehensionOp op) {
+  mlir::OpBuilder builder(op);
+  mlir::Location location = op.getLoc();
+  mlir::MLIRContext *context = builder.getContext();
+  mlir::Operation::operand_range ubs = op.getUpperBounds();
+  mlir::edsc::ScopedContext sc(builder, location);
+
+  if (mlir::Attribute init = op.getInit()) {
+    std::vector<unsigned> outputIndices = op.getOutputIndices();
+
+    if (outputIndices.empty()) {
+      mlir::Value initVal = builder.create<mlir::ConstantOp>(location, init);
+      builder.create<mlir::StoreOp>(location, initVal, op.getOutput());
+    } else {
+      std::vector<mlir::edsc::StructuredIndexed> inputs;
+      std::vector<mlir::AffineExpr> dims;
+
+      for (unsigned i = 0; i < outputIndices.size(); i++) {
+        mlir::AffineExpr dim = mlir::getAffineDimExpr(i, context);
+        mlir::edsc::StructuredIndexed domain(
+            buildDomainOperand(builder, ubs[outputIndices[i]], location));
+
+        inputs.push_back(domain({dim}));
+        dims.push_back(dim);
+      }
+
+      mlir::edsc::StructuredIndexed output(op.getOutput());
+      std::vector<mlir::IteratorType> iteratorTypes(
+          outputIndices.size(), mlir::IteratorType::Parallel);
+
+      mlir::edsc::makeGenericLinalgOp(
+          iteratorTypes, inputs, {output(dims)},
+          [&](mlir::ValueRange blockArgs) {
+            mlir::Value initVal =
+                mlir::edsc::ScopedContext::getBuilderRef()
+                    .create<mlir::ConstantOp>(location, init);
+            mlir::edsc::intrinsics::linalg_yield{initVal};
+          });
+    }
+  }
+
+  std::vector<mlir::edsc::StructuredIndexed> inputs;
+  std::vector<mlir::IteratorType> iteratorTypes;
+
+  for (unsigned i = 0; i < op.getNumIterators(); i++) {
+    mlir::edsc::StructuredIndexed domain(
+        buildDomainOperand(builder, ubs[i], location));
+
+    inputs.push_back(domain({mlir::getAffineDimExpr(i, context)}));
+    iteratorTypes.push_back(op.isReductionIterator(i)
+                                ? mlir::IteratorType::Reduction
+                                : mlir::IteratorType::Parallel);
+  }
+
+  // Input operand for each access
+  std::vector<std::pair<mlir::Value, mlir::AffineMap>> distinctAccesses;
+  llvm::DenseMap<mlir::Operation *, unsigned> argIndexes;
+
+  for (mlir::Operation &nested : op.getBody().without_terminator()) {
+    AccessOp access = llvm::dyn_cast<AccessOp>(&nested);
+
+    if (!access)
+      continue;
+
+    std::pair<mlir::Value, mlir::AffineMap> key(access.getTensor(),
+                                                access.getMap());
+    auto known =
+        std::find(distinctAccesses.begin(), distinctAccesses.end(), key);
+
+    if (known != distinctAccesses.end()) {
+      argIndexes[access] =
+          op.getNumIterators() + (known - distinctAccesses.begin());
+      continue;
+    }
+
+    mlir::edsc::StructuredIndexed tensor(access.getTensor());
+    llvm::ArrayRef<mlir::AffineExpr> exprs = access.getMap().getResults();
+
+    argIndexes[access] = inputs.size();
+    distinctAccesses.push_back(key);
+    inputs.push_back(tensor(std::vector<mlir::AffineExpr>(exprs.begin(),
+                                                          exprs.end())));
+  }
+
+  mlir::edsc::StructuredIndexed output(op.getOutput());
+  llvm::SmallVector<mlir::AffineExpr, 4> outputExprs = op.getOutputIndexExprs();
+  std::vector<mlir::edsc::StructuredIndexed> outputs{output(
+      std::vector<mlir::AffineExpr>(outputExprs.begin(), outputExprs.end()))};
+
+  // The block arguments are the elements of the domain operands and
+  // of the accesses followed by the output element
+  mlir::edsc::makeGenericLinalgOp(
+      iteratorTypes, inputs, outputs, [&](mlir::ValueRange blockArgs) {
+        mlir::Value res = cloneBody(
+            mlir::edsc::ScopedContext::getBuilderRef(), op, {},
+            blockArgs[blockArgs.size() - 1], [&](AccessOp access) {
+              return blockArgs[argIndexes.lookup(access)];
+            });
+
+        mlir::edsc::intrinsics::linalg_yield{res};
+      });
+
+  op.erase();
+}
+
+// Collects the comprehensions of `f`, such that they can be replaced
+// while iterating over them
+llvm::SmallVector<ComprehensionOp, 8> collectComprehensions(mlir::FuncOp f) {
+  llvm::SmallVector<ComprehensionOp, 8> ops;
+
+  f.walk([&](ComprehensionOp op) { ops.push_back(op); });
+
+  return ops;
+}
+
+struct LowerTcToLinalgPass
+    : public mlir::PassWrapper<LowerTcToLinalgPass, mlir::FunctionPass> {
+  void runOnFunction() override {
+    for (ComprehensionOp op : collectComprehensions(getFunction())) {
+      if (isLinalgCompatible(op))
+        lowerToLinalg(op);
+      else
+        lowerToLoops(op, LoopKind::SCF);
+    }
+  }
+};
+
+struct LowerTcToSCFPass
+    : public mlir::PassWrapper<LowerTcToSCFPass, mlir::FunctionPass> {
+  void runOnFunction() override {
+    for (ComprehensionOp op : collectComprehensions(getFunction()))
+      lowerToLoops(op, LoopKind::SCF);
+  }
+};
+
+struct LowerTcToAffinePass
+    : public mlir::PassWrapper<LowerTcToAffinePass, mlir::FunctionPass> {
+  void runOnFunction() override {
+    for (ComprehensionOp op : collectComprehensions(getFunction()))
+      lowerToLoops(op, LoopKind::Affine);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<mlir::Pass> createLowerTcToLinalgPass() {
+  return std::make_unique<LowerTcToLinalgPass>();
+}
+
+std::unique_ptr<mlir::Pass> createLowerTcToSCFPass() {
+  return std::make_unique<LowerTcToSCFPass>();
+}
+
+std::unique_ptr<mlir::Pass> createLowerTcToAffinePass() {
+  return std::make_unique<LowerTcToAffinePass>();
+}
+
+} // namespace dialect
+} // namespace teckyl
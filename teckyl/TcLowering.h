@@ -0,0 +1,33 @@
+#ifndef TECKYL_TCLOWERING_H
+#define TECKYL_TCLOWERING_H
+
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+
+namespace teckyl {
+namespace dialect {
+
+// Creates a pass lowering each tc.comprehension operation (see
+// TcDialect.h) to a linalg.generic operation, preceded by a second
+// linalg.generic operation initializing the output for
+// default-initialized reductions. Comprehensions whose iterators do
+// not all start at zero or whose body uses the values of the
+// iterators (e.g., for non-affine indexing) cannot be expressed as
+// linalg.generic operations and are lowered to scf.for loop nests
+// instead.
+std::unique_ptr<mlir::Pass> createLowerTcToLinalgPass();
+
+// Creates a pass lowering each tc.comprehension operation to a nest
+// of scf.for loops
+std::unique_ptr<mlir::Pass> createLowerTcToSCFPass();
+
+// Creates a pass lowering each tc.comprehension operation to a nest
+// of affine.for loops with affine loads and stores for all affine
+// accesses. The bounds of the iterators must be valid affine symbols.
+std::unique_ptr<mlir::Pass> createLowerTcToAffinePass();
+
+} // namespace dialect
+} // namespace teckyl
+
+#endif
@@ -0,0 +1,286 @@
+#include "teckyl/TuningDB.h"
+#include "teckyl/lang_extras.h"
+
+#include <llvm/Support/Host.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace teckyl {
+namespace tuning {
+
+// Splits `str` at each occurrence of `sep`. Empty parts are omitted.
+static std::vector<std::string> split(const std::string &str, char sep) {
+  std::vector<std::string> parts;
+  std::stringstream ss(str);
+  std::string part;
+
+  while (std::getline(ss, part, sep))
+    if (!part.empty())
+      parts.push_back(part);
+
+  return parts;
+}
+
+// Splits an assignment of the form "<key>=<value>" into its key and
+// value. Throws an exception if `str` is not an assignment.
+static std::pair<std::string, std::string>
+splitAssignment(const std::string &str) {
+  size_t pos = str.find('=');
+
+  if (pos == std::string::npos || pos == 0 || pos == str.size() - 1)
+    THROW_OR_ASSERT(Exception("Invalid assignment '" + str + "'"));
+
+  return {str.substr(0, pos), str.substr(pos + 1)};
+}
+
+// Writes a serialization of `tree` to `out`. Unlike the pretty
+// printer, the serialization includes the suffixes of numbers, such
+// that constants of different types yield different strings.
+static void serializeTree(std::ostream &out, const lang::TreeRef &tree) {
+  switch (tree->kind()) {
+  case lang::TK_NUMBER:
+    // The value is the exact spelling from the source, which is
+    // hashed without a round trip through a floating point type
+    out << tree->numValue()
+        << std::static_pointer_cast<lang::Number>(tree)->suffix();
+    break;
+  case lang::TK_STRING:
+    out << tree->stringValue();
+    break;
+  default:
+    out << "(" << lang::kindToString(tree->kind());
+
+    for (const lang::TreeRef &subtree : tree->trees()) {
+      out << " ";
+      serializeTree(out, subtree);
+    }
+
+    out << ")";
+    break;
+  }
+}
+
+std::string getKernelHash(const lang::Def &def) {
+  std::stringstream tree;
+  std::stringstream ss;
+
+  serializeTree(tree, def.tree());
+
+  // 64-bit FNV-1a, which, unlike llvm::hash_value(), is guaranteed to
+  // be stable across executions and builds
+  uint64_t hash = 0xcbf29ce484222325;
+
+  for (char c : tree.str()) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+
+  ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+  return ss.str();
+}
+
+Shape parseShape(const std::string &str) {
+  Shape shape;
+
+  for (const std::string &assignment : split(str, ',')) {
+    std::pair<std::string, std::string> kv = splitAssignment(assignment);
+    std::stringstream ss(kv.second);
+    uint64_t size;
+
+    if (!(ss >> size) || !ss.eof())
+      THROW_OR_ASSERT(Exception("Invalid size '" + kv.second + "'"));
+
+    shape[kv.first] = size;
+  }
+
+  return shape;
+}
+
+std::string getShapeKey(const lang::Def &def, const Shape &shape) {
+  std::stringstream ss;
+  bool first = true;
+
+  // Sets are ordered, such that the key does not depend on the order
+  // in which the sizes have been specified
+  for (const std::string &sizeParam : collectDimSizeParams(def)) {
+    auto it = shape.find(sizeParam);
+
+    if (it == shape.end())
+      return "";
+
+    if (!first)
+      ss << ",";
+
+    ss << sizeParam << "=" << it->second;
+    first = false;
+  }
+
+  return first ? "-" : ss.str();
+}
+
+std::string getHostCPU() { return llvm::sys::getHostCPUName().str(); }
+
+Config parseConfig(const std::string &str) {
+  Config config;
+
+  for (const std::string &setting : split(str, ';'))
+    config.insert(splitAssignment(setting));
+
+  return config;
+}
+
+std::string formatConfig(const Config &config) {
+  std::stringstream ss;
+  bool first = true;
+
+  for (const auto &setting : config) {
+    if (!first)
+      ss << ";";
+
+    ss << setting.first << "=" << setting.second;
+    first = false;
+  }
+
+  return ss.str();
+}
+
+void applyConfig(const Config &config, MLIRGenOptions &options) {
+  const std::string loopOrderPrefix = "loop-order.";
+
+  for (const auto &setting : config) {
+    const std::string &key = setting.first;
+    const std::string &value = setting.second;
+    bool valid = true;
+
+    if (key == "body-op") {
+      if (value == "linalg.generic")
+        options.body_op = MLIRGenOptions::BodyOp::LinalgGeneric;
+      else if (value == "scf.for")
+        options.body_op = MLIRGenOptions::BodyOp::ScfFor;
+      else
+        valid = false;
+    } else if (key == "specialize-linalg-ops") {
+      if (value == "0" || value == "1")
+        options.specialize_linalg_ops = (value == "1");
+      else
+        valid = false;
+    } else if (key == "contraction-backend") {
+      if (value == "linalg")
+        options.contraction_backend =
+            MLIRGenOptions::ContractionBackend::Linalg;
+      else if (value == "cblas")
+        options.contraction_backend = MLIRGenOptions::ContractionBackend::CBLAS;
+      else if (value == "teckyl-rt")
+        options.contraction_backend =
+            MLIRGenOptions::ContractionBackend::TeckylRT;
+      else
+        valid = false;
+    } else if (key.compare(0, loopOrderPrefix.size(), loopOrderPrefix) == 0) {
+      std::stringstream ss(key.substr(loopOrderPrefix.size()));
+      size_t idx;
+
+      if (ss >> idx && ss.eof())
+        options.loop_orders[idx] = split(value, ',');
+      else
+        valid = false;
+    } else {
+      THROW_OR_ASSERT(Exception("Unknown tuning setting '" + key + "'"));
+    }
+
+    if (!valid) {
+      THROW_OR_ASSERT(Exception("Invalid value '" + value +
+                                "' for tuning setting '" + key + "'"));
+    }
+  }
+
+  if (options.specialize_linalg_ops &&
+      options.body_op != MLIRGenOptions::BodyOp::LinalgGeneric) {
+    options.specialize_linalg_ops = false;
+  }
+}
+
+std::vector<Config> getKernelConfigs() {
+  std::vector<Config> configs;
+
+  for (const char *backend : {"linalg", "teckyl-rt"}) {
+    configs.push_back({{"body-op", "scf.for"},
+                       {"specialize-linalg-ops", "0"},
+                       {"contraction-backend", backend}});
+
+    for (const char *specialize : {"0", "1"}) {
+      configs.push_back({{"body-op", "linalg.generic"},
+                         {"specialize-linalg-ops", specialize},
+                         {"contraction-backend", backend}});
+    }
+  }
+
+  return configs;
+}
+
+std::map<size_t, std::vector<std::vector<std::string>>>
+getLoopOrders(const lang::Def &def, size_t maxOrders) {
+  std::map<size_t, std::vector<std::vector<std::string>>> orders;
+  size_t idx = 0;
+
+  for (const lang::Comprehension &c : lang::Def(def).statements()) {
+    std::set<std::string> iteratorSet = collectIteratorNames(def, c);
+    std::vector<std::string> iterators(iteratorSet.begin(), iteratorSet.end());
+
+    if (iterators.size() > 1) {
+      // The sorted sequence is the first permutation
+      do {
+        orders[idx].push_back(iterators);
+      } while (orders[idx].size() < maxOrders &&
+               std::next_permutation(iterators.begin(), iterators.end()));
+    }
+
+    idx++;
+  }
+
+  return orders;
+}
+
+void Database::load(const std::string &filename) {
+  std::ifstream ifs(filename);
+  std::string line;
+  size_t lineNo = 0;
+
+  if (!ifs.good())
+    THROW_OR_ASSERT(Exception("Could not open tuning database " + filename));
+
+  while (std::getline(ifs, line)) {
+    std::stringstream ss(line);
+    std::string kernelHash, cpu, shape, config, trailing;
+
+    lineNo++;
+
+    if (!(ss >> kernelHash) || kernelHash[0] == '#')
+      continue;
+
+    if (!(ss >> cpu >> shape >> config) || (ss >> trailing)) {
+      std::stringstream err;
+      err << filename << ":" << lineNo << ": Invalid record";
+      THROW_OR_ASSERT(Exception(err.str()));
+    }
+
+    records[{kernelHash, cpu, shape}] = parseConfig(config);
+  }
+}
+
+const Config *Database::lookup(const std::string &kernelHash,
+                               const std::string &cpu,
+                               const std::string &shape) const {
+  auto it = records.find({kernelHash, cpu, shape});
+
+  if (it == records.end())
+    return nullptr;
+
+  return &it->second;
+}
+
+} // namespace tuning
+} // namespace teckyl
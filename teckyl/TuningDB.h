@@ -0,0 +1,111 @@
+#ifndef TECKYL_TUNING_DB_H
+#define TECKYL_TUNING_DB_H
+
+#include "teckyl/Exception.h"
+#include "teckyl/MLIRGen.h"
+
+#include "teckyl/tc/lang/tree_views.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace teckyl {
+namespace tuning {
+
+class Exception : public teckyl::Exception {
+public:
+  Exception(const std::string &msg) : teckyl::Exception(msg) {}
+};
+
+// Values for the sizes of symbolic tensor dimensions, indexed by the
+// name of the size parameter
+using Shape = std::map<std::string, uint64_t>;
+
+// Settings for the code generation of one kernel, indexed by the name
+// of the setting (see applyConfig())
+using Config = std::map<std::string, std::string>;
+
+// Returns a hash identifying the TC definition `def`, which must not
+// have been processed by the semantic analysis. The hash is derived
+// from the structure of the AST and thus does not change with
+// formatting or comments.
+std::string getKernelHash(const lang::Def &def);
+
+// Parses a shape given as a comma-separated list of assignments
+// (e.g., "M=512,N=256")
+Shape parseShape(const std::string &str);
+
+// Returns the canonical representation of the sizes of `shape` for
+// the size parameters of `def`, used as the shape in the keys of the
+// tuning database. Returns "-" if `def` has no size parameters and
+// an empty string if `shape` lacks the size of any size parameter.
+std::string getShapeKey(const lang::Def &def, const Shape &shape);
+
+// Returns the name of the host CPU used in the keys of the tuning
+// database
+std::string getHostCPU();
+
+// Parses a configuration given as a semicolon-separated list of
+// settings (e.g., "body-op=scf.for;loop-order.0=i,k,j")
+Config parseConfig(const std::string &str);
+
+// Returns the textual representation of `config` as parsed by
+// parseConfig()
+std::string formatConfig(const Config &config);
+
+// Applies the settings from `config` to `options`. Supported settings
+// are:
+//
+//   body-op=linalg.generic|scf.for
+//   specialize-linalg-ops=0|1
+//   contraction-backend=linalg|cblas|teckyl-rt
+//   loop-order.<n>=<iterator>,<iterator>,...
+//
+// where <n> is the index of a comprehension within its definition.
+void applyConfig(const Config &config, MLIRGenOptions &options);
+
+// Returns the configurations for the choices made for entire kernels
+// explored by the tuner, i.e., the combinations of the body
+// operation, the specialization of linalg operations and the backend
+// for contractions (except for CBLAS, which requires an external
+// library)
+std::vector<Config> getKernelConfigs();
+
+// Returns up to `maxOrders` loop orders for each comprehension of the
+// definition `def` with more than one iterator, indexed by the index
+// of the comprehension. `def` must have been processed by the
+// semantic analysis.
+std::map<size_t, std::vector<std::vector<std::string>>>
+getLoopOrders(const lang::Def &def, size_t maxOrders);
+
+// Database with the best known configuration for each combination of
+// a kernel, a shape and a CPU.
+//
+// The database is a text file with one record per line of the form
+//
+//   <kernel hash> <cpu> <shape> <config>
+//
+// with the shape and the configuration as returned by getShapeKey()
+// and formatConfig(). Empty lines and lines starting with '#' are
+// ignored.
+class Database {
+public:
+  // Reads the records from the file `filename`
+  void load(const std::string &filename);
+
+  // Returns the configuration recorded for the kernel with the hash
+  // `kernelHash`, the CPU `cpu` and the shape `shape` or NULL if there
+  // is no such record
+  const Config *lookup(const std::string &kernelHash, const std::string &cpu,
+                       const std::string &shape) const;
+
+protected:
+  std::map<std::vector<std::string>, Config> records;
+};
+
+} // namespace tuning
+} // namespace teckyl
+
+#endif
@@ -99,46 +99,29 @@ bool isAffine(const lang::TreeRef &e, const std::set<std::string> &syms) {
   llvm_unreachable(err.what());
 }
 
-// Conservatively checks whether an expression indexes tensors with
-// non-affine expressions wrt. the symbols in `syms`.
-//
-// Some affine indexing schemes might be recognized as non-affine,
-// e.g., `A(1/(1/i))`.
-//
-// TODO: Canonicalize before checking
-bool hasNonAffineIndexing(const lang::TreeRef &e,
-                          const std::set<std::string> &syms) {
-  switch (e->kind()) {
-  case lang::TK_CONST:
+// Checks whether the tensor read `a` within a loop over the iterator
+// `innermost` is likely to miss the hardware prefetcher, such that
+// software prefetching pays off. This is the case for reads depending
+// on `innermost` that are either gathers (i.e., indexed non-affinely
+// wrt. the iterators in `syms`, e.g., `A(B(i))`) or strided (i.e.,
+// `innermost` occurs in the index of a dimension other than the
+// innermost dimension, e.g., `A(i, k)` in a loop over `i`).
+bool isPrefetchCandidate(const lang::Access &a, const std::string &innermost,
+                         const std::set<std::string> &syms) {
+  lang::ListView<lang::TreeRef> args = a.arguments();
+
+  if (!usesIdent(args.tree(), innermost))
     return false;
-  case lang::TK_ACCESS: {
-    for (const lang::TreeRef &arg : lang::Access(e).arguments())
-      if (!isAffine(arg, syms))
-        return true;
 
-    return false;
-  }
-  case '+':
-  case '-':
-  case '*':
-  case '/':
-  case '?':
-  case '>':
-  case '<':
-  case lang::TK_GE:
-  case lang::TK_LE:
-  case lang::TK_EQ: {
-    for (const lang::TreeRef &child : e->trees())
-      if (hasNonAffineIndexing(child, syms))
-        return true;
+  for (const lang::TreeRef &arg : args)
+    if (!isAffine(arg, syms))
+      return true;
 
-    return false;
-  }
-  default:;
-  }
+  for (size_t i = 0; i + 1 < args.size(); i++)
+    if (usesIdent(args[i], innermost))
+      return true;
 
-  Exception err("Unsupported kind '" + lang::kindToString(e->kind()) + "'");
-  llvm_unreachable(err.what());
+  return false;
 }
 } // namespace teckyl
 
@@ -0,0 +1,225 @@
+#ifndef TECKYL_LANG_ANALYSIS_H
+#define TECKYL_LANG_ANALYSIS_H
+
+#include "teckyl/lang_affine.h"
+#include "teckyl/lang_extras.h"
+#include "teckyl/patterns.h"
+
+#include "teckyl/tc/lang/tree_views.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace teckyl {
+
+// Kinds of tensor expression iterators
+enum IteratorKind {
+  // Iterator appears on the left hand side (and may also appear at
+  // the right hand side)
+  LHS,
+
+  // Iterator appears only on the right hand side
+  RHSOnly
+};
+
+// Dimension `dim` of the tensor `tensor` indexed directly by the
+// identifier `iterator` on the right hand side of a comprehension
+// (e.g., k for dimension 0 of B in B(k, j))
+struct DirectIndex {
+  std::string iterator;
+  std::string tensor;
+  size_t dim;
+};
+
+// Properties of a comprehension on which the code generation
+// depends, gathered by a single traversal of the comprehension (see
+// analyzeComprehension())
+struct ComprehensionInfo {
+  // Comprehension with its let bindings inlined into the right hand
+  // side (see inlineLetBindings())
+  lang::Comprehension comprehension;
+
+  // Iterators and their kinds; the iterators of the reduction are the
+  // iterators with the kind RHSOnly
+  std::map<std::string, IteratorKind> iterators;
+  std::set<std::string> allIterators;
+  std::set<std::string> reductionIterators;
+
+  // Ranges of the iterators from the where clauses
+  IteratorRangeMap bounds;
+
+  // Tensor accesses and constants of the right hand side in preorder,
+  // including those in index expressions
+  std::vector<lang::Access> accesses;
+  std::vector<lang::Const> constants;
+
+  // Tensor dimensions indexed directly by an identifier on the right
+  // hand side in preorder
+  std::vector<DirectIndex> directIndexes;
+
+  // Whether all index expressions are affine in the iterators
+  bool affineIndexing;
+
+  // Whether each reduction iterator is used at least once in the index
+  // expression of a tensor access, either for direct indexing (e.g., k
+  // in B(k)) or as part of a compound index expression (e.g., k in
+  // B(k+5))
+  bool reductionIteratorsIndexTensors;
+
+  // Whether each iterator whose range does not start at zero is only
+  // used for direct indexing of tensor dimensions. For example, this
+  // is the case for i in
+  //
+  //   C(i) = A(i) + B(i) where i in 1:N
+  //
+  // but not in
+  //
+  //   C(i) = A(i) + A(i-1) where i in 1:N
+  bool offsetIteratorsOnlyIndexDirectly;
+
+  // Operation implemented by the comprehension
+  pattern::Classification pattern;
+};
+
+// Gathers the properties of `comprehension` in a single traversal of
+// its right hand side. Identifiers for which `isSymbol` returns true
+// (e.g., parameters and size parameters) are not iterators.
+static inline ComprehensionInfo
+analyzeComprehension(const lang::Comprehension &comprehension,
+                     const std::function<bool(const std::string &)> &isSymbol) {
+  ComprehensionInfo info{
+      lang::Comprehension(inlineLetBindings(comprehension))};
+  const lang::Comprehension &c = info.comprehension;
+
+  // Number of uses of each identifier and identifiers used in index
+  // expressions
+  std::map<std::string, size_t> uses;
+  std::set<std::string> indexIdents;
+
+  for (const lang::Ident &lhsIndex : c.indices())
+    info.iterators.emplace(lhsIndex.name(), IteratorKind::LHS);
+
+  std::function<void(const lang::TreeRef &, bool)> visit =
+      [&](const lang::TreeRef &t, bool inIndex) {
+        switch (t->kind()) {
+        case lang::TK_IDENT: {
+          const std::string &name = lang::Ident(t).name();
+
+          uses[name]++;
+
+          if (inIndex)
+            indexIdents.insert(name);
+
+          if (!info.iterators.count(name) && !isSymbol(name))
+            info.iterators.emplace(name, IteratorKind::RHSOnly);
+
+          return;
+        }
+        case lang::TK_CONST:
+          info.constants.push_back(lang::Const(t));
+          return;
+        case lang::TK_ACCESS: {
+          lang::Access a(t);
+          size_t dim = 0;
+
+          info.accesses.push_back(a);
+          visit(a.name(), inIndex);
+
+          for (const lang::TreeRef &arg : a.arguments()) {
+            if (arg->kind() == lang::TK_IDENT) {
+              info.directIndexes.push_back(
+                  {lang::Ident(arg).name(), a.name().name(), dim});
+            }
+
+            visit(arg, true);
+            dim++;
+          }
+
+          return;
+        }
+        default:
+          for (const lang::TreeRef &child : t->trees())
+            visit(child, inIndex);
+        }
+      };
+
+  visit(c.rhs(), false);
+
+  for (const std::pair<std::string, IteratorKind> &it : info.iterators) {
+    info.allIterators.insert(it.first);
+
+    if (it.second == IteratorKind::RHSOnly)
+      info.reductionIterators.insert(it.first);
+  }
+
+  info.bounds = collectExplicitIteratorBounds(c);
+
+  info.affineIndexing = std::all_of(
+      info.accesses.begin(), info.accesses.end(), [&](const lang::Access &a) {
+        for (const lang::TreeRef &arg : a.arguments())
+          if (!isAffine(arg, info.allIterators))
+            return false;
+
+        return true;
+      });
+
+  info.reductionIteratorsIndexTensors =
+      std::includes(indexIdents.begin(), indexIdents.end(),
+                    info.reductionIterators.begin(),
+                    info.reductionIterators.end());
+
+  std::map<std::string, size_t> directUses;
+
+  for (const DirectIndex &di : info.directIndexes)
+    directUses[di.iterator]++;
+
+  info.offsetIteratorsOnlyIndexDirectly = true;
+
+  for (const auto &bound : info.bounds) {
+    if (!isZeroExpr(bound.second.start()) &&
+        uses[bound.first] != directUses[bound.first]) {
+      info.offsetIteratorsOnlyIndexDirectly = false;
+    }
+  }
+
+  info.pattern = pattern::classifyComprehension(c);
+
+  return info;
+}
+
+// Checks that the domain specified by a where clause of each iterator
+// of the comprehension analyzed in `info` that is used at least once
+// for direct indexing of a tensor dimension matches the size of the
+// indexed dimension specified in the tensor specifications
+// `paramSpecs`.
+//
+// That is, the range must start with 0 and end at the size of the
+// tensor dimension.
+static inline bool directIteratorDomainsMatchTensorDimensions(
+    const ComprehensionInfo &info,
+    const std::map<const std::string, lang::TensorType> &paramSpecs) {
+  const lang::Comprehension &c = info.comprehension;
+
+  // Check indexing of the output tensor
+  if (!comprehensionLHSIteratorDomainsMatchTensorDimensions(
+          paramSpecs, info.bounds, c.ident().name(), c.indices())) {
+    return false;
+  }
+
+  // Check indexing of the input tensors
+  for (const DirectIndex &di : info.directIndexes) {
+    if (!iteratorDomainMatchesTensorDimension(paramSpecs, info.bounds,
+                                              di.iterator, di.tensor, di.dim))
+      return false;
+  }
+
+  return true;
+}
+
+} // namespace teckyl
+
+#endif
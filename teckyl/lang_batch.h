@@ -0,0 +1,205 @@
+#ifndef TECKYL_LANG_BATCH_H
+#define TECKYL_LANG_BATCH_H
+
+#include "teckyl/tc/lang/tree_views.h"
+
+#include "teckyl/lang_extras.h"
+#include "teckyl/lang_layout.h"
+
+#include <set>
+#include <string>
+
+namespace teckyl {
+namespace batch {
+
+// Suffix of the names of batched definitions (see batchDef())
+static const char *const defSuffix = "_batch";
+
+// Names of the identifiers introduced by batching a definition and
+// the names of its parameters
+struct BatchNames {
+  // Size parameter for the number of problems
+  std::string size;
+
+  // Iterator over the problems
+  std::string iterator;
+
+  // Parameters and outputs with and without dimensions
+  std::set<std::string> tensors;
+  std::set<std::string> scalars;
+};
+
+// Returns a copy of the tensor type `type` with the additional
+// outermost dimension `names.size`. A layout annotation is translated
+// to the layout with the additional dimension outermost.
+static inline lang::TreeRef batchTensorType(const lang::TensorType &type,
+                                            const BatchNames &names) {
+  const lang::SourceRange &range = type.range();
+  lang::TreeList dims{lang::Ident::create(range, names.size)};
+
+  for (const lang::TreeRef &dim : type.dims())
+    dims.push_back(dim);
+
+  lang::TreeRef layoutTree = type.tree()->tree(2);
+  layout::Layout layout;
+  std::string err;
+
+  // Invalid annotations are kept and reported by the semantic
+  // analysis
+  if (type.layout().present() &&
+      layout::parseLayout(type.layout().get().name(), type.dims().size(),
+                          layout, err)) {
+    layout::Layout batchedLayout{{layout::PhysicalDim::Kind::Full, 0, 0}};
+
+    for (layout::PhysicalDim pdim : layout) {
+      pdim.dim++;
+      batchedLayout.push_back(pdim);
+    }
+
+    layoutTree = lang::Compound::create(
+        lang::TK_OPTION, range,
+        {lang::Ident::create(range, layout::formatLayout(batchedLayout))});
+  }
+
+  return lang::TensorType::create(range, type.tree()->tree(0),
+                                  lang::List::create(range, std::move(dims)),
+                                  layoutTree);
+}
+
+// Returns a copy of the expression `exp`, in which each access to a
+// tensor and each reference to a scalar parameter has the iterator
+// `names.iterator` as an additional first index
+static inline lang::TreeRef batchExpr(const lang::TreeRef &exp,
+                                      const BatchNames &names) {
+  switch (exp->kind()) {
+  case lang::TK_APPLY: {
+    lang::Apply apply(exp);
+    lang::TreeList args;
+
+    if (names.tensors.count(apply.name().name()))
+      args.push_back(lang::Ident::create(exp->range(), names.iterator));
+
+    for (const lang::TreeRef &arg : apply.arguments())
+      args.push_back(batchExpr(arg, names));
+
+    return lang::Apply::create(
+        exp->range(), apply.name(),
+        lang::List::create(apply.arguments().range(), std::move(args)));
+  }
+  case lang::TK_IDENT: {
+    if (!names.scalars.count(lang::Ident(exp).name()))
+      return exp;
+
+    lang::TreeRef idx = lang::Ident::create(exp->range(), names.iterator);
+
+    return lang::Apply::create(exp->range(), exp,
+                               lang::List::create(exp->range(), {idx}));
+  }
+  default:
+    if (exp->isAtom())
+      return exp;
+
+    return exp->map([&](lang::TreeRef t) { return batchExpr(t, names); });
+  }
+}
+
+// Returns a copy of the comprehension `c` with the iterator
+// `names.iterator` as an additional first index of the target tensor
+// and of all accesses (see batchExpr()), ranging over all problems
+static inline lang::TreeRef batchComprehension(const lang::Comprehension &c,
+                                               const BatchNames &names) {
+  const lang::SourceRange &range = c.range();
+  lang::TreeList indices{lang::Ident::create(range, names.iterator)};
+  lang::TreeList whereClauses;
+
+  for (const lang::Ident &index : c.indices())
+    indices.push_back(index);
+
+  for (const lang::TreeRef &clause : c.whereClauses()) {
+    if (clause->kind() == lang::TK_LET) {
+      lang::Let let(clause);
+      whereClauses.push_back(lang::Let::create(
+          clause->range(), let.name(), batchExpr(let.rhs(), names)));
+    } else if (clause->kind() == lang::TK_EXISTS) {
+      whereClauses.push_back(lang::Exists::create(
+          clause->range(), batchExpr(lang::Exists(clause).exp(), names)));
+    } else {
+      whereClauses.push_back(clause);
+    }
+  }
+
+  whereClauses.push_back(lang::RangeConstraint::create(
+      range, lang::Ident::create(range, names.iterator),
+      lang::Const::create(range, lang::Number::create("0", ""),
+                          lang::Compound::create(lang::TK_INT32, range, {})),
+      lang::Ident::create(range, names.size)));
+
+  return lang::Comprehension::create(
+      range, c.ident(),
+      lang::List::create(c.indices().range(), std::move(indices)),
+      c.assignment(), batchExpr(c.rhs(), names),
+      lang::List::create(c.whereClauses().range(), std::move(whereClauses)),
+      c.equivalent(), c.reductionVariables());
+}
+
+// Returns the batched variant of the definition `def`, which must not
+// have been processed by the semantic analysis. The batched variant
+// is named after `def` with the suffix `defSuffix` and executes `def`
+// for a number of independent problems given by an additional size
+// parameter: each parameter and output, including those without
+// dimensions, has an additional outermost dimension of that size, and
+// each comprehension has an additional, outermost parallel iterator
+// over the problems.
+static inline lang::TreeRef batchDef(const lang::Def &def) {
+  lang::Def d(def);
+  std::set<std::string> identNames = collectIdentNames(d);
+  BatchNames names;
+
+  names.size = getUniqueName("batch", identNames);
+  names.iterator = getUniqueName("batch_idx", identNames);
+
+  auto classifyParam = [&](const lang::Param &param) {
+    if (param.typeIsInferred() || param.tensorType().dims().size() > 0)
+      names.tensors.insert(param.ident().name());
+    else
+      names.scalars.insert(param.ident().name());
+  };
+
+  for (const lang::Param &param : d.params())
+    classifyParam(param);
+
+  for (const lang::Param &param : d.returns())
+    classifyParam(param);
+
+  auto batchParams = [&](const lang::ListView<lang::Param> &params) {
+    lang::TreeList batched;
+
+    for (const lang::Param &param : params) {
+      if (param.typeIsInferred()) {
+        batched.push_back(param);
+      } else {
+        batched.push_back(lang::Param::create(
+            param.range(), param.ident(),
+            batchTensorType(param.tensorType(), names)));
+      }
+    }
+
+    return lang::List::create(params.range(), std::move(batched));
+  };
+
+  lang::TreeList statements;
+
+  for (const lang::Comprehension &c : d.statements())
+    statements.push_back(batchComprehension(c, names));
+
+  return lang::Def::create(
+      d.range(),
+      lang::Ident::create(d.name().range(), d.name().name() + defSuffix),
+      batchParams(d.params()), batchParams(d.returns()),
+      lang::List::create(d.statements().range(), std::move(statements)));
+}
+
+} // namespace batch
+} // namespace teckyl
+
+#endif
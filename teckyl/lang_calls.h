@@ -0,0 +1,294 @@
+#ifndef TECKYL_LANG_CALLS_H
+#define TECKYL_LANG_CALLS_H
+
+#include "teckyl/tc/lang/error_report.h"
+#include "teckyl/tc/lang/tree_views.h"
+
+#include "teckyl/lang_extras.h"
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace teckyl {
+namespace calls {
+
+// Checks if the comprehension `c` is a call to another definition
+// from `defs`, i.e., a statement of the form
+//
+//   C = f(A, B)
+//
+// with a plain assignment of the result of `f` to an entire tensor
+// and without where clauses
+static inline bool isCall(const lang::Comprehension &c,
+                          const std::map<std::string, lang::Def> &defs) {
+  return c.assignment()->kind() == '=' && c.indices().empty() &&
+         c.whereClauses().empty() && c.rhs()->kind() == lang::TK_APPLY &&
+         defs.count(lang::Apply(c.rhs()).name().name());
+}
+
+// Returns a copy of `t` with each identifier from `bindings` replaced
+// with a copy of the tree it is bound to. Unlike
+// substituteIdentifiers(), the result shares no subtrees with `t` or
+// the bindings, since the semantic analysis requires distinct trees
+// for distinct expressions (e.g., if a callee is inlined twice).
+static lang::TreeRef
+substituteCopies(const lang::TreeRef &t,
+                 const std::map<std::string, lang::TreeRef> &bindings) {
+  if (t->kind() == lang::TK_IDENT) {
+    auto it = bindings.find(lang::Ident(t).name());
+
+    if (it != bindings.end())
+      return substituteCopies(it->second, {});
+  }
+
+  if (t->isAtom())
+    return t;
+
+  return t->map([&](const lang::TreeRef &child) {
+    return substituteCopies(child, bindings);
+  });
+}
+
+// Returns the parameter or output named `name` of the definition `def`
+// or throws an error for `context` if there is no such parameter
+static inline lang::Param getParam(const lang::Def &def,
+                                   const std::string &name,
+                                   const lang::TreeRef &context) {
+  for (const lang::Param &param : def.params())
+    if (param.ident().name() == name)
+      return param;
+
+  for (const lang::Param &param : def.returns())
+    if (param.ident().name() == name)
+      return param;
+
+  lang::ErrorReport err(context);
+  err << name << " is not a parameter or an output of "
+      << lang::Def(def).name().name();
+  THROW_OR_ASSERT(err);
+}
+
+// Binds each parameter of the callee `callee` to the parameter
+// `args[i]` of the caller `caller` and the output of the callee to
+// the output `result` of the caller. Adds the bindings of the names
+// of the parameters and of the size parameters of the callee to
+// `bindings`.
+static inline void
+bindParams(const lang::Def &caller, const lang::Def &callee,
+           const std::vector<lang::Ident> &args, const lang::Ident &result,
+           std::map<std::string, lang::TreeRef> &bindings) {
+  std::vector<lang::Param> calleeParams;
+  std::vector<lang::Ident> callerArgs = args;
+
+  for (const lang::Param &param : callee.params())
+    calleeParams.push_back(param);
+
+  calleeParams.push_back(callee.returns()[0]);
+  callerArgs.push_back(result);
+
+  for (size_t i = 0; i < calleeParams.size(); i++) {
+    const lang::Param &calleeParam = calleeParams[i];
+    lang::Param callerParam =
+        getParam(caller, callerArgs[i].name(), callerArgs[i]);
+
+    if (calleeParam.typeIsInferred() || callerParam.typeIsInferred()) {
+      lang::ErrorReport err(callerArgs[i]);
+      err << "Tensors passed to calls must have a type";
+      THROW_OR_ASSERT(err);
+    }
+
+    lang::ListView<lang::TreeRef> calleeDims =
+        calleeParam.tensorType().dims();
+    lang::ListView<lang::TreeRef> callerDims =
+        callerParam.tensorType().dims();
+
+    if (calleeDims.size() != callerDims.size()) {
+      lang::ErrorReport err(callerArgs[i]);
+      err << callerArgs[i].name() << " has " << callerDims.size()
+          << " dimensions, but " << calleeParam.ident().name() << " of "
+          << lang::Def(callee).name().name() << " has " << calleeDims.size();
+      THROW_OR_ASSERT(err);
+    }
+
+    bindings[calleeParam.ident().name()] = callerArgs[i];
+
+    // Size parameters of the callee are replaced with the sizes of
+    // the tensors passed for them
+    for (size_t dim = 0; dim < calleeDims.size(); dim++) {
+      if (calleeDims[dim]->kind() != lang::TK_IDENT)
+        continue;
+
+      const std::string &sizeParam = lang::Ident(calleeDims[dim]).name();
+      auto it = bindings.find(sizeParam);
+
+      if (it == bindings.end()) {
+        bindings[sizeParam] = callerDims[dim];
+      } else if (!compareConstOrParamExpr(it->second, callerDims[dim])) {
+        lang::ErrorReport err(callerArgs[i]);
+        err << "Size " << sizeParam << " of "
+            << lang::Def(callee).name().name()
+            << " is bound to different sizes of the caller";
+        THROW_OR_ASSERT(err);
+      }
+    }
+  }
+}
+
+// Returns the comprehensions of the definition `caller` with each
+// call to another definition from `defs` (see isCall()) replaced
+// with the comprehensions of the callee, in which the parameters,
+// the output and the size parameters of the callee are replaced with
+// the arguments, the target and the sizes of the caller. Iterators
+// of the callee that clash with names of the caller are renamed.
+//
+// The callees must not contain calls themselves (see inlineCalls()).
+static inline lang::TreeRef
+inlineCallsInDef(const lang::Def &caller,
+                 const std::map<std::string, lang::Def> &defs) {
+  lang::Def d(caller);
+  lang::TreeList statements;
+
+  // Names with the scope of the entire caller
+  std::set<std::string> callerNames = collectDimSizeParams(d);
+
+  for (const lang::Param &param : d.params())
+    callerNames.insert(param.ident().name());
+
+  for (const lang::Param &param : d.returns())
+    callerNames.insert(param.ident().name());
+
+  for (const lang::Comprehension &c : d.statements()) {
+    if (!isCall(c, defs)) {
+      statements.push_back(c);
+      continue;
+    }
+
+    lang::Apply call(c.rhs());
+    lang::Def callee = defs.at(call.name().name());
+    std::vector<lang::Ident> args;
+
+    if (callee.returns().size() != 1) {
+      lang::ErrorReport err(call);
+      err << "Only definitions with exactly one output can be called";
+      THROW_OR_ASSERT(err);
+    }
+
+    if (call.arguments().size() != callee.params().size()) {
+      lang::ErrorReport err(call);
+      err << callee.name().name() << " expects " << callee.params().size()
+          << " arguments, but " << call.arguments().size()
+          << " were passed";
+      THROW_OR_ASSERT(err);
+    }
+
+    for (const lang::TreeRef &arg : call.arguments()) {
+      if (arg->kind() != lang::TK_IDENT) {
+        lang::ErrorReport err(arg);
+        err << "Arguments of calls must be parameters or outputs";
+        THROW_OR_ASSERT(err);
+      }
+
+      // The comprehensions of the callee write the target while the
+      // arguments are read (e.g., C(i,j) +=! C(i,k) * B(k,j) for
+      // C = mm(C, B) would initialize C before reading it)
+      if (lang::Ident(arg).name() == c.ident().name()) {
+        lang::ErrorReport err(arg);
+        err << "The target " << c.ident().name()
+            << " of a call cannot be passed as an argument";
+        THROW_OR_ASSERT(err);
+      }
+
+      args.push_back(lang::Ident(arg));
+    }
+
+    std::map<std::string, lang::TreeRef> bindings;
+    bindParams(d, callee, args, c.ident(), bindings);
+
+    // Names the iterators of the callee must not take
+    std::set<std::string> reserved = callerNames;
+
+    for (const std::string &name : collectIdentNames(callee))
+      reserved.insert(name);
+
+    for (const lang::Comprehension &calleeC : callee.statements()) {
+      std::map<std::string, lang::TreeRef> cBindings = bindings;
+      std::set<std::string> functions;
+
+      mapRecursive(calleeC, [&](const lang::TreeRef &t) {
+        if (t->kind() == lang::TK_APPLY)
+          functions.insert(lang::Apply(t).name().name());
+      });
+
+      // Rename local identifiers of the callee (i.e., iterators and
+      // let bindings) that clash with names of the caller
+      for (const std::string &name : collectIdentNames(calleeC)) {
+        if (bindings.count(name) || functions.count(name) ||
+            !callerNames.count(name))
+          continue;
+
+        std::string unique = getUniqueName(name, reserved);
+
+        reserved.insert(unique);
+        cBindings[name] = lang::Ident::create(calleeC.range(), unique);
+      }
+
+      statements.push_back(substituteCopies(calleeC, cBindings));
+    }
+  }
+
+  return lang::Def::create(
+      d.range(), d.name(), d.params(), d.returns(),
+      lang::List::create(d.statements().range(), std::move(statements)));
+}
+
+// Returns the definitions from `defs`, in which calls to other
+// definitions (see isCall()) are inlined recursively. Throws an error
+// for recursive calls. The definitions must not have been processed
+// by the semantic analysis.
+static inline std::map<std::string, lang::Def>
+inlineCalls(const std::map<std::string, lang::Def> &defs) {
+  std::map<std::string, lang::Def> inlined;
+  std::set<std::string> active;
+
+  std::function<void(const std::string &)> inlineDef =
+      [&](const std::string &name) {
+        if (inlined.count(name))
+          return;
+
+        lang::Def def = defs.at(name);
+        active.insert(name);
+
+        // Inline the calls of the callees first
+        for (const lang::Comprehension &c : def.statements()) {
+          if (!isCall(c, defs))
+            continue;
+
+          lang::Apply call(c.rhs());
+          const std::string &calleeName = call.name().name();
+
+          if (active.count(calleeName)) {
+            lang::ErrorReport err(call);
+            err << "Recursive call of " << calleeName;
+            THROW_OR_ASSERT(err);
+          }
+
+          inlineDef(calleeName);
+        }
+
+        active.erase(name);
+        inlined.emplace(name, lang::Def(inlineCallsInDef(def, inlined)));
+      };
+
+  for (const auto &def : defs)
+    inlineDef(def.first);
+
+  return inlined;
+}
+
+} // namespace calls
+} // namespace teckyl
+
+#endif
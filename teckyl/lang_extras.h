@@ -35,6 +35,14 @@ static bool mapRecursiveWhile(const lang::TreeRef &tree,
   return true;
 }
 
+// Checks if the identifier `name` occurs anywhere in `tree`
+static inline bool usesIdent(const lang::TreeRef &tree,
+                             const std::string &name) {
+  return !mapRecursiveWhile(tree, [&](const lang::TreeRef &t) {
+    return t->kind() != lang::TK_IDENT || lang::Ident(t).name() != name;
+  });
+}
+
 static bool inline isSignedIntType(int kind) {
   switch (kind) {
   case lang::TK_INT2:
@@ -69,8 +77,29 @@ static inline bool isIntType(int kind) {
   return isSignedIntType(kind) || isUnsignedIntType(kind);
 }
 
+// Checks if `kind` is an integer type with less than 8 bits. Tensors
+// of these types are stored with multiple elements per byte.
+static inline bool isPackedIntType(int kind) {
+  switch (kind) {
+  case lang::TK_INT2:
+  case lang::TK_UINT2:
+  case lang::TK_INT4:
+  case lang::TK_UINT4:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
 static unsigned getIntBits(int kind) {
   switch (kind) {
+  case lang::TK_INT2:
+  case lang::TK_UINT2:
+    return 2;
+  case lang::TK_INT4:
+  case lang::TK_UINT4:
+    return 4;
   case lang::TK_INT8:
   case lang::TK_UINT8:
     return 8;
@@ -93,6 +122,7 @@ static inline bool isFloatType(int kind) {
   switch (kind) {
   case lang::TK_FLOAT:
   case lang::TK_FLOAT16:
+  case lang::TK_BFLOAT16:
   case lang::TK_FLOAT32:
   case lang::TK_FLOAT64:
     return true;
@@ -151,6 +181,31 @@ static std::set<std::string> collectDimSizeParams(const lang::Def &def) {
   return sizeParams;
 }
 
+// Returns `base`, extended with underscores until it differs from all
+// names in `names`
+static inline std::string getUniqueName(const std::string &base,
+                                        const std::set<std::string> &names) {
+  std::string name = base;
+
+  while (names.count(name))
+    name += "_";
+
+  return name;
+}
+
+// Returns the names of all identifiers in `tree` and its descendants
+static inline std::set<std::string>
+collectIdentNames(const lang::TreeRef &tree) {
+  std::set<std::string> names;
+
+  mapRecursive(tree, [&](const lang::TreeRef &t) {
+    if (t->kind() == lang::TK_IDENT)
+      names.insert(lang::Ident(t).name());
+  });
+
+  return names;
+}
+
 // Checks if two identifiers have the same name
 static inline bool compareIdentifiers(const lang::Ident &a,
                                       const lang::Ident &b) {
@@ -172,6 +227,7 @@ static inline bool isZeroConstant(const lang::Const &c) {
   case lang::TK_SIZET:
     return c.value<uint64_t>() == 0;
   case lang::TK_FLOAT16:
+  case lang::TK_BFLOAT16:
   case lang::TK_FLOAT32:
   case lang::TK_FLOAT64:
     return c.value<double>() == 0.0;
@@ -206,6 +262,7 @@ static inline bool compareConstants(const lang::Const &a,
   case lang::TK_UINT64:
     return a.value<uint64_t>() == b.value<uint64_t>();
   case lang::TK_FLOAT16:
+  case lang::TK_BFLOAT16:
   case lang::TK_FLOAT32:
   case lang::TK_FLOAT64:
     return a.value<double>() == b.value<double>();
@@ -224,28 +281,169 @@ static inline bool compareConstOrParamExpr(const lang::TreeRef &a,
           compareConstants(lang::Const(a), lang::Const(b)));
 }
 
-// Checks that each of the specified iterators is used at least once
-// for direct indexing (i.e., the iterator is used directly to index a
-// tensor dimension) a sub-expression of `e`.
-static inline bool
-allIteratorsIndexTensorDimension(const std::set<std::string> &iterators,
-                                 const lang::TreeRef &e) {
-  std::set<std::string> directIterators;
-
-  mapRecursive(e, [&](const lang::TreeRef &t) {
-    if (t->kind() == lang::TK_ACCESS) {
-      const lang::Access access(t);
-
-      for (const lang::TreeRef &idx : access.arguments()) {
-        if (idx->kind() == lang::TK_IDENT) {
-          directIterators.insert(lang::Ident(idx).name());
-        }
-      }
+// Checks if two trees are structurally identical, i.e., if they are
+// of the same kind, have identical atoms and structurally identical
+// subtrees in the same order. Source locations are ignored, such that
+// e.g., two occurrences of `A(i)` in the same expression compare
+// equal.
+static inline bool compareTreesStructurally(const lang::TreeRef &a,
+                                            const lang::TreeRef &b) {
+  if (a == b)
+    return true;
+
+  if (a->kind() != b->kind())
+    return false;
+
+  switch (a->kind()) {
+  case lang::TK_STRING:
+    return a->stringValue() == b->stringValue();
+  case lang::TK_NUMBER:
+    return a->numValue() == b->numValue();
+  case lang::TK_BOOL_VALUE:
+    return a->boolValue() == b->boolValue();
+  }
+
+  if (a->trees().size() != b->trees().size())
+    return false;
+
+  for (size_t i = 0; i < a->trees().size(); i++)
+    if (!compareTreesStructurally(a->tree(i), b->tree(i)))
+      return false;
+
+  return true;
+}
+
+// Calculates a hash value for a tree that is consistent with
+// `compareTreesStructurally`, i.e., structurally identical trees
+// yield identical hash values.
+static inline size_t hashTreeStructurally(const lang::TreeRef &t) {
+  size_t h = std::hash<int>()(t->kind());
+
+  auto combine = [&](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+
+  switch (t->kind()) {
+  case lang::TK_STRING:
+    combine(std::hash<std::string>()(t->stringValue()));
+    break;
+  case lang::TK_NUMBER:
+    combine(std::hash<std::string>()(t->numValue()));
+    break;
+  case lang::TK_BOOL_VALUE:
+    combine(std::hash<bool>()(t->boolValue()));
+    break;
+  default:
+    for (const lang::TreeRef &child : t->trees())
+      combine(hashTreeStructurally(child));
+  }
+
+  return h;
+}
+
+// Hash and equality functors for associative containers that
+// identify trees by their structure rather than by their identity
+struct TreeStructuralHash {
+  size_t operator()(const lang::TreeRef &t) const {
+    return hashTreeStructurally(t);
+  }
+};
+
+struct TreeStructuralEqual {
+  bool operator()(const lang::TreeRef &a, const lang::TreeRef &b) const {
+    return compareTreesStructurally(a, b);
+  }
+};
+
+// Replaces each reference to an identifier from `bindings` in `t`
+// with the expression the identifier is bound to. Identical bindings
+// are inserted as the very same subtree, such that multiple uses of
+// a binding share the same tree ID.
+static lang::TreeRef
+substituteIdentifiers(const lang::TreeRef &t,
+                      const std::map<std::string, lang::TreeRef> &bindings) {
+  if (t->kind() == lang::TK_IDENT) {
+    auto it = bindings.find(lang::Ident(t).name());
+
+    if (it != bindings.end())
+      return it->second;
+
+    return t;
+  }
+
+  if (t->isAtom())
+    return t;
+
+  return t->map([&](const lang::TreeRef &child) {
+    return substituteIdentifiers(child, bindings);
+  });
+}
+
+// Inlines all let bindings from the where clauses of `c` into its
+// right hand side, e.g.,
+//
+//   C(i) = t * t + t where t = A(i) + B(i), i in 0:N
+//
+// becomes
+//
+//   C(i) = (A(i) + B(i)) * (A(i) + B(i)) + (A(i) + B(i)) where i in 0:N
+//
+// Bindings may refer to previous bindings. Returns the comprehension
+// without let bindings in its where clauses.
+static lang::TreeRef inlineLetBindings(const lang::Comprehension &c) {
+  std::map<std::string, lang::TreeRef> bindings;
+  lang::TreeList remainingClauses;
+
+  for (const lang::TreeRef &where : c.whereClauses()) {
+    if (where->kind() == lang::TK_LET) {
+      lang::Let let(where);
+
+      bindings[let.name().name()] = substituteIdentifiers(let.rhs(), bindings);
+    } else {
+      remainingClauses.push_back(where);
+    }
+  }
+
+  if (bindings.empty())
+    return c;
+
+  return lang::Comprehension::create(
+      c.range(), c.ident(), c.indices(), c.assignment(),
+      substituteIdentifiers(c.rhs(), bindings),
+      lang::List::create(c.whereClauses().range(),
+                         std::move(remainingClauses)),
+      c.equivalent(), c.reductionVariables());
+}
+
+// Collects the names of the iterators of the comprehension `c` from
+// the definition `def`, i.e., the indexes of the tensor on the left
+// hand side and all identifiers on the right hand side that neither
+// refer to a parameter, nor to an output tensor, nor to a size
+// parameter, nor to a let binding.
+static std::set<std::string>
+collectIteratorNames(const lang::Def &def, const lang::Comprehension &c) {
+  std::set<std::string> symbols = collectDimSizeParams(def);
+  std::set<std::string> iterators;
+
+  for (const lang::Param &param : def.params())
+    symbols.insert(param.ident().name());
+
+  for (const lang::Param &ret : def.returns())
+    symbols.insert(ret.ident().name());
+
+  for (const lang::Ident &lhsIndex : c.indices())
+    iterators.insert(lhsIndex.name());
+
+  lang::Comprehension inlined(inlineLetBindings(c));
+
+  mapRecursive(inlined.rhs(), [&](const lang::TreeRef &t) {
+    if (t->kind() == lang::TK_IDENT) {
+      std::string name = lang::Ident(t).name();
+
+      if (symbols.count(name) == 0)
+        iterators.insert(name);
     }
   });
 
-  return std::includes(directIterators.begin(), directIterators.end(),
-                       iterators.begin(), iterators.end());
+  return iterators;
 }
 
 // Checks if the domain of a single iterator matches the size of a
@@ -285,46 +483,6 @@ static inline bool comprehensionLHSIteratorDomainsMatchTensorDimensions(
   return true;
 }
 
-// Checks that the domain specified in by a where clause of `c` of
-// each iterator that is used at least once for direct indexing of a
-// tensor dimension matches the size of the indexed dimension
-// specified in a tensor specifications of `paramSpecs`.
-//
-// That is, the range must start with 0 and end at the size of the
-// tensor dimension.
-static inline bool directIteratorDomainsMatchTensorDimensions(
-    const lang::Comprehension &c,
-    const std::map<const std::string, lang::TensorType> &paramSpecs) {
-  IteratorRangeMap bounds = collectExplicitIteratorBounds(c);
-
-  // Check indexing of the output tensor
-  if (!comprehensionLHSIteratorDomainsMatchTensorDimensions(
-          paramSpecs, bounds, c.ident().name(), c.indices())) {
-    return false;
-  }
-
-  // Check indexing of the input tensors
-  return mapRecursiveWhile(c.rhs(), [&](const lang::TreeRef &e) {
-    if (e->kind() == lang::TK_ACCESS) {
-      lang::Access access(e);
-
-      size_t i = 0;
-      for (const lang::TreeRef &arg : access.arguments()) {
-        if (arg->kind() == lang::TK_IDENT) {
-          if (!iteratorDomainMatchesTensorDimension(paramSpecs, bounds,
-                                                    lang::Ident(arg).name(),
-                                                    access.name().name(), i)) {
-            return false;
-          }
-        }
-
-        i++;
-      }
-    }
-    return true;
-  });
-}
-
 } // namespace teckyl
 
 #endif
@@ -0,0 +1,267 @@
+#ifndef TECKYL_LANG_LAYOUT_H
+#define TECKYL_LANG_LAYOUT_H
+
+#include "teckyl/tc/lang/tree_views.h"
+
+#include <cctype>
+#include <string>
+#include <vector>
+
+namespace teckyl {
+namespace layout {
+
+// Dimension of the physical layout of a tensor in memory
+struct PhysicalDim {
+  enum class Kind {
+    // Entire logical dimension
+    Full,
+
+    // Index of the block of a blocked logical dimension (i.e., the
+    // logical index divided by the block size)
+    Outer,
+
+    // Index within the block of a blocked logical dimension (i.e.,
+    // the logical index modulo the block size)
+    Inner
+  };
+
+  Kind kind;
+
+  // Index of the logical dimension
+  unsigned int dim;
+
+  // Block size for outer and inner dimensions, otherwise 0
+  int64_t blockSize;
+};
+
+// Physical dimensions of a tensor from the outermost to the innermost
+// dimension
+using Layout = std::vector<PhysicalDim>;
+
+// Returns the row-major layout for a tensor with `rank` dimensions
+static inline Layout rowMajorLayout(size_t rank) {
+  Layout layout;
+
+  for (unsigned int dim = 0; dim < rank; dim++)
+    layout.push_back({PhysicalDim::Kind::Full, dim, 0});
+
+  return layout;
+}
+
+// Parses the layout tag `tag` for a tensor with `rank` dimensions into
+// `layout`.
+//
+// Besides the aliases "rowmajor" and "colmajor", tags follow the
+// notation of oneDNN's format tags: the logical dimensions are named
+// by the letters a, b, c, ... in order of their declaration and are
+// listed from the outermost to the innermost physical dimension. A
+// blocked dimension appears twice: as an uppercase letter for the
+// index of the block and, further inwards, as a lowercase letter
+// prefixed with the block size for the index within the block. E.g.,
+// "ba" is the column-major layout of a matrix, "acdb" the
+// channels-last layout of a tensor with the logical dimensions NCHW
+// and "aBcd16b" the blocked layout nChw16c of the same tensor.
+//
+// Returns true on success, otherwise false and a description of the
+// error in `err`.
+static bool parseLayout(const std::string &tag, size_t rank, Layout &layout,
+                        std::string &err) {
+  layout.clear();
+
+  if (tag == "rowmajor") {
+    layout = rowMajorLayout(rank);
+    return true;
+  }
+
+  if (tag == "colmajor") {
+    for (unsigned int dim = rank; dim > 0; dim--)
+      layout.push_back({PhysicalDim::Kind::Full, dim - 1, 0});
+
+    return true;
+  }
+
+  std::vector<bool> seenFull(rank, false);
+  std::vector<bool> seenOuter(rank, false);
+  std::vector<int64_t> blockSizes(rank, 0);
+
+  for (size_t i = 0; i < tag.size();) {
+    int64_t blockSize = 0;
+    bool hasBlockSize = false;
+
+    for (; i < tag.size() && std::isdigit(tag[i]); i++) {
+      blockSize = blockSize * 10 + (tag[i] - '0');
+      hasBlockSize = true;
+
+      if (blockSize > (1 << 30)) {
+        err = "block size too large";
+        return false;
+      }
+    }
+
+    if (i == tag.size()) {
+      err = "expected a dimension after the block size";
+      return false;
+    }
+
+    char c = tag[i++];
+
+    if (!std::isalpha(c)) {
+      err = std::string("invalid character '") + c + "'";
+      return false;
+    }
+
+    unsigned int dim = std::tolower(c) - 'a';
+
+    if (dim >= rank) {
+      err = std::string("dimension '") + c + "' exceeds the rank of the tensor";
+      return false;
+    }
+
+    if (std::isupper(c)) {
+      if (hasBlockSize) {
+        err = std::string("unexpected block size for outer dimension '") + c +
+              "'";
+        return false;
+      }
+
+      if (seenFull[dim] || seenOuter[dim]) {
+        err = std::string("duplicate dimension '") + c + "'";
+        return false;
+      }
+
+      seenOuter[dim] = true;
+      layout.push_back({PhysicalDim::Kind::Outer, dim, 0});
+    } else if (hasBlockSize) {
+      if (blockSize == 0) {
+        err = std::string("block size of dimension '") + c + "' is zero";
+        return false;
+      }
+
+      if (!seenOuter[dim] || blockSizes[dim] != 0) {
+        err = std::string("block of dimension '") + c +
+              "' must follow exactly one outer dimension";
+        return false;
+      }
+
+      blockSizes[dim] = blockSize;
+      layout.push_back({PhysicalDim::Kind::Inner, dim, blockSize});
+    } else {
+      if (seenFull[dim] || seenOuter[dim]) {
+        err = std::string("duplicate dimension '") + c + "'";
+        return false;
+      }
+
+      seenFull[dim] = true;
+      layout.push_back({PhysicalDim::Kind::Full, dim, 0});
+    }
+  }
+
+  for (unsigned int dim = 0; dim < rank; dim++) {
+    char c = 'a' + dim;
+
+    if (!seenFull[dim] && !seenOuter[dim]) {
+      err = std::string("missing dimension '") + c + "'";
+      return false;
+    }
+
+    if (seenOuter[dim] && blockSizes[dim] == 0) {
+      err = std::string("missing block of dimension '") + c + "'";
+      return false;
+    }
+  }
+
+  for (PhysicalDim &pdim : layout) {
+    if (pdim.kind == PhysicalDim::Kind::Outer)
+      pdim.blockSize = blockSizes[pdim.dim];
+  }
+
+  return true;
+}
+
+// Returns the tag for `layout` in the notation of format tags accepted
+// by parseLayout() (i.e., without aliases)
+static inline std::string formatLayout(const Layout &layout) {
+  std::string tag;
+
+  for (const PhysicalDim &pdim : layout) {
+    char c = 'a' + pdim.dim;
+
+    switch (pdim.kind) {
+    case PhysicalDim::Kind::Full:
+      tag += c;
+      break;
+    case PhysicalDim::Kind::Outer:
+      tag += std::toupper(c);
+      break;
+    case PhysicalDim::Kind::Inner:
+      tag += std::to_string(pdim.blockSize) + c;
+      break;
+    }
+  }
+
+  return tag;
+}
+
+// Returns the layout of tensors of type `tt`. Tensor types without a
+// layout annotation are row-major. The annotation must have been
+// checked by the semantic analysis.
+static inline Layout getLayout(const lang::TensorType &tt) {
+  size_t rank = tt.dims().size();
+
+  if (!tt.layout().present())
+    return rowMajorLayout(rank);
+
+  Layout layout;
+  std::string err;
+
+  if (!parseLayout(tt.layout().get().name(), rank, layout, err))
+    llvm_unreachable("Invalid layout");
+
+  return layout;
+}
+
+// Checks if any logical dimension of `layout` is blocked
+static inline bool isBlocked(const Layout &layout) {
+  for (const PhysicalDim &pdim : layout) {
+    if (pdim.kind != PhysicalDim::Kind::Full)
+      return true;
+  }
+
+  return false;
+}
+
+// Checks if `layout` is the row-major layout
+static inline bool isRowMajor(const Layout &layout) {
+  for (size_t i = 0; i < layout.size(); i++) {
+    if (layout[i].kind != PhysicalDim::Kind::Full || layout[i].dim != i)
+      return false;
+  }
+
+  return true;
+}
+
+// Returns the index of the memref dimension whose size is the size of
+// the logical dimension `dim`.
+//
+// Memrefs for tensors with a blocked layout have one dimension per
+// physical dimension, in which the size of the outer dimension of a
+// blocked logical dimension is the size of the logical dimension and
+// the size of the inner dimension is the block size. Memrefs for all
+// other layouts have one dimension per logical dimension.
+static inline unsigned int getMemRefSizeDim(const Layout &layout,
+                                            unsigned int dim) {
+  if (!isBlocked(layout))
+    return dim;
+
+  for (size_t i = 0; i < layout.size(); i++) {
+    if (layout[i].dim == dim && layout[i].kind != PhysicalDim::Kind::Inner)
+      return i;
+  }
+
+  llvm_unreachable("Logical dimension not found in layout");
+}
+
+} // namespace layout
+} // namespace teckyl
+
+#endif
@@ -13,25 +13,58 @@
 #include <mlir/Dialect/StandardOps/EDSC/Intrinsics.h>
 #include <mlir/Dialect/Linalg/IR/LinalgOps.h>
 #include "mlir/Dialect/SCF/SCF.h"
+#include <mlir/Dialect/Affine/IR/AffineOps.h>
+#include <mlir/Dialect/LLVMIR/LLVMDialect.h>
+#include <mlir/Pass/PassManager.h>
 
 #include "teckyl/HeaderGen.h"
+#include "teckyl/LLVMLowering.h"
 #include "teckyl/MLIRGen.h"
+#include "teckyl/TcDialect.h"
+#include "teckyl/TcLowering.h"
+#include "teckyl/TuningDB.h"
+#include "teckyl/lang_batch.h"
+#include "teckyl/lang_calls.h"
 
 // Commandline options
 static llvm::cl::opt<std::string>
     inputFilename(llvm::cl::Positional, llvm::cl::desc("<input file>"),
                   llvm::cl::init("-"), llvm::cl::value_desc("filename"));
-enum Action { None, DumpAST, DumpMLIR, DumpHeader, DumpInference };
+enum Action {
+  None,
+  DumpAST,
+  DumpMLIR,
+  DumpTcMLIR,
+  DumpLLVMMLIR,
+  DumpHeader,
+  DumpInference,
+  DumpTuningSpace,
+  DumpBenchmark
+};
 
 static llvm::cl::opt<enum Action> emitAction(
     "emit", llvm::cl::desc("Select the kind of output desired"),
     llvm::cl::values(clEnumValN(DumpAST, "ast", "output the AST dump")),
     llvm::cl::values(clEnumValN(DumpMLIR, "mlir", "output the MLIR dump")),
+    llvm::cl::values(clEnumValN(DumpTcMLIR, "tc-mlir",
+                                "output the MLIR dump with comprehensions "
+                                "in the tc dialect")),
+    llvm::cl::values(clEnumValN(DumpLLVMMLIR, "llvm-mlir",
+                                "output the MLIR dump lowered to the LLVM "
+                                "dialect (with comprehensions lowered from "
+                                "the tc dialect if -lower-tc is given)")),
     llvm::cl::values(clEnumValN(
         DumpHeader, "header",
         "Output a C header file with signatures for generated functions")),
     llvm::cl::values(clEnumValN(DumpInference, "inference",
-                                "output inference results")));
+                                "output inference results")),
+    llvm::cl::values(clEnumValN(
+        DumpTuningSpace, "tuning-space",
+        "Output the tuning database keys and the candidate configurations "
+        "for each kernel")),
+    llvm::cl::values(clEnumValN(
+        DumpBenchmark, "benchmark",
+        "Output a C program measuring the execution time of a kernel")));
 
 static llvm::cl::opt<std::string> includeGuard(
     "include-guard",
@@ -54,6 +87,231 @@ static llvm::cl::opt<bool> specializeLinalgOps(
                    "operation (e.g., matrix multiplications)"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<teckyl::MLIRGenOptions::ContractionBackend>
+    contractionBackend(
+        "contraction-backend",
+        llvm::cl::desc("Select the implementation of recognized contractions "
+                       "(matrix multiplications, matrix-vector products)"),
+        llvm::cl::init(teckyl::MLIRGenOptions::ContractionBackend::Linalg),
+        llvm::cl::values(clEnumValN(
+            teckyl::MLIRGenOptions::ContractionBackend::Linalg, "linalg",
+            "Generated code as selected by --body-op")),
+        llvm::cl::values(clEnumValN(
+            teckyl::MLIRGenOptions::ContractionBackend::CBLAS, "cblas",
+            "Calls to CBLAS through the teckyl-cblas runtime library")),
+        llvm::cl::values(clEnumValN(
+            teckyl::MLIRGenOptions::ContractionBackend::TeckylRT, "teckyl-rt",
+            "Calls to the built-in teckyl-rt runtime library")));
+
+static llvm::cl::opt<teckyl::MLIRGenOptions::AccumulationType>
+    accumulationType(
+        "accumulation-type",
+        llvm::cl::desc("Accumulate reductions with narrower output tensors "
+                       "in a wider type"),
+        llvm::cl::init(teckyl::MLIRGenOptions::AccumulationType::Output),
+        llvm::cl::values(clEnumValN(
+            teckyl::MLIRGenOptions::AccumulationType::Output, "output",
+            "Accumulate in the element type of the output tensor")),
+        llvm::cl::values(
+            clEnumValN(teckyl::MLIRGenOptions::AccumulationType::F32, "f32",
+                       "Accumulate in f32")),
+        llvm::cl::values(
+            clEnumValN(teckyl::MLIRGenOptions::AccumulationType::F64, "f64",
+                       "Accumulate in f64")),
+        llvm::cl::values(
+            clEnumValN(teckyl::MLIRGenOptions::AccumulationType::I32, "i32",
+                       "Accumulate integer reductions in i32")));
+
+static llvm::cl::opt<std::string> requantizeScale(
+    "requantize-scale",
+    llvm::cl::desc("Name of the parameter holding the scale for the "
+                   "requantization of integer reductions accumulated in a "
+                   "wider type"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> requantizeZeroPoint(
+    "requantize-zero-point",
+    llvm::cl::desc("Name of the parameter holding the zero point for the "
+                   "requantization of integer reductions accumulated in a "
+                   "wider type"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> assumeNoalias(
+    "assume-noalias",
+    llvm::cl::desc("Assume that the tensors passed to generated functions "
+                   "do not alias"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned int> assumeAligned(
+    "assume-aligned",
+    llvm::cl::desc("Assume that the data of the tensors passed to generated "
+                   "functions is aligned to the given number of bytes"),
+    llvm::cl::init(0), llvm::cl::value_desc("bytes"));
+
+static llvm::cl::opt<int64_t> nontemporalThreshold(
+    "nontemporal-threshold",
+    llvm::cl::desc("Use non-temporal stores for output tensors of at least "
+                   "the given size that are written once and never read "
+                   "(0 disables non-temporal stores)"),
+    llvm::cl::init(0), llvm::cl::value_desc("bytes"));
+
+static llvm::cl::opt<int64_t> prefetchDistance(
+    "prefetch-distance",
+    llvm::cl::desc("Prefetch gathers and strided reads in scf.for loop nests "
+                   "the given number of iterations ahead (0 disables "
+                   "prefetching)"),
+    llvm::cl::init(0), llvm::cl::value_desc("iterations"));
+
+static llvm::cl::opt<bool> dynamicStrides(
+    "dynamic-strides",
+    llvm::cl::desc("Accept tensors with arbitrary strides and offsets in "
+                   "generated functions instead of assuming a unit "
+                   "innermost stride and a zero offset"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> instrument(
+    "instrument",
+    llvm::cl::desc("Count the cycles spent in each comprehension in a table "
+                   "passed as an additional argument to generated functions "
+                   "(requires the teckyl-prof runtime library)"),
+    llvm::cl::init(false));
+
+enum class TcLowering { None, Linalg, SCF, Affine };
+
+static llvm::cl::opt<TcLowering> lowerTc(
+    "lower-tc",
+    llvm::cl::desc("Lower the tc dialect generated by -emit=tc-mlir or "
+                   "-emit=llvm-mlir before the output"),
+    llvm::cl::init(TcLowering::None),
+    llvm::cl::values(clEnumValN(TcLowering::None, "none",
+                                "Keep the tc dialect")),
+    llvm::cl::values(clEnumValN(TcLowering::Linalg, "linalg",
+                                "Lower to linalg.generic operations")),
+    llvm::cl::values(clEnumValN(TcLowering::SCF, "scf",
+                                "Lower to nests of scf.for loops")),
+    llvm::cl::values(clEnumValN(TcLowering::Affine, "affine",
+                                "Lower to nests of affine.for loops")));
+
+static llvm::cl::opt<bool> batch(
+    "batch",
+    llvm::cl::desc("Generate an additional function <name>_batch for each "
+                   "kernel, which executes the kernel for a batch of "
+                   "problems given by tensors with an additional outermost "
+                   "dimension"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> functionSuffix(
+    "function-suffix",
+    llvm::cl::desc("Append the given suffix to the names of the generated "
+                   "functions"),
+    llvm::cl::init(""), llvm::cl::value_desc("suffix"));
+
+static llvm::cl::list<teckyl::HeaderGenOptions::ISA> multiversion(
+    "multiversion",
+    llvm::cl::desc("Declare variants of each function compiled for the "
+                   "given instruction sets and a dispatcher selecting a "
+                   "variant at runtime in generated headers"),
+    llvm::cl::CommaSeparated,
+    llvm::cl::values(clEnumValN(teckyl::HeaderGenOptions::ISA::SSE42,
+                                "sse4.2", "SSE4.2 and POPCNT")),
+    llvm::cl::values(clEnumValN(teckyl::HeaderGenOptions::ISA::AVX2, "avx2",
+                                "AVX2 and FMA")),
+    llvm::cl::values(
+        clEnumValN(teckyl::HeaderGenOptions::ISA::AVX512, "avx512",
+                   "AVX-512 (F, BW, DQ and VL), AVX2 and FMA")));
+
+static llvm::cl::opt<bool> strideVersioning(
+    "stride-versioning",
+    llvm::cl::desc("Declare a variant of each function for tensors with a "
+                   "unit innermost stride and a variant for arbitrary "
+                   "strides and a dispatcher checking the strides at "
+                   "runtime in generated headers"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> tuningDB(
+    "tuning-db",
+    llvm::cl::desc("Read the configuration for each kernel from the given "
+                   "tuning database (see teckyl-tune)"),
+    llvm::cl::init(""), llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string> tuningShape(
+    "tuning-shape",
+    llvm::cl::desc("Sizes of the size parameters used for lookups in the "
+                   "tuning database and for benchmarks (e.g., M=512,N=256)"),
+    llvm::cl::init(""), llvm::cl::value_desc("sizes"));
+
+static llvm::cl::opt<std::string> tuningCPU(
+    "tuning-cpu",
+    llvm::cl::desc("CPU used for lookups in the tuning database (defaults "
+                   "to the host CPU)"),
+    llvm::cl::init(""), llvm::cl::value_desc("cpu"));
+
+static llvm::cl::opt<unsigned int> tuningMaxLoopOrders(
+    "tuning-max-loop-orders",
+    llvm::cl::desc("Maximum number of loop orders listed per comprehension "
+                   "by -emit=tuning-space"),
+    llvm::cl::init(24), llvm::cl::value_desc("n"));
+
+static llvm::cl::opt<std::string> benchmarkKernel(
+    "benchmark-kernel",
+    llvm::cl::desc("Kernel measured by the program generated by "
+                   "-emit=benchmark"),
+    llvm::cl::init(""), llvm::cl::value_desc("name"));
+
+static llvm::cl::opt<unsigned int> benchmarkRepetitions(
+    "benchmark-repetitions",
+    llvm::cl::desc("Number of executions of the kernel in the program "
+                   "generated by -emit=benchmark"),
+    llvm::cl::init(10), llvm::cl::value_desc("n"));
+
+// Checks that the value passed to -assume-aligned is a power of two
+void checkAssumeAligned() {
+  if (assumeAligned & (assumeAligned - 1)) {
+    THROW_OR_ASSERT(
+        teckyl::Exception("--assume-aligned requires a power of two"));
+  }
+}
+
+// Returns the CPU used for lookups in the tuning database
+std::string getTuningCPU() {
+  return tuningCPU.empty() ? teckyl::tuning::getHostCPU()
+                           : std::string(tuningCPU);
+}
+
+// Returns the key for the shape of the kernel `def` given by
+// -tuning-shape. Throws an exception if the shape lacks the size of
+// any size parameter of the kernel.
+std::string getTuningShapeKey(const lang::Def &def) {
+  std::string shapeKey = teckyl::tuning::getShapeKey(
+      def, teckyl::tuning::parseShape(tuningShape));
+
+  if (shapeKey.empty()) {
+    THROW_OR_ASSERT(teckyl::Exception(
+        "--tuning-shape lacks the size of a size parameter of " +
+        lang::Def(def).name().name()));
+  }
+
+  return shapeKey;
+}
+
+// Returns the options for the generation of C headers
+teckyl::HeaderGenOptions getHeaderGenOptions() {
+  teckyl::HeaderGenOptions options;
+
+  options.assume_noalias = assumeNoalias;
+  options.assume_aligned = assumeAligned;
+  options.instrument = instrument;
+  options.isa_variants.assign(multiversion.begin(), multiversion.end());
+  options.stride_versioning = strideVersioning;
+
+  if (options.stride_versioning && !options.isa_variants.empty()) {
+    THROW_OR_ASSERT(teckyl::Exception(
+        "--stride-versioning cannot be combined with --multiversion"));
+  }
+
+  return options;
+}
+
 // Reads an entire file into a string
 std::string readFile(const std::string &filename) {
   std::ifstream ifs(filename);
@@ -82,6 +340,27 @@ std::map<std::string, lang::Def> parse(const std::string &tc,
   return parsed;
 }
 
+// Adds the batched variant of each kernel (see
+// teckyl::batch::batchDef()) to `tcs`
+void addBatchedKernels(std::map<std::string, lang::Def> &tcs) {
+  std::map<std::string, lang::Def> batched;
+
+  for (const auto &tc : tcs) {
+    lang::Def def(teckyl::batch::batchDef(tc.second));
+    const std::string &name = def.name().name();
+
+    if (tcs.find(name) != tcs.end()) {
+      THROW_OR_ASSERT(teckyl::Exception("Batched variant of kernel " +
+                                        tc.first + " conflicts with kernel " +
+                                        name));
+    }
+
+    batched.emplace(name, def);
+  }
+
+  tcs.insert(batched.begin(), batched.end());
+}
+
 // Dumps the AST for a set of kernels to stdout
 void dumpAST(const std::map<std::string, lang::Def> &tcs) {
   for (const auto &res : tcs)
@@ -100,14 +379,58 @@ void dumpInference(const std::map<std::string, lang::Def> &tcs) {
     auto func = sema.checkFunction(res.second);
 }
 
+// Lowers the tc dialect in `module` as selected by -lower-tc
+void lowerTcDialect(mlir::MLIRContext &context, mlir::ModuleOp module) {
+  std::unique_ptr<mlir::Pass> pass;
+
+  switch (lowerTc) {
+  case TcLowering::None:
+    return;
+  case TcLowering::Linalg:
+    pass = teckyl::dialect::createLowerTcToLinalgPass();
+    break;
+  case TcLowering::SCF:
+    pass = teckyl::dialect::createLowerTcToSCFPass();
+    break;
+  case TcLowering::Affine:
+    pass = teckyl::dialect::createLowerTcToAffinePass();
+    break;
+  }
+
+  mlir::PassManager pm(&context);
+
+  pm.nest<mlir::FuncOp>().addPass(std::move(pass));
+
+  if (mlir::failed(pm.run(module)))
+    THROW_OR_ASSERT(teckyl::Exception("Lowering of the tc dialect failed"));
+}
+
+// Lowers `module` to the LLVM dialect (see
+// teckyl::addLowerToLLVMPasses())
+void lowerToLLVMDialect(mlir::MLIRContext &context, mlir::ModuleOp module) {
+  mlir::PassManager pm(&context);
+
+  teckyl::addLowerToLLVMPasses(pm);
+
+  if (mlir::failed(pm.run(module)))
+    THROW_OR_ASSERT(teckyl::Exception("Lowering to the LLVM dialect failed"));
+}
+
 // Generates an MLIR representation for each TC kernel and dumps a
-// textual representation to stdout.
+// textual representation to stdout. If `tcDialect` is true,
+// comprehensions are represented in the tc dialect and lowered as
+// selected by -lower-tc. If `llvmDialect` is true, the module is
+// lowered to the LLVM dialect before the output.
 //
 // Returns 0 on success or 1 in case of an error.
-void dumpMLIR(const std::map<std::string, lang::Def> &tcs) {
+void dumpMLIR(const std::map<std::string, lang::Def> &tcs, bool tcDialect,
+              bool llvmDialect) {
   mlir::registerDialect<mlir::StandardOpsDialect>();
   mlir::registerDialect<mlir::linalg::LinalgDialect>();
   mlir::registerDialect<mlir::scf::SCFDialect>();
+  mlir::registerDialect<mlir::AffineDialect>();
+  mlir::registerDialect<mlir::LLVM::LLVMDialect>();
+  mlir::registerDialect<teckyl::dialect::TcDialect>();
   mlir::MLIRContext context;
   mlir::ModuleOp module;
   mlir::OpBuilder builder(&context);
@@ -116,6 +439,17 @@ void dumpMLIR(const std::map<std::string, lang::Def> &tcs) {
 
   options.body_op = bodyOp;
   options.specialize_linalg_ops = specializeLinalgOps;
+  options.contraction_backend = contractionBackend;
+  options.accumulation_type = accumulationType;
+  options.requantize_scale = requantizeScale;
+  options.requantize_zero_point = requantizeZeroPoint;
+  options.assume_noalias = assumeNoalias;
+  options.assume_aligned = assumeAligned;
+  options.nontemporal_threshold = nontemporalThreshold;
+  options.prefetch_distance = prefetchDistance;
+  options.dynamic_strides = dynamicStrides;
+  options.instrument = instrument;
+  options.emit_tc_dialect = tcDialect;
 
   if (options.specialize_linalg_ops &&
       options.body_op != teckyl::MLIRGenOptions::BodyOp::LinalgGeneric) {
@@ -124,23 +458,115 @@ void dumpMLIR(const std::map<std::string, lang::Def> &tcs) {
                           "conjunction with --body-op=linalg.generic"));
   }
 
+  teckyl::tuning::Database db;
+  teckyl::tuning::Shape shape = teckyl::tuning::parseShape(tuningShape);
+  std::string cpu;
+
+  if (!tuningDB.empty()) {
+    db.load(tuningDB);
+    cpu = getTuningCPU();
+  }
+
   module = mlir::ModuleOp::create(builder.getUnknownLoc());
 
   for (auto &tc : tcs) {
     lang::TreeRef checked = sema.checkFunction(tc.second);
+    teckyl::MLIRGenOptions kernelOptions = options;
 
-    mlir::FuncOp f = teckyl::buildMLIRFunction(context, tc.first,
-                                               lang::Def(checked), options);
+    // Kernels without a record for the shape and the CPU use the
+    // options from the command line
+    if (!tuningDB.empty()) {
+      std::string shapeKey = teckyl::tuning::getShapeKey(tc.second, shape);
+
+      if (!shapeKey.empty()) {
+        const teckyl::tuning::Config *config = db.lookup(
+            teckyl::tuning::getKernelHash(tc.second), cpu, shapeKey);
+
+        if (config)
+          teckyl::tuning::applyConfig(*config, kernelOptions);
+      }
+    }
+
+    mlir::FuncOp f =
+        teckyl::buildMLIRFunction(context, module, tc.first + functionSuffix,
+                                  lang::Def(checked), kernelOptions);
 
     module.push_back(f);
   }
 
+  if (tcDialect)
+    lowerTcDialect(context, module);
+
+  if (llvmDialect)
+    lowerToLLVMDialect(context, module);
+
   module.print(llvm::outs());
 
   if (mlir::failed(mlir::verify(module)))
     llvm_unreachable("Module verification error");
 }
 
+// Dumps the keys for the tuning database and the candidate
+// configurations explored by teckyl-tune for a set of kernels to
+// stdout. For each kernel, the output starts with a line
+//
+//   kernel <name> <kernel hash> <cpu> <shape>
+//
+// followed by one line "config <config>" for each configuration of
+// the entire kernel and one line "loop-order <n> <iterators>" for each
+// candidate loop order of the comprehension with the index <n>.
+void dumpTuningSpace(const std::map<std::string, lang::Def> &tcs) {
+  std::string cpu = getTuningCPU();
+
+  for (const auto &tc : tcs) {
+    lang::Sema sema;
+    lang::Def checked(sema.checkFunction(tc.second));
+    std::string shapeKey = getTuningShapeKey(tc.second);
+
+    std::cout << "kernel " << tc.first << " "
+              << teckyl::tuning::getKernelHash(tc.second) << " " << cpu << " "
+              << shapeKey << std::endl;
+
+    for (const teckyl::tuning::Config &config :
+         teckyl::tuning::getKernelConfigs()) {
+      std::cout << "config " << teckyl::tuning::formatConfig(config)
+                << std::endl;
+    }
+
+    for (const auto &orders :
+         teckyl::tuning::getLoopOrders(checked, tuningMaxLoopOrders)) {
+      for (const std::vector<std::string> &order : orders.second) {
+        std::cout << "loop-order " << orders.first << " ";
+
+        for (size_t i = 0; i < order.size(); i++)
+          std::cout << (i > 0 ? "," : "") << order[i];
+
+        std::cout << std::endl;
+      }
+    }
+  }
+}
+
+// Dumps a C program measuring the execution time of the kernel
+// selected by -benchmark-kernel for the shape given by -tuning-shape
+// to stdout
+void dumpBenchmark(const std::map<std::string, lang::Def> &tcs) {
+  auto it = tcs.find(benchmarkKernel);
+
+  if (it == tcs.end()) {
+    THROW_OR_ASSERT(
+        teckyl::Exception("Unknown kernel '" + benchmarkKernel + "'"));
+  }
+
+  // Checks that the shape is complete
+  getTuningShapeKey(it->second);
+
+  std::cout << teckyl::genBenchmark(tcs, benchmarkKernel,
+                                    teckyl::tuning::parseShape(tuningShape),
+                                    benchmarkRepetitions,
+                                    getHeaderGenOptions());
+}
+
 int main(int argc, char **argv) {
   std::map<std::string, lang::Def> tcs;
 
@@ -149,23 +575,40 @@ int main(int argc, char **argv) {
 #ifdef COMPILE_WITH_EXCEPTIONS
   try {
 #endif // COMPILE_WITH_EXCEPTIONS
+    checkAssumeAligned();
+
     std::string source = readFile(inputFilename);
 
-    tcs = parse(source, inputFilename);
+    tcs = teckyl::calls::inlineCalls(parse(source, inputFilename));
+
+    if (batch)
+      addBatchedKernels(tcs);
 
     switch (emitAction) {
     case Action::DumpAST:
       dumpAST(tcs);
       break;
     case Action::DumpMLIR:
-      dumpMLIR(tcs);
+      dumpMLIR(tcs, false, false);
+      break;
+    case Action::DumpTcMLIR:
+      dumpMLIR(tcs, true, false);
+      break;
+    case Action::DumpLLVMMLIR:
+      dumpMLIR(tcs, lowerTc != TcLowering::None, true);
       break;
     case Action::DumpHeader:
-      std::cout << teckyl::genHeader(tcs, includeGuard);
+      std::cout << teckyl::genHeader(tcs, includeGuard, getHeaderGenOptions());
       break;
     case Action::DumpInference:
       dumpInference(tcs);
       break;
+    case Action::DumpTuningSpace:
+      dumpTuningSpace(tcs);
+      break;
+    case Action::DumpBenchmark:
+      dumpBenchmark(tcs);
+      break;
     default:
       THROW_OR_ASSERT(teckyl::Exception("Unknown action"));
     }
@@ -3,6 +3,11 @@
 
 #include "teckyl/tc/lang/tree_views.h"
 
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
 namespace teckyl {
 namespace pattern {
 
@@ -250,6 +255,529 @@ isDefinitMatmulComprehension(const lang::Comprehension &c,
   return definit;
 }
 
+// Checks if a comprehension is a sum of products of exactly two
+// tensor accesses, i.e., if it has the pattern
+//
+//   C(...) +=! A(...) * B(...) or
+//   C(...) += A(...) * B(...)
+//
+// where neither A nor B is the output tensor C. On success, the two
+// accesses are appended to accesses in the order of their appearance
+// on the right hand side.
+//
+// The output parameter definit indicates whether the output tensor
+// is default initialized with zeros.
+static inline bool
+isSumOfAccessProducts(const lang::Comprehension &c, bool *definit,
+                      std::vector<lang::Access> &accesses) {
+  // Ensure this is a sum of products
+  if ((c.assignment()->kind() != lang::TK_PLUS_EQ_B &&
+       c.assignment()->kind() != lang::TK_PLUS_EQ) ||
+      c.rhs()->kind() != '*')
+    return false;
+
+  // Ensure that there are exactly two operands to the multiplication
+  if (c.rhs()->trees().size() != 2)
+    return false;
+
+  // Ensure that the source operands are indexed tensors
+  if (c.rhs()->tree(0)->kind() != lang::TK_ACCESS ||
+      c.rhs()->tree(1)->kind() != lang::TK_ACCESS) {
+    return false;
+  }
+
+  lang::Access a(c.rhs()->tree(0));
+  lang::Access b(c.rhs()->tree(1));
+
+  // Ensure that the output operand is not used as an input
+  if (a.name().name() == c.ident().name() ||
+      b.name().name() == c.ident().name()) {
+    return false;
+  }
+
+  *definit = (c.assignment()->kind() == lang::TK_PLUS_EQ_B);
+  accesses.push_back(a);
+  accesses.push_back(b);
+
+  return true;
+}
+
+// Extracts the names of the identifiers directly indexing the
+// dimensions of the access a. Returns false if the access has not
+// exactly rank arguments or if any of the arguments is not an
+// identifier.
+static inline bool getDirectIndexNames(const lang::Access &a, size_t rank,
+                                       std::vector<std::string> &names) {
+  if (a.arguments().size() != rank)
+    return false;
+
+  for (const lang::TreeRef &arg : a.arguments()) {
+    if (arg->kind() != lang::TK_IDENT)
+      return false;
+
+    names.push_back(lang::Ident(arg).name());
+  }
+
+  return true;
+}
+
+// Checks if the expression e is a sum of two identifiers, one of
+// which has the name outer, i.e., if it has the pattern
+//
+//   outer + inner or
+//   inner + outer
+//
+// If the pattern matches, the name of the second identifier is
+// stored in inner.
+static inline bool isOffsetIndex(const lang::TreeRef &e,
+                                 const std::string &outer,
+                                 std::string &inner) {
+  if (e->kind() != '+' || e->trees().size() != 2 ||
+      e->tree(0)->kind() != lang::TK_IDENT ||
+      e->tree(1)->kind() != lang::TK_IDENT) {
+    return false;
+  }
+
+  std::string names[2] = {lang::Ident(e->tree(0)).name(),
+                          lang::Ident(e->tree(1)).name()};
+
+  if (names[0] == outer && names[1] != outer) {
+    inner = names[1];
+    return true;
+  } else if (names[1] == outer && names[0] != outer) {
+    inner = names[0];
+    return true;
+  }
+
+  return false;
+}
+
+// Checks if all strings in names are pairwise distinct
+static inline bool allDistinct(const std::vector<std::string> &names) {
+  std::set<std::string> s(names.begin(), names.end());
+  return s.size() == names.size();
+}
+
+// Tries to match the two accesses of a binary product in both
+// operand orders using match(first, second). If one of the orders
+// matches, the indexes for the canonical order of the input operands
+// are provided in canonical_order (if non-NULL).
+template <typename F>
+static inline bool matchBinaryOperandOrder(
+    const std::vector<lang::Access> &accesses,
+    size_t (*canonical_order)[2], const F &match) {
+  for (size_t first = 0; first < 2; first++) {
+    size_t second = 1 - first;
+
+    if (match(accesses[first], accesses[second])) {
+      if (canonical_order) {
+        (*canonical_order)[0] = first;
+        (*canonical_order)[1] = second;
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Checks if a comprehension is a dot product, i.e., if it has the
+// pattern
+//
+//   C +=! A(i) * B(i) or
+//   C += A(i) * B(i)
+//
+// Returns true if the pattern matches, otherwise false. If
+// canonical_order is non-NULL, the indexes for the canonical order of
+// the input operands will be provided.
+//
+// The output parameter definit indicates whether the output scalar
+// is default initialized with zero.
+static inline bool isDotComprehensionEx(const lang::Comprehension &c,
+                                        bool *definit,
+                                        size_t (*canonical_order)[2] = NULL) {
+  std::vector<lang::Access> accesses;
+
+  // Ensure that the output is a scalar
+  if (c.indices().size() != 0 || !isSumOfAccessProducts(c, definit, accesses))
+    return false;
+
+  return matchBinaryOperandOrder(
+      accesses, canonical_order,
+      [](const lang::Access &a, const lang::Access &b) {
+        std::vector<std::string> aIdx, bIdx;
+
+        return getDirectIndexNames(a, 1, aIdx) &&
+               getDirectIndexNames(b, 1, bIdx) && aIdx[0] == bIdx[0];
+      });
+}
+
+static inline bool isDotComprehension(const lang::Comprehension &c,
+                                      size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isDotComprehensionEx(c, &definit, canonical_order))
+    return false;
+
+  return !definit;
+}
+
+static inline bool
+isDefinitDotComprehension(const lang::Comprehension &c,
+                          size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isDotComprehensionEx(c, &definit, canonical_order))
+    return false;
+
+  return definit;
+}
+
+// Checks if a comprehension is a batched matrix multiplication,
+// i.e., if it has the pattern
+//
+//   C(b, i, j) +=! A(b, i, k) * B(b, k, j) or
+//   C(b, i, j) +=! B(b, k, j) * A(b, i, k) or
+//   C(b, i, j) += A(b, i, k) * B(b, k, j) or
+//   C(b, i, j) += B(b, k, j) * A(b, i, k)
+//
+// Returns true if the pattern matches, otherwise false. If
+// canonical_order is non-NULL, the indexes for the canonical order of
+// the input operands will be provided.
+//
+// The output parameter definit indicates whether the output tensor
+// is default initialized with zeros.
+static inline bool
+isBatchMatmulComprehensionEx(const lang::Comprehension &c, bool *definit,
+                             size_t (*canonical_order)[2] = NULL) {
+  std::vector<lang::Access> accesses;
+  std::vector<std::string> lhsIdx;
+
+  for (const lang::Ident &idx : c.indices())
+    lhsIdx.push_back(idx.name());
+
+  // Ensure that the output is a batch of matrices
+  if (lhsIdx.size() != 3 || !allDistinct(lhsIdx) ||
+      !isSumOfAccessProducts(c, definit, accesses)) {
+    return false;
+  }
+
+  return matchBinaryOperandOrder(
+      accesses, canonical_order,
+      [&](const lang::Access &a, const lang::Access &b) {
+        std::vector<std::string> aIdx, bIdx;
+
+        if (!getDirectIndexNames(a, 3, aIdx) ||
+            !getDirectIndexNames(b, 3, bIdx))
+          return false;
+
+        return aIdx[0] == lhsIdx[0] && bIdx[0] == lhsIdx[0] &&
+               aIdx[1] == lhsIdx[1] && bIdx[2] == lhsIdx[2] &&
+               aIdx[2] == bIdx[1] && allDistinct({lhsIdx[0], lhsIdx[1],
+                                                   lhsIdx[2], aIdx[2]});
+      });
+}
+
+static inline bool
+isBatchMatmulComprehension(const lang::Comprehension &c,
+                           size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isBatchMatmulComprehensionEx(c, &definit, canonical_order))
+    return false;
+
+  return !definit;
+}
+
+static inline bool
+isDefinitBatchMatmulComprehension(const lang::Comprehension &c,
+                                  size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isBatchMatmulComprehensionEx(c, &definit, canonical_order))
+    return false;
+
+  return definit;
+}
+
+// Checks if a comprehension is a convolution of a tensor of rank
+// `rank` with a kernel of the same rank without strides and
+// dilations, e.g., for rank 2 if it has the pattern
+//
+//   O(i, j) +=! I(i + r, j + s) * K(r, s) or
+//   O(i, j) +=! K(r, s) * I(i + r, j + s) or
+//   O(i, j) += I(i + r, j + s) * K(r, s) or
+//   O(i, j) += K(r, s) * I(i + r, j + s)
+//
+// The operands of the additions in the index expressions may appear
+// in any order (e.g., I(r + i, s + j)).
+//
+// Returns true if the pattern matches, otherwise false. If
+// canonical_order is non-NULL, the indexes for the canonical order of
+// the input operands (input first, kernel second) will be provided.
+//
+// The output parameter definit indicates whether the output tensor
+// is default initialized with zeros.
+static inline bool isConvComprehensionEx(const lang::Comprehension &c,
+                                         size_t rank, bool *definit,
+                                         size_t (*canonical_order)[2] = NULL) {
+  std::vector<lang::Access> accesses;
+  std::vector<std::string> lhsIdx;
+
+  for (const lang::Ident &idx : c.indices())
+    lhsIdx.push_back(idx.name());
+
+  if (lhsIdx.size() != rank || !allDistinct(lhsIdx) ||
+      !isSumOfAccessProducts(c, definit, accesses)) {
+    return false;
+  }
+
+  return matchBinaryOperandOrder(
+      accesses, canonical_order,
+      [&](const lang::Access &in, const lang::Access &kernel) {
+        std::vector<std::string> kernelIdx;
+        std::vector<std::string> allIdx(lhsIdx);
+
+        if (in.arguments().size() != rank ||
+            !getDirectIndexNames(kernel, rank, kernelIdx)) {
+          return false;
+        }
+
+        for (size_t i = 0; i < rank; i++) {
+          std::string inner;
+
+          if (!isOffsetIndex(in.arguments()[i], lhsIdx[i], inner) ||
+              inner != kernelIdx[i]) {
+            return false;
+          }
+
+          allIdx.push_back(inner);
+        }
+
+        return allDistinct(allIdx);
+      });
+}
+
+static inline bool isConv1DComprehension(const lang::Comprehension &c,
+                                         size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isConvComprehensionEx(c, 1, &definit, canonical_order))
+    return false;
+
+  return !definit;
+}
+
+static inline bool
+isDefinitConv1DComprehension(const lang::Comprehension &c,
+                             size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isConvComprehensionEx(c, 1, &definit, canonical_order))
+    return false;
+
+  return definit;
+}
+
+static inline bool isConv2DComprehension(const lang::Comprehension &c,
+                                         size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isConvComprehensionEx(c, 2, &definit, canonical_order))
+    return false;
+
+  return !definit;
+}
+
+static inline bool
+isDefinitConv2DComprehension(const lang::Comprehension &c,
+                             size_t (*canonical_order)[2] = NULL) {
+  bool definit;
+  if (!isConvComprehensionEx(c, 2, &definit, canonical_order))
+    return false;
+
+  return definit;
+}
+
+// Checks if a comprehension is a sum pooling operation without
+// strides and dilations, e.g., for two dimensions if it has the
+// pattern
+//
+//   O(i, j) +=! I(i + r, j + s) or
+//   O(i, j) += I(i + r, j + s)
+//
+// The operands of the additions in the index expressions may appear
+// in any order (e.g., I(r + i, s + j)).
+//
+// Returns true if the pattern matches, otherwise false. If the
+// pattern matches, the names of the iterators for the window
+// dimensions (e.g., r and s) are stored in windowIterators in the
+// order of the dimensions.
+//
+// The output parameter definit indicates whether the output tensor
+// is default initialized with zeros.
+static inline bool
+isSumPoolingComprehensionEx(const lang::Comprehension &c, bool *definit,
+                            std::vector<std::string> &windowIterators) {
+  std::vector<std::string> lhsIdx;
+
+  for (const lang::Ident &idx : c.indices())
+    lhsIdx.push_back(idx.name());
+
+  if ((c.assignment()->kind() != lang::TK_PLUS_EQ_B &&
+       c.assignment()->kind() != lang::TK_PLUS_EQ) ||
+      c.rhs()->kind() != lang::TK_ACCESS || lhsIdx.empty() ||
+      !allDistinct(lhsIdx)) {
+    return false;
+  }
+
+  lang::Access in(c.rhs());
+
+  if (in.name().name() == c.ident().name() ||
+      in.arguments().size() != lhsIdx.size()) {
+    return false;
+  }
+
+  std::vector<std::string> window;
+  std::vector<std::string> allIdx(lhsIdx);
+
+  for (size_t i = 0; i < lhsIdx.size(); i++) {
+    std::string inner;
+
+    if (!isOffsetIndex(in.arguments()[i], lhsIdx[i], inner))
+      return false;
+
+    window.push_back(inner);
+    allIdx.push_back(inner);
+  }
+
+  if (!allDistinct(allIdx))
+    return false;
+
+  *definit = (c.assignment()->kind() == lang::TK_PLUS_EQ_B);
+  windowIterators = window;
+
+  return true;
+}
+
+// Checks if a comprehension is a copy of a tensor with a permutation
+// of its dimensions, i.e., if it has the pattern
+//
+//   B(i_0, ..., i_n) = A(i_p(0), ..., i_p(n))
+//
+// for a permutation p, e.g.,
+//
+//   B(j, i) = A(i, j)
+//
+// Returns true if the pattern matches, otherwise false. If the
+// pattern matches, permutation holds p, i.e., the position of the
+// output dimension indexed by each input dimension.
+static inline bool
+isPermutedCopyComprehension(const lang::Comprehension &c,
+                            std::vector<unsigned> &permutation) {
+  std::vector<std::string> lhsIdx;
+  std::vector<std::string> rhsIdx;
+
+  for (const lang::Ident &idx : c.indices())
+    lhsIdx.push_back(idx.name());
+
+  if (c.assignment()->kind() != '=' || c.rhs()->kind() != lang::TK_ACCESS ||
+      lhsIdx.empty() || !allDistinct(lhsIdx)) {
+    return false;
+  }
+
+  lang::Access in(c.rhs());
+
+  if (in.name().name() == c.ident().name() ||
+      !getDirectIndexNames(in, lhsIdx.size(), rhsIdx)) {
+    return false;
+  }
+
+  std::vector<unsigned> perm;
+
+  for (const std::string &idx : rhsIdx) {
+    auto it = std::find(lhsIdx.begin(), lhsIdx.end(), idx);
+
+    if (it == lhsIdx.end())
+      return false;
+
+    perm.push_back(it - lhsIdx.begin());
+  }
+
+  if (!allDistinct(rhsIdx))
+    return false;
+
+  permutation = perm;
+
+  return true;
+}
+
+// Operations recognized by classifyComprehension()
+enum class Kind {
+  None,
+  ConstantInitialization,
+  Matmul,
+  Matvec,
+  Dot,
+  BatchMatmul,
+  Conv1D,
+  Conv2D,
+  PermutedCopy,
+  SumPooling
+};
+
+// Operation implemented by a comprehension and the parameters of its
+// pattern (see classifyComprehension())
+struct Classification {
+  Kind kind = Kind::None;
+
+  // Whether the output is default-initialized with zeros; set for
+  // all kinds except for ConstantInitialization and PermutedCopy
+  bool definit = false;
+
+  // Indexes of the input operands of a contraction or convolution in
+  // canonical order (see isMatmulComprehensionEx())
+  size_t canonicalOrder[2] = {0, 1};
+
+  // Names of the iterators for the window dimensions of SumPooling
+  // (see isSumPoolingComprehensionEx())
+  std::vector<std::string> windowIterators;
+
+  // Permutation of the dimensions of PermutedCopy (see
+  // isPermutedCopyComprehension())
+  std::vector<unsigned> permutation;
+};
+
+// Matches the comprehension `c` against all patterns of this file at
+// once. The patterns are mutually exclusive, such that at most one of
+// them matches.
+static inline Classification
+classifyComprehension(const lang::Comprehension &c) {
+  Classification res;
+  size_t(*canon)[2] = &res.canonicalOrder;
+
+  if (isConstantInitialization(c))
+    res.kind = Kind::ConstantInitialization;
+  else if (isMatmulComprehensionEx(c, &res.definit, canon))
+    res.kind = Kind::Matmul;
+  else if (isMatvecComprehensionEx(c, &res.definit, canon))
+    res.kind = Kind::Matvec;
+  else if (isDotComprehensionEx(c, &res.definit, canon))
+    res.kind = Kind::Dot;
+  else if (isBatchMatmulComprehensionEx(c, &res.definit, canon))
+    res.kind = Kind::BatchMatmul;
+  else if (isConvComprehensionEx(c, 1, &res.definit, canon))
+    res.kind = Kind::Conv1D;
+  else if (isConvComprehensionEx(c, 2, &res.definit, canon))
+    res.kind = Kind::Conv2D;
+  else if (isPermutedCopyComprehension(c, res.permutation))
+    res.kind = Kind::PermutedCopy;
+  else if (isSumPoolingComprehensionEx(c, &res.definit, res.windowIterators))
+    res.kind = Kind::SumPooling;
+
+  // Matchers may set `definit` before failing
+  if (res.kind == Kind::None || res.kind == Kind::ConstantInitialization ||
+      res.kind == Kind::PermutedCopy) {
+    res.definit = false;
+  }
+
+  return res;
+}
+
 } // namespace pattern
 } // namespace teckyl
 
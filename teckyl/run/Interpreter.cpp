@@ -0,0 +1,966 @@
+#include "teckyl/run/Interpreter.h"
+
+#include "teckyl/lang_analysis.h"
+#include "teckyl/lang_extras.h"
+#include "teckyl/lang_layout.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace teckyl {
+namespace run {
+
+// Applies `f` to the values of the columns `a` and `b` for the first
+// `n` iterations and stores the results in `res`. Columns of nodes
+// that are not varying hold a single value used for all iterations.
+template <typename R, typename T, typename F>
+static void map2(std::vector<R> &res, const std::vector<T> &a, bool varyingA,
+                 const std::vector<T> &b, bool varyingB, int64_t n, F f) {
+  size_t sa = varyingA ? 1 : 0;
+  size_t sb = varyingB ? 1 : 0;
+
+  for (int64_t l = 0; l < n; l++)
+    res[l] = f(a[l * sa], b[l * sb]);
+}
+
+// Integer arithmetic on the unsigned representation, which wraps
+// around instead of overflowing
+static int64_t addWrapping(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) +
+                              static_cast<uint64_t>(b));
+}
+
+static int64_t subWrapping(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) -
+                              static_cast<uint64_t>(b));
+}
+
+static int64_t mulWrapping(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) *
+                              static_cast<uint64_t>(b));
+}
+
+// Signed division; the result of a division by zero is undefined in
+// the generated code and 0 in the interpreter
+static int64_t divSigned(int64_t a, int64_t b) {
+  if (b == 0)
+    return 0;
+
+  if (b == -1)
+    return subWrapping(0, a);
+
+  return a / b;
+}
+
+Interpreter::Interpreter(const lang::Def &def) { translateDef(def); }
+
+bool Interpreter::getValueType(int kind, ValueType &type) {
+  switch (kind) {
+  case lang::TK_BOOL:
+    type = ValueType::Bool;
+    return true;
+  case lang::TK_INT8:
+  case lang::TK_UINT8:
+    type = ValueType::I8;
+    return true;
+  case lang::TK_INT16:
+  case lang::TK_UINT16:
+    type = ValueType::I16;
+    return true;
+  case lang::TK_INT32:
+  case lang::TK_UINT32:
+    type = ValueType::I32;
+    return true;
+  case lang::TK_INT64:
+  case lang::TK_UINT64:
+    type = ValueType::I64;
+    return true;
+  case lang::TK_SIZET:
+    type = ValueType::Index;
+    return true;
+  case lang::TK_FLOAT:
+  case lang::TK_FLOAT32:
+    type = ValueType::F32;
+    return true;
+  case lang::TK_DOUBLE:
+  case lang::TK_FLOAT64:
+    type = ValueType::F64;
+    return true;
+  }
+
+  return false;
+}
+
+bool Interpreter::isFloat(ValueType type) {
+  return type == ValueType::F32 || type == ValueType::F64;
+}
+
+unsigned int Interpreter::getBits(ValueType type) {
+  switch (type) {
+  case ValueType::Bool:
+    return 1;
+  case ValueType::I8:
+    return 8;
+  case ValueType::I16:
+    return 16;
+  case ValueType::I32:
+  case ValueType::F32:
+    return 32;
+  case ValueType::I64:
+  case ValueType::Index:
+  case ValueType::F64:
+    return 64;
+  }
+
+  return 0;
+}
+
+// Same rules as typeLosslesslyConvertible() in MLIRGen, except that
+// the index type converts like a 64-bit integer
+bool Interpreter::losslesslyConvertible(ValueType from, ValueType to) {
+  if (from == to)
+    return true;
+
+  if (from == ValueType::Bool || to == ValueType::Bool)
+    return false;
+
+  if (isFloat(from) && isFloat(to))
+    return getBits(from) <= getBits(to);
+
+  if (!isFloat(from) && !isFloat(to))
+    return getBits(from) <= getBits(to);
+
+  // Integers must fit into the mantissa
+  if (!isFloat(from))
+    return getBits(from) <= (to == ValueType::F32 ? 23 : 52);
+
+  return false;
+}
+
+int64_t Interpreter::wrap(int64_t v, ValueType type) {
+  switch (type) {
+  case ValueType::Bool:
+    return v & 1;
+  case ValueType::I8:
+    return static_cast<int8_t>(v);
+  case ValueType::I16:
+    return static_cast<int16_t>(v);
+  case ValueType::I32:
+    return static_cast<int32_t>(v);
+  default:
+    return v;
+  }
+}
+
+// Rounding the exact result of an operation on two floats to double
+// and then to float yields the correctly rounded float result, since
+// double has more than twice as many mantissa bits as float
+double Interpreter::round(double v, ValueType type) {
+  if (type == ValueType::F32)
+    return static_cast<float>(v);
+
+  return v;
+}
+
+int64_t Interpreter::loadInt(const char *p, ValueType type) {
+  switch (type) {
+  case ValueType::I8: {
+    int8_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  case ValueType::I16: {
+    int16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  case ValueType::I32: {
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  default: {
+    int64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  }
+}
+
+double Interpreter::loadFloat(const char *p, ValueType type) {
+  if (type == ValueType::F32) {
+    float v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  double v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+void Interpreter::storeInt(char *p, ValueType type, int64_t v) {
+  // Little endian: the low bytes of the 64-bit value come first
+  memcpy(p, &v, getBits(type) / 8);
+}
+
+void Interpreter::storeFloat(char *p, ValueType type, double v) {
+  if (type == ValueType::F32) {
+    float f = v;
+    memcpy(p, &f, sizeof(f));
+  } else {
+    memcpy(p, &v, sizeof(v));
+  }
+}
+
+bool Interpreter::fail(const std::string &reason) {
+  if (unsupported.empty())
+    unsupported = reason;
+
+  return false;
+}
+
+bool Interpreter::translateDef(const lang::Def &def) {
+  std::vector<lang::Param> params;
+
+  for (const lang::Param &param : def.params())
+    params.push_back(param);
+
+  for (const lang::Param &param : def.returns())
+    params.push_back(param);
+
+  for (size_t i = 0; i < params.size(); i++) {
+    const std::string &name = params[i].ident().name();
+    lang::TensorType type = params[i].tensorType();
+    ValueType valueType;
+    size_t dim = 0;
+
+    if (!getValueType(type.scalarType(), valueType) ||
+        valueType == ValueType::Bool) {
+      return fail("Element type of " + name +
+                  " is not supported by the interpreter");
+    }
+
+    if (!layout::isRowMajor(layout::getLayout(type)))
+      return fail("Layout of " + name + " is not supported by the interpreter");
+
+    tensorIndexes.emplace(name, i);
+    tensorTypes.push_back(valueType);
+    tensorUnsigned.push_back(isUnsignedIntType(type.scalarType()));
+
+    // The first dimension of a size parameter defines its size, like
+    // in the generated code
+    for (const lang::TreeRef &d : type.dims()) {
+      if (d->kind() == lang::TK_IDENT) {
+        const std::string &sizeParam = lang::Ident(d).name();
+
+        if (sizeParamIndexes.emplace(sizeParam, sizeParamDims.size()).second)
+          sizeParamDims.push_back({i, dim});
+      }
+
+      dim++;
+    }
+  }
+
+  for (const lang::Comprehension &c : def.statements())
+    if (!translateComprehension(c))
+      return false;
+
+  return true;
+}
+
+bool Interpreter::translateComprehension(
+    const lang::Comprehension &comprehension) {
+  ComprehensionInfo info =
+      analyzeComprehension(comprehension, [&](const std::string &name) {
+        return tensorIndexes.count(name) || sizeParamIndexes.count(name);
+      });
+  const lang::Comprehension &c = info.comprehension;
+  const std::string &outputName = c.ident().name();
+  Statement s;
+
+  s.output = tensorIndexes.at(outputName);
+  s.outputType = tensorTypes[s.output];
+  s.outputUnsigned = tensorUnsigned[s.output];
+  s.assignment = c.assignment()->kind();
+
+  // Same (arbitrary) loop order as in MLIRGen
+  std::map<std::string, size_t> iterators;
+  size_t innermost = info.iterators.size() - 1;
+
+  for (const std::pair<std::string, IteratorKind> &it : info.iterators) {
+    auto bound = info.bounds.find(it.first);
+    Expr lb;
+    Expr ub;
+
+    iterators.emplace(it.first, iterators.size());
+
+    if (bound == info.bounds.end())
+      return fail("No range for iterator " + it.first);
+
+    if (!translateExpr(bound->second.start(), {}, innermost, lb) ||
+        !translateExpr(bound->second.end(), {}, innermost, ub)) {
+      return false;
+    }
+
+    if (isFloat(lb.back().type) || isFloat(ub.back().type))
+      return fail("Range of iterator " + it.first + " is not integral");
+
+    s.lowerBounds.push_back(lb);
+    s.upperBounds.push_back(ub);
+  }
+
+  for (const lang::Ident &index : c.indices())
+    s.outputIterators.push_back(iterators.at(index.name()));
+
+  // Same widening of integer operands of sums and products as
+  // getOperandWideningType() in MLIRGen
+  bool sumOrProduct = (s.assignment == lang::TK_PLUS_EQ ||
+                       s.assignment == lang::TK_PLUS_EQ_B ||
+                       s.assignment == lang::TK_TIMES_EQ ||
+                       s.assignment == lang::TK_TIMES_EQ_B);
+
+  if (sumOrProduct && !isFloat(s.outputType))
+    widenedType = s.outputType;
+
+  bool translated = translateExpr(c.rhs(), iterators, innermost, s.rhs);
+
+  widenedType = ValueType::Bool;
+
+  if (!translated)
+    return false;
+
+  size_t rhs = s.rhs.size() - 1;
+
+  if (!losslesslyConvertible(s.rhs[rhs].type, s.outputType))
+    return fail("Right hand side of " + outputName +
+                " cannot be converted to its element type");
+
+  if (!appendConversion(s.rhs, rhs, s.outputType))
+    return false;
+
+  // Elements written by earlier iterations of a batch must be visible
+  // to reads of the output tensor in later iterations
+  s.batch = batchSize;
+
+  for (const lang::Access &a : info.accesses)
+    if (a.name().name() == outputName)
+      s.batch = 1;
+
+  for (Node &node : s.rhs) {
+    node.ints.resize(node.varying ? s.batch : 1);
+    node.floats.resize(node.varying ? s.batch : 1);
+  }
+
+  statements.push_back(std::move(s));
+
+  return true;
+}
+
+bool Interpreter::appendConversion(Expr &expr, size_t &operand,
+                                   ValueType type) {
+  if (expr[operand].type == type)
+    return true;
+
+  if (!losslesslyConvertible(expr[operand].type, type))
+    return fail("Unsupported type conversion");
+
+  Node node{lang::TK_CAST, type, expr[operand].varying, {operand}};
+
+  expr.push_back(node);
+  operand = expr.size() - 1;
+
+  return true;
+}
+
+// Converts the operand with the narrower type to the type of the
+// other operand, like alignTypes() in MLIRGen
+bool Interpreter::alignOperands(Expr &expr, size_t &a, size_t &b,
+                                ValueType &type) {
+  ValueType ta = expr[a].type;
+  ValueType tb = expr[b].type;
+
+  if (losslesslyConvertible(ta, tb)) {
+    type = tb;
+    return appendConversion(expr, a, tb);
+  } else if (losslesslyConvertible(tb, ta)) {
+    type = ta;
+    return appendConversion(expr, b, ta);
+  }
+
+  return fail("Operands of a binary expression have incompatible types");
+}
+
+bool Interpreter::translateExpr(const lang::TreeRef &t,
+                                const std::map<std::string, size_t> &iterators,
+                                size_t innermost, Expr &expr) {
+  Node node{t->kind(), ValueType::Index, false, {}, 0, 0.0, 0};
+
+  switch (t->kind()) {
+  case '+':
+  case '-':
+  case '*':
+  case '/':
+  case '<':
+  case '>':
+  case lang::TK_LE:
+  case lang::TK_GE:
+  case lang::TK_EQ: {
+    if (!translateExpr(t->tree(0), iterators, innermost, expr))
+      return false;
+
+    size_t a = expr.size() - 1;
+
+    if (!translateExpr(t->tree(1), iterators, innermost, expr))
+      return false;
+
+    size_t b = expr.size() - 1;
+
+    if (!alignOperands(expr, a, b, node.type))
+      return false;
+
+    if (node.type == ValueType::Bool)
+      return fail("Arithmetic on booleans is not supported");
+
+    if (t->kind() != '+' && t->kind() != '-' && t->kind() != '*' &&
+        t->kind() != '/') {
+      node.type = ValueType::Bool;
+    }
+
+    node.operands = {a, b};
+    node.varying = expr[a].varying || expr[b].varying;
+    break;
+  }
+  case '?': {
+    if (!translateExpr(t->tree(0), iterators, innermost, expr))
+      return false;
+
+    size_t cond = expr.size() - 1;
+
+    if (expr[cond].type != ValueType::Bool)
+      return fail("Condition of a ternary expression is not a boolean");
+
+    if (!translateExpr(t->tree(1), iterators, innermost, expr))
+      return false;
+
+    size_t a = expr.size() - 1;
+
+    if (!translateExpr(t->tree(2), iterators, innermost, expr))
+      return false;
+
+    size_t b = expr.size() - 1;
+
+    if (!alignOperands(expr, a, b, node.type))
+      return false;
+
+    node.operands = {cond, a, b};
+    node.varying = expr[cond].varying || expr[a].varying || expr[b].varying;
+    break;
+  }
+  case lang::TK_CONST: {
+    lang::Const cst(t);
+
+    if (!getValueType(cst.type()->kind(), node.type))
+      return fail("Type of constant " + cst.value() + " is not supported");
+
+    const std::string &value = cst.value();
+
+    if (isFloat(node.type))
+      node.floatValue = round(strtod(value.c_str(), nullptr), node.type);
+    else
+      node.intValue = wrap(strtoll(value.c_str(), nullptr, 10), node.type);
+
+    node.ints.push_back(node.intValue);
+    node.floats.push_back(node.floatValue);
+    break;
+  }
+  case lang::TK_IDENT: {
+    const std::string &name = lang::Ident(t).name();
+    auto it = iterators.find(name);
+
+    if (it != iterators.end()) {
+      node.ref = it->second;
+      node.varying = (it->second == innermost);
+    } else if (sizeParamIndexes.count(name)) {
+      node.op = lang::TK_PARAM;
+      node.ref = sizeParamIndexes.at(name);
+    } else {
+      return fail("Unsupported use of identifier " + name);
+    }
+
+    break;
+  }
+  case lang::TK_ACCESS: {
+    lang::Access a(t);
+    auto it = tensorIndexes.find(a.name().name());
+
+    if (it == tensorIndexes.end())
+      return fail("Unknown tensor " + a.name().name());
+
+    node.ref = it->second;
+    node.type = tensorTypes[it->second];
+
+    for (const lang::TreeRef &arg : a.arguments()) {
+      if (!translateExpr(arg, iterators, innermost, expr))
+        return false;
+
+      const Node &index = expr.back();
+
+      if (isFloat(index.type) || index.type == ValueType::Bool)
+        return fail("Index of " + a.name().name() + " is not an integer");
+
+      node.operands.push_back(expr.size() - 1);
+      node.varying |= index.varying;
+    }
+
+    expr.push_back(node);
+
+    // Like widenAccess() in MLIRGen, elements of unsigned tensors are
+    // zero-extended and all others sign-extended
+    if (widenedType != ValueType::Bool && !isFloat(node.type) &&
+        getBits(node.type) < getBits(widenedType)) {
+      Node widened{lang::TK_CAST, widenedType, node.varying,
+                   {expr.size() - 1}};
+
+      widened.zeroExtend = tensorUnsigned[node.ref];
+      expr.push_back(widened);
+    }
+
+    return true;
+  }
+  default:
+    return fail("Expressions of kind " + lang::kindToString(t->kind()) +
+                " are not supported by the interpreter");
+  }
+
+  expr.push_back(node);
+
+  return true;
+}
+
+void Interpreter::evaluate(Expr &expr, Frame &frame, int64_t len) {
+  for (Node &node : expr) {
+    int64_t n = node.varying ? len : 1;
+
+    switch (node.op) {
+    case lang::TK_CONST:
+      break;
+    case lang::TK_PARAM:
+      node.ints[0] = frame.sizeParams[node.ref];
+      break;
+    case lang::TK_IDENT: {
+      int64_t base = frame.iterators[node.ref];
+
+      for (int64_t l = 0; l < n; l++)
+        node.ints[l] = base + l;
+
+      break;
+    }
+    case lang::TK_ACCESS: {
+      const Tensor &tensor = (*frame.tensors)[node.ref];
+      const std::vector<int64_t> &strides = frame.strides[node.ref];
+      size_t elementSize = getElementSize(tensor.kind);
+
+      // Compute the offsets of the elements into the integer column
+      // and replace them by the elements
+      std::fill(node.ints.begin(), node.ints.begin() + n, 0);
+
+      for (size_t d = 0; d < node.operands.size(); d++) {
+        const Node &index = expr[node.operands[d]];
+        int64_t stride = strides[d];
+
+        map2(node.ints, node.ints, true, index.ints, index.varying, n,
+             [=](int64_t off, int64_t i) { return off + i * stride; });
+      }
+
+      if (isFloat(node.type)) {
+        for (int64_t l = 0; l < n; l++)
+          node.floats[l] =
+              loadFloat(tensor.data + node.ints[l] * elementSize, node.type);
+      } else {
+        for (int64_t l = 0; l < n; l++)
+          node.ints[l] =
+              loadInt(tensor.data + node.ints[l] * elementSize, node.type);
+      }
+
+      break;
+    }
+    case lang::TK_CAST: {
+      const Node &a = expr[node.operands[0]];
+      size_t sa = a.varying ? 1 : 0;
+
+      if (isFloat(node.type) && isFloat(a.type)) {
+        for (int64_t l = 0; l < n; l++)
+          node.floats[l] = a.floats[l * sa];
+      } else if (isFloat(node.type)) {
+        for (int64_t l = 0; l < n; l++)
+          node.floats[l] = round(a.ints[l * sa], node.type);
+      } else if (node.zeroExtend) {
+        uint64_t mask = (uint64_t(1) << getBits(a.type)) - 1;
+
+        for (int64_t l = 0; l < n; l++)
+          node.ints[l] = wrap(a.ints[l * sa] & mask, node.type);
+      } else {
+        for (int64_t l = 0; l < n; l++)
+          node.ints[l] = wrap(a.ints[l * sa], node.type);
+      }
+
+      break;
+    }
+    case '?': {
+      const Node &cond = expr[node.operands[0]];
+      const Node &a = expr[node.operands[1]];
+      const Node &b = expr[node.operands[2]];
+      size_t sc = cond.varying ? 1 : 0;
+      size_t sa = a.varying ? 1 : 0;
+      size_t sb = b.varying ? 1 : 0;
+
+      for (int64_t l = 0; l < n; l++) {
+        if (cond.ints[l * sc]) {
+          node.ints[l] = a.ints[l * sa];
+          node.floats[l] = a.floats[l * sa];
+        } else {
+          node.ints[l] = b.ints[l * sb];
+          node.floats[l] = b.floats[l * sb];
+        }
+      }
+
+      break;
+    }
+    default: {
+      const Node &a = expr[node.operands[0]];
+      const Node &b = expr[node.operands[1]];
+      ValueType type = node.type;
+
+      // Comparisons yield booleans, but compare values of the type
+      // of their operands
+      if (node.type == ValueType::Bool && isFloat(a.type)) {
+        switch (node.op) {
+        case '<':
+          map2(node.ints, a.floats, a.varying, b.floats, b.varying, n,
+               [](double x, double y) { return x < y; });
+          break;
+        case '>':
+          map2(node.ints, a.floats, a.varying, b.floats, b.varying, n,
+               [](double x, double y) { return x > y; });
+          break;
+        case lang::TK_LE:
+          map2(node.ints, a.floats, a.varying, b.floats, b.varying, n,
+               [](double x, double y) { return x <= y; });
+          break;
+        case lang::TK_GE:
+          map2(node.ints, a.floats, a.varying, b.floats, b.varying, n,
+               [](double x, double y) { return x >= y; });
+          break;
+        case lang::TK_EQ:
+          map2(node.ints, a.floats, a.varying, b.floats, b.varying, n,
+               [](double x, double y) { return x == y; });
+          break;
+        }
+      } else if (node.type == ValueType::Bool) {
+        switch (node.op) {
+        case '<':
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [](int64_t x, int64_t y) { return x < y; });
+          break;
+        case '>':
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [](int64_t x, int64_t y) { return x > y; });
+          break;
+        case lang::TK_LE:
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [](int64_t x, int64_t y) { return x <= y; });
+          break;
+        case lang::TK_GE:
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [](int64_t x, int64_t y) { return x >= y; });
+          break;
+        case lang::TK_EQ:
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [](int64_t x, int64_t y) { return x == y; });
+          break;
+        }
+      } else if (isFloat(type)) {
+        switch (node.op) {
+        case '+':
+          map2(node.floats, a.floats, a.varying, b.floats, b.varying, n,
+               [=](double x, double y) { return round(x + y, type); });
+          break;
+        case '-':
+          map2(node.floats, a.floats, a.varying, b.floats, b.varying, n,
+               [=](double x, double y) { return round(x - y, type); });
+          break;
+        case '*':
+          map2(node.floats, a.floats, a.varying, b.floats, b.varying, n,
+               [=](double x, double y) { return round(x * y, type); });
+          break;
+        case '/':
+          map2(node.floats, a.floats, a.varying, b.floats, b.varying, n,
+               [=](double x, double y) { return round(x / y, type); });
+          break;
+        }
+      } else {
+        switch (node.op) {
+        case '+':
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [=](int64_t x, int64_t y) {
+                 return wrap(addWrapping(x, y), type);
+               });
+          break;
+        case '-':
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [=](int64_t x, int64_t y) {
+                 return wrap(subWrapping(x, y), type);
+               });
+          break;
+        case '*':
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [=](int64_t x, int64_t y) {
+                 return wrap(mulWrapping(x, y), type);
+               });
+          break;
+        case '/':
+          map2(node.ints, a.ints, a.varying, b.ints, b.varying, n,
+               [=](int64_t x, int64_t y) {
+                 return wrap(divSigned(x, y), type);
+               });
+          break;
+        }
+      }
+    }
+    }
+  }
+}
+
+int64_t Interpreter::evaluateScalar(Expr &expr, Frame &frame) {
+  for (Node &node : expr) {
+    node.ints.resize(1);
+    node.floats.resize(1);
+  }
+
+  evaluate(expr, frame, 1);
+
+  return expr.back().ints[0];
+}
+
+// Combines the value `v` with the accumulator `acc` for the
+// reduction operator `kind`, like buildReductionStep() in MLIRGen
+template <typename T, typename Less>
+static T reduce(int kind, T v, T acc, Less less) {
+  switch (kind) {
+  case lang::TK_MAX_EQ:
+  case lang::TK_MAX_EQ_B:
+    return less(acc, v) ? v : acc;
+  case lang::TK_MIN_EQ:
+  case lang::TK_MIN_EQ_B:
+    return less(v, acc) ? v : acc;
+  default:
+    return v;
+  }
+}
+
+void Interpreter::executeBatch(Statement &s, Frame &frame, int64_t len) {
+  evaluate(s.rhs, frame, len);
+
+  const Tensor &output = (*frame.tensors)[s.output];
+  const std::vector<int64_t> &strides = frame.strides[s.output];
+  size_t innermost = s.lowerBounds.size() - 1;
+  size_t elementSize = getElementSize(output.kind);
+  int64_t offset = 0;
+  int64_t laneStride = 0;
+
+  for (size_t d = 0; d < s.outputIterators.size(); d++) {
+    offset += frame.iterators[s.outputIterators[d]] * strides[d];
+
+    if (s.outputIterators[d] == innermost)
+      laneStride += strides[d];
+  }
+
+  const Node &rhs = s.rhs.back();
+  size_t sr = rhs.varying ? 1 : 0;
+  ValueType type = s.outputType;
+  bool isUnsigned = s.outputUnsigned;
+  int kind = s.assignment;
+
+  for (int64_t l = 0; l < len; l++) {
+    char *p = output.data + (offset + l * laneStride) * elementSize;
+
+    if (isFloat(type)) {
+      double v = rhs.floats[l * sr];
+
+      if (kind == lang::TK_PLUS_EQ || kind == lang::TK_PLUS_EQ_B)
+        v = round(v + loadFloat(p, type), type);
+      else if (kind == lang::TK_TIMES_EQ || kind == lang::TK_TIMES_EQ_B)
+        v = round(v * loadFloat(p, type), type);
+      else if (kind != '=')
+        v = reduce(kind, v, loadFloat(p, type),
+                   [](double x, double y) { return x < y; });
+
+      storeFloat(p, type, v);
+    } else {
+      int64_t v = rhs.ints[l * sr];
+      uint64_t mask = (getBits(type) == 64)
+                          ? std::numeric_limits<uint64_t>::max()
+                          : (uint64_t(1) << getBits(type)) - 1;
+
+      if (kind == lang::TK_PLUS_EQ || kind == lang::TK_PLUS_EQ_B)
+        v = wrap(addWrapping(v, loadInt(p, type)), type);
+      else if (kind == lang::TK_TIMES_EQ || kind == lang::TK_TIMES_EQ_B)
+        v = wrap(mulWrapping(v, loadInt(p, type)), type);
+      else if (kind != '=')
+        v = reduce(kind, v, loadInt(p, type), [=](int64_t x, int64_t y) {
+          return isUnsigned ? (uint64_t(x) & mask) < (uint64_t(y) & mask)
+                            : x < y;
+        });
+
+      storeInt(p, type, v);
+    }
+  }
+}
+
+void Interpreter::executeLoops(Statement &s, Frame &frame, size_t depth,
+                               const std::vector<int64_t> &lbs,
+                               const std::vector<int64_t> &ubs) {
+  // Comprehensions without iterators assign a single element
+  if (lbs.empty()) {
+    executeBatch(s, frame, 1);
+    return;
+  }
+
+  if (depth == lbs.size() - 1) {
+    for (int64_t i = lbs[depth]; i < ubs[depth]; i += s.batch) {
+      frame.iterators[depth] = i;
+      executeBatch(s, frame, std::min(s.batch, ubs[depth] - i));
+    }
+
+    return;
+  }
+
+  for (int64_t i = lbs[depth]; i < ubs[depth]; i++) {
+    frame.iterators[depth] = i;
+    executeLoops(s, frame, depth + 1, lbs, ubs);
+  }
+}
+
+// Fills the elements of the output tensor indexed by the iterators of
+// the left hand side with the neutral element of the reduction, like
+// buildTensorInitialization() in MLIRGen
+void Interpreter::initializeOutput(Statement &s, Frame &frame,
+                                   const std::vector<int64_t> &lbs,
+                                   const std::vector<int64_t> &ubs) {
+  const Tensor &output = (*frame.tensors)[s.output];
+  const std::vector<int64_t> &strides = frame.strides[s.output];
+  size_t elementSize = getElementSize(output.kind);
+  ValueType type = s.outputType;
+  unsigned int bits = getBits(type);
+  bool lowest = (s.assignment == lang::TK_MAX_EQ_B);
+  bool highest = (s.assignment == lang::TK_MIN_EQ_B);
+  double floatValue = (s.assignment == lang::TK_TIMES_EQ_B) ? 1 : 0;
+  int64_t intValue = floatValue;
+
+  if (lowest || highest) {
+    floatValue = lowest ? -INFINITY : INFINITY;
+
+    if (s.outputUnsigned) {
+      intValue = lowest ? 0 : -1;
+    } else {
+      uint64_t max = (uint64_t(1) << (bits - 1)) - 1;
+      intValue = lowest ? -static_cast<int64_t>(max) - 1 : max;
+    }
+  }
+
+  // Iterators appearing multiple times on the left hand side (e.g.,
+  // i in C(i, i)) only count once
+  std::vector<size_t> lhsIterators;
+
+  for (size_t it : s.outputIterators)
+    if (std::find(lhsIterators.begin(), lhsIterators.end(), it) ==
+        lhsIterators.end())
+      lhsIterators.push_back(it);
+
+  for (size_t it : lhsIterators) {
+    if (lbs[it] >= ubs[it])
+      return;
+
+    frame.iterators[it] = lbs[it];
+  }
+
+  while (true) {
+    int64_t offset = 0;
+
+    for (size_t d = 0; d < s.outputIterators.size(); d++)
+      offset += frame.iterators[s.outputIterators[d]] * strides[d];
+
+    if (isFloat(type))
+      storeFloat(output.data + offset * elementSize, type, floatValue);
+    else
+      storeInt(output.data + offset * elementSize, type, intValue);
+
+    // Advance to the next element, innermost iterator first
+    size_t i = lhsIterators.size();
+
+    for (; i > 0; i--) {
+      size_t it = lhsIterators[i - 1];
+
+      if (++frame.iterators[it] < ubs[it])
+        break;
+
+      frame.iterators[it] = lbs[it];
+    }
+
+    if (i == 0)
+      return;
+  }
+}
+
+void Interpreter::execute(Statement &s, Frame &frame) {
+  std::vector<int64_t> lbs;
+  std::vector<int64_t> ubs;
+
+  for (size_t i = 0; i < s.lowerBounds.size(); i++) {
+    lbs.push_back(evaluateScalar(s.lowerBounds[i], frame));
+    ubs.push_back(evaluateScalar(s.upperBounds[i], frame));
+  }
+
+  frame.iterators.assign(lbs.size(), 0);
+
+  if (s.assignment == lang::TK_PLUS_EQ_B ||
+      s.assignment == lang::TK_TIMES_EQ_B ||
+      s.assignment == lang::TK_MAX_EQ_B || s.assignment == lang::TK_MIN_EQ_B) {
+    initializeOutput(s, frame, lbs, ubs);
+  }
+
+  executeLoops(s, frame, 0, lbs, ubs);
+}
+
+void Interpreter::invoke(const std::vector<Tensor> &tensors) {
+  if (!isSupported())
+    THROW_OR_ASSERT(Exception(unsupported));
+
+  Frame frame;
+
+  frame.tensors = &tensors;
+
+  for (const Tensor &t : tensors) {
+    std::vector<int64_t> strides(t.sizes.size());
+    int64_t stride = 1;
+
+    for (size_t i = t.sizes.size(); i > 0; i--) {
+      strides[i - 1] = stride;
+      stride *= t.sizes[i - 1];
+    }
+
+    frame.strides.push_back(strides);
+  }
+
+  for (const std::pair<size_t, size_t> &dim : sizeParamDims)
+    frame.sizeParams.push_back(tensors[dim.first].sizes[dim.second]);
+
+  for (Statement &s : statements)
+    execute(s, frame);
+}
+
+} // namespace run
+} // namespace teckyl
@@ -0,0 +1,198 @@
+#ifndef TECKYL_RUN_INTERPRETER_H
+#define TECKYL_RUN_INTERPRETER_H
+
+#include "teckyl/run/Tensor.h"
+
+#include "teckyl/tc/lang/tree_views.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace teckyl {
+namespace run {
+
+// Executes TC definitions directly on tensors without compiling them,
+// e.g., while the compilation of a kernel is still in progress (see
+// TieredKernel).
+//
+// Each comprehension is executed as a loop nest over its iterators in
+// the same order as the loops generated by MLIRGen. The expressions
+// of the right hand side are translated once into a list of nodes,
+// which are evaluated for a batch of consecutive iterations of the
+// innermost loop at once: each node computes a column with one value
+// per iteration, such that the dispatch on the operation and on the
+// type of a node is amortized over the batch. Nodes that do not
+// depend on the innermost iterator compute a single value per batch.
+//
+// The values follow the semantics of the generated code: integers are
+// signless and wrap around at the width of their type, floats are
+// rounded to their type after each operation and operands of
+// different types are converted like in MLIRGen.
+class Interpreter {
+public:
+  // Prepares the execution of the TC definition `def`, which must
+  // have been checked by the semantic analysis. Definitions with
+  // constructs not supported by the interpreter (see isSupported())
+  // are accepted, but cannot be executed.
+  explicit Interpreter(const lang::Def &def);
+
+  // Checks if the interpreter can execute the definition. The
+  // interpreter supports the same expressions as MLIRGen, but only
+  // for row-major tensors of types with at least 32 bits for floats
+  // and at least 8 bits for integers.
+  bool isSupported() const { return unsupported.empty(); }
+
+  // Returns the reason why the definition cannot be executed or an
+  // empty string if it is supported
+  const std::string &getUnsupportedReason() const { return unsupported; }
+
+  // Executes the definition on `tensors`, which holds the parameters
+  // and outputs of the definition in order of their declaration
+  // (i.e., the same tensors as packed for a JitKernel)
+  void invoke(const std::vector<Tensor> &tensors);
+
+  // Maximum number of iterations of the innermost loop evaluated at
+  // once
+  static const int64_t batchSize = 256;
+
+private:
+  // Types of values; integer types are signless and the index type
+  // is used for iterators and size parameters
+  enum class ValueType { Bool, I8, I16, I32, I64, Index, F32, F64 };
+
+  // An operation computing a column of values, identified by the
+  // kind of the tree it has been translated from (e.g., '+',
+  // lang::TK_ACCESS or lang::TK_IDENT for iterators), by
+  // lang::TK_PARAM for size parameters or by lang::TK_CAST for type
+  // conversions
+  struct Node {
+    int op;
+    ValueType type;
+
+    // Whether the value depends on the innermost iterator
+    bool varying;
+
+    // Indexes of the operand nodes in the list of nodes
+    std::vector<size_t> operands;
+
+    // Value of constants
+    int64_t intValue;
+    double floatValue;
+
+    // Index of the tensor for accesses, of the iterator in loop
+    // order for iterators and of the size parameter for size
+    // parameters
+    size_t ref;
+
+    // Whether an integer conversion zero-extends its operand instead
+    // of sign-extending it (for widened elements of unsigned tensors)
+    bool zeroExtend;
+
+    // Columns with one value per iteration of the batch for varying
+    // nodes and a single value otherwise; integers and booleans are
+    // stored sign-extended to 64 bits
+    std::vector<int64_t> ints;
+    std::vector<double> floats;
+  };
+
+  // Nodes of an expression in evaluation order; the last node
+  // computes the value of the expression
+  using Expr = std::vector<Node>;
+
+  // A comprehension translated for the interpreter
+  struct Statement {
+    // Index of the output tensor and element type of its elements
+    size_t output;
+    ValueType outputType;
+    bool outputUnsigned;
+
+    // Assignment or reduction operator (e.g., lang::TK_PLUS_EQ_B)
+    int assignment;
+
+    // Bounds of the iterators in loop order; the last iterator is the
+    // innermost iterator
+    std::vector<Expr> lowerBounds;
+    std::vector<Expr> upperBounds;
+
+    // Position of the iterator indexing each dimension of the output
+    // tensor in loop order
+    std::vector<size_t> outputIterators;
+
+    // Right hand side, converted to `outputType`
+    Expr rhs;
+
+    // Number of iterations evaluated at once, 1 if the right hand
+    // side reads the output tensor
+    int64_t batch;
+  };
+
+  // State of a single invocation
+  struct Frame {
+    const std::vector<Tensor> *tensors;
+
+    // Row-major strides in elements for each tensor
+    std::vector<std::vector<int64_t>> strides;
+
+    std::vector<int64_t> sizeParams;
+    std::vector<int64_t> iterators;
+  };
+
+  std::string unsupported;
+  std::vector<Statement> statements;
+
+  // Tensor and dimension defining each size parameter
+  std::vector<std::pair<size_t, size_t>> sizeParamDims;
+
+  // Indexes of the parameters and outputs and of the size parameters
+  std::map<std::string, size_t> tensorIndexes;
+  std::map<std::string, size_t> sizeParamIndexes;
+
+  // Element types of the parameters and outputs and whether their
+  // types are unsigned
+  std::vector<ValueType> tensorTypes;
+  std::vector<bool> tensorUnsigned;
+
+  // Integer type to which narrower tensor elements are widened when
+  // they are read by the right hand side being translated, like in
+  // sums and products in MLIRGen (see setAccessWidening()); Bool if
+  // elements are not widened
+  ValueType widenedType = ValueType::Bool;
+
+  bool translateDef(const lang::Def &def);
+  bool translateComprehension(const lang::Comprehension &comprehension);
+  bool translateExpr(const lang::TreeRef &t,
+                     const std::map<std::string, size_t> &iterators,
+                     size_t innermost, Expr &expr);
+  bool appendConversion(Expr &expr, size_t &operand, ValueType type);
+  bool alignOperands(Expr &expr, size_t &a, size_t &b, ValueType &type);
+  bool fail(const std::string &reason);
+
+  void execute(Statement &s, Frame &frame);
+  void executeLoops(Statement &s, Frame &frame, size_t depth,
+                    const std::vector<int64_t> &lbs,
+                    const std::vector<int64_t> &ubs);
+  void executeBatch(Statement &s, Frame &frame, int64_t len);
+  void initializeOutput(Statement &s, Frame &frame,
+                        const std::vector<int64_t> &lbs,
+                        const std::vector<int64_t> &ubs);
+  int64_t evaluateScalar(Expr &expr, Frame &frame);
+  void evaluate(Expr &expr, Frame &frame, int64_t len);
+
+  static bool getValueType(int kind, ValueType &type);
+  static bool isFloat(ValueType type);
+  static unsigned int getBits(ValueType type);
+  static bool losslesslyConvertible(ValueType from, ValueType to);
+  static int64_t wrap(int64_t v, ValueType type);
+  static double round(double v, ValueType type);
+  static int64_t loadInt(const char *p, ValueType type);
+  static double loadFloat(const char *p, ValueType type);
+  static void storeInt(char *p, ValueType type, int64_t v);
+  static void storeFloat(char *p, ValueType type, double v);
+};
+
+} // namespace run
+} // namespace teckyl
+
+#endif
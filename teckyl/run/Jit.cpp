@@ -0,0 +1,123 @@
+#include "teckyl/run/Jit.h"
+#include "teckyl/LLVMLowering.h"
+
+#include <llvm/Support/TargetSelect.h>
+#include <mlir/Dialect/Affine/IR/AffineOps.h>
+#include <mlir/Dialect/LLVMIR/LLVMDialect.h>
+#include <mlir/Dialect/Linalg/IR/LinalgOps.h>
+#include <mlir/Dialect/SCF/SCF.h>
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/ExecutionEngine/OptUtils.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/Module.h>
+#include <mlir/Pass/PassManager.h>
+
+#include <cstring>
+#include <mutex>
+
+namespace teckyl {
+namespace run {
+
+PackedArgs::PackedArgs(const std::vector<Tensor> &tensors) {
+  size_t numSlots = 0;
+
+  for (const Tensor &t : tensors)
+    numSlots += t.byValue ? 1 : 3 + 2 * t.sizes.size();
+
+  slots.reserve(numSlots);
+
+  auto addSlot = [&](const void *val, size_t size) {
+    slots.push_back(0);
+    memcpy(&slots.back(), val, size);
+    pointers.push_back(&slots.back());
+  };
+
+  for (const Tensor &t : tensors) {
+    if (t.byValue) {
+      addSlot(t.data, getElementSize(t.kind));
+      continue;
+    }
+
+    int64_t offset = 0;
+    int64_t stride = 1;
+    std::vector<int64_t> strides(t.sizes.size());
+
+    // Row-major strides in elements
+    for (size_t i = t.sizes.size(); i > 0; i--) {
+      strides[i - 1] = stride;
+      stride *= t.sizes[i - 1];
+    }
+
+    // Allocated and aligned pointer are the same, since the kernel
+    // never frees the memory
+    addSlot(&t.data, sizeof(t.data));
+    addSlot(&t.data, sizeof(t.data));
+    addSlot(&offset, sizeof(offset));
+
+    for (int64_t size : t.sizes)
+      addSlot(&size, sizeof(size));
+
+    for (int64_t s : strides)
+      addSlot(&s, sizeof(s));
+  }
+}
+
+// Registers the dialects generated by MLIRGen and the LLVM dialect
+// and initializes the native target once per process, such that
+// kernels can be compiled concurrently on multiple threads
+static void initializeOnce() {
+  static std::once_flag flag;
+
+  std::call_once(flag, []() {
+    mlir::registerDialect<mlir::StandardOpsDialect>();
+    mlir::registerDialect<mlir::linalg::LinalgDialect>();
+    mlir::registerDialect<mlir::scf::SCFDialect>();
+    mlir::registerDialect<mlir::AffineDialect>();
+    mlir::registerDialect<mlir::LLVM::LLVMDialect>();
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  });
+}
+
+JitKernel::JitKernel(const lang::Def &def, const MLIRGenOptions &options,
+                     unsigned int optLevel) {
+  initializeOnce();
+
+  mlir::MLIRContext context;
+  mlir::OpBuilder builder(&context);
+  mlir::OwningModuleRef module(mlir::ModuleOp::create(builder.getUnknownLoc()));
+  const std::string &name = def.name().name();
+
+  module->push_back(buildMLIRFunction(context, *module, name, def, options));
+
+  // Same lowering as in teckyl-genobject
+  mlir::PassManager pm(&context);
+
+  addLowerToLLVMPasses(pm);
+
+  if (mlir::failed(pm.run(*module)))
+    THROW_OR_ASSERT(Exception("Could not lower kernel " + name + " to LLVM"));
+
+  auto maybeEngine = mlir::ExecutionEngine::create(
+      *module, mlir::makeOptimizingTransformer(optLevel, 0, nullptr));
+
+  if (!maybeEngine) {
+    THROW_OR_ASSERT(Exception("Could not compile kernel " + name + ": " +
+                              llvm::toString(maybeEngine.takeError())));
+  }
+
+  engine = std::move(*maybeEngine);
+
+  auto maybeFn = engine->lookup(name);
+
+  if (!maybeFn) {
+    THROW_OR_ASSERT(Exception("Could not find compiled kernel " + name +
+                              ": " + llvm::toString(maybeFn.takeError())));
+  }
+
+  fn = *maybeFn;
+}
+
+} // namespace run
+} // namespace teckyl
@@ -0,0 +1,59 @@
+#ifndef TECKYL_RUN_JIT_H
+#define TECKYL_RUN_JIT_H
+
+#include "teckyl/MLIRGen.h"
+#include "teckyl/run/Tensor.h"
+
+#include "teckyl/tc/lang/tree_views.h"
+
+#include <mlir/ExecutionEngine/ExecutionEngine.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace teckyl {
+namespace run {
+
+// Arguments of a kernel in the form expected by the packed interface
+// of functions compiled by the MLIR execution engine: one pointer per
+// argument of the LLVM function, for which each memref is expanded
+// into its allocated and aligned pointers, its offset, its sizes and
+// its strides. Tensors passed by value take a single argument.
+class PackedArgs {
+public:
+  explicit PackedArgs(const std::vector<Tensor> &tensors);
+
+  void **get() { return pointers.data(); }
+
+private:
+  // Storage for the values of the arguments; `pointers` points into
+  // `slots`, which is never resized after construction
+  std::vector<uint64_t> slots;
+  std::vector<void *> pointers;
+};
+
+// A kernel compiled to native code for the host at runtime
+class JitKernel {
+public:
+  // Compiles the TC definition `def`, which must have been checked by
+  // the semantic analysis, with the code generation options
+  // `options` and the LLVM optimization level `optLevel` (0 to 3).
+  // Throws an exception if the compilation fails.
+  JitKernel(const lang::Def &def, const MLIRGenOptions &options,
+            unsigned int optLevel);
+
+  // Executes the kernel with the arguments `args`, which must have
+  // been packed for the parameters and outputs of the definition in
+  // order of their declaration
+  void invoke(PackedArgs &args) { fn(args.get()); }
+
+private:
+  std::unique_ptr<mlir::ExecutionEngine> engine;
+  void (*fn)(void **);
+};
+
+} // namespace run
+} // namespace teckyl
+
+#endif
@@ -0,0 +1,324 @@
+#include "teckyl/run/Tensor.h"
+
+#include "teckyl/tc/lang/lexer.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace teckyl {
+namespace run {
+
+size_t getElementSize(int kind) {
+  switch (kind) {
+  case lang::TK_UINT8:
+  case lang::TK_INT8:
+    return 1;
+  case lang::TK_UINT16:
+  case lang::TK_INT16:
+  case lang::TK_FLOAT16:
+  case lang::TK_BFLOAT16:
+    return 2;
+  case lang::TK_UINT32:
+  case lang::TK_INT32:
+  case lang::TK_FLOAT:
+  case lang::TK_FLOAT32:
+    return 4;
+  case lang::TK_UINT64:
+  case lang::TK_INT64:
+  case lang::TK_SIZET:
+  case lang::TK_FLOAT64:
+    return 8;
+  }
+
+  return 0;
+}
+
+std::string getNpyDescr(int kind) {
+  switch (kind) {
+  case lang::TK_UINT8:
+    return "|u1";
+  case lang::TK_UINT16:
+    return "<u2";
+  case lang::TK_UINT32:
+    return "<u4";
+  case lang::TK_UINT64:
+  case lang::TK_SIZET:
+    return "<u8";
+  case lang::TK_INT8:
+    return "|i1";
+  case lang::TK_INT16:
+    return "<i2";
+  case lang::TK_INT32:
+    return "<i4";
+  case lang::TK_INT64:
+    return "<i8";
+  case lang::TK_FLOAT16:
+    return "<f2";
+  case lang::TK_FLOAT:
+  case lang::TK_FLOAT32:
+    return "<f4";
+  case lang::TK_FLOAT64:
+    return "<f8";
+  }
+
+  return "";
+}
+
+// Returns the message for the error code `errno` prefixed with `what`
+static std::string getErrnoMessage(const std::string &what) {
+  return what + ": " + strerror(errno);
+}
+
+// Maps `size` bytes of the open file `fd`; closes `fd`
+static char *mapFd(int fd, size_t size, bool writable,
+                   const std::string &filename) {
+  // Empty files cannot be mapped, but tensors without elements do not
+  // need any memory either
+  if (size == 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  void *ptr = mmap(nullptr, size, PROT_READ | (writable ? PROT_WRITE : 0),
+                   MAP_SHARED, fd, 0);
+  int mmapErrno = errno;
+
+  close(fd);
+
+  if (ptr == MAP_FAILED) {
+    errno = mmapErrno;
+    THROW_OR_ASSERT(Exception(getErrnoMessage("Could not map " + filename)));
+  }
+
+  return static_cast<char *>(ptr);
+}
+
+std::unique_ptr<Buffer> Buffer::mapFile(const std::string &filename,
+                                        bool writable) {
+  int fd = open(filename.c_str(), writable ? O_RDWR : O_RDONLY);
+  struct stat st;
+
+  if (fd < 0)
+    THROW_OR_ASSERT(Exception(getErrnoMessage("Could not open " + filename)));
+
+  if (fstat(fd, &st)) {
+    close(fd);
+    THROW_OR_ASSERT(Exception(getErrnoMessage("Could not stat " + filename)));
+  }
+
+  size_t size = st.st_size;
+
+  return std::unique_ptr<Buffer>(
+      new Buffer(mapFd(fd, size, writable, filename), size, true));
+}
+
+std::unique_ptr<Buffer> Buffer::createFile(const std::string &filename,
+                                           size_t size) {
+  int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0) {
+    THROW_OR_ASSERT(
+        Exception(getErrnoMessage("Could not create " + filename)));
+  }
+
+  if (ftruncate(fd, size)) {
+    close(fd);
+    THROW_OR_ASSERT(
+        Exception(getErrnoMessage("Could not resize " + filename)));
+  }
+
+  return std::unique_ptr<Buffer>(
+      new Buffer(mapFd(fd, size, true, filename), size, true));
+}
+
+std::unique_ptr<Buffer> Buffer::allocate(size_t size, size_t alignment) {
+  void *ptr = nullptr;
+
+  if (size > 0 && posix_memalign(&ptr, alignment, size))
+    THROW_OR_ASSERT(Exception("Could not allocate buffer"));
+
+  if (ptr)
+    memset(ptr, 0, size);
+
+  return std::unique_ptr<Buffer>(
+      new Buffer(static_cast<char *>(ptr), size, false));
+}
+
+Buffer::~Buffer() {
+  if (!ptr)
+    return;
+
+  if (mapped)
+    munmap(ptr, len);
+  else
+    free(ptr);
+}
+
+// Magic string at the beginning of .npy files
+static const char npyMagic[] = "\x93NUMPY";
+static const size_t npyMagicLen = sizeof(npyMagic) - 1;
+
+// Returns the value of the key `key` in the dictionary `dict` of a
+// .npy header as a string, e.g., "'<f4'" for the key "descr". Throws
+// an exception if the key is missing.
+static std::string getNpyDictValue(const std::string &dict,
+                                   const std::string &key,
+                                   const std::string &filename) {
+  size_t pos = dict.find("'" + key + "'");
+
+  if (pos != std::string::npos)
+    pos = dict.find(':', pos);
+
+  if (pos == std::string::npos) {
+    THROW_OR_ASSERT(
+        Exception("Missing key '" + key + "' in header of " + filename));
+  }
+
+  size_t start = dict.find_first_not_of(' ', pos + 1);
+  size_t end;
+
+  // Tuples contain commas; all other values end at the next comma or
+  // at the end of the dictionary
+  if (start != std::string::npos && dict[start] == '(')
+    end = dict.find(')', start) + 1;
+  else
+    end = dict.find_first_of(",}", start);
+
+  if (start == std::string::npos || end == std::string::npos ||
+      end < start) {
+    THROW_OR_ASSERT(
+        Exception("Invalid value for '" + key + "' in header of " + filename));
+  }
+
+  return dict.substr(start, end - start);
+}
+
+NpyHeader parseNpyHeader(const char *data, size_t size,
+                         const std::string &filename) {
+  if (size < npyMagicLen + 4 || memcmp(data, npyMagic, npyMagicLen))
+    THROW_OR_ASSERT(Exception(filename + " is not a .npy file"));
+
+  const unsigned char *udata = reinterpret_cast<const unsigned char *>(data);
+  unsigned int major = udata[npyMagicLen];
+  size_t headerLen;
+  size_t headerStart;
+
+  // Version 1 has a 16-bit header length, versions 2 and 3 a 32-bit
+  // header length; both are little endian
+  if (major == 1) {
+    headerLen = udata[8] | (udata[9] << 8);
+    headerStart = 10;
+  } else if (major == 2 || major == 3) {
+    if (size < 12)
+      THROW_OR_ASSERT(Exception("Truncated header in " + filename));
+
+    headerLen = udata[8] | (udata[9] << 8) | (udata[10] << 16) |
+                ((size_t)udata[11] << 24);
+    headerStart = 12;
+  } else {
+    THROW_OR_ASSERT(Exception("Unsupported .npy version " +
+                              std::to_string(major) + " of " + filename));
+  }
+
+  if (headerStart + headerLen > size)
+    THROW_OR_ASSERT(Exception("Truncated header in " + filename));
+
+  std::string dict(data + headerStart, headerLen);
+  NpyHeader header;
+  std::string descr = getNpyDictValue(dict, "descr", filename);
+  std::string fortranOrder = getNpyDictValue(dict, "fortran_order", filename);
+  std::string shape = getNpyDictValue(dict, "shape", filename);
+
+  if (descr.size() < 2 || descr.front() != '\'' || descr.back() != '\'')
+    THROW_OR_ASSERT(Exception("Unsupported type descriptor in " + filename));
+
+  header.descr = descr.substr(1, descr.size() - 2);
+  header.fortranOrder = (fortranOrder == "True");
+  header.dataOffset = headerStart + headerLen;
+
+  // Shapes are tuples of integers, e.g., "(3, 4)", "(3,)" or "()"
+  std::stringstream ss(shape.substr(1, shape.size() - 2));
+  std::string dim;
+
+  while (std::getline(ss, dim, ',')) {
+    size_t start = dim.find_first_not_of(' ');
+
+    if (start == std::string::npos)
+      continue;
+
+    char *end;
+    long long val = strtoll(dim.c_str() + start, &end, 10);
+
+    if (*end != '\0' && *end != ' ' && *end != 'L')
+      THROW_OR_ASSERT(Exception("Invalid shape in header of " + filename));
+
+    header.shape.push_back(val);
+  }
+
+  return header;
+}
+
+std::string formatNpyHeader(const std::string &descr,
+                            const std::vector<int64_t> &shape) {
+  std::stringstream dict;
+
+  dict << "{'descr': '" << descr << "', 'fortran_order': False, 'shape': (";
+
+  for (size_t i = 0; i < shape.size(); i++)
+    dict << shape[i] << (shape.size() == 1 || i < shape.size() - 1 ? ", " : "");
+
+  dict << "), }";
+
+  // The dictionary is padded with spaces and terminated by a newline,
+  // such that the entire header has a multiple of 64 bytes
+  std::string padded = dict.str();
+  size_t preludeLen = npyMagicLen + 4;
+  size_t total = (preludeLen + padded.size() + 1 + 63) / 64 * 64;
+
+  padded.append(total - preludeLen - padded.size() - 1, ' ');
+  padded.push_back('\n');
+
+  std::string header(npyMagic, npyMagicLen);
+
+  header.push_back('\x01');
+  header.push_back('\x00');
+  header.push_back(static_cast<char>(padded.size() & 0xff));
+  header.push_back(static_cast<char>(padded.size() >> 8));
+
+  return header + padded;
+}
+
+bool npyDescrsMatch(const std::string &a, const std::string &b) {
+  // Returns the descriptor with an explicit little-endian byte order
+  // for all sizes except single bytes, which have no byte order
+  auto normalize = [](std::string d) {
+    if (!d.empty() && d[0] == '=')
+      d[0] = '<';
+
+    if (d.size() == 3 && d[2] == '1' && (d[0] == '<' || d[0] == '>'))
+      d[0] = '|';
+
+    return d;
+  };
+
+  return normalize(a) == normalize(b);
+}
+
+int64_t Tensor::getNumElements() const {
+  int64_t n = 1;
+
+  for (int64_t size : sizes)
+    n *= size;
+
+  return n;
+}
+
+} // namespace run
+} // namespace teckyl
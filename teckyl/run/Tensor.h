@@ -0,0 +1,119 @@
+#ifndef TECKYL_RUN_TENSOR_H
+#define TECKYL_RUN_TENSOR_H
+
+#include "teckyl/Exception.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace teckyl {
+namespace run {
+
+class Exception : public teckyl::Exception {
+public:
+  Exception(const std::string &msg) : teckyl::Exception(msg) {}
+};
+
+// Returns the size in bytes of the elements of the TC scalar type
+// `kind` or 0 if tensors of this type cannot be passed to kernels
+// by teckyl-run (i.e., for packed sub-byte integers)
+size_t getElementSize(int kind);
+
+// Returns the NumPy type descriptor (e.g., "<f4") for the elements of
+// the TC scalar type `kind` or an empty string if NumPy has no
+// equivalent type (e.g., for bfloat16)
+std::string getNpyDescr(int kind);
+
+// Memory holding the elements of a tensor: either a mapping of (a
+// part of) a file or an aligned allocation. Mappings are shared with
+// the file, such that writes to writable mappings end up in the file.
+class Buffer {
+public:
+  Buffer(const Buffer &) = delete;
+  Buffer &operator=(const Buffer &) = delete;
+  ~Buffer();
+
+  // Maps the entire file `filename`. The mapping is read-only unless
+  // `writable` is set.
+  static std::unique_ptr<Buffer> mapFile(const std::string &filename,
+                                         bool writable);
+
+  // Creates the file `filename` with `size` bytes (replacing any
+  // existing file) and maps it writable. The new file is filled with
+  // zeros.
+  static std::unique_ptr<Buffer> createFile(const std::string &filename,
+                                            size_t size);
+
+  // Allocates `size` bytes filled with zeros at an address aligned to
+  // `alignment` bytes, which must be a power of two
+  static std::unique_ptr<Buffer> allocate(size_t size, size_t alignment);
+
+  char *data() { return ptr; }
+  size_t size() const { return len; }
+
+private:
+  Buffer(char *ptr, size_t len, bool mapped)
+      : ptr(ptr), len(len), mapped(mapped) {}
+
+  char *ptr;
+  size_t len;
+  bool mapped;
+};
+
+// Header of a NumPy .npy file
+struct NpyHeader {
+  // Type descriptor of the elements (e.g., "<f4")
+  std::string descr;
+  bool fortranOrder;
+  std::vector<int64_t> shape;
+
+  // Offset of the first element from the start of the file
+  size_t dataOffset;
+};
+
+// Parses the header of the .npy file with the contents `data` of
+// `size` bytes. Throws an exception if the data does not start with a
+// valid header. `filename` is only used for error messages.
+NpyHeader parseNpyHeader(const char *data, size_t size,
+                         const std::string &filename);
+
+// Returns a header for a .npy file holding a C-ordered array with the
+// elements of type `descr` and the shape `shape`. The header is padded
+// to a multiple of 64 bytes, such that the elements following the
+// header in a mapping of the file are aligned to 64 bytes.
+std::string formatNpyHeader(const std::string &descr,
+                            const std::vector<int64_t> &shape);
+
+// Checks if the NumPy type descriptors `a` and `b` describe the same
+// type on the host, i.e., ignoring the byte order for single bytes
+// and treating the native byte order as little endian
+bool npyDescrsMatch(const std::string &a, const std::string &b);
+
+// A tensor passed to a kernel. The elements are stored in row-major
+// order in `data`, which points into `buffer`.
+struct Tensor {
+  // Name of the parameter or output of the kernel
+  std::string name;
+
+  // TC scalar type of the elements
+  int kind;
+
+  std::vector<int64_t> sizes;
+  char *data;
+  std::shared_ptr<Buffer> buffer;
+
+  // Inputs without dimensions are passed by value instead of through
+  // a memref
+  bool byValue;
+
+  // Returns the number of elements
+  int64_t getNumElements() const;
+};
+
+} // namespace run
+} // namespace teckyl
+
+#endif
@@ -0,0 +1,62 @@
+#include "teckyl/run/Tiered.h"
+
+namespace teckyl {
+namespace run {
+
+TieredKernel::TieredKernel(const lang::Def &def, const MLIRGenOptions &options,
+                           unsigned int optLevel)
+    : interpreter(def), compiled(nullptr), joined(false), compileTime(0),
+      numInterpreted(0) {
+  // The thread only shares the trees of the definition, which are
+  // immutable, and `jit`, `error` and `compileTime`, which are only
+  // accessed after the release of `compiled` or after joining it
+  compiler = std::thread([this, def, options, optLevel]() {
+    auto start = std::chrono::steady_clock::now();
+
+#ifdef COMPILE_WITH_EXCEPTIONS
+    try {
+#endif
+      jit.reset(new JitKernel(def, options, optLevel));
+#ifdef COMPILE_WITH_EXCEPTIONS
+    } catch (teckyl::Exception &e) {
+      error = e.getMessage();
+    }
+#endif
+
+    compileTime = std::chrono::steady_clock::now() - start;
+
+    if (jit)
+      compiled.store(jit.get(), std::memory_order_release);
+  });
+}
+
+TieredKernel::~TieredKernel() {
+  if (!joined)
+    compiler.join();
+}
+
+void TieredKernel::waitForCompilation() {
+  if (!joined) {
+    compiler.join();
+    joined = true;
+  }
+
+  if (!jit)
+    THROW_OR_ASSERT(Exception(error));
+}
+
+void TieredKernel::invoke(const std::vector<Tensor> &tensors,
+                          PackedArgs &args) {
+  if (JitKernel *k = compiled.load(std::memory_order_acquire)) {
+    k->invoke(args);
+  } else if (interpreter.isSupported()) {
+    interpreter.invoke(tensors);
+    numInterpreted++;
+  } else {
+    waitForCompilation();
+    jit->invoke(args);
+  }
+}
+
+} // namespace run
+} // namespace teckyl
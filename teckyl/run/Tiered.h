@@ -0,0 +1,80 @@
+#ifndef TECKYL_RUN_TIERED_H
+#define TECKYL_RUN_TIERED_H
+
+#include "teckyl/MLIRGen.h"
+#include "teckyl/run/Interpreter.h"
+#include "teckyl/run/Jit.h"
+
+#include "teckyl/tc/lang/tree_views.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace teckyl {
+namespace run {
+
+// A kernel that can be invoked immediately after its construction: the
+// kernel is compiled by a JitKernel on a background thread and
+// executed by the Interpreter until the compilation has finished,
+// after which all invocations use the compiled code.
+//
+// Kernels not supported by the interpreter wait for the compilation
+// upon their first invocation.
+class TieredKernel {
+public:
+  // Starts the compilation of the TC definition `def`, which must have
+  // been checked by the semantic analysis, with the code generation
+  // options `options` and the LLVM optimization level `optLevel`
+  TieredKernel(const lang::Def &def, const MLIRGenOptions &options,
+               unsigned int optLevel);
+  ~TieredKernel();
+
+  TieredKernel(const TieredKernel &) = delete;
+  TieredKernel &operator=(const TieredKernel &) = delete;
+
+  // Executes the kernel on `tensors` with the arguments `args` packed
+  // for the same tensors. Must not be called concurrently from
+  // multiple threads. Throws an exception if the kernel must be
+  // compiled for this invocation and the compilation failed.
+  void invoke(const std::vector<Tensor> &tensors, PackedArgs &args);
+
+  // Checks if the compilation has finished successfully
+  bool isCompiled() const { return compiled.load() != nullptr; }
+
+  // Waits until the compilation has finished and throws an exception
+  // if it failed
+  void waitForCompilation();
+
+  // Returns the duration of the compilation, which must have finished
+  std::chrono::duration<double> getCompileTime() const { return compileTime; }
+
+  // Returns the number of invocations executed by the interpreter
+  size_t getNumInterpreted() const { return numInterpreted; }
+
+  const Interpreter &getInterpreter() const { return interpreter; }
+
+private:
+  Interpreter interpreter;
+
+  // Set by the compiler thread once `jit` has been constructed
+  std::unique_ptr<JitKernel> jit;
+  std::atomic<JitKernel *> compiled;
+
+  std::thread compiler;
+  bool joined;
+
+  // Written by the compiler thread, read after joining it
+  std::string error;
+  std::chrono::duration<double> compileTime;
+
+  size_t numInterpreted;
+};
+
+} // namespace run
+} // namespace teckyl
+
+#endif
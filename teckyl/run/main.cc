@@ -0,0 +1,663 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+
+#include "teckyl/tc/lang/parser.h"
+#include "teckyl/tc/lang/sema.h"
+#include <llvm/Support/CommandLine.h>
+
+#include "teckyl/MLIRGen.h"
+#include "teckyl/TuningDB.h"
+#include "teckyl/lang_calls.h"
+#include "teckyl/lang_extras.h"
+#include "teckyl/lang_layout.h"
+#include "teckyl/run/Interpreter.h"
+#include "teckyl/run/Jit.h"
+#include "teckyl/run/Tensor.h"
+#include "teckyl/run/Tiered.h"
+
+// Commandline options
+static llvm::cl::opt<std::string>
+    inputFilename(llvm::cl::Positional, llvm::cl::desc("<input file>"),
+                  llvm::cl::init("-"), llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string>
+    kernelName("kernel", llvm::cl::desc("Name of the kernel to execute"),
+               llvm::cl::init(""), llvm::cl::value_desc("name"));
+
+static llvm::cl::list<std::string> inputs(
+    "input",
+    llvm::cl::desc("Input NAME=FILE for the parameter NAME, mapped from a "
+                   ".npy file or a file with the raw elements in row-major "
+                   "order; parameters without dimensions take a value "
+                   "(NAME=VALUE)"),
+    llvm::cl::value_desc("assignment"));
+
+static llvm::cl::list<std::string> outputs(
+    "output",
+    llvm::cl::desc("Write the output NAME to FILE (NAME=FILE), as a .npy "
+                   "file if FILE ends with .npy and as raw elements "
+                   "otherwise"),
+    llvm::cl::value_desc("assignment"));
+
+static llvm::cl::opt<std::string> shapeSpec(
+    "shape",
+    llvm::cl::desc("Sizes of the size parameters not determined by .npy "
+                   "inputs (e.g., M=512,N=256)"),
+    llvm::cl::init(""), llvm::cl::value_desc("sizes"));
+
+static llvm::cl::opt<unsigned int> repetitions(
+    "repetitions",
+    llvm::cl::desc("Number of timed executions of the kernel"),
+    llvm::cl::init(10), llvm::cl::value_desc("n"));
+
+static llvm::cl::opt<unsigned int>
+    warmup("warmup",
+           llvm::cl::desc("Number of untimed executions before the timed "
+                          "executions"),
+           llvm::cl::init(1), llvm::cl::value_desc("n"));
+
+static llvm::cl::opt<unsigned int>
+    optLevel("O", llvm::cl::desc("LLVM optimization level (0 to 3)"),
+             llvm::cl::init(3), llvm::cl::Prefix,
+             llvm::cl::value_desc("level"));
+
+enum class Tier { Jit, Interpreter, Tiered };
+
+static llvm::cl::opt<Tier> tier(
+    "tier", llvm::cl::desc("Select how the kernel is executed"),
+    llvm::cl::init(Tier::Jit),
+    llvm::cl::values(clEnumValN(Tier::Jit, "jit",
+                                "Compile the kernel before executing it")),
+    llvm::cl::values(clEnumValN(Tier::Interpreter, "interpreter",
+                                "Execute the kernel with the interpreter "
+                                "without compiling it")),
+    llvm::cl::values(clEnumValN(Tier::Tiered, "tiered",
+                                "Execute the kernel with the interpreter "
+                                "while it is compiled in the background")));
+
+static llvm::cl::opt<unsigned int> maxInterpreted(
+    "max-interpreted",
+    llvm::cl::desc("With -tier=tiered, wait for the compilation after the "
+                   "given number of interpreted executions (default: no "
+                   "limit)"),
+    llvm::cl::init(std::numeric_limits<unsigned int>::max()),
+    llvm::cl::value_desc("n"));
+
+static llvm::cl::opt<teckyl::MLIRGenOptions::BodyOp> bodyOp(
+    "body-op",
+    llvm::cl::desc("Select the operation used for the body of computations"),
+    llvm::cl::init(teckyl::MLIRGenOptions::BodyOp::ScfFor),
+    llvm::cl::values(clEnumValN(teckyl::MLIRGenOptions::BodyOp::LinalgGeneric,
+                                "linalg.generic", "Linalg.generic")),
+    llvm::cl::values(clEnumValN(teckyl::MLIRGenOptions::BodyOp::ScfFor,
+                                "scf.for",
+                                "Sets of nested instances of Scf.for")));
+
+static llvm::cl::opt<bool> specializeLinalgOps(
+    "specialize-linalg-ops",
+    llvm::cl::desc("Use structured Ops from the linalg dialect for common "
+                   "operation (e.g., matrix multiplications)"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> assumeNoalias(
+    "assume-noalias",
+    llvm::cl::desc("Assume that the tensors passed to the kernel do not "
+                   "alias"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> tuningDB(
+    "tuning-db",
+    llvm::cl::desc("Use the configuration recorded for the kernel, the "
+                   "shape of the inputs and the host CPU in the given "
+                   "tuning database (see teckyl-tune)"),
+    llvm::cl::init(""), llvm::cl::value_desc("filename"));
+
+using teckyl::run::Exception;
+using teckyl::run::Tensor;
+using teckyl::run::getElementSize;
+
+// Alignment in bytes of the buffers allocated for outputs
+static const size_t bufferAlignment = 64;
+
+// Reads an entire file into a string
+std::string readFile(const std::string &filename) {
+  std::ifstream ifs(filename);
+
+  if (!ifs.good())
+    THROW_OR_ASSERT(Exception("Could not open file " + filename));
+
+  return std::string((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+}
+
+// Parses a string with TCs and returns a map with one entry for each
+// kernel, composed of the kernel's name and its AST.
+std::map<std::string, lang::Def> parse(const std::string &tc,
+                                       const std::string &filename) {
+  lang::Parser parser(tc, filename);
+  std::map<std::string, lang::Def> parsed;
+
+  while (parser.L.cur().kind != lang::TK_EOF) {
+    auto t = parser.parseFunction();
+    auto def = lang::Def(t);
+    auto name = def.name().name();
+    parsed.emplace(std::make_pair(name, def));
+  }
+
+  return parsed;
+}
+
+// Parses the assignments "NAME=VALUE" from `list` into a map. Throws
+// an exception for invalid or duplicate assignments.
+std::map<std::string, std::string>
+parseAssignments(const std::vector<std::string> &list) {
+  std::map<std::string, std::string> res;
+
+  for (const std::string &str : list) {
+    size_t pos = str.find('=');
+
+    if (pos == std::string::npos || pos == 0 || pos == str.size() - 1)
+      THROW_OR_ASSERT(Exception("Invalid assignment '" + str + "'"));
+
+    if (!res.emplace(str.substr(0, pos), str.substr(pos + 1)).second) {
+      THROW_OR_ASSERT(
+          Exception("Multiple assignments to '" + str.substr(0, pos) + "'"));
+    }
+  }
+
+  return res;
+}
+
+// Checks if `str` ends with `suffix`
+bool endsWith(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Checks that tensors of the type of `param` can be passed to kernels
+// by teckyl-run
+void checkSupportedType(const lang::Param &param) {
+  lang::TensorType type = param.tensorType();
+  const std::string &name = param.ident().name();
+
+  if (getElementSize(type.scalarType()) == 0) {
+    THROW_OR_ASSERT(Exception("Element type of " + name +
+                              " is not supported by teckyl-run"));
+  }
+
+  if (!teckyl::layout::isRowMajor(teckyl::layout::getLayout(type))) {
+    THROW_OR_ASSERT(
+        Exception("Layout of " + name + " is not supported by teckyl-run"));
+  }
+}
+
+// Binds the size parameters among the dimensions of `param` to the
+// sizes `sizes` in `shape` and checks the sizes of constant
+// dimensions and of size parameters that are already bound. Throws
+// an exception on mismatch.
+void bindSizes(const lang::Param &param, const std::vector<int64_t> &sizes,
+               teckyl::tuning::Shape &shape) {
+  lang::ListView<lang::TreeRef> dims = param.tensorType().dims();
+  const std::string &name = param.ident().name();
+
+  if (dims.size() != sizes.size()) {
+    THROW_OR_ASSERT(Exception(
+        name + " has " + std::to_string(sizes.size()) +
+        " dimensions instead of " + std::to_string(dims.size())));
+  }
+
+  for (size_t i = 0; i < dims.size(); i++) {
+    uint64_t expected;
+
+    if (dims[i]->kind() == lang::TK_IDENT) {
+      const std::string &sizeParam = lang::Ident(dims[i]).name();
+      auto it = shape.emplace(sizeParam, sizes[i]).first;
+
+      expected = it->second;
+    } else {
+      expected = lang::Const(dims[i]).value<uint64_t>();
+    }
+
+    if ((uint64_t)sizes[i] != expected) {
+      THROW_OR_ASSERT(Exception(
+          "Dimension " + std::to_string(i) + " of " + name + " has size " +
+          std::to_string(sizes[i]) + " instead of " +
+          std::to_string(expected)));
+    }
+  }
+}
+
+// Returns the sizes of the dimensions of `param` for the sizes of the
+// size parameters from `shape`. Throws an exception if a size is
+// unknown.
+std::vector<int64_t> getSizes(const lang::Param &param,
+                              const teckyl::tuning::Shape &shape) {
+  std::vector<int64_t> sizes;
+
+  for (const lang::TreeRef &dim : param.tensorType().dims()) {
+    if (dim->kind() == lang::TK_IDENT) {
+      const std::string &sizeParam = lang::Ident(dim).name();
+      auto it = shape.find(sizeParam);
+
+      if (it == shape.end()) {
+        THROW_OR_ASSERT(Exception("Size of " + sizeParam + " for " +
+                                  param.ident().name() +
+                                  " unknown (see -shape)"));
+      }
+
+      sizes.push_back(it->second);
+    } else {
+      sizes.push_back(lang::Const(dim).value<uint64_t>());
+    }
+  }
+
+  return sizes;
+}
+
+// Returns a tensor for the input parameter `param` without
+// dimensions holding the value `value`
+Tensor makeScalarInput(const lang::Param &param, const std::string &value) {
+  int kind = param.tensorType().scalarType();
+  size_t size = getElementSize(kind);
+  std::shared_ptr<teckyl::run::Buffer> buffer =
+      teckyl::run::Buffer::allocate(size, bufferAlignment);
+  char *end;
+
+  errno = 0;
+
+  if (teckyl::isFloatType(kind)) {
+    double d = strtod(value.c_str(), &end);
+
+    if (kind == lang::TK_FLOAT64) {
+      memcpy(buffer->data(), &d, sizeof(d));
+    } else if (size == sizeof(float)) {
+      float f = d;
+      memcpy(buffer->data(), &f, sizeof(f));
+    } else {
+      THROW_OR_ASSERT(Exception("Values of the type of " +
+                                param.ident().name() +
+                                " are not supported by teckyl-run"));
+    }
+  } else if (teckyl::isUnsignedIntType(kind) || kind == lang::TK_SIZET) {
+    uint64_t u = strtoull(value.c_str(), &end, 0);
+    memcpy(buffer->data(), &u, size);
+  } else {
+    int64_t i = strtoll(value.c_str(), &end, 0);
+    memcpy(buffer->data(), &i, size);
+  }
+
+  if (errno || *end != '\0' || value.empty()) {
+    THROW_OR_ASSERT(Exception("Invalid value '" + value + "' for " +
+                              param.ident().name()));
+  }
+
+  return Tensor{param.ident().name(), kind, {}, buffer->data(), buffer,
+                true};
+}
+
+// Maps the .npy file `filename` for the input parameter `param`
+// without copying the elements and binds the size parameters of
+// `param` to the shape of the array in `shape`
+Tensor mapNpyInput(const lang::Param &param, const std::string &filename,
+                   teckyl::tuning::Shape &shape) {
+  int kind = param.tensorType().scalarType();
+  std::shared_ptr<teckyl::run::Buffer> buffer =
+      teckyl::run::Buffer::mapFile(filename, false);
+  teckyl::run::NpyHeader header =
+      teckyl::run::parseNpyHeader(buffer->data(), buffer->size(), filename);
+  std::string descr = teckyl::run::getNpyDescr(kind);
+
+  if (descr.empty() || !teckyl::run::npyDescrsMatch(header.descr, descr)) {
+    THROW_OR_ASSERT(Exception("Type '" + header.descr + "' of " + filename +
+                              " does not match the type of " +
+                              param.ident().name()));
+  }
+
+  if (header.fortranOrder) {
+    THROW_OR_ASSERT(
+        Exception(filename + " is in Fortran order; only C order is "
+                             "supported"));
+  }
+
+  bindSizes(param, header.shape, shape);
+
+  Tensor t{param.ident().name(), kind, header.shape,
+           buffer->data() + header.dataOffset, buffer, false};
+
+  if (header.dataOffset + t.getNumElements() * getElementSize(t.kind) >
+      buffer->size()) {
+    THROW_OR_ASSERT(Exception(filename + " is truncated"));
+  }
+
+  return t;
+}
+
+// Maps the file `filename` with the raw elements of the input
+// parameter `param`, whose sizes must be known from `shape`
+Tensor mapRawInput(const lang::Param &param, const std::string &filename,
+                   const teckyl::tuning::Shape &shape) {
+  int kind = param.tensorType().scalarType();
+  std::shared_ptr<teckyl::run::Buffer> buffer =
+      teckyl::run::Buffer::mapFile(filename, false);
+  Tensor t{param.ident().name(), kind, getSizes(param, shape),
+           buffer->data(), buffer, false};
+
+  if (t.getNumElements() * getElementSize(t.kind) != buffer->size()) {
+    THROW_OR_ASSERT(Exception("Size of " + filename +
+                              " does not match the size of " +
+                              param.ident().name()));
+  }
+
+  return t;
+}
+
+// Returns a zero-initialized tensor for the output `param`, whose
+// sizes must be known from `shape`. If `filename` is not empty, the
+// tensor is a writable mapping of the newly created file `filename`,
+// such that the kernel writes its results directly into the file;
+// otherwise the tensor is allocated in memory.
+Tensor makeOutput(const lang::Param &param, const std::string &filename,
+                  const teckyl::tuning::Shape &shape) {
+  int kind = param.tensorType().scalarType();
+  Tensor t{param.ident().name(), kind, getSizes(param, shape), nullptr,
+           nullptr, false};
+  size_t bytes = t.getNumElements() * getElementSize(t.kind);
+  std::string header;
+
+  if (filename.empty()) {
+    t.buffer = teckyl::run::Buffer::allocate(bytes, bufferAlignment);
+    t.data = t.buffer->data();
+    return t;
+  }
+
+  if (endsWith(filename, ".npy")) {
+    std::string descr = teckyl::run::getNpyDescr(kind);
+
+    if (descr.empty()) {
+      THROW_OR_ASSERT(Exception("The type of " + param.ident().name() +
+                                " has no equivalent in .npy files"));
+    }
+
+    header = teckyl::run::formatNpyHeader(descr, t.sizes);
+  }
+
+  t.buffer = teckyl::run::Buffer::createFile(filename, header.size() + bytes);
+  std::copy(header.begin(), header.end(), t.buffer->data());
+  t.data = t.buffer->data() + header.size();
+
+  return t;
+}
+
+// Returns the `p`-th percentile of the sorted samples `samples` with
+// the nearest-rank method
+double getPercentile(const std::vector<double> &samples, double p) {
+  size_t rank = std::ceil(p / 100.0 * samples.size());
+
+  return samples[std::max<size_t>(rank, 1) - 1];
+}
+
+// Prints a line of the report with the time `ms` in milliseconds
+void printTime(const std::string &label, double ms) {
+  std::cout << "  " << std::left << std::setw(10) << label << std::right
+            << std::fixed << std::setprecision(3) << std::setw(12) << ms
+            << " ms" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv,
+      "teckyl-run: compiles a kernel at runtime and measures its execution "
+      "time on tensors from files\n");
+
+#ifdef COMPILE_WITH_EXCEPTIONS
+  try {
+#endif // COMPILE_WITH_EXCEPTIONS
+    std::map<std::string, lang::Def> tcs = teckyl::calls::inlineCalls(
+        parse(readFile(inputFilename), inputFilename));
+
+    if (kernelName.empty() && tcs.size() == 1)
+      kernelName = tcs.begin()->first;
+
+    auto kernelIt = tcs.find(kernelName);
+
+    if (kernelIt == tcs.end())
+      THROW_OR_ASSERT(Exception("Unknown kernel '" + kernelName + "'"));
+
+    const lang::Def &def = kernelIt->second;
+    std::map<std::string, std::string> inputFiles = parseAssignments(inputs);
+    std::map<std::string, std::string> outputFiles =
+        parseAssignments(outputs);
+    teckyl::tuning::Shape shape = teckyl::tuning::parseShape(shapeSpec);
+    std::vector<Tensor> tensors;
+
+    for (const lang::Param &param : def.params()) {
+      checkSupportedType(param);
+
+      if (!inputFiles.count(param.ident().name())) {
+        THROW_OR_ASSERT(
+            Exception("No input for parameter " + param.ident().name()));
+      }
+    }
+
+    for (const lang::Param &param : def.returns())
+      checkSupportedType(param);
+
+    // The shapes of .npy inputs determine the sizes of the size
+    // parameters of raw inputs and outputs
+    std::map<std::string, Tensor> npyInputs;
+
+    for (const lang::Param &param : def.params()) {
+      const std::string &name = param.ident().name();
+      const std::string &filename = inputFiles.at(name);
+
+      if (param.tensorType().dims().size() > 0 && endsWith(filename, ".npy"))
+        npyInputs.emplace(name, mapNpyInput(param, filename, shape));
+    }
+
+    for (const lang::Param &param : def.params()) {
+      const std::string &name = param.ident().name();
+      const std::string &arg = inputFiles.at(name);
+
+      if (param.tensorType().dims().size() == 0)
+        tensors.push_back(makeScalarInput(param, arg));
+      else if (npyInputs.count(name))
+        tensors.push_back(npyInputs.at(name));
+      else
+        tensors.push_back(mapRawInput(param, arg, shape));
+    }
+
+    for (const lang::Param &param : def.returns()) {
+      auto it = outputFiles.find(param.ident().name());
+
+      tensors.push_back(makeOutput(
+          param, it != outputFiles.end() ? it->second : "", shape));
+      outputFiles.erase(param.ident().name());
+    }
+
+    if (!outputFiles.empty()) {
+      THROW_OR_ASSERT(
+          Exception("Unknown output '" + outputFiles.begin()->first + "'"));
+    }
+
+    teckyl::MLIRGenOptions options;
+
+    options.body_op = bodyOp;
+    options.specialize_linalg_ops = specializeLinalgOps;
+    options.contraction_backend =
+        teckyl::MLIRGenOptions::ContractionBackend::Linalg;
+    options.accumulation_type =
+        teckyl::MLIRGenOptions::AccumulationType::Output;
+    options.assume_noalias = assumeNoalias;
+    options.assume_aligned = 0;
+    options.nontemporal_threshold = 0;
+    options.prefetch_distance = 0;
+    options.dynamic_strides = false;
+    options.instrument = false;
+    options.emit_tc_dialect = false;
+
+    if (!tuningDB.empty()) {
+      teckyl::tuning::Database db;
+      std::string shapeKey = teckyl::tuning::getShapeKey(def, shape);
+
+      db.load(tuningDB);
+
+      const teckyl::tuning::Config *config =
+          db.lookup(teckyl::tuning::getKernelHash(def),
+                    teckyl::tuning::getHostCPU(), shapeKey);
+
+      if (config)
+        teckyl::tuning::applyConfig(*config, options);
+
+      // Kernels are not linked with the runtime libraries for
+      // library calls
+      options.contraction_backend =
+          teckyl::MLIRGenOptions::ContractionBackend::Linalg;
+    }
+
+    lang::Sema sema;
+    lang::Def checked(sema.checkFunction(def));
+
+    teckyl::run::PackedArgs args(tensors);
+    std::unique_ptr<teckyl::run::JitKernel> jit;
+    std::unique_ptr<teckyl::run::Interpreter> interpreter;
+    std::unique_ptr<teckyl::run::TieredKernel> tiered;
+
+    auto setupStart = std::chrono::steady_clock::now();
+
+    switch (tier) {
+    case Tier::Jit:
+      jit.reset(new teckyl::run::JitKernel(checked, options, optLevel));
+      break;
+    case Tier::Interpreter:
+      interpreter.reset(new teckyl::run::Interpreter(checked));
+
+      if (!interpreter->isSupported()) {
+        THROW_OR_ASSERT(Exception("Cannot interpret kernel " + kernelName +
+                                  ": " +
+                                  interpreter->getUnsupportedReason()));
+      }
+
+      break;
+    case Tier::Tiered:
+      tiered.reset(new teckyl::run::TieredKernel(checked, options, optLevel));
+      break;
+    }
+
+    auto setupEnd = std::chrono::steady_clock::now();
+    auto firstEnd = setupEnd;
+    std::vector<double> samples;
+
+    auto invoke = [&]() {
+      if (jit) {
+        jit->invoke(args);
+      } else if (interpreter) {
+        interpreter->invoke(tensors);
+      } else {
+        if (tiered->getNumInterpreted() >= maxInterpreted)
+          tiered->waitForCompilation();
+
+        tiered->invoke(tensors, args);
+      }
+    };
+
+    // Outputs are zero-initialized before each execution, such that
+    // kernels updating their outputs (e.g., C(i) += A(i)) produce the
+    // result of a single execution
+    unsigned int numExecuted = 0;
+
+    auto resetOutputs = [&]() {
+      if (numExecuted++ == 0)
+        return;
+
+      for (size_t i = def.params().size(); i < tensors.size(); i++) {
+        const Tensor &t = tensors[i];
+        memset(t.data, 0, t.getNumElements() * getElementSize(t.kind));
+      }
+    };
+
+    for (unsigned int i = 0; i < warmup; i++) {
+      resetOutputs();
+      invoke();
+
+      if (i == 0)
+        firstEnd = std::chrono::steady_clock::now();
+    }
+
+    for (unsigned int i = 0; i < repetitions; i++) {
+      resetOutputs();
+
+      auto start = std::chrono::steady_clock::now();
+      invoke();
+      auto end = std::chrono::steady_clock::now();
+
+      if (i == 0 && warmup == 0)
+        firstEnd = end;
+
+      samples.push_back(
+          std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    std::cout << "kernel " << kernelName << std::endl;
+
+    if (jit) {
+      printTime("compile", std::chrono::duration<double, std::milli>(
+                               setupEnd - setupStart)
+                               .count());
+    } else if (tiered) {
+      // Reports errors of the compilation even if all executions
+      // have been interpreted
+      tiered->waitForCompilation();
+
+      printTime("compile", std::chrono::duration<double, std::milli>(
+                               tiered->getCompileTime())
+                               .count());
+      std::cout << "  interpret " << std::setw(12)
+                << tiered->getNumInterpreted() << std::endl;
+    }
+
+    if (warmup + repetitions > 0) {
+      printTime("first", std::chrono::duration<double, std::milli>(
+                             firstEnd - setupStart)
+                             .count());
+    }
+
+    if (!samples.empty()) {
+      double sum = 0;
+
+      for (double s : samples)
+        sum += s;
+
+      std::cout << "  runs      " << std::setw(12) << samples.size()
+                << std::endl;
+      printTime("min", samples.front());
+      printTime("p50", getPercentile(samples, 50));
+      printTime("p90", getPercentile(samples, 90));
+      printTime("p99", getPercentile(samples, 99));
+      printTime("max", samples.back());
+      printTime("mean", sum / samples.size());
+    }
+
+#ifdef COMPILE_WITH_EXCEPTIONS
+  } catch (teckyl::Exception &e) {
+    std::cerr << "Error: " << e.getMessage() << std::endl;
+    return 1;
+  } catch (lang::ErrorReport &r) {
+    std::cerr << "Error: " << r.what() << std::endl;
+    return 1;
+  } catch (...) {
+    std::cerr << "An unknown error has occured." << std::endl;
+    return 1;
+  }
+#endif // COMPILE_WITH_EXCEPTIONS
+}
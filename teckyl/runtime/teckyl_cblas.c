@@ -0,0 +1,177 @@
+/* Thin wrappers around CBLAS for the contractions lowered to library
+ * calls by teckyl with --contraction-backend=cblas.
+ *
+ * The generated code passes all tensors as memrefs with a fully
+ * dynamic strided layout (see teckyl_memref.h). The transposition
+ * flags and leading dimensions for the BLAS calls are derived from
+ * the strides. Operands whose strides cannot be expressed in terms
+ * of BLAS arguments are handled by a naive fallback implementation.
+ */
+
+#include "teckyl_memref.h"
+
+#include <cblas.h>
+#include <limits.h>
+#include <stdint.h>
+
+static inline int64_t max_i64(int64_t a, int64_t b)
+{
+	return (a > b) ? a : b;
+}
+
+/* Checks if all values fit into the integer type used for sizes,
+ * leading dimensions and increments by CBLAS */
+static int fits_blas_int(int64_t a, int64_t b, int64_t c)
+{
+	return a <= INT_MAX && b <= INT_MAX && c <= INT_MAX;
+}
+
+/* Determines the transposition flag and the leading dimension for a
+ * rows x cols matrix with the given strides for a CBLAS call using
+ * the storage order `order`. Returns 1 on success or 0 if the matrix
+ * cannot be described with a transposition flag and a leading
+ * dimension. */
+static int blas_layout(enum CBLAS_ORDER order, int64_t rows, int64_t cols,
+		       int64_t stride0, int64_t stride1,
+		       enum CBLAS_TRANSPOSE *trans, int64_t *ld)
+{
+	int rowmajor = (order == CblasRowMajor);
+	int64_t minor = rowmajor ? stride1 : stride0;
+	int64_t major = rowmajor ? stride0 : stride1;
+	int64_t minor_size = rowmajor ? cols : rows;
+	int64_t major_size = rowmajor ? rows : cols;
+
+	if(minor == 1 && major >= max_i64(1, minor_size)) {
+		*trans = CblasNoTrans;
+		*ld = major;
+	} else if(major == 1 && minor >= max_i64(1, major_size)) {
+		*trans = CblasTrans;
+		*ld = minor;
+	} else {
+		return 0;
+	}
+
+	return fits_blas_int(rows, cols, *ld);
+}
+
+/* Defines _teckyl_cblas_<prefix>gemm, calculating
+ *
+ *   C(i, j) = sum_k A(i, k) * B(k, j) + beta * C(i, j)
+ *
+ * with the CBLAS function blas_fn */
+#define DEFINE_TECKYL_GEMM(prefix, eltype, blas_fn)			\
+  void _teckyl_cblas_##prefix##gemm(TECKYL_MEMREF2D_ARGS(a, const eltype), \
+				    TECKYL_MEMREF2D_ARGS(b, const eltype), \
+				    TECKYL_MEMREF2D_ARGS(c, eltype),	\
+				    eltype beta)			\
+  {									\
+	const eltype *a = a_alignedPtr + a_offset;			\
+	const eltype *b = b_alignedPtr + b_offset;			\
+	eltype *c = c_alignedPtr + c_offset;				\
+	int64_t m = c_size0, n = c_size1, k = a_size1;			\
+	enum CBLAS_ORDER order = CblasRowMajor;				\
+	enum CBLAS_TRANSPOSE ta, tb, tc;				\
+	int64_t lda, ldb, ldc;						\
+									\
+	if(m == 0 || n == 0)						\
+		return;							\
+									\
+	/* Implementations may return early for k == 0 without	\
+	 * scaling or clearing the output */				\
+	if(k == 0)							\
+		goto fallback;						\
+									\
+	/* The output must be stored without transposition; choose	\
+	 * the storage order accordingly */				\
+	if(!blas_layout(order, m, n, c_stride0, c_stride1, &tc, &ldc) || \
+	   tc != CblasNoTrans) {					\
+		order = CblasColMajor;					\
+									\
+		if(!blas_layout(order, m, n, c_stride0, c_stride1,	\
+				&tc, &ldc) ||				\
+		   tc != CblasNoTrans)					\
+			goto fallback;					\
+	}								\
+									\
+	if(!blas_layout(order, m, k, a_stride0, a_stride1, &ta, &lda) || \
+	   !blas_layout(order, k, n, b_stride0, b_stride1, &tb, &ldb))	\
+		goto fallback;						\
+									\
+	blas_fn(order, ta, tb, m, n, k, 1, a, lda, b, ldb, beta, c, ldc); \
+	return;								\
+									\
+  fallback:								\
+	for(int64_t i = 0; i < m; i++) {				\
+		for(int64_t j = 0; j < n; j++) {			\
+			eltype *pc = &c[i * c_stride0 + j * c_stride1];	\
+			eltype accu = (beta == 0) ? 0 : beta * *pc;	\
+									\
+			for(int64_t l = 0; l < k; l++)			\
+				accu += a[i * a_stride0 + l * a_stride1] * \
+					b[l * b_stride0 + j * b_stride1]; \
+									\
+			*pc = accu;					\
+		}							\
+	}								\
+  }
+
+/* Defines _teckyl_cblas_<prefix>gemv, calculating
+ *
+ *   y(i) = sum_k A(i, k) * x(k) + beta * y(i)
+ *
+ * with the CBLAS function blas_fn */
+#define DEFINE_TECKYL_GEMV(prefix, eltype, blas_fn)			\
+  void _teckyl_cblas_##prefix##gemv(TECKYL_MEMREF2D_ARGS(a, const eltype), \
+				    TECKYL_MEMREF1D_ARGS(x, const eltype), \
+				    TECKYL_MEMREF1D_ARGS(y, eltype),	\
+				    eltype beta)			\
+  {									\
+	const eltype *a = a_alignedPtr + a_offset;			\
+	const eltype *x = x_alignedPtr + x_offset;			\
+	eltype *y = y_alignedPtr + y_offset;				\
+	int64_t m = y_size0, k = a_size1;				\
+	enum CBLAS_TRANSPOSE ta;					\
+	int64_t lda;							\
+									\
+	if(m == 0)							\
+		return;							\
+									\
+	/* cblas_?gemv returns without writing y for k == 0, even if	\
+	 * beta is 0 */							\
+	if(k == 0)							\
+		goto fallback;						\
+									\
+	if(!blas_layout(CblasRowMajor, m, k, a_stride0, a_stride1,	\
+			&ta, &lda) ||					\
+	   x_stride0 <= 0 || y_stride0 <= 0 ||				\
+	   !fits_blas_int(x_stride0, y_stride0, 0))			\
+		goto fallback;						\
+									\
+	/* For transposed matrices, the dimensions refer to the	\
+	 * matrix as stored in memory */				\
+	if(ta == CblasNoTrans)						\
+		blas_fn(CblasRowMajor, ta, m, k, 1, a, lda,		\
+			x, x_stride0, beta, y, y_stride0);		\
+	else								\
+		blas_fn(CblasRowMajor, ta, k, m, 1, a, lda,		\
+			x, x_stride0, beta, y, y_stride0);		\
+									\
+	return;								\
+									\
+  fallback:								\
+	for(int64_t i = 0; i < m; i++) {				\
+		eltype *py = &y[i * y_stride0];				\
+		eltype accu = (beta == 0) ? 0 : beta * *py;		\
+									\
+		for(int64_t l = 0; l < k; l++)				\
+			accu += a[i * a_stride0 + l * a_stride1] *	\
+				x[l * x_stride0];			\
+									\
+		*py = accu;						\
+	}								\
+  }
+
+DEFINE_TECKYL_GEMM(s, float, cblas_sgemm)
+DEFINE_TECKYL_GEMM(d, double, cblas_dgemm)
+DEFINE_TECKYL_GEMV(s, float, cblas_sgemv)
+DEFINE_TECKYL_GEMV(d, double, cblas_dgemv)
@@ -0,0 +1,29 @@
+/* Parameter lists for memrefs passed to the runtime libraries by
+ * generated code. After conversion to the LLVM dialect, each 1d
+ * memref argument is expanded into the parameters (allocatedPtr,
+ * alignedPtr, offset, size0, stride0) and each 2d memref into
+ * (allocatedPtr, alignedPtr, offset, size0, size1, stride0,
+ * stride1). */
+
+#ifndef TECKYL_MEMREF_H
+#define TECKYL_MEMREF_H
+
+#include <stdint.h>
+
+#define TECKYL_MEMREF1D_ARGS(prefix, eltype)		\
+  eltype *prefix##_allocatedPtr,			\
+    eltype *prefix##_alignedPtr,			\
+    int64_t prefix##_offset,				\
+    int64_t prefix##_size0,				\
+    int64_t prefix##_stride0
+
+#define TECKYL_MEMREF2D_ARGS(prefix, eltype)		\
+  eltype *prefix##_allocatedPtr,			\
+    eltype *prefix##_alignedPtr,			\
+    int64_t prefix##_offset,				\
+    int64_t prefix##_size0,				\
+    int64_t prefix##_size1,				\
+    int64_t prefix##_stride0,				\
+    int64_t prefix##_stride1
+
+#endif /* TECKYL_MEMREF_H */
@@ -0,0 +1,32 @@
+/* Cycle counter for the profiling instrumentation emitted by teckyl
+ * with --instrument.
+ *
+ * Instrumented functions read the counter before and after each
+ * comprehension. On x86, the time stamp counter is used; on other
+ * architectures, the counter falls back to the monotonic clock in
+ * nanoseconds.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+int64_t _teckyl_prof_cycles(void)
+{
+	return (int64_t)__rdtsc();
+}
+#else
+#include <time.h>
+
+int64_t _teckyl_prof_cycles(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
@@ -0,0 +1,364 @@
+/* GEMM and GEMV drivers of the teckyl-rt runtime library and the
+ * entry points called by code generated with
+ * --contraction-backend=teckyl-rt.
+ *
+ * The entry points take memrefs with a fully dynamic strided layout
+ * (see teckyl_memref.h) and calculate
+ *
+ *   C(i, j) = sum_k A(i, k) * B(k, j) + beta * C(i, j)   (GEMM)
+ *   y(i) = sum_k A(i, k) * x(k) + beta * y(i)             (GEMV)
+ *
+ * for float, double and int8 operands. For int8, the products are
+ * calculated and accumulated with 32 bits and the output is a tensor
+ * of 32-bit integers. The C operand is not read if beta is zero.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "teckyl_memref.h"
+#include "teckyl_rt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Allocates a panel of `n` elements of `size` bytes each. Returns
+ * NULL on failure. */
+static void *alloc_panel(size_t n, size_t size)
+{
+	void *p;
+
+	if(posix_memalign(&p, TECKYL_RT_PANEL_ALIGN, n * size))
+		return NULL;
+
+	return p;
+}
+
+static inline int64_t min_i64(int64_t a, int64_t b)
+{
+	return (a < b) ? a : b;
+}
+
+/* Selects the kernels for the most capable instruction set supported
+ * by the executing CPU (or the one requested via TECKYL_RT_ISA) */
+static const struct teckyl_rt_kernels *select_kernels(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	const char *isa = getenv("TECKYL_RT_ISA");
+	int has_avx512, has_avx2;
+
+	__builtin_cpu_init();
+
+	has_avx512 = __builtin_cpu_supports("avx512f") &&
+		__builtin_cpu_supports("avx512bw");
+	has_avx2 = __builtin_cpu_supports("avx2") &&
+		__builtin_cpu_supports("fma");
+
+	/* Requests for instruction sets that are not supported are
+	 * ignored */
+	if(isa) {
+		if(strcmp(isa, "scalar") == 0)
+			return &teckyl_rt_kernels_scalar;
+		else if(strcmp(isa, "avx2") == 0 && has_avx2)
+			return &teckyl_rt_kernels_avx2;
+		else if(strcmp(isa, "avx512") == 0 && has_avx512)
+			return &teckyl_rt_kernels_avx512;
+	}
+
+	if(has_avx512)
+		return &teckyl_rt_kernels_avx512;
+	else if(has_avx2)
+		return &teckyl_rt_kernels_avx2;
+#endif
+
+	return &teckyl_rt_kernels_scalar;
+}
+
+const struct teckyl_rt_kernels *teckyl_rt_get_kernels(void)
+{
+	static const struct teckyl_rt_kernels *kernels = NULL;
+	const struct teckyl_rt_kernels *k;
+
+	k = __atomic_load_n(&kernels, __ATOMIC_ACQUIRE);
+
+	if(!k) {
+		k = select_kernels();
+		__atomic_store_n(&kernels, k, __ATOMIC_RELEASE);
+	}
+
+	return k;
+}
+
+/* Defines a GEMM driver prefix##gemm for operands of type eltype,
+ * which are packed as packtype and accumulated with acctype.
+ *
+ * Packed slivers hold `group` consecutive steps of k per row (for A)
+ * or column (for B), such that the microkernels can process multiple
+ * steps of k with a single instruction (e.g., pairs of 16-bit values
+ * for int8). Incomplete groups and slivers are padded with zeros.
+ *
+ * The operands are processed in blocks of at most mc_max x kc_max
+ * elements of A and kc_max x nc_max elements of B, which are packed
+ * into contiguous panels intended to reside in the L2 and L3 caches,
+ * respectively. */
+#define DEFINE_TECKYL_RT_GEMM(prefix, eltype, packtype, acctype, group,	\
+			      mc_target, kc_max, nc_target)		\
+	static void prefix##gemm_pack_a(int64_t mc, int64_t kc, int mr,	\
+					const eltype *a, int64_t rsa,	\
+					int64_t csa, packtype *buf)	\
+	{								\
+		int64_t kcg = (kc + group - 1) / group;			\
+									\
+		for(int64_t ir = 0; ir < mc; ir += mr) {		\
+			int full = (ir + mr <= mc) && (kc % group == 0); \
+									\
+			for(int64_t p = 0; p < kcg; p++) {		\
+				for(int i = 0; i < mr; i++) {		\
+					int64_t row = ir + i;		\
+									\
+					for(int t = 0; t < group; t++) { \
+						int64_t col = p * group + t; \
+									\
+						*buf++ = (full || (row < mc && col < kc)) ? \
+							(packtype)a[row * rsa + col * csa] : 0; \
+					}				\
+				}					\
+			}						\
+		}							\
+	}								\
+									\
+	static void prefix##gemm_pack_b(int64_t kc, int64_t nc, int nr,	\
+					const eltype *b, int64_t rsb,	\
+					int64_t csb, packtype *buf)	\
+	{								\
+		int64_t kcg = (kc + group - 1) / group;			\
+									\
+		for(int64_t jr = 0; jr < nc; jr += nr) {		\
+			int full = (jr + nr <= nc) && (kc % group == 0); \
+									\
+			for(int64_t p = 0; p < kcg; p++) {		\
+				for(int j = 0; j < nr; j++) {		\
+					int64_t col = jr + j;		\
+									\
+					for(int t = 0; t < group; t++) { \
+						int64_t row = p * group + t; \
+									\
+						*buf++ = (full || (row < kc && col < nc)) ? \
+							(packtype)b[row * rsb + col * csb] : 0; \
+					}				\
+				}					\
+			}						\
+		}							\
+	}								\
+									\
+	/* Naive implementation used if the panels cannot be		\
+	 * allocated */							\
+	static void prefix##gemm_naive(int64_t m, int64_t n, int64_t k,	\
+				       const eltype *a, int64_t rsa,	\
+				       int64_t csa, const eltype *b,	\
+				       int64_t rsb, int64_t csb,	\
+				       acctype *c, int64_t rsc,		\
+				       int64_t csc, acctype beta)	\
+	{								\
+		for(int64_t i = 0; i < m; i++) {			\
+			for(int64_t j = 0; j < n; j++) {		\
+				acctype *pc = &c[i * rsc + j * csc];	\
+				acctype accu = (beta == 0) ? 0 : beta * *pc; \
+									\
+				for(int64_t l = 0; l < k; l++)		\
+					accu += (acctype)a[i * rsa + l * csa] * \
+						b[l * rsb + j * csb];	\
+									\
+				*pc = accu;				\
+			}						\
+		}							\
+	}								\
+									\
+	static void prefix##gemm(const struct teckyl_rt_kernels *kern,	\
+				 int64_t m, int64_t n, int64_t k,	\
+				 const eltype *a, int64_t rsa, int64_t csa, \
+				 const eltype *b, int64_t rsb, int64_t csb, \
+				 acctype *c, int64_t rsc, int64_t csc,	\
+				 acctype beta)				\
+	{								\
+		int mr = kern->prefix##gemm.mr;				\
+		int nr = kern->prefix##gemm.nr;				\
+		int64_t mc_max = (mc_target / mr) * mr;			\
+		int64_t nc_max = (nc_target / nr) * nr;			\
+		int64_t kcg_max = (kc_max + group - 1) / group;		\
+		packtype *abuf, *bbuf;					\
+		acctype *ab;						\
+									\
+		if(m == 0 || n == 0)					\
+			return;						\
+									\
+		if(k == 0) {						\
+			prefix##gemm_naive(m, n, k, a, rsa, csa, b, rsb, csb, \
+					   c, rsc, csc, beta);		\
+			return;						\
+		}							\
+									\
+		abuf = alloc_panel(mc_max * kcg_max * group, sizeof(packtype)); \
+		bbuf = alloc_panel(nc_max * kcg_max * group, sizeof(packtype)); \
+		ab = alloc_panel(mr * nr, sizeof(acctype));		\
+									\
+		if(!abuf || !bbuf || !ab) {				\
+			prefix##gemm_naive(m, n, k, a, rsa, csa, b, rsb, csb, \
+					   c, rsc, csc, beta);		\
+			goto out;					\
+		}							\
+									\
+		for(int64_t jc = 0; jc < n; jc += nc_max) {		\
+			int64_t nc = min_i64(nc_max, n - jc);		\
+									\
+			for(int64_t pc = 0; pc < k; pc += kc_max) {	\
+				int64_t kc = min_i64(kc_max, k - pc);	\
+				int64_t kcg = (kc + group - 1) / group;	\
+									\
+				prefix##gemm_pack_b(kc, nc, nr,		\
+						    b + pc * rsb + jc * csb, \
+						    rsb, csb, bbuf);	\
+									\
+				for(int64_t ic = 0; ic < m; ic += mc_max) { \
+					int64_t mc = min_i64(mc_max, m - ic); \
+									\
+					prefix##gemm_pack_a(mc, kc, mr,	\
+							    a + ic * rsa + pc * csa, \
+							    rsa, csa, abuf); \
+									\
+					for(int64_t jr = 0; jr < nc; jr += nr) { \
+						for(int64_t ir = 0; ir < mc; ir += mr) { \
+							int64_t mt = min_i64(mr, mc - ir); \
+							int64_t nt = min_i64(nr, nc - jr); \
+							acctype *ct = c + (ic + ir) * rsc + \
+								(jc + jr) * csc; \
+									\
+							kern->prefix##gemm.ukernel( \
+								kcg,	\
+								abuf + ir * kcg * group, \
+								bbuf + jr * kcg * group, \
+								ab);	\
+									\
+							/* Scale C with beta for the first \
+							 * block of k only */	\
+							for(int64_t i = 0; i < mt; i++) { \
+								for(int64_t j = 0; j < nt; j++) { \
+									acctype *pct = &ct[i * rsc + j * csc]; \
+									acctype v = ab[i * nr + j]; \
+									\
+									if(pc != 0) \
+										*pct += v; \
+									else if(beta == 0) \
+										*pct = v; \
+									else \
+										*pct = beta * *pct + v; \
+								} \
+							}			\
+						}				\
+					}					\
+				}						\
+			}							\
+		}								\
+									\
+	out:								\
+		free(abuf);						\
+		free(bbuf);						\
+		free(ab);						\
+	}
+
+DEFINE_TECKYL_RT_GEMM(s, float, float, float, 1, 192, 256, 4096)
+DEFINE_TECKYL_RT_GEMM(d, double, double, double, 1, 96, 256, 2048)
+DEFINE_TECKYL_RT_GEMM(i8, int8_t, int16_t, int32_t, 2, 192, 512, 4096)
+
+/* Number of rows of A processed per invocation of a GEMV kernel */
+#define GEMV_CHUNK 1024
+
+/* Defines a GEMV driver prefix##gemv for operands of type eltype
+ * accumulated with acctype. Row kernels are used if the elements of
+ * the rows of A are contiguous and column kernels if the elements of
+ * the columns are contiguous. Non-contiguous vectors x are copied
+ * into a temporary buffer first. */
+#define DEFINE_TECKYL_RT_GEMV(prefix, eltype, acctype)			\
+	static void prefix##gemv(const struct teckyl_rt_kernels *kern,	\
+				 int64_t m, int64_t k,			\
+				 const eltype *a, int64_t rsa, int64_t csa, \
+				 const eltype *x, int64_t incx,		\
+				 acctype *y, int64_t incy, acctype beta) \
+	{								\
+		acctype ybuf[GEMV_CHUNK];				\
+		eltype *xbuf = NULL;					\
+									\
+		if(incx != 1 && k > 1) {				\
+			if((xbuf = alloc_panel(k, sizeof(eltype)))) {	\
+				for(int64_t l = 0; l < k; l++)		\
+					xbuf[l] = x[l * incx];		\
+									\
+				x = xbuf;				\
+				incx = 1;				\
+			}						\
+		}							\
+									\
+		for(int64_t i0 = 0; i0 < m; i0 += GEMV_CHUNK) {		\
+			int64_t mc = min_i64(GEMV_CHUNK, m - i0);	\
+			const eltype *ac = a + i0 * rsa;		\
+									\
+			if(k > 0 && (csa == 1 || k == 1) && incx == 1) { \
+				kern->prefix##gemv_rows(mc, k, ac, rsa, x, ybuf); \
+			} else if(k > 0 && rsa == 1 && incx == 1) {	\
+				memset(ybuf, 0, mc * sizeof(acctype));	\
+				kern->prefix##gemv_cols(mc, k, ac, csa, x, ybuf); \
+			} else {					\
+				for(int64_t i = 0; i < mc; i++) {	\
+					acctype accu = 0;		\
+									\
+					for(int64_t l = 0; l < k; l++)	\
+						accu += (acctype)ac[i * rsa + l * csa] * \
+							x[l * incx];	\
+									\
+					ybuf[i] = accu;			\
+				}					\
+			}						\
+									\
+			for(int64_t i = 0; i < mc; i++) {		\
+				acctype *py = &y[(i0 + i) * incy];	\
+									\
+				*py = (beta == 0) ? ybuf[i] : beta * *py + ybuf[i]; \
+			}						\
+		}							\
+									\
+		free(xbuf);						\
+	}
+
+DEFINE_TECKYL_RT_GEMV(s, float, float)
+DEFINE_TECKYL_RT_GEMV(d, double, double)
+DEFINE_TECKYL_RT_GEMV(i8, int8_t, int32_t)
+
+/* Defines the entry points _teckyl_rt_<prefix>gemm and
+ * _teckyl_rt_<prefix>gemv called by generated code */
+#define DEFINE_TECKYL_RT_ENTRY_POINTS(prefix, eltype, acctype)		\
+	void _teckyl_rt_##prefix##gemm(TECKYL_MEMREF2D_ARGS(a, const eltype), \
+				       TECKYL_MEMREF2D_ARGS(b, const eltype), \
+				       TECKYL_MEMREF2D_ARGS(c, acctype), \
+				       acctype beta)			\
+	{								\
+		prefix##gemm(teckyl_rt_get_kernels(),			\
+			     c_size0, c_size1, a_size1,			\
+			     a_alignedPtr + a_offset, a_stride0, a_stride1, \
+			     b_alignedPtr + b_offset, b_stride0, b_stride1, \
+			     c_alignedPtr + c_offset, c_stride0, c_stride1, \
+			     beta);					\
+	}								\
+									\
+	void _teckyl_rt_##prefix##gemv(TECKYL_MEMREF2D_ARGS(a, const eltype), \
+				       TECKYL_MEMREF1D_ARGS(x, const eltype), \
+				       TECKYL_MEMREF1D_ARGS(y, acctype), \
+				       acctype beta)			\
+	{								\
+		prefix##gemv(teckyl_rt_get_kernels(), y_size0, a_size1,	\
+			     a_alignedPtr + a_offset, a_stride0, a_stride1, \
+			     x_alignedPtr + x_offset, x_stride0,	\
+			     y_alignedPtr + y_offset, y_stride0, beta);	\
+	}
+
+DEFINE_TECKYL_RT_ENTRY_POINTS(s, float, float)
+DEFINE_TECKYL_RT_ENTRY_POINTS(d, double, double)
+DEFINE_TECKYL_RT_ENTRY_POINTS(i8, int8_t, int32_t)
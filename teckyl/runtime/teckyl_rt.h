@@ -0,0 +1,93 @@
+/* Internal interface of the teckyl-rt runtime library, which provides
+ * the GEMM and GEMV routines called by code generated with
+ * --contraction-backend=teckyl-rt.
+ *
+ * The GEMM driver in teckyl_rt.c follows the usual scheme of packing
+ * blocks of the operands into contiguous panels that fit into the
+ * caches and calling a register-blocked microkernel for each tile of
+ * MR x NR elements of the output. The microkernels and the GEMV
+ * kernels are provided once per instruction set (see
+ * teckyl_rt_scalar.c, teckyl_rt_avx2.c and teckyl_rt_avx512.c) and
+ * selected at runtime based on the features of the executing CPU.
+ */
+
+#ifndef TECKYL_RT_H
+#define TECKYL_RT_H
+
+#include <stdint.h>
+
+/* Alignment of packed panels in bytes */
+#define TECKYL_RT_PANEL_ALIGN 64
+
+/* Microkernels compute the MR x NR tile ab = A * B, where a points to
+ * a packed sliver of A with MR consecutive elements per step of k
+ * and b to a packed sliver of B with NR consecutive elements per step
+ * of k. The tile ab is stored in row-major order with a leading
+ * dimension of NR.
+ *
+ * For int8, both slivers hold pairs of consecutive steps of k widened
+ * to 16 bits (i.e., 2 * MR and 2 * NR elements per pair) and kc2 is
+ * the number of pairs. */
+typedef void (*teckyl_rt_sgemm_ukernel_t)(int64_t kc, const float *a,
+					  const float *b, float *ab);
+typedef void (*teckyl_rt_dgemm_ukernel_t)(int64_t kc, const double *a,
+					  const double *b, double *ab);
+typedef void (*teckyl_rt_i8gemm_ukernel_t)(int64_t kc2, const int16_t *a,
+					   const int16_t *b, int32_t *ab);
+
+/* GEMV kernels for a matrix A with m rows and k columns and a
+ * contiguous vector x.
+ *
+ * Row kernels require a unit stride between the elements of a row
+ * and store the dot products of the rows of A with x in the
+ * contiguous vector y (y(i) = sum_k A(i, k) * x(k)).
+ *
+ * Column kernels require a unit stride between the elements of a
+ * column and accumulate into the contiguous vector y
+ * (y(i) += sum_k A(i, k) * x(k)). */
+#define TECKYL_RT_DECL_GEMV_KERNEL_TYPE(name, eltype, acctype)		\
+	typedef void (*name)(int64_t m, int64_t k, const eltype *a,	\
+			     int64_t lda, const eltype *x, acctype *y);
+
+TECKYL_RT_DECL_GEMV_KERNEL_TYPE(teckyl_rt_sgemv_kernel_t, float, float)
+TECKYL_RT_DECL_GEMV_KERNEL_TYPE(teckyl_rt_dgemv_kernel_t, double, double)
+TECKYL_RT_DECL_GEMV_KERNEL_TYPE(teckyl_rt_i8gemv_kernel_t, int8_t, int32_t)
+
+/* Set of kernels for one instruction set */
+struct teckyl_rt_kernels {
+	const char *name;
+
+	struct {
+		int mr, nr;
+		teckyl_rt_sgemm_ukernel_t ukernel;
+	} sgemm;
+
+	struct {
+		int mr, nr;
+		teckyl_rt_dgemm_ukernel_t ukernel;
+	} dgemm;
+
+	struct {
+		int mr, nr;
+		teckyl_rt_i8gemm_ukernel_t ukernel;
+	} i8gemm;
+
+	teckyl_rt_sgemv_kernel_t sgemv_rows;
+	teckyl_rt_sgemv_kernel_t sgemv_cols;
+	teckyl_rt_dgemv_kernel_t dgemv_rows;
+	teckyl_rt_dgemv_kernel_t dgemv_cols;
+	teckyl_rt_i8gemv_kernel_t i8gemv_rows;
+	teckyl_rt_i8gemv_kernel_t i8gemv_cols;
+};
+
+extern const struct teckyl_rt_kernels teckyl_rt_kernels_scalar;
+extern const struct teckyl_rt_kernels teckyl_rt_kernels_avx2;
+extern const struct teckyl_rt_kernels teckyl_rt_kernels_avx512;
+
+/* Returns the set of kernels for the most capable instruction set
+ * supported by the executing CPU. The selection can be overridden
+ * by setting the environment variable TECKYL_RT_ISA to "scalar",
+ * "avx2" or "avx512". */
+const struct teckyl_rt_kernels *teckyl_rt_get_kernels(void);
+
+#endif /* TECKYL_RT_H */
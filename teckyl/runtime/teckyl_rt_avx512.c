@@ -0,0 +1,397 @@
+/* Kernels of the teckyl-rt runtime library for CPUs supporting
+ * AVX-512F and AVX-512BW. The kernels are compiled for the
+ * instruction set using function attributes, such that the library
+ * itself can be built without any target-specific compiler flags. */
+
+#include "teckyl_rt.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <string.h>
+
+#define TARGET __attribute__((target("avx512f,avx512bw")))
+
+/* Register blocking of the microkernels: 12 rows of 2 vectors each,
+ * using 24 of the 32 vector registers for accumulators */
+#define AVX512_MR 12
+#define AVX512_SGEMM_NR 32
+#define AVX512_DGEMM_NR 16
+#define AVX512_I8GEMM_NR 32
+
+#define REPEAT_MR(M)					\
+	M(0) M(1) M(2) M(3) M(4) M(5)			\
+	M(6) M(7) M(8) M(9) M(10) M(11)
+
+/* Returns a pair of 16-bit values as a single 32-bit value */
+static inline int32_t load_pair(const int16_t *p)
+{
+	int32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+TARGET static void sgemm_ukernel(int64_t kc, const float *a, const float *b,
+				 float *ab)
+{
+#define DECL_ROW(i) __m512 c##i##_0 = _mm512_setzero_ps(), c##i##_1 = c##i##_0;
+	REPEAT_MR(DECL_ROW)
+#undef DECL_ROW
+
+	for(int64_t p = 0; p < kc; p++) {
+		__m512 b0 = _mm512_loadu_ps(b);
+		__m512 b1 = _mm512_loadu_ps(b + 16);
+		__m512 ai;
+
+#define FMA_ROW(i)						\
+		ai = _mm512_set1_ps(a[i]);			\
+		c##i##_0 = _mm512_fmadd_ps(ai, b0, c##i##_0);	\
+		c##i##_1 = _mm512_fmadd_ps(ai, b1, c##i##_1);
+		REPEAT_MR(FMA_ROW)
+#undef FMA_ROW
+
+		a += AVX512_MR;
+		b += AVX512_SGEMM_NR;
+	}
+
+#define STORE_ROW(i)						\
+	_mm512_storeu_ps(ab + i * AVX512_SGEMM_NR, c##i##_0);	\
+	_mm512_storeu_ps(ab + i * AVX512_SGEMM_NR + 16, c##i##_1);
+	REPEAT_MR(STORE_ROW)
+#undef STORE_ROW
+}
+
+TARGET static void dgemm_ukernel(int64_t kc, const double *a, const double *b,
+				 double *ab)
+{
+#define DECL_ROW(i) __m512d c##i##_0 = _mm512_setzero_pd(), c##i##_1 = c##i##_0;
+	REPEAT_MR(DECL_ROW)
+#undef DECL_ROW
+
+	for(int64_t p = 0; p < kc; p++) {
+		__m512d b0 = _mm512_loadu_pd(b);
+		__m512d b1 = _mm512_loadu_pd(b + 8);
+		__m512d ai;
+
+#define FMA_ROW(i)						\
+		ai = _mm512_set1_pd(a[i]);			\
+		c##i##_0 = _mm512_fmadd_pd(ai, b0, c##i##_0);	\
+		c##i##_1 = _mm512_fmadd_pd(ai, b1, c##i##_1);
+		REPEAT_MR(FMA_ROW)
+#undef FMA_ROW
+
+		a += AVX512_MR;
+		b += AVX512_DGEMM_NR;
+	}
+
+#define STORE_ROW(i)						\
+	_mm512_storeu_pd(ab + i * AVX512_DGEMM_NR, c##i##_0);	\
+	_mm512_storeu_pd(ab + i * AVX512_DGEMM_NR + 8, c##i##_1);
+	REPEAT_MR(STORE_ROW)
+#undef STORE_ROW
+}
+
+/* Each vector of B holds 16 columns with 2 steps of k each, such
+ * that vpmaddwd yields the sum of the products of two steps of k for
+ * 16 columns at once. */
+TARGET static void i8gemm_ukernel(int64_t kc2, const int16_t *a,
+				  const int16_t *b, int32_t *ab)
+{
+#define DECL_ROW(i) __m512i c##i##_0 = _mm512_setzero_si512(), c##i##_1 = c##i##_0;
+	REPEAT_MR(DECL_ROW)
+#undef DECL_ROW
+
+	for(int64_t p = 0; p < kc2; p++) {
+		__m512i b0 = _mm512_loadu_si512(b);
+		__m512i b1 = _mm512_loadu_si512(b + 32);
+		__m512i ai;
+
+#define MADD_ROW(i)							\
+		ai = _mm512_set1_epi32(load_pair(&a[2 * i]));		\
+		c##i##_0 = _mm512_add_epi32(c##i##_0,			\
+					    _mm512_madd_epi16(ai, b0));	\
+		c##i##_1 = _mm512_add_epi32(c##i##_1,			\
+					    _mm512_madd_epi16(ai, b1));
+		REPEAT_MR(MADD_ROW)
+#undef MADD_ROW
+
+		a += 2 * AVX512_MR;
+		b += 2 * AVX512_I8GEMM_NR;
+	}
+
+#define STORE_ROW(i)							\
+	_mm512_storeu_si512(ab + i * AVX512_I8GEMM_NR, c##i##_0);	\
+	_mm512_storeu_si512(ab + i * AVX512_I8GEMM_NR + 16, c##i##_1);
+	REPEAT_MR(STORE_ROW)
+#undef STORE_ROW
+}
+
+/* GEMV row kernels process blocks of 4 rows to reuse each vector of
+ * x for 4 rows */
+TARGET static void sgemv_rows(int64_t m, int64_t k, const float *a,
+			      int64_t lda, const float *x, float *y)
+{
+	int64_t i = 0;
+
+	for(; i + 4 <= m; i += 4) {
+		const float *a0 = a + i * lda, *a1 = a0 + lda;
+		const float *a2 = a1 + lda, *a3 = a2 + lda;
+		__m512 s0 = _mm512_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+		int64_t l = 0;
+
+		for(; l + 16 <= k; l += 16) {
+			__m512 xv = _mm512_loadu_ps(x + l);
+
+			s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a0 + l), xv, s0);
+			s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a1 + l), xv, s1);
+			s2 = _mm512_fmadd_ps(_mm512_loadu_ps(a2 + l), xv, s2);
+			s3 = _mm512_fmadd_ps(_mm512_loadu_ps(a3 + l), xv, s3);
+		}
+
+		float r0 = _mm512_reduce_add_ps(s0);
+		float r1 = _mm512_reduce_add_ps(s1);
+		float r2 = _mm512_reduce_add_ps(s2);
+		float r3 = _mm512_reduce_add_ps(s3);
+
+		for(; l < k; l++) {
+			r0 += a0[l] * x[l];
+			r1 += a1[l] * x[l];
+			r2 += a2[l] * x[l];
+			r3 += a3[l] * x[l];
+		}
+
+		y[i] = r0;
+		y[i + 1] = r1;
+		y[i + 2] = r2;
+		y[i + 3] = r3;
+	}
+
+	for(; i < m; i++) {
+		const float *ai = a + i * lda;
+		__m512 s = _mm512_setzero_ps();
+		int64_t l = 0;
+
+		for(; l + 16 <= k; l += 16)
+			s = _mm512_fmadd_ps(_mm512_loadu_ps(ai + l),
+					    _mm512_loadu_ps(x + l), s);
+
+		float r = _mm512_reduce_add_ps(s);
+
+		for(; l < k; l++)
+			r += ai[l] * x[l];
+
+		y[i] = r;
+	}
+}
+
+TARGET static void dgemv_rows(int64_t m, int64_t k, const double *a,
+			      int64_t lda, const double *x, double *y)
+{
+	int64_t i = 0;
+
+	for(; i + 4 <= m; i += 4) {
+		const double *a0 = a + i * lda, *a1 = a0 + lda;
+		const double *a2 = a1 + lda, *a3 = a2 + lda;
+		__m512d s0 = _mm512_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+		int64_t l = 0;
+
+		for(; l + 8 <= k; l += 8) {
+			__m512d xv = _mm512_loadu_pd(x + l);
+
+			s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a0 + l), xv, s0);
+			s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a1 + l), xv, s1);
+			s2 = _mm512_fmadd_pd(_mm512_loadu_pd(a2 + l), xv, s2);
+			s3 = _mm512_fmadd_pd(_mm512_loadu_pd(a3 + l), xv, s3);
+		}
+
+		double r0 = _mm512_reduce_add_pd(s0);
+		double r1 = _mm512_reduce_add_pd(s1);
+		double r2 = _mm512_reduce_add_pd(s2);
+		double r3 = _mm512_reduce_add_pd(s3);
+
+		for(; l < k; l++) {
+			r0 += a0[l] * x[l];
+			r1 += a1[l] * x[l];
+			r2 += a2[l] * x[l];
+			r3 += a3[l] * x[l];
+		}
+
+		y[i] = r0;
+		y[i + 1] = r1;
+		y[i + 2] = r2;
+		y[i + 3] = r3;
+	}
+
+	for(; i < m; i++) {
+		const double *ai = a + i * lda;
+		__m512d s = _mm512_setzero_pd();
+		int64_t l = 0;
+
+		for(; l + 8 <= k; l += 8)
+			s = _mm512_fmadd_pd(_mm512_loadu_pd(ai + l),
+					    _mm512_loadu_pd(x + l), s);
+
+		double r = _mm512_reduce_add_pd(s);
+
+		for(; l < k; l++)
+			r += ai[l] * x[l];
+
+		y[i] = r;
+	}
+}
+
+/* Returns the dot product of the int8 vectors a and x of length k,
+ * widening to 16 bits and accumulating in 32 bits */
+TARGET static int32_t i8dot(int64_t k, const int8_t *a, const int8_t *x)
+{
+	__m512i s = _mm512_setzero_si512();
+	int64_t l = 0;
+
+	for(; l + 32 <= k; l += 32) {
+		__m512i av = _mm512_cvtepi8_epi16(
+			_mm256_loadu_si256((const __m256i *)(a + l)));
+		__m512i xv = _mm512_cvtepi8_epi16(
+			_mm256_loadu_si256((const __m256i *)(x + l)));
+
+		s = _mm512_add_epi32(s, _mm512_madd_epi16(av, xv));
+	}
+
+	int32_t r = _mm512_reduce_add_epi32(s);
+
+	for(; l < k; l++)
+		r += (int32_t)a[l] * x[l];
+
+	return r;
+}
+
+TARGET static void i8gemv_rows(int64_t m, int64_t k, const int8_t *a,
+			       int64_t lda, const int8_t *x, int32_t *y)
+{
+	for(int64_t i = 0; i < m; i++)
+		y[i] = i8dot(k, a + i * lda, x);
+}
+
+/* GEMV column kernels keep blocks of y in registers while iterating
+ * over the columns of A */
+TARGET static void sgemv_cols(int64_t m, int64_t k, const float *a,
+			      int64_t lda, const float *x, float *y)
+{
+	int64_t i = 0;
+
+	for(; i + 64 <= m; i += 64) {
+		__m512 y0 = _mm512_loadu_ps(y + i);
+		__m512 y1 = _mm512_loadu_ps(y + i + 16);
+		__m512 y2 = _mm512_loadu_ps(y + i + 32);
+		__m512 y3 = _mm512_loadu_ps(y + i + 48);
+
+		for(int64_t l = 0; l < k; l++) {
+			const float *al = a + i + l * lda;
+			__m512 xb = _mm512_set1_ps(x[l]);
+
+			y0 = _mm512_fmadd_ps(_mm512_loadu_ps(al), xb, y0);
+			y1 = _mm512_fmadd_ps(_mm512_loadu_ps(al + 16), xb, y1);
+			y2 = _mm512_fmadd_ps(_mm512_loadu_ps(al + 32), xb, y2);
+			y3 = _mm512_fmadd_ps(_mm512_loadu_ps(al + 48), xb, y3);
+		}
+
+		_mm512_storeu_ps(y + i, y0);
+		_mm512_storeu_ps(y + i + 16, y1);
+		_mm512_storeu_ps(y + i + 32, y2);
+		_mm512_storeu_ps(y + i + 48, y3);
+	}
+
+	for(; i + 16 <= m; i += 16) {
+		__m512 yv = _mm512_loadu_ps(y + i);
+
+		for(int64_t l = 0; l < k; l++)
+			yv = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + l * lda),
+					     _mm512_set1_ps(x[l]), yv);
+
+		_mm512_storeu_ps(y + i, yv);
+	}
+
+	for(; i < m; i++)
+		for(int64_t l = 0; l < k; l++)
+			y[i] += a[i + l * lda] * x[l];
+}
+
+TARGET static void dgemv_cols(int64_t m, int64_t k, const double *a,
+			      int64_t lda, const double *x, double *y)
+{
+	int64_t i = 0;
+
+	for(; i + 32 <= m; i += 32) {
+		__m512d y0 = _mm512_loadu_pd(y + i);
+		__m512d y1 = _mm512_loadu_pd(y + i + 8);
+		__m512d y2 = _mm512_loadu_pd(y + i + 16);
+		__m512d y3 = _mm512_loadu_pd(y + i + 24);
+
+		for(int64_t l = 0; l < k; l++) {
+			const double *al = a + i + l * lda;
+			__m512d xb = _mm512_set1_pd(x[l]);
+
+			y0 = _mm512_fmadd_pd(_mm512_loadu_pd(al), xb, y0);
+			y1 = _mm512_fmadd_pd(_mm512_loadu_pd(al + 8), xb, y1);
+			y2 = _mm512_fmadd_pd(_mm512_loadu_pd(al + 16), xb, y2);
+			y3 = _mm512_fmadd_pd(_mm512_loadu_pd(al + 24), xb, y3);
+		}
+
+		_mm512_storeu_pd(y + i, y0);
+		_mm512_storeu_pd(y + i + 8, y1);
+		_mm512_storeu_pd(y + i + 16, y2);
+		_mm512_storeu_pd(y + i + 24, y3);
+	}
+
+	for(; i + 8 <= m; i += 8) {
+		__m512d yv = _mm512_loadu_pd(y + i);
+
+		for(int64_t l = 0; l < k; l++)
+			yv = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + l * lda),
+					     _mm512_set1_pd(x[l]), yv);
+
+		_mm512_storeu_pd(y + i, yv);
+	}
+
+	for(; i < m; i++)
+		for(int64_t l = 0; l < k; l++)
+			y[i] += a[i + l * lda] * x[l];
+}
+
+TARGET static void i8gemv_cols(int64_t m, int64_t k, const int8_t *a,
+			       int64_t lda, const int8_t *x, int32_t *y)
+{
+	int64_t i = 0;
+
+	for(; i + 16 <= m; i += 16) {
+		__m512i yv = _mm512_loadu_si512(y + i);
+
+		for(int64_t l = 0; l < k; l++) {
+			__m512i av = _mm512_cvtepi8_epi32(_mm_loadu_si128(
+				(const __m128i *)(a + i + l * lda)));
+
+			yv = _mm512_add_epi32(
+				yv, _mm512_mullo_epi32(av, _mm512_set1_epi32(x[l])));
+		}
+
+		_mm512_storeu_si512(y + i, yv);
+	}
+
+	for(; i < m; i++)
+		for(int64_t l = 0; l < k; l++)
+			y[i] += (int32_t)a[i + l * lda] * x[l];
+}
+
+const struct teckyl_rt_kernels teckyl_rt_kernels_avx512 = {
+	.name = "avx512",
+	.sgemm = { AVX512_MR, AVX512_SGEMM_NR, sgemm_ukernel },
+	.dgemm = { AVX512_MR, AVX512_DGEMM_NR, dgemm_ukernel },
+	.i8gemm = { AVX512_MR, AVX512_I8GEMM_NR, i8gemm_ukernel },
+	.sgemv_rows = sgemv_rows,
+	.sgemv_cols = sgemv_cols,
+	.dgemv_rows = dgemv_rows,
+	.dgemv_cols = dgemv_cols,
+	.i8gemv_rows = i8gemv_rows,
+	.i8gemv_cols = i8gemv_cols
+};
+
+#endif
@@ -0,0 +1,95 @@
+/* Portable kernels of the teckyl-rt runtime library for CPUs without
+ * support for any of the vector instruction sets handled
+ * explicitly. */
+
+#include "teckyl_rt.h"
+
+#define SCALAR_MR 4
+#define SCALAR_NR 4
+
+/* Defines a microkernel for GEMM on packed slivers of SCALAR_MR rows
+ * and SCALAR_NR columns */
+#define DEFINE_SCALAR_GEMM_UKERNEL(name, eltype)			\
+	static void name(int64_t kc, const eltype *a, const eltype *b,	\
+			 eltype *ab)					\
+	{								\
+		eltype c[SCALAR_MR][SCALAR_NR] = { { 0 } };		\
+									\
+		for(int64_t p = 0; p < kc; p++) {			\
+			for(int i = 0; i < SCALAR_MR; i++)		\
+				for(int j = 0; j < SCALAR_NR; j++)	\
+					c[i][j] += a[i] * b[j];		\
+									\
+			a += SCALAR_MR;					\
+			b += SCALAR_NR;					\
+		}							\
+									\
+		for(int i = 0; i < SCALAR_MR; i++)			\
+			for(int j = 0; j < SCALAR_NR; j++)		\
+				ab[i * SCALAR_NR + j] = c[i][j];	\
+	}
+
+DEFINE_SCALAR_GEMM_UKERNEL(sgemm_ukernel, float)
+DEFINE_SCALAR_GEMM_UKERNEL(dgemm_ukernel, double)
+
+static void i8gemm_ukernel(int64_t kc2, const int16_t *a, const int16_t *b,
+			   int32_t *ab)
+{
+	int32_t c[SCALAR_MR][SCALAR_NR] = { { 0 } };
+
+	for(int64_t p = 0; p < kc2; p++) {
+		for(int i = 0; i < SCALAR_MR; i++)
+			for(int j = 0; j < SCALAR_NR; j++)
+				c[i][j] += a[2 * i] * b[2 * j] +
+					a[2 * i + 1] * b[2 * j + 1];
+
+		a += 2 * SCALAR_MR;
+		b += 2 * SCALAR_NR;
+	}
+
+	for(int i = 0; i < SCALAR_MR; i++)
+		for(int j = 0; j < SCALAR_NR; j++)
+			ab[i * SCALAR_NR + j] = c[i][j];
+}
+
+/* Defines the row and column kernels for GEMV */
+#define DEFINE_SCALAR_GEMV_KERNELS(prefix, eltype, acctype)		\
+	static void prefix##gemv_rows(int64_t m, int64_t k,		\
+				      const eltype *a, int64_t lda,	\
+				      const eltype *x, acctype *y)	\
+	{								\
+		for(int64_t i = 0; i < m; i++) {			\
+			acctype accu = 0;				\
+									\
+			for(int64_t l = 0; l < k; l++)			\
+				accu += (acctype)a[i * lda + l] * x[l];	\
+									\
+			y[i] = accu;					\
+		}							\
+	}								\
+									\
+	static void prefix##gemv_cols(int64_t m, int64_t k,		\
+				      const eltype *a, int64_t lda,	\
+				      const eltype *x, acctype *y)	\
+	{								\
+		for(int64_t l = 0; l < k; l++)				\
+			for(int64_t i = 0; i < m; i++)			\
+				y[i] += (acctype)a[i + l * lda] * x[l];	\
+	}
+
+DEFINE_SCALAR_GEMV_KERNELS(s, float, float)
+DEFINE_SCALAR_GEMV_KERNELS(d, double, double)
+DEFINE_SCALAR_GEMV_KERNELS(i8, int8_t, int32_t)
+
+const struct teckyl_rt_kernels teckyl_rt_kernels_scalar = {
+	.name = "scalar",
+	.sgemm = { SCALAR_MR, SCALAR_NR, sgemm_ukernel },
+	.dgemm = { SCALAR_MR, SCALAR_NR, dgemm_ukernel },
+	.i8gemm = { SCALAR_MR, SCALAR_NR, i8gemm_ukernel },
+	.sgemv_rows = sgemv_rows,
+	.sgemv_cols = sgemv_cols,
+	.dgemv_rows = dgemv_rows,
+	.dgemv_cols = dgemv_cols,
+	.i8gemv_rows = i8gemv_rows,
+	.i8gemv_cols = i8gemv_cols
+};
@@ -0,0 +1,184 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "teckyl/tc/lang/benchmark/reference_lexer.h"
+#include "teckyl/tc/lang/lexer.h"
+
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ErrorHandling.h>
+
+// Commandline options
+static llvm::cl::list<std::string>
+    inputFilenames(llvm::cl::Positional, llvm::cl::desc("<input files>"),
+                   llvm::cl::ZeroOrMore);
+
+static llvm::cl::opt<unsigned int>
+    sourceSize("size",
+               llvm::cl::desc("Size in MiB of the source lexed per "
+                              "repetition (input files are repeated)"),
+               llvm::cl::init(32));
+
+static llvm::cl::opt<unsigned int>
+    repetitions("repetitions", llvm::cl::desc("Number of repetitions"),
+                llvm::cl::init(5));
+
+// Source used if no input files are given, resembling the output of
+// code generators: many definitions with long names, numbers with and
+// without type suffixes and comments
+static const char *defaultSource = R"TC(
+# Generated kernel
+def conv_layer_0042_fwd(float(N,C,H,W) input_0042,
+                        float(M,C,KH,KW) weights_0042,
+                        float(M) bias_0042)
+    -> (float(N,M,HO,WO) output_0042)
+{
+  output_0042(n, m, h, w) +=!
+      input_0042(n, c, h + kh, w + kw) * weights_0042(m, c, kh, kw)
+      where h in 0:HO, w in 0:WO
+  output_0042(n, m, h, w) =
+      max(output_0042(n, m, h, w) + bias_0042(m), 0.0f32)
+}
+
+def scale_and_shift_0042(float(1024,512) A_0042, float(512) S_0042)
+    -> (double(1024,512) B_0042)
+{
+  # Shift
+  B_0042(i, j) = 2.5e-3f64 * A_0042(i, j) * S_0042(j) + 17i32 - 3.0 + 1e5
+}
+)TC";
+
+// Reads the file `filename` into `out`
+static bool readFile(const std::string &filename, std::string &out) {
+  std::ifstream in(filename);
+
+  if (!in)
+    return false;
+
+  std::stringstream ss;
+  ss << in.rdbuf();
+  out = ss.str();
+
+  return true;
+}
+
+// Matches all tokens of `source` with `matcher` and calls `f` with
+// the kind, the position and the source location of each token. The
+// kind is -1 if no token matches.
+template <typename Matcher, typename F>
+static void lexAll(Matcher &matcher, const std::string &source, F f) {
+  size_t pos = 0;
+  size_t line = 1;
+  size_t ch = 1;
+
+  while (true) {
+    int kind = -1;
+    size_t start = 0;
+    size_t len = 0;
+
+    if (!matcher.match(source, pos, &kind, &start, &len, &line, &ch)) {
+      f(-1, start, 0, line, ch);
+      break;
+    }
+
+    f(kind, start, len, line, ch);
+
+    if (kind == lang::TK_EOF)
+      break;
+
+    pos = start + len;
+  }
+}
+
+// Returns the token stream of `source` matched with `matcher`
+template <typename Matcher>
+static std::vector<size_t> tokenStream(Matcher &matcher,
+                                       const std::string &source) {
+  std::vector<size_t> tokens;
+
+  lexAll(matcher, source,
+         [&](int kind, size_t start, size_t len, size_t line, size_t ch) {
+           size_t token[] = {static_cast<size_t>(kind), start, len, line, ch};
+           tokens.insert(tokens.end(), std::begin(token), std::end(token));
+         });
+
+  return tokens;
+}
+
+// Keeps the compiler from optimizing away the lexing in measure()
+static volatile size_t checksumSink;
+
+// Returns the throughput in MiB/s of lexing `source` with `matcher`
+// as the best of `repetitions` runs
+template <typename Matcher>
+static double measure(Matcher &matcher, const std::string &source) {
+  double best = 0;
+
+  for (unsigned int i = 0; i < repetitions; i++) {
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    lexAll(matcher, source,
+           [&](int kind, size_t start, size_t len, size_t line, size_t ch) {
+             checksum += kind + len;
+           });
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> seconds = end - start;
+
+    checksumSink = checksum;
+    best = std::max(best, source.size() / seconds.count() / (1 << 20));
+  }
+
+  return best;
+}
+
+int main(int argc, char **argv) {
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "Benchmark for the TC lexer\n");
+
+  std::string unit;
+
+  for (const std::string &filename : inputFilenames) {
+    std::string content;
+
+    if (!readFile(filename, content)) {
+      llvm::errs() << "Could not open input file " << filename << "\n";
+      return 1;
+    }
+
+    unit += content + "\n";
+  }
+
+  if (unit.empty())
+    unit = defaultSource;
+
+  std::string source;
+  size_t size = static_cast<size_t>(sourceSize) << 20;
+
+  while (source.size() < size)
+    source += unit;
+
+  lang::SharedParserData &shared = lang::sharedParserData();
+  lang::reference::ReferenceMatcher reference;
+
+  // Both lexers must produce the same token stream
+  std::vector<size_t> tokens = tokenStream(shared, source);
+
+  if (tokens != tokenStream(reference, source)) {
+    llvm::errs() << "Token streams of the lexers differ\n";
+    return 1;
+  }
+
+  double referenceRate = measure(reference, source);
+  double rate = measure(shared, source);
+
+  std::cout << "Source size:        " << source.size() << " bytes, "
+            << tokens.size() / 5 << " tokens\n"
+            << "Reference lexer:    " << referenceRate << " MiB/s\n"
+            << "Table-driven lexer: " << rate << " MiB/s\n"
+            << "Speedup:            " << rate / referenceRate << "x\n";
+
+  return 0;
+}
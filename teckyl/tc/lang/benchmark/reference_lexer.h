@@ -0,0 +1,198 @@
+#ifndef TECKYL_TC_LANG_BENCHMARK_REFERENCE_LEXER_H_
+#define TECKYL_TC_LANG_BENCHMARK_REFERENCE_LEXER_H_
+
+#include "teckyl/tc/lang/lexer.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace lang {
+namespace reference {
+
+// Character-by-character matching of tokens as implemented by
+// lang::SharedParserData before the table-driven lexer, kept as the
+// baseline for the lexer benchmark and as a reference for its token
+// stream.
+
+// nested hash tables that indicate char-by-char what is a valid token.
+struct TokenTrie;
+using TokenTrieRef = std::unique_ptr<TokenTrie>;
+struct TokenTrie {
+  TokenTrie() : kind(0) {}
+  void insert(const char *str, int tok) {
+    if (*str == '\0') {
+      assert(kind == 0);
+      kind = tok;
+      return;
+    }
+    auto &entry = children[*str];
+    if (entry == nullptr) {
+      entry.reset(new TokenTrie());
+    }
+    entry->insert(str + 1, tok);
+  }
+  int kind; // 0 == invalid token
+  std::unordered_map<char, TokenTrieRef> children;
+};
+
+struct ReferenceMatcher {
+  ReferenceMatcher() : head(new TokenTrie()) {
+    for (const char *c = valid_single_char_tokens; *c; c++) {
+      const char str[] = {*c, '\0'};
+      head->insert(str, *c);
+    }
+
+#define ADD_CASE(tok, _, tokstring)                                            \
+  if (*tokstring != '\0') {                                                    \
+    head->insert(tokstring, tok);                                              \
+  }
+    TC_FORALL_TOKEN_KINDS(ADD_CASE)
+#undef ADD_CASE
+  }
+  bool isNumber(const std::string &str, size_t start, size_t *len) {
+    char first = str[start];
+    // strtod allows numbers to start with + or -
+    // http://en.cppreference.com/w/cpp/string/byte/strtof
+    // but we want only the number part, otherwise 1+3 will turn into two
+    // adjacent numbers in the lexer
+    if (first == '-' || first == '+')
+      return false;
+    const char *startptr = str.c_str() + start;
+    char *endptr;
+    std::strtod(startptr, &endptr);
+    *len = endptr - startptr;
+    if (*len == 0)
+      return false;
+
+    bool isFloatLiteral = false;
+
+    for (const char *tokptr = startptr; tokptr != endptr; tokptr++) {
+      if (*tokptr == '.' || *tokptr == 'e') {
+        isFloatLiteral = true;
+        break;
+      }
+    }
+
+    // It's safe to dereference endptr, since as per the specification
+    // of strtod, it is either equal to startptr or the address of the
+    // character past startptr. Since startptr is initialized with
+    // std::string::c_str(), it is guaranteed to point to a sequence
+    // of characters terminated by zero, so endptr points at most at
+    // the NUL character at the end of the string.
+    //
+    // Similarly, the use of C string functions are safe here, since
+    // the above check guarantees that endptr hasn't moved past the
+    // NUL character.
+    if (*endptr != '\0') {
+      static const char *suffixes[] = {"i2",  "i4",  "i8",  "i16", "i32",
+                                       "i64", "u2",  "u4",  "u8",  "u16",
+                                       "u32", "u64", "z",   "f16", "f32",
+                                       "f64", "bf16"};
+
+#define REFERENCE_ARRAY_SIZE(a) ((sizeof(a) / sizeof(a[0])))
+
+      for (size_t i = 0; i < REFERENCE_ARRAY_SIZE(suffixes); i++) {
+        size_t sufflen = strlen(suffixes[i]);
+
+        if (std::strncmp(endptr, suffixes[i], sufflen) == 0) {
+          *len += sufflen;
+
+          // Float literals must have a float type suffix
+          if (isFloatLiteral && suffixes[i][0] != 'f' &&
+              suffixes[i][0] != 'b')
+            return false;
+          else
+            return true;
+        }
+      }
+    }
+
+    // Constant without type suffix
+    return true;
+  }
+  // find the longest match of str.substring(pos) against a token, return true
+  // if successful
+  // filling in kind, start,and len
+  bool match(const std::string &str, size_t pos, int *kind, size_t *start,
+             size_t *len, size_t *line, size_t *ch) {
+    // skip whitespace
+    while (pos < str.size() && isspace(str[pos])) {
+      if (str[pos] == '\n') {
+        (*line)++;
+        *ch = 1;
+      } else {
+        (*ch)++;
+      }
+
+      pos++;
+    }
+    // skip comments
+    if (pos < str.size() && str[pos] == '#') {
+      while (pos < str.size() && str[pos] != '\n') {
+        pos++;
+        (*ch)++;
+      }
+
+      if (pos < str.size() && str[pos] == '\n') {
+        *ch = 1;
+        (*line)++;
+      }
+
+      // tail call, handle whitespace and more comments
+      return match(str, pos, kind, start, len, line, ch);
+    }
+    *start = pos;
+    if (pos == str.size()) {
+      *kind = TK_EOF;
+      *len = 0;
+      return true;
+    }
+    // check for a valid number
+    if (isNumber(str, pos, len)) {
+      *kind = TK_NUMBER;
+      return true;
+    }
+    // check for either an ident or a token
+    // ident tracks whether what we have scanned so far could be an identifier
+    // matched indicates if we have found any match.
+    bool matched = false;
+    bool ident = true;
+    TokenTrie *cur = head.get();
+    for (size_t i = 0; pos + i < str.size() && (ident || cur != nullptr); i++) {
+      ident = ident && validIdent(i, str[pos + i]);
+      if (ident) {
+        matched = true;
+        *len = i + 1;
+        *kind = TK_IDENT;
+      }
+      // check for token second, so that e.g. 'max' matches the token TK_MAX
+      // rather the
+      // identifier 'max'
+      if (cur) {
+        auto it = cur->children.find(str[pos + i]);
+        cur = (it == cur->children.end()) ? nullptr : it->second.get();
+        if (cur && cur->kind != 0) {
+          matched = true;
+          *len = i + 1;
+          *kind = cur->kind;
+        }
+      }
+    }
+    return matched;
+  }
+
+private:
+  bool validIdent(size_t i, char n) {
+    return isalpha(n) || n == '_' || (i > 0 && isdigit(n));
+  }
+  TokenTrieRef head;
+};
+
+} // namespace reference
+} // namespace lang
+
+#endif // TECKYL_TC_LANG_BENCHMARK_REFERENCE_LEXER_H_
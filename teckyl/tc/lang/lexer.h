@@ -17,7 +17,10 @@
 #define TECKYL_TC_LANG_LEXER_H_
 
 #include <algorithm>
+#include <array>
 #include <assert.h>
+#include <cctype>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -26,6 +29,10 @@
 #include <unordered_map>
 #include <vector>
 
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
 namespace lang {
 
 // single character tokens are just the character itself '+'
@@ -84,6 +91,7 @@ namespace lang {
   _(TK_INT64, "int64", "int64")                                                \
   _(TK_SIZET, "size_t", "size_t")                                              \
   _(TK_FLOAT16, "float16", "float16")                                          \
+  _(TK_BFLOAT16, "bfloat16", "bfloat16")                                       \
   _(TK_FLOAT32, "float32", "float32")                                          \
   _(TK_FLOAT64, "float64", "float64")                                          \
   _(TK_FLOAT, "float", "float")                                                \
@@ -99,7 +107,7 @@ namespace lang {
   _(TK_LET, "let", "")                                                         \
   _(TK_EXISTS, "exists", "exists")
 
-static const char *valid_single_char_tokens = "+-*/()[]?:,={}><!%";
+static const char *valid_single_char_tokens = "+-*/()[]?:,={}><!%@";
 
 enum TokenKind {
   // we use characters to represent themselves so skip all valid characters
@@ -117,31 +125,197 @@ std::string kindToString(int kind);
 // if it can't be produced by the lexer.
 std::string kindToToken(int kind);
 
-// nested hash tables that indicate char-by-char what is a valid token.
-struct TokenTrie;
-using TokenTrieRef = std::unique_ptr<TokenTrie>;
-struct TokenTrie {
-  TokenTrie() : kind(0) {}
-  void insert(const char *str, int tok) {
-    if (*str == '\0') {
-      assert(kind == 0);
-      kind = tok;
-      return;
+// Classes of characters for the table-driven scanning of the source
+enum CharClass : uint8_t {
+  CC_SPACE = 1 << 0,       // whitespace except for newlines
+  CC_IDENT_START = 1 << 1, // letters and '_'
+  CC_DIGIT = 1 << 2,
+  CC_IDENT = CC_IDENT_START | CC_DIGIT
+};
+
+// Table of the character classes indexed by the unsigned value of a
+// character
+struct CharClassTable {
+  CharClassTable() : classes() {
+    for (int c = 'a'; c <= 'z'; c++) {
+      classes[c] |= CC_IDENT_START;
+      classes[c - 'a' + 'A'] |= CC_IDENT_START;
     }
-    auto &entry = children[*str];
-    if (entry == nullptr) {
-      entry.reset(new TokenTrie());
+
+    for (int c = '0'; c <= '9'; c++)
+      classes[c] |= CC_DIGIT;
+
+    classes['_'] |= CC_IDENT_START;
+
+    for (unsigned char c : {' ', '\t', '\v', '\f', '\r'})
+      classes[c] |= CC_SPACE;
+  }
+
+  bool is(char c, uint8_t cls) const {
+    return classes[static_cast<unsigned char>(c)] & cls;
+  }
+
+  uint8_t classes[256];
+};
+
+// Returns a bit mask with bit i set if the character p[i] belongs to
+// the class `cls`, for the 16 (SSE2) or 32 (AVX2) characters at `p`
+#ifdef __SSE2__
+static inline uint32_t classMask16(const char *p, uint8_t cls) {
+  __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  __m128i m = _mm_setzero_si128();
+
+  // Characters >= 128 are negative and thus never within the ranges
+  if (cls & CC_SPACE) {
+    // ' ' and '\t', '\v', '\f', '\r' (i.e., 9 to 13 except for '\n')
+    __m128i ctrl = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(8)),
+                                 _mm_cmplt_epi8(c, _mm_set1_epi8(14)));
+    ctrl = _mm_andnot_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\n')), ctrl);
+    __m128i space = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+    m = _mm_or_si128(m, _mm_or_si128(ctrl, space));
+  }
+
+  if (cls & CC_IDENT_START) {
+    // Setting bit 5 maps uppercase letters to lowercase letters
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i alpha =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i underscore = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+    m = _mm_or_si128(m, _mm_or_si128(alpha, underscore));
+  }
+
+  if (cls & CC_DIGIT) {
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    m = _mm_or_si128(m, digit);
+  }
+
+  return _mm_movemask_epi8(m);
+}
+#endif // __SSE2__
+
+#ifdef __AVX2__
+static inline uint32_t classMask32(const char *p, uint8_t cls) {
+  __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  __m256i m = _mm256_setzero_si256();
+
+  if (cls & CC_SPACE) {
+    __m256i ctrl = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(8)),
+                                    _mm256_cmpgt_epi8(_mm256_set1_epi8(14), c));
+    ctrl = _mm256_andnot_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')),
+                               ctrl);
+    m = _mm256_or_si256(
+        m, _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' '))));
+  }
+
+  if (cls & CC_IDENT_START) {
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    __m256i alpha =
+        _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    m = _mm256_or_si256(
+        m, _mm256_or_si256(alpha, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'))));
+  }
+
+  if (cls & CC_DIGIT) {
+    m = _mm256_or_si256(
+        m, _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c)));
+  }
+
+  return _mm256_movemask_epi8(m);
+}
+#endif // __AVX2__
+
+// Returns the position of the first character at or after `pos` in
+// the string `s` of size `size` that does not belong to the class
+// `cls`, or `size` if there is no such character. Runs of characters
+// are classified in blocks of 32 or 16 characters if AVX2 or SSE2 is
+// available and character by character using `table` otherwise.
+static inline size_t scanClass(const CharClassTable &table, const char *s,
+                               size_t pos, size_t size, uint8_t cls) {
+  // Most runs are short: check the first few characters individually
+  for (size_t end = std::min(pos + 8, size); pos < end; pos++) {
+    if (!table.is(s[pos], cls))
+      return pos;
+  }
+
+#ifdef __AVX2__
+  for (; pos + 32 <= size; pos += 32) {
+    uint32_t m = classMask32(s + pos, cls);
+
+    if (m != 0xffffffffu)
+      return pos + __builtin_ctz(~m);
+  }
+#endif // __AVX2__
+
+#ifdef __SSE2__
+  for (; pos + 16 <= size; pos += 16) {
+    uint32_t m = classMask16(s + pos, cls);
+
+    if (m != 0xffffu)
+      return pos + __builtin_ctz(~m);
+  }
+#endif // __SSE2__
+
+  while (pos < size && table.is(s[pos], cls))
+    pos++;
+
+  return pos;
+}
+
+// Deterministic finite automaton recognizing the tokens matched by
+// their string in TC_FORALL_TOKEN_KINDS and the single character
+// tokens. The transitions are stored in a dense table with one row of
+// 128 entries per state; state 0 is the initial state.
+struct TokenDFA {
+  TokenDFA() { addState(); }
+
+  void insert(const char *str, int tok) {
+    int state = 0;
+
+    for (; *str; str++) {
+      unsigned char c = *str;
+      assert(c < 128);
+
+      if (transitions[state][c] < 0)
+        transitions[state][c] = addState();
+
+      state = transitions[state][c];
     }
-    entry->insert(str + 1, tok);
+
+    assert(kinds[state] == 0);
+    kinds[state] = tok;
+  }
+
+  // Returns the state reached from `state` with the character `c` or
+  // -1 if there is no transition
+  int next(int state, char c) const {
+    unsigned char uc = c;
+    return (uc < 128) ? transitions[state][uc] : -1;
+  }
+
+  std::vector<std::array<int16_t, 128>> transitions;
+
+  // Token kind accepted in each state; 0 for non-accepting states
+  std::vector<int> kinds;
+
+private:
+  int addState() {
+    std::array<int16_t, 128> row;
+    row.fill(-1);
+    transitions.push_back(row);
+    kinds.push_back(0);
+
+    return transitions.size() - 1;
   }
-  int kind; // 0 == invalid token
-  std::unordered_map<char, TokenTrieRef> children;
 };
 
 // stuff that is shared against all TC lexers/parsers and is initialized only
 // once.
 struct SharedParserData {
-  SharedParserData() : head(new TokenTrie()) {
+  SharedParserData() {
     // listed in increasing order of precedence
     std::vector<std::vector<int>> binary_ops = {
         {'?'},      {TK_OR},
@@ -155,12 +329,12 @@ struct SharedParserData {
     std::stringstream ss;
     for (const char *c = valid_single_char_tokens; *c; c++) {
       const char str[] = {*c, '\0'};
-      head->insert(str, *c);
+      tokens.insert(str, *c);
     }
 
 #define ADD_CASE(tok, _, tokstring)                                            \
   if (*tokstring != '\0') {                                                    \
-    head->insert(tokstring, tok);                                              \
+    tokens.insert(tokstring, tok);                                             \
   }
     TC_FORALL_TOKEN_KINDS(ADD_CASE)
 #undef ADD_CASE
@@ -183,54 +357,67 @@ struct SharedParserData {
     }
   }
   bool isNumber(const std::string &str, size_t start, size_t *len) {
-    char first = str[start];
+    const char *s = str.c_str();
+    size_t size = str.size();
+    char first = s[start];
+
     // strtod allows numbers to start with + or -
     // http://en.cppreference.com/w/cpp/string/byte/strtof
     // but we want only the number part, otherwise 1+3 will turn into two
     // adjacent numbers in the lexer
     if (first == '-' || first == '+')
       return false;
-    const char *startptr = str.c_str() + start;
-    char *endptr;
-    std::strtod(startptr, &endptr);
-    *len = endptr - startptr;
+
+    bool maybeSpecial = first == 'i' || first == 'I' || first == 'n' ||
+                        first == 'N';
+
+    if (!maybeSpecial && first != '.' && !charClasses.is(first, CC_DIGIT))
+      return false;
+
+    // Hexadecimal numbers, infinities and NaNs are accepted by strtod,
+    // but rare enough to leave them to strtod
+    if ((first == '0' && start + 1 < size &&
+         (s[start + 1] == 'x' || s[start + 1] == 'X')) ||
+        (maybeSpecial && (startsWithNoCase(s + start, "inf") ||
+                          startsWithNoCase(s + start, "nan")))) {
+      char *endptr;
+      std::strtod(s + start, &endptr);
+      *len = endptr - (s + start);
+    } else {
+      *len = scanDecimal(s, start, size);
+    }
+
     if (*len == 0)
       return false;
 
+    size_t end = start + *len;
     bool isFloatLiteral = false;
 
-    for (const char *tokptr = startptr; tokptr != endptr; tokptr++) {
-      if (*tokptr == '.' || *tokptr == 'e') {
+    for (size_t i = start; i < end; i++) {
+      if (s[i] == '.' || s[i] == 'e') {
         isFloatLiteral = true;
         break;
       }
     }
 
-    // It's safe to dereference endptr, since as per the specification
-    // of strtod, it is either equal to startptr or the address of the
-    // character past startptr. Since startptr is initialized with
-    // std::string::c_str(), it is guaranteed to point to a sequence
-    // of characters terminated by zero, so endptr points at most at
-    // the NUL character at the end of the string.
-    //
-    // Similarly, the use of C string functions are safe here, since
-    // the above check guarantees that endptr hasn't moved past the
-    // NUL character.
-    if (*endptr != '\0') {
-      static const char *suffixes[] = {"i2", "i4",  "i8",  "i16", "i32", "i64",
-                                       "u2", "u4",  "u8",  "u16", "u32", "u64",
-                                       "z",  "f16", "f32", "f64"};
+    if (end < size && charClasses.is(s[end], CC_IDENT_START)) {
+      static const char *suffixes[] = {"i2",  "i4",  "i8",  "i16", "i32",
+                                       "i64", "u2",  "u4",  "u8",  "u16",
+                                       "u32", "u64", "z",   "f16", "f32",
+                                       "f64", "bf16"};
 
 #define ARRAY_SIZE(a) ((sizeof(a) / sizeof(a[0])))
 
       for (size_t i = 0; i < ARRAY_SIZE(suffixes); i++) {
         size_t sufflen = strlen(suffixes[i]);
 
-        if (std::strncmp(endptr, suffixes[i], sufflen) == 0) {
+        if (sufflen <= size - end &&
+            std::memcmp(s + end, suffixes[i], sufflen) == 0) {
           *len += sufflen;
 
           // Float literals must have a float type suffix
-          if (isFloatLiteral && suffixes[i][0] != 'f')
+          if (isFloatLiteral && suffixes[i][0] != 'f' &&
+              suffixes[i][0] != 'b')
             return false;
           else
             return true;
@@ -246,34 +433,37 @@ struct SharedParserData {
   // filling in kind, start,and len
   bool match(const std::string &str, size_t pos, int *kind, size_t *start,
              size_t *len, size_t *line, size_t *ch) {
-    // skip whitespace
-    while (pos < str.size() && isspace(str[pos])) {
-      if (str[pos] == '\n') {
-        (*line)++;
-        *ch = 1;
-      } else {
-        (*ch)++;
-      }
+    const char *s = str.c_str();
+    size_t size = str.size();
 
-      pos++;
-    }
-    // skip comments
-    if (pos < str.size() && str[pos] == '#') {
-      while (pos < str.size() && str[pos] != '\n') {
-        pos++;
-        (*ch)++;
-      }
+    // skip whitespace and comments
+    while (pos < size) {
+      size_t end = scanClass(charClasses, s, pos, size, CC_SPACE);
+      *ch += end - pos;
+      pos = end;
 
-      if (pos < str.size() && str[pos] == '\n') {
-        *ch = 1;
+      if (pos < size && s[pos] == '\n') {
         (*line)++;
+        *ch = 1;
+        pos++;
+      } else if (pos < size && s[pos] == '#') {
+        const void *nl = std::memchr(s + pos, '\n', size - pos);
+        end = nl ? static_cast<const char *>(nl) - s : size;
+        *ch += end - pos;
+        pos = end;
+
+        // The newline is counted again as whitespace, as it has
+        // always been, which keeps the source locations unchanged
+        if (pos < size) {
+          *ch = 1;
+          (*line)++;
+        }
+      } else {
+        break;
       }
-
-      // tail call, handle whitespace and more comments
-      return match(str, pos, kind, start, len, line, ch);
     }
     *start = pos;
-    if (pos == str.size()) {
+    if (pos == size) {
       *kind = TK_EOF;
       *len = 0;
       return true;
@@ -283,33 +473,42 @@ struct SharedParserData {
       *kind = TK_NUMBER;
       return true;
     }
-    // check for either an ident or a token
-    // ident tracks whether what we have scanned so far could be an identifier
-    // matched indicates if we have found any match.
-    bool matched = false;
-    bool ident = true;
-    TokenTrie *cur = head.get();
-    for (size_t i = 0; pos + i < str.size() && (ident || cur != nullptr); i++) {
-      ident = ident && validIdent(i, str[pos + i]);
-      if (ident) {
-        matched = true;
-        *len = i + 1;
-        *kind = TK_IDENT;
-      }
-      // check for token second, so that e.g. 'max' matches the token TK_MAX
-      // rather the
-      // identifier 'max'
-      if (cur) {
-        auto it = cur->children.find(str[pos + i]);
-        cur = (it == cur->children.end()) ? nullptr : it->second.get();
-        if (cur && cur->kind != 0) {
-          matched = true;
-          *len = i + 1;
-          *kind = cur->kind;
-        }
+    // check for either an ident or a token; the longest match wins and
+    // tokens win over identifiers of the same length, so that e.g.
+    // 'max' matches the token TK_MAX rather than the identifier 'max'
+    size_t identLen = 0;
+
+    if (charClasses.is(s[pos], CC_IDENT_START))
+      identLen = scanClass(charClasses, s, pos + 1, size, CC_IDENT) - pos;
+
+    size_t tokenLen = 0;
+    int tokenKind = 0;
+
+    for (int state = 0, i = 0; pos + i < size; i++) {
+      state = tokens.next(state, s[pos + i]);
+
+      if (state < 0)
+        break;
+
+      if (tokens.kinds[state] != 0) {
+        tokenLen = i + 1;
+        tokenKind = tokens.kinds[state];
       }
     }
-    return matched;
+
+    if (tokenLen > 0 && tokenLen >= identLen) {
+      *kind = tokenKind;
+      *len = tokenLen;
+      return true;
+    }
+
+    if (identLen > 0) {
+      *kind = TK_IDENT;
+      *len = identLen;
+      return true;
+    }
+
+    return false;
   }
   bool isUnary(int kind, int *prec) {
     auto it = unary_prec.find(kind);
@@ -352,6 +551,7 @@ struct SharedParserData {
     case TK_INT64:
     case TK_SIZET:
     case TK_FLOAT16:
+    case TK_BFLOAT16:
     case TK_FLOAT32:
     case TK_FLOAT64:
     case TK_FLOAT:
@@ -363,10 +563,51 @@ struct SharedParserData {
   }
 
 private:
-  bool validIdent(size_t i, char n) {
-    return isalpha(n) || n == '_' || (i > 0 && isdigit(n));
+  // Returns the length of the decimal floating point or integer
+  // number starting at `start` in the string `s` of size `size` in
+  // the syntax accepted by strtod, or 0 if there is no such number
+  // Checks if the NUL-terminated string `s` starts with the lowercase
+  // string `prefix`, ignoring the case of `s`
+  static bool startsWithNoCase(const char *s, const char *prefix) {
+    for (; *prefix; s++, prefix++) {
+      if (std::tolower(static_cast<unsigned char>(*s)) != *prefix)
+        return false;
+    }
+
+    return true;
+  }
+  size_t scanDecimal(const char *s, size_t start, size_t size) {
+    size_t pos = scanClass(charClasses, s, start, size, CC_DIGIT);
+    bool hasDigits = pos > start;
+
+    if (pos < size && s[pos] == '.') {
+      size_t end = scanClass(charClasses, s, pos + 1, size, CC_DIGIT);
+      hasDigits = hasDigits || end > pos + 1;
+
+      if (hasDigits)
+        pos = end;
+    }
+
+    if (!hasDigits)
+      return 0;
+
+    // The exponent is only part of the number if it has digits
+    if (pos < size && (s[pos] == 'e' || s[pos] == 'E')) {
+      size_t expStart = pos + 1;
+
+      if (expStart < size && (s[expStart] == '+' || s[expStart] == '-'))
+        expStart++;
+
+      size_t end = scanClass(charClasses, s, expStart, size, CC_DIGIT);
+
+      if (end > expStart)
+        pos = end;
+    }
+
+    return pos - start;
   }
-  TokenTrieRef head;
+  CharClassTable charClasses;
+  TokenDFA tokens;
   std::unordered_map<int, int>
       unary_prec; // map from token to its unary precedence
   std::unordered_map<int, int>
@@ -449,11 +690,11 @@ struct Token {
       std::string suffix = text().substr(idx);
 
       assert(suffix == "f16" || suffix == "f32" || suffix == "f64" ||
-             suffix == "u2" || suffix == "u4" || suffix == "u8" ||
-             suffix == "u16" || suffix == "u32" || suffix == "u64" ||
-             suffix == "i2" || suffix == "i4" || suffix == "i8" ||
-             suffix == "i16" || suffix == "i32" || suffix == "i64" ||
-             suffix == "z");
+             suffix == "bf16" || suffix == "u2" || suffix == "u4" ||
+             suffix == "u8" || suffix == "u16" || suffix == "u32" ||
+             suffix == "u64" || suffix == "i2" || suffix == "i4" ||
+             suffix == "i8" || suffix == "i16" || suffix == "i32" ||
+             suffix == "i64" || suffix == "z");
     } else {
       assert(idx == range.size());
     }
@@ -462,8 +703,8 @@ struct Token {
   }
   // Returns the suffix for the number literal (either "u2", "u4",
   // "u8", "u16", "u32", "u64", "i2", "i4", "i8", "i16", "i32", "i64",
-  // "f16", "f32", "f64", "z" or the empty string "" if no suffix has
-  // been specified originally.
+  // "f16", "f32", "f64", "bf16", "z" or the empty string "" if no
+  // suffix has been specified originally.
   std::string numSuffix() {
     assert(TK_NUMBER == kind);
     size_t idx;
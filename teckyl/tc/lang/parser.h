@@ -44,6 +44,8 @@ struct Parser {
     // and 32-bit precision for floating point values by default.
     if (suffix == "f16")
       type = TK_FLOAT16;
+    else if (suffix == "bf16")
+      type = TK_BFLOAT16;
     else if (suffix == "f32")
       type = TK_FLOAT32;
     else if (suffix == "f64")
@@ -233,10 +235,21 @@ struct Parser {
       return Param::create(ident->range(), ident,
                            c(TK_INFERRED, ident->range(), {}));
     }
-    auto typ = parseType();
+    auto st = parseScalarType();
+    auto list = parseOptionalDimList();
     auto ident = parseIdent();
+    auto layout = parseOptionalLayout();
+    auto typ = TensorType::create(st->range(), st, list, layout);
     return Param::create(typ->range(), ident, typ);
   }
+  // @layout following the name of a parameter
+  TreeRef parseOptionalLayout() {
+    auto r = L.cur().range;
+    if (L.nextIf('@')) {
+      return c(TK_OPTION, r, {parseIdent()});
+    }
+    return c(TK_OPTION, r, {});
+  }
   TreeRef parseWhereClauses() {
     if (L.nextIf(TK_WHERE)) {
       return parseNonEmptyList(',', [&](int i) { return parseWhereClause(); });
@@ -321,7 +334,8 @@ struct Parser {
   TreeRef parseType() {
     auto st = parseScalarType();
     auto list = parseOptionalDimList();
-    return TensorType::create(st->range(), st, list);
+    return TensorType::create(st->range(), st, list,
+                              c(TK_OPTION, st->range(), {}));
   }
   TreeRef parseFunction() {
     L.expect(TK_DEF);
@@ -19,6 +19,7 @@
 #include <unordered_set>
 
 #include "teckyl/PrefixedOStream.h"
+#include "teckyl/lang_layout.h"
 #include "teckyl/tc/lang/builtins.h"
 #include "teckyl/tc/lang/error_report.h"
 #include "teckyl/tc/lang/inference/ranges.h"
@@ -32,7 +33,9 @@ namespace lang {
 // dependency for this trivial functionality, and it allows us to
 // modify the behavior in the future
 struct TypeInfo {
-  enum Code { Int, UInt, Float };
+  // BFloat denotes the bfloat16 format, which has the same size as
+  // 16-bit IEEE floats, but a wider exponent and a shorter mantissa
+  enum Code { Int, UInt, Float, BFloat };
   TypeInfo(Code code_, uint8_t bits_) : code_(code_), bits_(bits_) {}
   TypeInfo(TreeRef scalar_type) {
     switch (scalar_type->kind()) {
@@ -55,6 +58,7 @@ struct TypeInfo {
       TYPE_INFO_OPTION(TK_INT32, Int, 32)
       TYPE_INFO_OPTION(TK_INT64, Int, 64)
       TYPE_INFO_OPTION(TK_FLOAT16, Float, 16)
+      TYPE_INFO_OPTION(TK_BFLOAT16, BFloat, 16)
       TYPE_INFO_OPTION(TK_FLOAT32, Float, 32)
       TYPE_INFO_OPTION(TK_FLOAT64, Float, 64)
       TYPE_INFO_OPTION(TK_FLOAT, Float, 32)
@@ -111,13 +115,18 @@ struct TypeInfo {
       case 64:
         return TK_DOUBLE;
       }
+    case BFloat:
+      switch (bits()) {
+      case 16:
+        return TK_BFLOAT16;
+      }
     }
 
     llvm_unreachable("Unknown type info?");
   }
   Code code() const { return code_; }
   uint8_t bits() const { return bits_; }
-  bool is_float() const { return code_ == Float; }
+  bool is_float() const { return code_ == Float || code_ == BFloat; }
   bool is_uint() const { return code_ == UInt; }
 
 private:
@@ -143,7 +152,12 @@ static inline TreeRef match_types(TreeRef a, TreeRef b) {
     return a;
   } else if (ta.is_float() && tb.is_float()) {
     // float(a) * float(b) -> float(max(a, b))
-    if (ta.bits() > tb.bits())
+    //
+    // float16 and bfloat16 cannot represent each other's values, so
+    // mixing both promotes to float32
+    if (ta.bits() == tb.bits())
+      return Compound::create(TK_FLOAT, a->range(), {});
+    else if (ta.bits() > tb.bits())
       return a;
     else
       return b;
@@ -215,7 +229,7 @@ struct Sema {
   }
 
   TreeRef expectIntegral(TreeRef e) {
-    if (TypeInfo(typeOfExpr(e)).code() == TypeInfo::Float) {
+    if (TypeInfo(typeOfExpr(e)).is_float()) {
       ErrorReport err(e);
       err << " expected integral type but found "
           << kindToString(typeOfExpr(e)->kind());
@@ -488,6 +502,16 @@ struct Sema {
       if (d->kind() == TK_IDENT)
         checkDim(Ident(d));
     }
+    if (tt.layout().present()) {
+      teckyl::layout::Layout layout;
+      std::string what;
+      if (!teckyl::layout::parseLayout(tt.layout().get().name(),
+                                       tt.dims().size(), layout, what)) {
+        ErrorReport err(tt.layout().get());
+        err << "Invalid layout " << tt.layout().get().name() << ": " << what;
+        llvm_unreachable(err.what());
+      }
+    }
     return type;
   }
 
@@ -635,7 +659,8 @@ struct Sema {
 
     auto type = TensorType::create(
         stmt.range(), scalar_type,
-        List::create(stmt.range(), std::move(output_indices)));
+        List::create(stmt.range(), std::move(output_indices)),
+        createCompound(TK_OPTION, stmt.range(), {}));
     insert(env, stmt.ident(), type, false);
 
     // if we redefined an input, it is no longer valid for range expressions
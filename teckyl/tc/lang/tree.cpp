@@ -1,5 +1,5 @@
 #include "tree.h"
 
 namespace lang {
-unsigned int TreeId::curr_id = 0;
+std::atomic<unsigned int> TreeId::curr_id(0);
 };
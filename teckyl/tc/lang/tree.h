@@ -16,6 +16,7 @@
 #ifndef TECKYL_TC_LANG_TREE_H_
 #define TECKYL_TC_LANG_TREE_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <sstream>
@@ -57,13 +58,14 @@ public:
   TreeId(int id) : id(id) {}
   bool operator<(const TreeId &other) const { return this->id < other.id; }
 
-  // FIXME: This is not thread safe
+  // Trees may be created concurrently, e.g., by a kernel compiled on
+  // a background thread (see teckyl-run)
   static TreeId generate() { return TreeId(curr_id++); }
 
 protected:
   unsigned int id;
 
-  static unsigned int curr_id;
+  static std::atomic<unsigned int> curr_id;
 };
 
 struct Tree : std::enable_shared_from_this<Tree> {
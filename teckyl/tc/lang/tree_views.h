@@ -35,7 +35,9 @@ namespace lang {
 //
 // -- NB: dim_list can only contain Const and Ident trees
 // -- NB: dim_list is optional (can be empty)
-// Type  = TensorType(ScalarType scalar_type, List<Expr> dim_list)      TK_TENSOR_TYPE
+// -- NB: layout is the name of the layout following the parameter name
+// Type  = TensorType(ScalarType scalar_type, List<Expr> dim_list,      TK_TENSOR_TYPE
+//                    Option<Ident> layout)
 // Param = Param(Ident name, Type type)                                 TK_PARAM
 //
 // Def   = Def(Ident name, List<Param> params, List<Param> returns, List<Stmt> body) TK_DEF
@@ -223,11 +225,12 @@ private:
 
 struct TensorType : public TreeView {
   explicit TensorType(const TreeRef &tree) : TreeView(tree) {
-    tree_->expect(TK_TENSOR_TYPE, 2);
+    tree_->expect(TK_TENSOR_TYPE, 3);
   }
   static TreeRef create(const SourceRange &range, TreeRef scalar_type_,
-                        TreeRef dims_) {
-    return Compound::create(TK_TENSOR_TYPE, range, {scalar_type_, dims_});
+                        TreeRef dims_, TreeRef layout_) {
+    return Compound::create(TK_TENSOR_TYPE, range,
+                            {scalar_type_, dims_, layout_});
   }
   TreeRef scalarTypeTree() const {
     auto scalar_type_ = subtree(0);
@@ -242,6 +245,8 @@ struct TensorType : public TreeView {
   int scalarType() const { return scalarTypeTree()->kind(); }
   // either an Ident or a constant
   ListView<TreeRef> dims() const { return ListView<TreeRef>(subtree(1)); }
+  // layout annotation (e.g., colmajor), see teckyl/lang_layout.h
+  OptionView<Ident> layout() const { return OptionView<Ident>(subtree(2)); }
 };
 
 struct Param : public TreeView {
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated function with inlined calls to mv and add under test */
+extern void mv_residual(DECL_VEC2D_FUNC_IN_ARGS(w, float),
+			DECL_VEC1D_FUNC_IN_ARGS(v, float),
+			DECL_VEC1D_FUNC_IN_ARGS(r, float),
+			DECL_VEC1D_FUNC_OUT_ARGS(t, float),
+			DECL_VEC1D_FUNC_OUT_ARGS(u, float));
+
+/* Reference implementation of mv_residual */
+void mv_residual_refimpl(const struct vec_f2d* w, const struct vec_f1d* v,
+			 const struct vec_f1d* r, struct vec_f1d* t,
+			 struct vec_f1d* u)
+{
+	float accu;
+
+	for(int64_t i = 0; i < w->sizes[0]; i++) {
+		accu = 0;
+
+		for(int64_t k = 0; k < w->sizes[1]; k++)
+			accu += vec_f2d_get(w, k, i) * vec_f1d_get(v, k);
+
+		vec_f1d_set(t, i, accu);
+		vec_f1d_set(u, i, accu + vec_f1d_get(r, i));
+	}
+}
+
+/* Checks if the elements of two 1d memrefs of the same size are
+ * equal */
+int vecs_equal(const struct vec_f1d* a, const struct vec_f1d* b)
+{
+	for(int64_t i = 0; i < a->sizes[0]; i++)
+		if(vec_f1d_get(a, i) != vec_f1d_get(b, i))
+			return 0;
+
+	return 1;
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct vec_f2d w;
+	struct vec_f1d v, r, t, u, t_ref, u_ref;
+	int verbose = 0;
+	int p = 11;
+	int q = 7;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(vec_f2d_alloc(&w, p, q) ||
+	   vec_f1d_alloc(&v, q) ||
+	   vec_f1d_alloc(&r, p) ||
+	   vec_f1d_alloc(&t, p) ||
+	   vec_f1d_alloc(&u, p) ||
+	   vec_f1d_alloc(&t_ref, p) ||
+	   vec_f1d_alloc(&u_ref, p))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	/* Small integers, such that sums are exact in any order */
+	for(int64_t i = 0; i < p; i++) {
+		for(int64_t k = 0; k < q; k++)
+			vec_f2d_set(&w, k, i, (i * 3 + k) % 5 - 2);
+
+		vec_f1d_set(&r, i, i % 4);
+	}
+
+	for(int64_t k = 0; k < q; k++)
+		vec_f1d_set(&v, k, k % 3 - 1);
+
+	mv_residual(VEC2D_ARGS(&w), VEC1D_ARGS(&v), VEC1D_ARGS(&r),
+		    VEC1D_ARGS(&t), VEC1D_ARGS(&u));
+	mv_residual_refimpl(&w, &v, &r, &t_ref, &u_ref);
+
+	if(verbose) {
+		puts("Result t, u:");
+		vec_f1d_dump(&t);
+		vec_f1d_dump(&u);
+		puts("");
+
+		puts("Reference t, u:");
+		vec_f1d_dump(&t_ref);
+		vec_f1d_dump(&u_ref);
+		puts("");
+	}
+
+	if(!vecs_equal(&t, &t_ref) || !vecs_equal(&u, &u_ref)) {
+		fputs("Result differs from reference result\n", stderr);
+		exit(1);
+	}
+
+	vec_f2d_destroy(&w);
+	vec_f1d_destroy(&v);
+	vec_f1d_destroy(&r);
+	vec_f1d_destroy(&t);
+	vec_f1d_destroy(&u);
+	vec_f1d_destroy(&t_ref);
+	vec_f1d_destroy(&u_ref);
+
+	return 0;
+}
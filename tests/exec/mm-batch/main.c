@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Generated header with mm_batch_wrap() */
+#include "mm-batch.h"
+
+#define BATCH 100
+#define M 8
+#define K 5
+#define N 7
+
+static float a[BATCH][M][K];
+static float b[BATCH][K][N];
+static float alpha[BATCH];
+static float c[BATCH][M][N];
+
+/* Reference implementation of the scaled matrix multiplication of
+ * the problem `p` */
+static float mm_refimpl(int p, int i, int j)
+{
+	float accu = 0;
+
+	for(int k = 0; k < K; k++)
+		accu += alpha[p] * a[p][i][k] * b[p][k][j];
+
+	return accu;
+}
+
+int main(void)
+{
+	/* Small integers, such that the results are exact */
+	for(int p = 0; p < BATCH; p++) {
+		alpha[p] = p % 3 - 1;
+
+		for(int i = 0; i < M; i++)
+			for(int k = 0; k < K; k++)
+				a[p][i][k] = (p + i + k) % 5;
+
+		for(int k = 0; k < K; k++)
+			for(int j = 0; j < N; j++)
+				b[p][k][j] = (p * k + j) % 7 - 3;
+
+		/* Must be overwritten */
+		for(int i = 0; i < M; i++)
+			for(int j = 0; j < N; j++)
+				c[p][i][j] = 1234;
+	}
+
+	mm_batch_wrap(&a[0][0][0], &b[0][0][0], alpha, &c[0][0][0],
+		      BATCH, M, K, N);
+
+	for(int p = 0; p < BATCH; p++) {
+		for(int i = 0; i < M; i++) {
+			for(int j = 0; j < N; j++) {
+				if(c[p][i][j] != mm_refimpl(p, i, j)) {
+					fprintf(stderr, "Result of problem %d "
+						"differs from reference result "
+						"at (%d, %d)\n", p, i, j);
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
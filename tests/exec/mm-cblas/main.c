@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated matrix multiplication functions under test */
+#define DECL_MM_KERNEL(name)					\
+  extern void name(DECL_VEC2D_FUNC_IN_ARGS(a, float),		\
+		   DECL_VEC2D_FUNC_IN_ARGS(b, float),		\
+		   DECL_VEC2D_FUNC_OUT_ARGS(c, float))
+
+/* Generated matrix-vector products under test */
+#define DECL_MV_KERNEL(name)					\
+  extern void name(DECL_VEC2D_FUNC_IN_ARGS(a, float),		\
+		   DECL_VEC1D_FUNC_IN_ARGS(x, float),		\
+		   DECL_VEC1D_FUNC_OUT_ARGS(y, float))
+
+DECL_MM_KERNEL(mm);
+DECL_MM_KERNEL(mm_at);
+DECL_MM_KERNEL(mm_ccm);
+DECL_MM_KERNEL(mm_acc);
+DECL_MV_KERNEL(mv);
+DECL_MV_KERNEL(mv_acc);
+
+typedef void (*mm_kernel_t)(DECL_VEC2D_FUNC_IN_ARGS(a, float),
+			    DECL_VEC2D_FUNC_IN_ARGS(b, float),
+			    DECL_VEC2D_FUNC_OUT_ARGS(c, float));
+
+typedef void (*mv_kernel_t)(DECL_VEC2D_FUNC_IN_ARGS(a, float),
+			    DECL_VEC1D_FUNC_IN_ARGS(x, float),
+			    DECL_VEC1D_FUNC_OUT_ARGS(y, float));
+
+/* Matrix multiplications under test. Operands with a column-major
+ * layout are passed to BLAS as transposed matrices; a column-major
+ * output forces the column-major storage order for the BLAS call. */
+static const struct {
+	const char* name;
+	mm_kernel_t fn;
+	int a_colmajor;
+	int c_colmajor;
+	int accumulate;
+} mm_tests[] = {
+	{ "mm", mm, 0, 0, 0 },
+	{ "mm_at", mm_at, 1, 0, 0 },
+	{ "mm_ccm", mm_ccm, 0, 1, 0 },
+	{ "mm_acc", mm_acc, 0, 0, 1 },
+};
+
+/* Matrix-vector products under test */
+static const struct {
+	const char* name;
+	mv_kernel_t fn;
+	int accumulate;
+} mv_tests[] = {
+	{ "mv", mv, 0 },
+	{ "mv_acc", mv_acc, 1 },
+};
+
+/* Returns a pointer to the element (i, j) of a strided 2d memref */
+static float* f2d_elem(const struct vec_f2d* m, int64_t i, int64_t j)
+{
+	return m->alignedPtr + m->offset + i * m->strides[0] +
+		j * m->strides[1];
+}
+
+/* Returns a pointer to the element i of a strided 1d memref */
+static float* f1d_elem(const struct vec_f1d* v, int64_t i)
+{
+	return v->alignedPtr + v->offset + i * v->strides[0];
+}
+
+/* Allocates a rows x cols matrix in row-major or column-major
+ * order. Matrices with an empty dimension are backed by a single
+ * element, such that the allocation never has a size of zero. Returns
+ * 0 on success, otherwise 1. */
+static int matrix_alloc(struct vec_f2d* m, int64_t rows, int64_t cols,
+			int colmajor)
+{
+	int64_t prows = rows ? rows : 1;
+	int64_t pcols = cols ? cols : 1;
+
+	if(vec_f2d_alloc(m, prows, pcols))
+		return 1;
+
+	m->sizes[0] = rows;
+	m->sizes[1] = cols;
+	m->strides[0] = colmajor ? 1 : pcols;
+	m->strides[1] = colmajor ? prows : 1;
+
+	return 0;
+}
+
+/* Allocates a vector of n elements like matrix_alloc() */
+static int vector_alloc(struct vec_f1d* v, int64_t n)
+{
+	if(vec_f1d_alloc(v, n ? n : 1))
+		return 1;
+
+	v->sizes[0] = n;
+
+	return 0;
+}
+
+/* Initializes a matrix with small integers, such that sums are exact
+ * in any order */
+static void init_matrix(struct vec_f2d* m, int seed)
+{
+	for(int64_t i = 0; i < m->sizes[0]; i++)
+		for(int64_t j = 0; j < m->sizes[1]; j++)
+			*f2d_elem(m, i, j) = (i * 3 + j * 5 + seed) % 7 - 3;
+}
+
+/* Initializes a vector like init_matrix() */
+static void init_vector(struct vec_f1d* v, int seed)
+{
+	for(int64_t i = 0; i < v->sizes[0]; i++)
+		*f1d_elem(v, i) = (i * 3 + seed) % 7 - 3;
+}
+
+/* Reference implementation of a matrix multiplication, adding to the
+ * previous values of c if `accumulate` is set */
+static void mm_refimpl(const struct vec_f2d* a, const struct vec_f2d* b,
+		       struct vec_f2d* c, int accumulate)
+{
+	for(int64_t i = 0; i < c->sizes[0]; i++) {
+		for(int64_t j = 0; j < c->sizes[1]; j++) {
+			float accu = accumulate ? *f2d_elem(c, i, j) : 0;
+
+			for(int64_t k = 0; k < a->sizes[1]; k++)
+				accu += *f2d_elem(a, i, k) * *f2d_elem(b, k, j);
+
+			*f2d_elem(c, i, j) = accu;
+		}
+	}
+}
+
+/* Reference implementation of a matrix-vector product, adding to the
+ * previous values of y if `accumulate` is set */
+static void mv_refimpl(const struct vec_f2d* a, const struct vec_f1d* x,
+		       struct vec_f1d* y, int accumulate)
+{
+	for(int64_t i = 0; i < y->sizes[0]; i++) {
+		float accu = accumulate ? *f1d_elem(y, i) : 0;
+
+		for(int64_t k = 0; k < a->sizes[1]; k++)
+			accu += *f2d_elem(a, i, k) * *f1d_elem(x, k);
+
+		*f1d_elem(y, i) = accu;
+	}
+}
+
+/* Checks if the elements of two matrices of the same size are equal */
+static int matrices_equal(const struct vec_f2d* a, const struct vec_f2d* b)
+{
+	for(int64_t i = 0; i < a->sizes[0]; i++)
+		for(int64_t j = 0; j < a->sizes[1]; j++)
+			if(*f2d_elem(a, i, j) != *f2d_elem(b, i, j))
+				return 0;
+
+	return 1;
+}
+
+/* Checks if the elements of two vectors of the same size are equal */
+static int vectors_equal(const struct vec_f1d* a, const struct vec_f1d* b)
+{
+	for(int64_t i = 0; i < a->sizes[0]; i++)
+		if(*f1d_elem(a, i) != *f1d_elem(b, i))
+			return 0;
+
+	return 1;
+}
+
+/* Runs the matrix multiplication with index `t` in mm_tests for an
+ * m x k matrix A and a k x n matrix B. The output is initialized with
+ * non-zero values, which must be overwritten by kernels with a
+ * default-initialized output. Returns 0 on success, otherwise 1. */
+static int run_mm_test(size_t t, int64_t m, int64_t n, int64_t k,
+		       int verbose)
+{
+	struct vec_f2d a, b, c, c_ref;
+	int ret = 0;
+
+	if(verbose)
+		printf("%s, M=%" PRId64 ", N=%" PRId64 ", K=%" PRId64 "\n",
+		       mm_tests[t].name, m, n, k);
+
+	if(matrix_alloc(&a, m, k, mm_tests[t].a_colmajor) ||
+	   matrix_alloc(&b, k, n, 0) ||
+	   matrix_alloc(&c, m, n, mm_tests[t].c_colmajor) ||
+	   matrix_alloc(&c_ref, m, n, mm_tests[t].c_colmajor))
+	{
+		fprintf(stderr, "Allocation failed");
+		exit(1);
+	}
+
+	init_matrix(&a, 1);
+	init_matrix(&b, 2);
+	init_matrix(&c, 3);
+	init_matrix(&c_ref, 3);
+
+	mm_tests[t].fn(VEC2D_ARGS(&a), VEC2D_ARGS(&b), VEC2D_ARGS(&c));
+	mm_refimpl(&a, &b, &c_ref, mm_tests[t].accumulate);
+
+	if(!matrices_equal(&c, &c_ref)) {
+		fprintf(stderr, "Result of %s with K=%" PRId64 " differs "
+			"from reference result\n", mm_tests[t].name, k);
+		ret = 1;
+	}
+
+	vec_f2d_destroy(&a);
+	vec_f2d_destroy(&b);
+	vec_f2d_destroy(&c);
+	vec_f2d_destroy(&c_ref);
+
+	return ret;
+}
+
+/* Runs the matrix-vector product with index `t` in mv_tests for an
+ * m x k matrix like run_mm_test() */
+static int run_mv_test(size_t t, int64_t m, int64_t k, int verbose)
+{
+	struct vec_f2d a;
+	struct vec_f1d x, y, y_ref;
+	int ret = 0;
+
+	if(verbose)
+		printf("%s, M=%" PRId64 ", K=%" PRId64 "\n",
+		       mv_tests[t].name, m, k);
+
+	if(matrix_alloc(&a, m, k, 0) ||
+	   vector_alloc(&x, k) ||
+	   vector_alloc(&y, m) ||
+	   vector_alloc(&y_ref, m))
+	{
+		fprintf(stderr, "Allocation failed");
+		exit(1);
+	}
+
+	init_matrix(&a, 1);
+	init_vector(&x, 2);
+	init_vector(&y, 3);
+	init_vector(&y_ref, 3);
+
+	mv_tests[t].fn(VEC2D_ARGS(&a), VEC1D_ARGS(&x), VEC1D_ARGS(&y));
+	mv_refimpl(&a, &x, &y_ref, mv_tests[t].accumulate);
+
+	if(!vectors_equal(&y, &y_ref)) {
+		fprintf(stderr, "Result of %s with K=%" PRId64 " differs "
+			"from reference result\n", mv_tests[t].name, k);
+		ret = 1;
+	}
+
+	vec_f2d_destroy(&a);
+	vec_f1d_destroy(&x);
+	vec_f1d_destroy(&y);
+	vec_f1d_destroy(&y_ref);
+
+	return ret;
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	/* Reductions over an empty dimension must still initialize or
+	 * keep the output, which BLAS implementations skip */
+	const int64_t ks[] = { 9, 0 };
+	int verbose = 0;
+	int failed = 0;
+	int64_t m = 12;
+	int64_t n = 6;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	for(size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+		for(size_t t = 0; t < sizeof(mm_tests) / sizeof(mm_tests[0]); t++)
+			failed |= run_mm_test(t, m, n, ks[i], verbose);
+
+		for(size_t t = 0; t < sizeof(mv_tests) / sizeof(mv_tests[0]); t++)
+			failed |= run_mv_test(t, m, ks[i], verbose);
+	}
+
+	return failed;
+}
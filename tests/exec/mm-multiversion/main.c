@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated header with the variants of the function under test and
+ * the dispatcher mm() */
+#include "mm-multiversion.h"
+
+/* Reference implementation of a matrix multiplication */
+void mm_refimpl(const struct vec_f2d* a, const struct vec_f2d* b, struct vec_f2d* o)
+{
+	float accu;
+
+	for(int64_t y = 0; y < o->sizes[0]; y++) {
+		for(int64_t x = 0; x < o->sizes[1]; x++) {
+			accu = 0;
+
+			for(int64_t k = 0; k < a->sizes[1]; k++)
+				accu += vec_f2d_get(a, k, y) * vec_f2d_get(b, x, k);
+
+			vec_f2d_set(o, x, y, accu);
+		}
+	}
+}
+
+/* Initialize matrix with value x+y at position (x, y) */
+void init_matrix(struct vec_f2d* m)
+{
+	for(int64_t y = 0; y < m->sizes[0]; y++)
+		for(int64_t x = 0; x < m->sizes[1]; x++)
+			vec_f2d_set(m, x, y, x+y);
+}
+
+/* Runs the variant `variant` and compares the result with the
+ * reference result `o_ref`. Returns 1 if the results are identical,
+ * otherwise 0. */
+int check_variant(const char* name, mm_variant_t variant,
+		  const struct vec_f2d* a, const struct vec_f2d* b,
+		  struct vec_f2d* o, const struct vec_f2d* o_ref,
+		  int verbose)
+{
+	memset(o->alignedPtr, 0, o->sizes[0] * o->sizes[1] * sizeof(float));
+
+	variant(VEC2D_ARGS(a), VEC2D_ARGS(b), VEC2D_ARGS(o));
+
+	if(verbose) {
+		printf("Result O (%s):\n", name);
+		vec_f2d_dump(o);
+		puts("");
+	}
+
+	if(!vec_f2d_compare(o, o_ref)) {
+		fprintf(stderr, "Result of %s differs from reference result\n",
+			name);
+		return 0;
+	}
+
+	return 1;
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct vec_f2d a, b, o, o_ref;
+	int verbose = 0;
+	int n = 6;
+	int k = 9;
+	int m = 12;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(vec_f2d_alloc(&a, n, k) ||
+	   vec_f2d_alloc(&b, k, m) ||
+	   vec_f2d_alloc(&o, n, m) ||
+	   vec_f2d_alloc(&o_ref, n, m))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	init_matrix(&a);
+	init_matrix(&b);
+
+	mm_refimpl(&a, &b, &o_ref);
+
+	if(verbose) {
+		puts("Reference O:");
+		vec_f2d_dump(&o_ref);
+		puts("");
+	}
+
+	/* The dispatcher and each variant the host can execute */
+	if(!check_variant("mm", mm, &a, &b, &o, &o_ref, verbose) ||
+	   !check_variant("mm_generic", mm_generic, &a, &b, &o, &o_ref,
+			  verbose))
+	{
+		exit(1);
+	}
+
+	if(mm_select_variant() == mm_avx512 &&
+	   !check_variant("mm_avx512", mm_avx512, &a, &b, &o, &o_ref, verbose))
+	{
+		exit(1);
+	}
+
+	if(mm_select_variant() != mm_generic &&
+	   mm_select_variant() != mm_sse42 &&
+	   !check_variant("mm_avx2", mm_avx2, &a, &b, &o, &o_ref, verbose))
+	{
+		exit(1);
+	}
+
+	if(mm_select_variant() != mm_generic &&
+	   !check_variant("mm_sse42", mm_sse42, &a, &b, &o, &o_ref, verbose))
+	{
+		exit(1);
+	}
+
+	vec_f2d_destroy(&a);
+	vec_f2d_destroy(&b);
+	vec_f2d_destroy(&o);
+	vec_f2d_destroy(&o_ref);
+
+	return 0;
+}
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated matrix multiplication functions under test */
+#define DECL_MM_KERNEL(name, intype, outtype)			\
+  extern void name(DECL_VEC2D_FUNC_IN_ARGS(a, intype),		\
+		   DECL_VEC2D_FUNC_IN_ARGS(b, intype),		\
+		   DECL_VEC2D_FUNC_OUT_ARGS(c, outtype))
+
+/* Generated matrix-vector products under test */
+#define DECL_MV_KERNEL(name, intype, outtype)			\
+  extern void name(DECL_VEC2D_FUNC_IN_ARGS(a, intype),		\
+		   DECL_VEC1D_FUNC_IN_ARGS(x, intype),		\
+		   DECL_VEC1D_FUNC_OUT_ARGS(y, outtype))
+
+DECL_MM_KERNEL(mm, float, float);
+DECL_MM_KERNEL(mm_at, float, float);
+DECL_MM_KERNEL(mm_ccm, float, float);
+DECL_MM_KERNEL(mm_acc, float, float);
+DECL_MV_KERNEL(mv, float, float);
+DECL_MV_KERNEL(mv_at, float, float);
+DECL_MV_KERNEL(mv_acc, float, float);
+
+DECL_MM_KERNEL(mm_i8, int8_t, int32_t);
+DECL_MM_KERNEL(mm_i8_at, int8_t, int32_t);
+DECL_MM_KERNEL(mm_i8_ccm, int8_t, int32_t);
+DECL_MM_KERNEL(mm_i8_acc, int8_t, int32_t);
+DECL_MV_KERNEL(mv_i8, int8_t, int32_t);
+DECL_MV_KERNEL(mv_i8_at, int8_t, int32_t);
+DECL_MV_KERNEL(mv_i8_acc, int8_t, int32_t);
+
+/* Defines functions for strided memrefs of type struct vec_<name>2d
+ * and struct vec_<name>1d with elements of type eltype. Matrices are
+ * allocated in row-major or column-major order; matrices and vectors
+ * with an empty dimension are backed by a single element, such that
+ * allocations never have a size of zero. Initialization uses small
+ * integers, such that sums are exact in any order. */
+#define DEFINE_MEMREF_FUNCTIONS(name, eltype)				\
+  static eltype* name##_elem2d(const struct vec_##name##2d* m,		\
+			       int64_t i, int64_t j)			\
+  {									\
+	  return m->alignedPtr + m->offset + i * m->strides[0] +	\
+		  j * m->strides[1];					\
+  }									\
+									\
+  static eltype* name##_elem1d(const struct vec_##name##1d* v, int64_t i) \
+  {									\
+	  return v->alignedPtr + v->offset + i * v->strides[0];		\
+  }									\
+									\
+  static int name##_matrix_alloc(struct vec_##name##2d* m,		\
+				 int64_t rows, int64_t cols,		\
+				 int colmajor)				\
+  {									\
+	  int64_t prows = rows ? rows : 1;				\
+	  int64_t pcols = cols ? cols : 1;				\
+									\
+	  if(vec_##name##2d_alloc(m, prows, pcols))			\
+		  return 1;						\
+									\
+	  m->sizes[0] = rows;						\
+	  m->sizes[1] = cols;						\
+	  m->strides[0] = colmajor ? 1 : pcols;				\
+	  m->strides[1] = colmajor ? prows : 1;				\
+									\
+	  return 0;							\
+  }									\
+									\
+  static int name##_vector_alloc(struct vec_##name##1d* v, int64_t n)	\
+  {									\
+	  if(vec_##name##1d_alloc(v, n ? n : 1))			\
+		  return 1;						\
+									\
+	  v->sizes[0] = n;						\
+									\
+	  return 0;							\
+  }									\
+									\
+  static void name##_init_matrix(struct vec_##name##2d* m, int seed)	\
+  {									\
+	  for(int64_t i = 0; i < m->sizes[0]; i++)			\
+		  for(int64_t j = 0; j < m->sizes[1]; j++)		\
+			  *name##_elem2d(m, i, j) =			\
+				  (i * 3 + j * 5 + seed) % 7 - 3;	\
+  }									\
+									\
+  static void name##_init_vector(struct vec_##name##1d* v, int seed)	\
+  {									\
+	  for(int64_t i = 0; i < v->sizes[0]; i++)			\
+		  *name##_elem1d(v, i) = (i * 3 + seed) % 7 - 3;	\
+  }									\
+									\
+  static int name##_matrices_equal(const struct vec_##name##2d* a,	\
+				   const struct vec_##name##2d* b)	\
+  {									\
+	  for(int64_t i = 0; i < a->sizes[0]; i++)			\
+		  for(int64_t j = 0; j < a->sizes[1]; j++)		\
+			  if(*name##_elem2d(a, i, j) !=			\
+			     *name##_elem2d(b, i, j))			\
+				  return 0;				\
+									\
+	  return 1;							\
+  }									\
+									\
+  static int name##_vectors_equal(const struct vec_##name##1d* a,	\
+				  const struct vec_##name##1d* b)	\
+  {									\
+	  for(int64_t i = 0; i < a->sizes[0]; i++)			\
+		  if(*name##_elem1d(a, i) != *name##_elem1d(b, i))	\
+			  return 0;					\
+									\
+	  return 1;							\
+  }
+
+DEFINE_MEMREF_FUNCTIONS(f, float)
+DEFINE_MEMREF_FUNCTIONS(i8, int8_t)
+DEFINE_MEMREF_FUNCTIONS(i32, int32_t)
+
+/* Defines prefix##run_mm_test and prefix##run_mv_test, which run a
+ * generated matrix multiplication or matrix-vector product with
+ * operands of type intype (memrefs struct vec_<in>2d / vec_<in>1d)
+ * and an output of type outtype (struct vec_<out>2d / vec_<out>1d)
+ * and compare the result with a reference implementation. The output
+ * is initialized with non-zero values, which must be overwritten by
+ * kernels with a default-initialized output and are added to by
+ * kernels that accumulate. Both functions return 0 on success,
+ * otherwise 1. */
+#define DEFINE_TEST_FUNCTIONS(prefix, in, intype, out, outtype)	\
+  typedef void (*prefix##mm_kernel_t)(DECL_VEC2D_FUNC_IN_ARGS(a, intype), \
+				      DECL_VEC2D_FUNC_IN_ARGS(b, intype), \
+				      DECL_VEC2D_FUNC_OUT_ARGS(c, outtype)); \
+									\
+  typedef void (*prefix##mv_kernel_t)(DECL_VEC2D_FUNC_IN_ARGS(a, intype), \
+				      DECL_VEC1D_FUNC_IN_ARGS(x, intype), \
+				      DECL_VEC1D_FUNC_OUT_ARGS(y, outtype)); \
+									\
+  static int prefix##run_mm_test(const char* name,			\
+				 prefix##mm_kernel_t fn,		\
+				 int a_colmajor, int c_colmajor,	\
+				 int accumulate, int64_t m, int64_t n,	\
+				 int64_t k, int verbose)		\
+  {									\
+	  struct vec_##in##2d a, b;					\
+	  struct vec_##out##2d c, c_ref;				\
+	  int ret = 0;							\
+									\
+	  if(verbose)							\
+		  printf("%s, M=%" PRId64 ", N=%" PRId64 ", K=%" PRId64 "\n", \
+			 name, m, n, k);				\
+									\
+	  if(in##_matrix_alloc(&a, m, k, a_colmajor) ||			\
+	     in##_matrix_alloc(&b, k, n, 0) ||				\
+	     out##_matrix_alloc(&c, m, n, c_colmajor) ||		\
+	     out##_matrix_alloc(&c_ref, m, n, c_colmajor))		\
+	  {								\
+		  fprintf(stderr, "Allocation failed");			\
+		  exit(1);						\
+	  }								\
+									\
+	  in##_init_matrix(&a, 1);					\
+	  in##_init_matrix(&b, 2);					\
+	  out##_init_matrix(&c, 3);					\
+	  out##_init_matrix(&c_ref, 3);					\
+									\
+	  fn(VEC2D_ARGS(&a), VEC2D_ARGS(&b), VEC2D_ARGS(&c));		\
+									\
+	  for(int64_t i = 0; i < m; i++) {				\
+		  for(int64_t j = 0; j < n; j++) {			\
+			  outtype accu = accumulate ?			\
+				  *out##_elem2d(&c_ref, i, j) : 0;	\
+									\
+			  for(int64_t l = 0; l < k; l++)		\
+				  accu += (outtype)*in##_elem2d(&a, i, l) * \
+					  *in##_elem2d(&b, l, j);	\
+									\
+			  *out##_elem2d(&c_ref, i, j) = accu;		\
+		  }							\
+	  }								\
+									\
+	  if(!out##_matrices_equal(&c, &c_ref)) {			\
+		  fprintf(stderr, "Result of %s with K=%" PRId64 " differs " \
+			  "from reference result\n", name, k);		\
+		  ret = 1;						\
+	  }								\
+									\
+	  vec_##in##2d_destroy(&a);					\
+	  vec_##in##2d_destroy(&b);					\
+	  vec_##out##2d_destroy(&c);					\
+	  vec_##out##2d_destroy(&c_ref);				\
+									\
+	  return ret;							\
+  }									\
+									\
+  static int prefix##run_mv_test(const char* name,			\
+				 prefix##mv_kernel_t fn,		\
+				 int a_colmajor, int accumulate,	\
+				 int64_t m, int64_t k, int verbose)	\
+  {									\
+	  struct vec_##in##2d a;					\
+	  struct vec_##in##1d x;					\
+	  struct vec_##out##1d y, y_ref;				\
+	  int ret = 0;							\
+									\
+	  if(verbose)							\
+		  printf("%s, M=%" PRId64 ", K=%" PRId64 "\n", name, m, k); \
+									\
+	  if(in##_matrix_alloc(&a, m, k, a_colmajor) ||			\
+	     in##_vector_alloc(&x, k) ||				\
+	     out##_vector_alloc(&y, m) ||				\
+	     out##_vector_alloc(&y_ref, m))				\
+	  {								\
+		  fprintf(stderr, "Allocation failed");			\
+		  exit(1);						\
+	  }								\
+									\
+	  in##_init_matrix(&a, 1);					\
+	  in##_init_vector(&x, 2);					\
+	  out##_init_vector(&y, 3);					\
+	  out##_init_vector(&y_ref, 3);					\
+									\
+	  fn(VEC2D_ARGS(&a), VEC1D_ARGS(&x), VEC1D_ARGS(&y));		\
+									\
+	  for(int64_t i = 0; i < m; i++) {				\
+		  outtype accu = accumulate ? *out##_elem1d(&y_ref, i) : 0; \
+									\
+		  for(int64_t l = 0; l < k; l++)			\
+			  accu += (outtype)*in##_elem2d(&a, i, l) *	\
+				  *in##_elem1d(&x, l);			\
+									\
+		  *out##_elem1d(&y_ref, i) = accu;			\
+	  }								\
+									\
+	  if(!out##_vectors_equal(&y, &y_ref)) {			\
+		  fprintf(stderr, "Result of %s with K=%" PRId64 " differs " \
+			  "from reference result\n", name, k);		\
+		  ret = 1;						\
+	  }								\
+									\
+	  vec_##in##2d_destroy(&a);					\
+	  vec_##in##1d_destroy(&x);					\
+	  vec_##out##1d_destroy(&y);					\
+	  vec_##out##1d_destroy(&y_ref);				\
+									\
+	  return ret;							\
+  }
+
+DEFINE_TEST_FUNCTIONS(s, f, float, f, float)
+DEFINE_TEST_FUNCTIONS(i8, i8, int8_t, i32, int32_t)
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	/* Sizes that are not multiples of the register blocks of the
+	 * microkernels; K covers a single step, an odd number of steps
+	 * (incomplete pairs for int8), multiple blocks of K for float
+	 * and an empty reduction */
+	const int64_t ks[] = { 1, 41, 300, 0 };
+	int verbose = 0;
+	int failed = 0;
+	int64_t m = 37;
+	int64_t n = 29;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	for(size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+		int64_t k = ks[i];
+
+		failed |= srun_mm_test("mm", mm, 0, 0, 0, m, n, k, verbose);
+		failed |= srun_mm_test("mm_at", mm_at, 1, 0, 0, m, n, k, verbose);
+		failed |= srun_mm_test("mm_ccm", mm_ccm, 0, 1, 0, m, n, k, verbose);
+		failed |= srun_mm_test("mm_acc", mm_acc, 0, 0, 1, m, n, k, verbose);
+		failed |= srun_mv_test("mv", mv, 0, 0, m, k, verbose);
+		failed |= srun_mv_test("mv_at", mv_at, 1, 0, m, k, verbose);
+		failed |= srun_mv_test("mv_acc", mv_acc, 0, 1, m, k, verbose);
+
+		failed |= i8run_mm_test("mm_i8", mm_i8, 0, 0, 0,
+					m, n, k, verbose);
+		failed |= i8run_mm_test("mm_i8_at", mm_i8_at, 1, 0, 0,
+					m, n, k, verbose);
+		failed |= i8run_mm_test("mm_i8_ccm", mm_i8_ccm, 0, 1, 0,
+					m, n, k, verbose);
+		failed |= i8run_mm_test("mm_i8_acc", mm_i8_acc, 0, 0, 1,
+					m, n, k, verbose);
+		failed |= i8run_mv_test("mv_i8", mv_i8, 0, 0, m, k, verbose);
+		failed |= i8run_mv_test("mv_i8_at", mv_i8_at, 1, 0, m, k,
+					verbose);
+		failed |= i8run_mv_test("mv_i8_acc", mv_i8_acc, 0, 1, m, k,
+					verbose);
+	}
+
+	return failed;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated function under test, whose output is written with
+ * non-temporal stores */
+extern void transpose_square(DECL_VEC2D_FUNC_IN_ARGS(a, float),
+			     DECL_VEC2D_FUNC_OUT_ARGS(o, float));
+
+/* Reference implementation squaring the elements of a transposed
+ * matrix */
+void transpose_square_refimpl(const struct vec_f2d* a, struct vec_f2d* o)
+{
+	for(int64_t y = 0; y < o->sizes[0]; y++) {
+		for(int64_t x = 0; x < o->sizes[1]; x++) {
+			float v = vec_f2d_get(a, y, x);
+			vec_f2d_set(o, x, y, v * v);
+		}
+	}
+}
+
+/* Initialize matrix with value x+2*y at position (x, y) */
+void init_matrix(struct vec_f2d* m)
+{
+	for(int64_t y = 0; y < m->sizes[0]; y++)
+		for(int64_t x = 0; x < m->sizes[1]; x++)
+			vec_f2d_set(m, x, y, x+2*y);
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct vec_f2d a, o, o_ref;
+	int verbose = 0;
+	int n = 37;
+	int m = 21;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(vec_f2d_alloc(&a, n, m) ||
+	   vec_f2d_alloc(&o, m, n) ||
+	   vec_f2d_alloc(&o_ref, m, n))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	init_matrix(&a);
+
+	if(verbose) {
+		puts("A:");
+		vec_f2d_dump(&a);
+		puts("");
+	}
+
+	transpose_square(VEC2D_ARGS(&a), VEC2D_ARGS(&o));
+	transpose_square_refimpl(&a, &o_ref);
+
+	if(verbose) {
+		puts("Result O:");
+		vec_f2d_dump(&o);
+		puts("");
+
+		puts("Reference O:");
+		vec_f2d_dump(&o_ref);
+		puts("");
+	}
+
+	if(!vec_f2d_compare(&o, &o_ref)) {
+		fputs("Result differs from reference result\n", stderr);
+		exit(1);
+	}
+
+	vec_f2d_destroy(&a);
+	vec_f2d_destroy(&o);
+	vec_f2d_destroy(&o_ref);
+
+	return 0;
+}
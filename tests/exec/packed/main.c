@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated function under test; A is a packed int4 matrix, B and C
+ * are packed uint2 matrices */
+extern void packed(DECL_VEC2D_FUNC_IN_ARGS(a, uint8_t),
+		   DECL_VEC1D_FUNC_IN_ARGS(x, int8_t),
+		   DECL_VEC2D_FUNC_IN_ARGS(b, uint8_t),
+		   DECL_VEC1D_FUNC_OUT_ARGS(y, int32_t),
+		   DECL_VEC2D_FUNC_OUT_ARGS(c, uint8_t));
+
+/* Matrix with packed elements of `bits` bits. Each row occupies
+ * (cols * bits + 7) / 8 bytes; the element with the lowest index of
+ * each byte is stored in the least significant bits. */
+struct packed_matrix {
+	uint8_t* data;
+	int64_t rows;
+	int64_t cols;
+	int64_t row_bytes;
+	int bits;
+};
+
+int packed_matrix_alloc(struct packed_matrix* m, int64_t rows, int64_t cols,
+			int bits)
+{
+	m->rows = rows;
+	m->cols = cols;
+	m->bits = bits;
+	m->row_bytes = (cols * bits + 7) / 8;
+	m->data = calloc(rows * m->row_bytes, 1);
+
+	return m->data == NULL;
+}
+
+void packed_matrix_destroy(struct packed_matrix* m)
+{
+	free(m->data);
+}
+
+/* Returns the raw bits of the element at row r and column c */
+unsigned packed_matrix_get(const struct packed_matrix* m, int64_t r, int64_t c)
+{
+	int64_t per_byte = 8 / m->bits;
+	uint8_t byte = m->data[r * m->row_bytes + c / per_byte];
+
+	return (byte >> ((c % per_byte) * m->bits)) & ((1 << m->bits) - 1);
+}
+
+/* Returns the element at row r and column c interpreted as a signed
+ * integer */
+int packed_matrix_get_signed(const struct packed_matrix* m, int64_t r, int64_t c)
+{
+	unsigned v = packed_matrix_get(m, r, c);
+
+	if(v & (1 << (m->bits - 1)))
+		return (int)v - (1 << m->bits);
+
+	return v;
+}
+
+void packed_matrix_set(struct packed_matrix* m, int64_t r, int64_t c, int v)
+{
+	int64_t per_byte = 8 / m->bits;
+	int shift = (c % per_byte) * m->bits;
+	uint8_t mask = ((1 << m->bits) - 1) << shift;
+	uint8_t* byte = &m->data[r * m->row_bytes + c / per_byte];
+
+	*byte = (*byte & ~mask) | ((v << shift) & mask);
+}
+
+void packed_matrix_dump(const struct packed_matrix* m, int is_signed)
+{
+	for(int64_t r = 0; r < m->rows; r++) {
+		for(int64_t c = 0; c < m->cols; c++) {
+			printf("%d ", is_signed ?
+			       packed_matrix_get_signed(m, r, c) :
+			       (int)packed_matrix_get(m, r, c));
+		}
+
+		puts("");
+	}
+}
+
+#define PACKED_ARGS(m)				\
+	(m)->data, (m)->data, 0, (m)->rows, (m)->cols, (m)->row_bytes, 1
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct packed_matrix a, b, c;
+	struct vec_i81d x;
+	struct vec_i321d y;
+	int verbose = 0;
+	int ret = 0;
+	int m = 5;
+	int k = 7;
+	int n = 6;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(packed_matrix_alloc(&a, m, k, 4) ||
+	   packed_matrix_alloc(&b, m, n, 2) ||
+	   packed_matrix_alloc(&c, m, n, 2) ||
+	   vec_i81d_alloc(&x, k) ||
+	   vec_i321d_alloc(&y, m))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	/* Values in [-8, 7] for A, [0, 3] for B */
+	for(int64_t i = 0; i < m; i++) {
+		for(int64_t j = 0; j < k; j++)
+			packed_matrix_set(&a, i, j, ((i * 5 + j * 3) % 16) - 8);
+
+		for(int64_t j = 0; j < n; j++)
+			packed_matrix_set(&b, i, j, (i + j) % 4);
+	}
+
+	for(int64_t j = 0; j < k; j++)
+		vec_i81d_set(&x, j, (j * 29) % 256 - 128);
+
+	if(verbose) {
+		puts("A:");
+		packed_matrix_dump(&a, 1);
+		puts("");
+
+		puts("B:");
+		packed_matrix_dump(&b, 0);
+		puts("");
+	}
+
+	packed(PACKED_ARGS(&a), VEC1D_ARGS(&x), PACKED_ARGS(&b),
+	       VEC1D_ARGS(&y), PACKED_ARGS(&c));
+
+	for(int64_t i = 0; i < m; i++) {
+		int32_t accu = 0;
+
+		for(int64_t j = 0; j < k; j++) {
+			accu += packed_matrix_get_signed(&a, i, j) *
+				vec_i81d_get(&x, j);
+		}
+
+		if(vec_i321d_get(&y, i) != accu) {
+			fprintf(stderr, "Result y(%" PRId64 ") = %" PRId32 " "
+				"differs from reference result %" PRId32 "\n",
+				i, vec_i321d_get(&y, i), accu);
+			ret = 1;
+		}
+
+		for(int64_t j = 0; j < n; j++) {
+			unsigned v = packed_matrix_get(&b, i, j);
+			unsigned ref = (v * v + v) & 3;
+
+			if(packed_matrix_get(&c, i, j) != ref) {
+				fprintf(stderr, "Result C(%" PRId64 ", %" PRId64 ") "
+					"differs from reference result\n", i, j);
+				ret = 1;
+			}
+		}
+	}
+
+	if(verbose) {
+		puts("Result C:");
+		packed_matrix_dump(&c, 0);
+		puts("");
+	}
+
+	packed_matrix_destroy(&a);
+	packed_matrix_destroy(&b);
+	packed_matrix_destroy(&c);
+	vec_i81d_destroy(&x);
+	vec_i321d_destroy(&y);
+
+	return ret;
+}
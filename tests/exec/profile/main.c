@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated instrumented function under test */
+extern void axpby(DECL_VEC1D_FUNC_IN_ARGS(x, float),
+		  DECL_VEC1D_FUNC_IN_ARGS(y, float),
+		  DECL_VEC1D_FUNC_OUT_ARGS(t, float),
+		  DECL_VEC1D_FUNC_OUT_ARGS(z, float),
+		  DECL_VEC2D_FUNC_OUT_ARGS(profile, int64_t));
+
+/* Reference implementation of the function under test */
+void axpby_refimpl(const struct vec_f1d* x, const struct vec_f1d* y,
+		   struct vec_f1d* z)
+{
+	for(int64_t i = 0; i < z->sizes[0]; i++)
+		vec_f1d_set(z, i, 2.0f * vec_f1d_get(x, i) +
+			    3.0f * vec_f1d_get(y, i));
+}
+
+/* Initialize vector with value i at position i */
+void init_vector(struct vec_f1d* v)
+{
+	for(int64_t i = 0; i < v->sizes[0]; i++)
+		vec_f1d_set(v, i, i);
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct vec_f1d x, y, t, z, z_ref;
+	struct vec_i642d profile;
+	int verbose = 0;
+	int n = 1024;
+	int num_calls = 3;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(vec_f1d_alloc(&x, n) ||
+	   vec_f1d_alloc(&y, n) ||
+	   vec_f1d_alloc(&t, n) ||
+	   vec_f1d_alloc(&z, n) ||
+	   vec_f1d_alloc(&z_ref, n) ||
+	   vec_i642d_alloc(&profile, 2, 2))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	init_vector(&x);
+	init_vector(&y);
+
+	for(int i = 0; i < num_calls; i++) {
+		axpby(VEC1D_ARGS(&x), VEC1D_ARGS(&y), VEC1D_ARGS(&t),
+		      VEC1D_ARGS(&z), VEC2D_ARGS(&profile));
+	}
+
+	axpby_refimpl(&x, &y, &z_ref);
+
+	if(verbose) {
+		puts("Profile:");
+		vec_i642d_dump(&profile);
+		puts("");
+	}
+
+	if(!vec_f1d_compare(&z, &z_ref)) {
+	        fputs("Result differs from reference result\n", stderr);
+		exit(1);
+	}
+
+	/* One row per comprehension with the cycles in the first and
+	 * the number of executions in the second column */
+	for(int64_t row = 0; row < 2; row++) {
+		if(vec_i642d_get(&profile, 0, row) < 0 ||
+		   vec_i642d_get(&profile, 1, row) != num_calls)
+		{
+			fputs("Unexpected profiling counters\n", stderr);
+			exit(1);
+		}
+	}
+
+	vec_f1d_destroy(&x);
+	vec_f1d_destroy(&y);
+	vec_f1d_destroy(&t);
+	vec_f1d_destroy(&z);
+	vec_f1d_destroy(&z_ref);
+	vec_i642d_destroy(&profile);
+
+	return 0;
+}
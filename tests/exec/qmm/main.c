@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated quantized matrix multiplication function under test */
+extern void qmm(DECL_VEC2D_FUNC_IN_ARGS(a, int8_t),
+		DECL_VEC2D_FUNC_IN_ARGS(b, int8_t),
+		DECL_VEC1D_FUNC_IN_ARGS(scale, float),
+		DECL_VEC1D_FUNC_IN_ARGS(zero_point, int32_t),
+		DECL_VEC2D_FUNC_OUT_ARGS(o, int8_t));
+
+/* Reference implementation of a matrix multiplication accumulating
+ * with 32 bits, followed by a requantization to 8 bits */
+void qmm_refimpl(const struct vec_i82d* a, const struct vec_i82d* b,
+		 float scale, int32_t zero_point, struct vec_i82d* o)
+{
+	int32_t accu;
+	float scaled;
+
+	for(int64_t y = 0; y < o->sizes[0]; y++) {
+		for(int64_t x = 0; x < o->sizes[1]; x++) {
+			accu = 0;
+
+			for(int64_t k = 0; k < a->sizes[1]; k++)
+				accu += (int32_t)vec_i82d_get(a, k, y) *
+					(int32_t)vec_i82d_get(b, x, k);
+
+			/* Round half away from zero */
+			scaled = (float)accu * scale;
+			scaled = (scaled < 0) ? scaled - 0.5f : scaled + 0.5f;
+			accu = (int32_t)scaled + zero_point;
+
+			if(accu < INT8_MIN)
+				accu = INT8_MIN;
+			else if(accu > INT8_MAX)
+				accu = INT8_MAX;
+
+			vec_i82d_set(o, x, y, accu);
+		}
+	}
+}
+
+/* Initialize matrix with values in [-64, 63] derived from the
+ * position (x, y) */
+void init_matrix(struct vec_i82d* m)
+{
+	for(int64_t y = 0; y < m->sizes[0]; y++)
+		for(int64_t x = 0; x < m->sizes[1]; x++)
+			vec_i82d_set(m, x, y, ((x * 37 + y * 11) % 128) - 64);
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct vec_i82d a, b, o, o_ref;
+	struct vec_f1d scale;
+	struct vec_i321d zero_point;
+	int verbose = 0;
+	int n = 6;
+	int k = 9;
+	int m = 12;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(vec_i82d_alloc(&a, n, k) ||
+	   vec_i82d_alloc(&b, k, m) ||
+	   vec_i82d_alloc(&o, n, m) ||
+	   vec_i82d_alloc(&o_ref, n, m) ||
+	   vec_f1d_alloc(&scale, 1) ||
+	   vec_i321d_alloc(&zero_point, 1))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	init_matrix(&a);
+	init_matrix(&b);
+
+	/* Power of two, such that the scaled values are exact */
+	vec_f1d_set(&scale, 0, 0.0625f);
+	vec_i321d_set(&zero_point, 0, -3);
+
+	if(verbose) {
+		puts("A:");
+		vec_i82d_dump(&a);
+		puts("");
+
+		puts("B:");
+		vec_i82d_dump(&b);
+		puts("");
+	}
+
+	qmm(VEC2D_ARGS(&a), VEC2D_ARGS(&b), VEC1D_ARGS(&scale),
+	    VEC1D_ARGS(&zero_point), VEC2D_ARGS(&o));
+	qmm_refimpl(&a, &b, vec_f1d_get(&scale, 0),
+		    vec_i321d_get(&zero_point, 0), &o_ref);
+
+	if(verbose) {
+		puts("Result O:");
+		vec_i82d_dump(&o);
+		puts("");
+
+		puts("Reference O:");
+		vec_i82d_dump(&o_ref);
+		puts("");
+	}
+
+	if(!vec_i82d_compare(&o, &o_ref)) {
+	        fputs("Result differs from reference result\n", stderr);
+		exit(1);
+	}
+
+	vec_i82d_destroy(&a);
+	vec_i82d_destroy(&b);
+	vec_i82d_destroy(&o);
+	vec_i82d_destroy(&o_ref);
+	vec_f1d_destroy(&scale);
+	vec_i321d_destroy(&zero_point);
+
+	return 0;
+}
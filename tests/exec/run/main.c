@@ -0,0 +1,254 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Generates the inputs for and checks the outputs of teckyl-run
+ * executing the kernels of this directory:
+ *
+ *   run-check gen DIR          writes the inputs of all kernels to DIR
+ *   run-check check KERNEL C   compares the .npy file C with the
+ *                              reference result of KERNEL
+ *
+ * The inputs are:
+ *
+ *   A.npy, B.raw    float A and B for mm.tc
+ *   A8.npy, B8.raw  int8 A and B for mm_int8_int32.tc
+ *   AU8.npy         uint8 A for mm_uint8_int8_int32.tc (with B8.raw)
+ */
+
+#define M 67
+#define K 45
+#define N 29
+
+enum kernel {
+	KERNEL_MM,
+	KERNEL_MM_INT8_INT32,
+	KERNEL_MM_UINT8_INT8_INT32
+};
+
+/* Small integers, such that sums are exact in any order */
+int64_t a_elem(int64_t i, int64_t k)
+{
+	return (i * 7 + k) % 13 - 6;
+}
+
+int64_t b_elem(int64_t k, int64_t j)
+{
+	return (k * 3 + j * 5) % 11 - 5;
+}
+
+/* Elements whose products overflow 8 and 16 bits and elements of
+ * uint8 tensors beyond the range of int8 */
+int64_t a8_elem(int64_t i, int64_t k)
+{
+	return a_elem(i, k) * 20;
+}
+
+int64_t b8_elem(int64_t k, int64_t j)
+{
+	return b_elem(k, j) * 25;
+}
+
+int64_t au8_elem(int64_t i, int64_t k)
+{
+	return (a_elem(i, k) + 6) * 19;
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr,
+		"Usage: %s gen DIR\n"
+		"       %s check mm|mm_int8_int32|mm_uint8_int8_int32 FILE\n",
+		program_name, program_name);
+	exit(1);
+}
+
+FILE* open_path(const char* path, const char* mode)
+{
+	FILE* fp;
+
+	if(!(fp = fopen(path, mode))) {
+		fprintf(stderr, "Could not open %s\n", path);
+		exit(1);
+	}
+
+	return fp;
+}
+
+FILE* open_file(const char* dir, const char* name, const char* mode)
+{
+	char path[4096];
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+	return open_path(path, mode);
+}
+
+/* Writes a version 1 .npy header for a C-ordered array with the
+ * elements described by `descr` (e.g., "<f4") and the shape given as
+ * a string (e.g., "(3, 4)") */
+void write_npy_header(FILE* fp, const char* descr, const char* shape)
+{
+	char dict[128];
+	int len;
+
+	len = snprintf(dict, sizeof(dict),
+		       "{'descr': '%s', 'fortran_order': False, "
+		       "'shape': %s, }", descr, shape);
+
+	/* Pad with spaces and a newline to a multiple of 64 bytes */
+	while((10 + len + 1) % 64 != 0)
+		dict[len++] = ' ';
+
+	dict[len++] = '\n';
+
+	fwrite("\x93NUMPY\x01\x00", 1, 8, fp);
+	fputc(len & 0xff, fp);
+	fputc(len >> 8, fp);
+	fwrite(dict, 1, len, fp);
+}
+
+void gen(const char* dir)
+{
+	FILE* fa = open_file(dir, "A.npy", "wb");
+	FILE* fb = open_file(dir, "B.raw", "wb");
+	FILE* fa8 = open_file(dir, "A8.npy", "wb");
+	FILE* fb8 = open_file(dir, "B8.raw", "wb");
+	FILE* fau8 = open_file(dir, "AU8.npy", "wb");
+
+	write_npy_header(fa, "<f4", "(67, 45)");
+	write_npy_header(fa8, "|i1", "(67, 45)");
+	write_npy_header(fau8, "|u1", "(67, 45)");
+
+	for(int64_t i = 0; i < M; i++) {
+		for(int64_t k = 0; k < K; k++) {
+			float v = a_elem(i, k);
+			int8_t v8 = a8_elem(i, k);
+			uint8_t vu8 = au8_elem(i, k);
+
+			fwrite(&v, sizeof(v), 1, fa);
+			fwrite(&v8, sizeof(v8), 1, fa8);
+			fwrite(&vu8, sizeof(vu8), 1, fau8);
+		}
+	}
+
+	for(int64_t k = 0; k < K; k++) {
+		for(int64_t j = 0; j < N; j++) {
+			float v = b_elem(k, j);
+			int8_t v8 = b8_elem(k, j);
+
+			fwrite(&v, sizeof(v), 1, fb);
+			fwrite(&v8, sizeof(v8), 1, fb8);
+		}
+	}
+
+	fclose(fa);
+	fclose(fb);
+	fclose(fa8);
+	fclose(fb8);
+	fclose(fau8);
+}
+
+int64_t ref_elem(enum kernel kernel, int64_t i, int64_t j)
+{
+	int64_t ref = 0;
+
+	for(int64_t k = 0; k < K; k++) {
+		switch(kernel) {
+			case KERNEL_MM:
+				ref += a_elem(i, k) * b_elem(k, j);
+				break;
+			case KERNEL_MM_INT8_INT32:
+				ref += a8_elem(i, k) * b8_elem(k, j);
+				break;
+			case KERNEL_MM_UINT8_INT8_INT32:
+				ref += au8_elem(i, k) * b8_elem(k, j);
+				break;
+		}
+	}
+
+	return ref;
+}
+
+int check(enum kernel kernel, const char* filename)
+{
+	FILE* fc = open_path(filename, "rb");
+	const char* descr = (kernel == KERNEL_MM) ? "'<f4'" : "'<i4'";
+	unsigned char prelude[10];
+	char dict[65536];
+	size_t len;
+	float c[M][N];
+	int32_t c32[M][N];
+	void* data = (kernel == KERNEL_MM) ? (void*)c : (void*)c32;
+
+	if(fread(prelude, 1, 10, fc) != 10 ||
+	   memcmp(prelude, "\x93NUMPY\x01", 7) != 0)
+	{
+		fprintf(stderr, "%s is not a .npy file\n", filename);
+		return 1;
+	}
+
+	len = prelude[8] | (prelude[9] << 8);
+
+	if(fread(dict, 1, len, fc) != len) {
+		fprintf(stderr, "Truncated header in %s\n", filename);
+		return 1;
+	}
+
+	dict[len] = '\0';
+
+	if(!strstr(dict, descr) || !strstr(dict, "(67, 29)") ||
+	   (10 + len) % 64 != 0)
+	{
+		fprintf(stderr, "Unexpected header in %s: %s\n",
+			filename, dict);
+		return 1;
+	}
+
+	/* Both element types have 4 bytes */
+	if(fread(data, 4, M * N, fc) != M * N) {
+		fprintf(stderr, "Truncated data in %s\n", filename);
+		return 1;
+	}
+
+	fclose(fc);
+
+	for(int64_t i = 0; i < M; i++) {
+		for(int64_t j = 0; j < N; j++) {
+			int64_t ref = ref_elem(kernel, i, j);
+			int match = (kernel == KERNEL_MM) ?
+				(c[i][j] == (float)ref) :
+				(c32[i][j] == ref);
+
+			if(!match) {
+				fprintf(stderr,
+					"Result in %s differs from reference "
+					"result\n", filename);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc == 3 && strcmp(argv[1], "gen") == 0) {
+		gen(argv[2]);
+	} else if(argc == 4 && strcmp(argv[1], "check") == 0) {
+		if(strcmp(argv[2], "mm") == 0)
+			return check(KERNEL_MM, argv[3]);
+		else if(strcmp(argv[2], "mm_int8_int32") == 0)
+			return check(KERNEL_MM_INT8_INT32, argv[3]);
+		else if(strcmp(argv[2], "mm_uint8_int8_int32") == 0)
+			return check(KERNEL_MM_UINT8_INT8_INT32, argv[3]);
+		else
+			die_usage(argv[0]);
+	} else {
+		die_usage(argv[0]);
+	}
+
+	return 0;
+}
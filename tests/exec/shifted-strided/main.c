@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated function with shifted and strided accesses under test */
+extern void shifted_strided(DECL_VEC1D_FUNC_IN_ARGS(a, float),
+			    DECL_VEC1D_FUNC_IN_ARGS(b, float),
+			    DECL_VEC1D_FUNC_OUT_ARGS(s, float),
+			    DECL_VEC1D_FUNC_OUT_ARGS(d, float),
+			    DECL_VEC1D_FUNC_OUT_ARGS(w, float),
+			    DECL_VEC1D_FUNC_OUT_ARGS(e, float));
+
+/* Reference implementation of shifted_strided. Elements of the
+ * outputs beyond the ranges of the iterators are left untouched. */
+void shifted_strided_refimpl(const struct vec_f1d* a, const struct vec_f1d* b,
+			     struct vec_f1d* s, struct vec_f1d* d,
+			     struct vec_f1d* w, struct vec_f1d* e)
+{
+	int64_t n = a->sizes[0];
+	int64_t m = b->sizes[0];
+	float accu;
+
+	accu = 0;
+
+	for(int64_t k = 0; k < n-5; k++)
+		accu += vec_f1d_get(a, k+5);
+
+	vec_f1d_set(s, 0, accu);
+
+	for(int64_t i = 0; i < m; i++) {
+		accu = 0;
+
+		for(int64_t r = 0; r < 2; r++)
+			accu += vec_f1d_get(a, 2*i+r);
+
+		vec_f1d_set(d, i, accu);
+	}
+
+	for(int64_t i = 0; i < n-2; i++) {
+		accu = 0;
+
+		for(int64_t r = 0; r < 3; r++)
+			accu += vec_f1d_get(a, i+r);
+
+		vec_f1d_set(w, i, accu);
+	}
+
+	for(int64_t i = 0; i < m; i++) {
+		vec_f1d_set(e, i, vec_f1d_get(a, i+1) + vec_f1d_get(a, 2*i) +
+			    vec_f1d_get(b, i));
+	}
+}
+
+/* Checks if the elements of two 1d memrefs of the same size are
+ * equal */
+int vecs_equal(const struct vec_f1d* a, const struct vec_f1d* b)
+{
+	for(int64_t i = 0; i < a->sizes[0]; i++)
+		if(vec_f1d_get(a, i) != vec_f1d_get(b, i))
+			return 0;
+
+	return 1;
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct vec_f1d a, b, s, d, w, e, s_ref, d_ref, w_ref, e_ref;
+	int verbose = 0;
+	/* The ranges of the iterators match neither size */
+	int n = 23;
+	int m = 10;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(vec_f1d_alloc(&a, n) ||
+	   vec_f1d_alloc(&b, m) ||
+	   vec_f1d_alloc(&s, 1) ||
+	   vec_f1d_alloc(&d, m) ||
+	   vec_f1d_alloc(&w, n) ||
+	   vec_f1d_alloc(&e, m) ||
+	   vec_f1d_alloc(&s_ref, 1) ||
+	   vec_f1d_alloc(&d_ref, m) ||
+	   vec_f1d_alloc(&w_ref, n) ||
+	   vec_f1d_alloc(&e_ref, m))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	/* Small integers, such that sums are exact in any order */
+	for(int64_t i = 0; i < n; i++)
+		vec_f1d_set(&a, i, (i * 7) % 11 - 5);
+
+	for(int64_t i = 0; i < m; i++)
+		vec_f1d_set(&b, i, i % 3);
+
+	shifted_strided(VEC1D_ARGS(&a), VEC1D_ARGS(&b), VEC1D_ARGS(&s),
+			VEC1D_ARGS(&d), VEC1D_ARGS(&w), VEC1D_ARGS(&e));
+	shifted_strided_refimpl(&a, &b, &s_ref, &d_ref, &w_ref, &e_ref);
+
+	if(verbose) {
+		puts("Result s, d, w, e:");
+		vec_f1d_dump(&s);
+		vec_f1d_dump(&d);
+		vec_f1d_dump(&w);
+		vec_f1d_dump(&e);
+		puts("");
+
+		puts("Reference s, d, w, e:");
+		vec_f1d_dump(&s_ref);
+		vec_f1d_dump(&d_ref);
+		vec_f1d_dump(&w_ref);
+		vec_f1d_dump(&e_ref);
+		puts("");
+	}
+
+	if(!vecs_equal(&s, &s_ref) || !vecs_equal(&d, &d_ref) ||
+	   !vecs_equal(&w, &w_ref) || !vecs_equal(&e, &e_ref))
+	{
+		fputs("Result differs from reference result\n", stderr);
+		exit(1);
+	}
+
+	vec_f1d_destroy(&a);
+	vec_f1d_destroy(&b);
+	vec_f1d_destroy(&s);
+	vec_f1d_destroy(&d);
+	vec_f1d_destroy(&w);
+	vec_f1d_destroy(&e);
+	vec_f1d_destroy(&s_ref);
+	vec_f1d_destroy(&d_ref);
+	vec_f1d_destroy(&w_ref);
+	vec_f1d_destroy(&e_ref);
+
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated header with the variants of the function under test and
+ * the dispatcher add() */
+#include "stride-versioning.h"
+
+#define M 5
+#define N 7
+
+/* Buffers for strided views with an offset of 3 elements, a stride of
+ * 2 elements for the innermost dimension and padded rows */
+#define VIEW_OFFSET 3
+#define VIEW_STRIDE1 2
+#define VIEW_STRIDE0 (2*N+1)
+#define VIEW_BUFSIZE (VIEW_OFFSET + M*VIEW_STRIDE0)
+
+/* Value of the element at position (x, y) of the input A */
+static float a_val(int64_t x, int64_t y)
+{
+	return x + 10*y;
+}
+
+/* Value of the element at position (x, y) of the input B */
+static float b_val(int64_t x, int64_t y)
+{
+	return 100*x - y;
+}
+
+/* Initializes a strided 2d memref `v` of MxN elements viewing the
+ * buffer `buf` */
+static void init_view(struct vec_f2d* v, float* buf)
+{
+	v->allocatedPtr = buf;
+	v->alignedPtr = buf;
+	v->offset = VIEW_OFFSET;
+	v->sizes[0] = M;
+	v->sizes[1] = N;
+	v->strides[0] = VIEW_STRIDE0;
+	v->strides[1] = VIEW_STRIDE1;
+}
+
+/* Returns a pointer to the element at position (x, y) of a strided 2d
+ * memref */
+static float* view_elem(const struct vec_f2d* v, int64_t x, int64_t y)
+{
+	return v->alignedPtr + v->offset + y*v->strides[0] + x*v->strides[1];
+}
+
+/* Checks that the MxN elements of `o` are the sums of the inputs and
+ * that all other elements of the buffer `buf` with `bufsize` elements
+ * have been left untouched, i.e., are still 0. Returns 1 on success,
+ * otherwise 0. */
+static int check_result(const char* name, const struct vec_f2d* o,
+			float* buf, size_t bufsize)
+{
+	size_t num_written = 0;
+
+	for(int64_t y = 0; y < M; y++) {
+		for(int64_t x = 0; x < N; x++) {
+			if(*view_elem(o, x, y) != a_val(x, y) + b_val(x, y)) {
+				fprintf(stderr, "Result of %s differs from "
+					"reference result at (%" PRId64 ", "
+					"%" PRId64 ")\n", name, x, y);
+				return 0;
+			}
+		}
+	}
+
+	for(size_t i = 0; i < bufsize; i++)
+		if(buf[i] != 0)
+			num_written++;
+
+	if(num_written > M*N) {
+		fprintf(stderr, "%s wrote outside of the output\n", name);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Runs the function `fn` on the inputs `a` and `b` and checks the
+ * output `o` viewing the buffer `obuf` with `obufsize`
+ * elements. Returns 1 on success, otherwise 0. */
+static int check_fn(const char* name,
+		    void (*fn)(DECL_VEC2D_FUNC_IN_ARGS(A, float),
+			       DECL_VEC2D_FUNC_IN_ARGS(B, float),
+			       DECL_VEC2D_FUNC_OUT_ARGS(C, float)),
+		    const struct vec_f2d* a, const struct vec_f2d* b,
+		    struct vec_f2d* o, float* obuf, size_t obufsize)
+{
+	memset(obuf, 0, obufsize * sizeof(float));
+	fn(VEC2D_ARGS(a), VEC2D_ARGS(b), VEC2D_ARGS(o));
+
+	return check_result(name, o, obuf, obufsize);
+}
+
+/* Fills the elements of the view `v` with the values of `val` */
+static void fill_view(struct vec_f2d* v, float (*val)(int64_t, int64_t))
+{
+	for(int64_t y = 0; y < M; y++)
+		for(int64_t x = 0; x < N; x++)
+			*view_elem(v, x, y) = val(x, y);
+}
+
+int main(void)
+{
+	struct vec_f2d a, b, o;
+	struct vec_f2d as, bs, os;
+	static float asbuf[VIEW_BUFSIZE];
+	static float bsbuf[VIEW_BUFSIZE];
+	static float osbuf[VIEW_BUFSIZE];
+
+	if(vec_f2d_alloc(&a, M, N) ||
+	   vec_f2d_alloc(&b, M, N) ||
+	   vec_f2d_alloc(&o, M, N))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	init_view(&as, asbuf);
+	init_view(&bs, bsbuf);
+	init_view(&os, osbuf);
+
+	fill_view(&a, a_val);
+	fill_view(&b, b_val);
+	fill_view(&as, a_val);
+	fill_view(&bs, b_val);
+
+	/* Contiguous tensors through the dispatcher and each variant */
+	if(!check_fn("add", add, &a, &b, &o, o.alignedPtr, M*N) ||
+	   !check_fn("add_contiguous", add_contiguous, &a, &b, &o,
+		     o.alignedPtr, M*N) ||
+	   !check_fn("add_strided", add_strided, &a, &b, &o,
+		     o.alignedPtr, M*N))
+	{
+		exit(1);
+	}
+
+	/* Strided tensors through the dispatcher, which must select the
+	 * strided variant, both for all and for some of the tensors */
+	if(!check_fn("add", add, &as, &bs, &os, osbuf, VIEW_BUFSIZE) ||
+	   !check_fn("add", add, &a, &bs, &os, osbuf, VIEW_BUFSIZE) ||
+	   !check_fn("add", add, &as, &b, &o, o.alignedPtr, M*N))
+	{
+		exit(1);
+	}
+
+	vec_f2d_destroy(&a);
+	vec_f2d_destroy(&b);
+	vec_f2d_destroy(&o);
+
+	return 0;
+}
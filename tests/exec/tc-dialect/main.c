@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include "../lib/memref.h"
+
+/* Generated function under test with comprehensions lowered from the
+ * tc dialect */
+extern void mvmaxdiff(DECL_VEC2D_FUNC_IN_ARGS(a, float),
+		      DECL_VEC1D_FUNC_IN_ARGS(x, float),
+		      DECL_VEC1D_FUNC_OUT_ARGS(c, float),
+		      DECL_VEC1D_FUNC_OUT_ARGS(m, float),
+		      DECL_VEC1D_FUNC_OUT_ARGS(d, float));
+
+/* Reference implementation of the function under test */
+void mvmaxdiff_refimpl(const struct vec_f2d* a, const struct vec_f1d* x,
+		       struct vec_f1d* c, struct vec_f1d* m,
+		       struct vec_f1d* d)
+{
+	for(int64_t y = 0; y < a->sizes[0]; y++) {
+		float sum = 0;
+		float max = vec_f2d_get(a, 0, y);
+
+		for(int64_t k = 0; k < a->sizes[1]; k++) {
+			float v = vec_f2d_get(a, k, y);
+
+			sum += v * vec_f1d_get(x, k);
+
+			if(v > max)
+				max = v;
+		}
+
+		vec_f1d_set(c, y, sum);
+		vec_f1d_set(m, y, max);
+	}
+
+	for(int64_t j = 0; j < d->sizes[0]; j++)
+		vec_f1d_set(d, j, vec_f1d_get(x, j+1) - vec_f1d_get(x, j));
+}
+
+/* Initialize matrix with small integers, such that sums are exact in
+ * any order; the maximum of each row is in its last column */
+void init_matrix(struct vec_f2d* a)
+{
+	for(int64_t y = 0; y < a->sizes[0]; y++)
+		for(int64_t x = 0; x < a->sizes[1]; x++)
+			vec_f2d_set(a, x, y, (x * 7 + y) % 13 - 6 +
+				    (x == a->sizes[1] - 1 ? 20 : 0));
+}
+
+/* Initialize vector with value i % 3 at position i */
+void init_vector(struct vec_f1d* v)
+{
+	for(int64_t i = 0; i < v->sizes[0]; i++)
+		vec_f1d_set(v, i, i % 3);
+}
+
+void die_usage(const char* program_name)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", program_name);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	struct vec_f2d a;
+	struct vec_f1d x, c, c_ref, m, m_ref, d, d_ref;
+	int verbose = 0;
+	int n = 3;
+	int k = 4099;
+
+	if(argc > 2)
+		die_usage(argv[0]);
+
+	if(argc == 2) {
+		if(strcmp(argv[1], "-v") == 0)
+			verbose = 1;
+		else
+			die_usage(argv[0]);
+	}
+
+	if(vec_f2d_alloc(&a, n, k) ||
+	   vec_f1d_alloc(&x, k) ||
+	   vec_f1d_alloc(&c, n) ||
+	   vec_f1d_alloc(&c_ref, n) ||
+	   vec_f1d_alloc(&m, n) ||
+	   vec_f1d_alloc(&m_ref, n) ||
+	   vec_f1d_alloc(&d, k-1) ||
+	   vec_f1d_alloc(&d_ref, k-1))
+	{
+		fprintf(stderr, "Allocation failed");
+		return 1;
+	}
+
+	init_matrix(&a);
+	init_vector(&x);
+
+	mvmaxdiff(VEC2D_ARGS(&a), VEC1D_ARGS(&x), VEC1D_ARGS(&c),
+		  VEC1D_ARGS(&m), VEC1D_ARGS(&d));
+	mvmaxdiff_refimpl(&a, &x, &c_ref, &m_ref, &d_ref);
+
+	if(verbose) {
+		puts("Sums:");
+		vec_f1d_dump(&c);
+		puts("");
+
+		puts("Maxima:");
+		vec_f1d_dump(&m);
+		puts("");
+
+		puts("Differences:");
+		vec_f1d_dump(&d);
+		puts("");
+	}
+
+	if(!vec_f1d_compare(&c, &c_ref) || !vec_f1d_compare(&m, &m_ref) ||
+	   !vec_f1d_compare(&d, &d_ref))
+	{
+	        fputs("Result differs from reference result\n", stderr);
+		exit(1);
+	}
+
+	vec_f2d_destroy(&a);
+	vec_f1d_destroy(&x);
+	vec_f1d_destroy(&c);
+	vec_f1d_destroy(&c_ref);
+	vec_f1d_destroy(&m);
+	vec_f1d_destroy(&m_ref);
+	vec_f1d_destroy(&d);
+	vec_f1d_destroy(&d_ref);
+
+	return 0;
+}